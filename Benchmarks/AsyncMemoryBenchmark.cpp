@@ -0,0 +1,162 @@
+#include "Benchmark.hh"
+#include <AsyncMemory.hh>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+/*
+ * Asynchronous copies: where the MDMA starts paying off.
+ *
+ *  - crossover per region pair, timing model of the target in CM7 cycles (480 MHz, AXI and
+ *    AHB at 240 MHz). A CPU copy reads and writes every word in turn; an MDMA copy costs a
+ *    fixed software and start-up latency, the cache maintenance of cached regions, and the
+ *    transfer at the rate of the slower side (half of it when both sides share the AXI bus
+ *    or the AHBS port). AsyncMemory::findCrossover() runs on the model and the table is
+ *    printed in the layout of AsyncMemory::Thresholds, the source of defaultThresholds.
+ *    The rates are estimates from the bus widths and clocks; calibrate() measures the real
+ *    ones on the board.
+ *  - CPU path on the host: cpuCopy() and cpuFill() against the C library, and the cost of
+ *    going through copyAsync() and its token when the size stays below the threshold.
+ */
+
+namespace
+{
+    using AsyncMemory::Region;
+
+    struct RegionTiming {
+        const char* name;
+        double cpuRead;         ///< Bytes per CM7 cycle, cold cache for cached regions.
+        double cpuWrite;
+        double dmaRate;         ///< Bytes per CM7 cycle for the MDMA on that side.
+        bool axi;               ///< MDMA access through its AXI master, the TCMs use AHBS.
+    };
+
+    constexpr std::array<RegionTiming, AsyncMemory::regionCount> timings{ {
+        { "ITCM", 4.0, 4.0, 2.0, false },
+        { "DTCM", 4.0, 4.0, 2.0, false },
+        { "AXI SRAM", 1.0, 2.0, 4.0, true },
+        { "D2 SRAM", 0.6, 1.0, 2.0, true },
+        { "SRAM4", 0.5, 0.8, 2.0, true },
+        { "other", 0.2, 0.4, 0.5, true },
+    } };
+
+    constexpr double cpuFixedCycles{ 20 };
+    constexpr double dmaFixedCycles{ 600 };          // chain build, validation, 13 register writes, IRQ and completion
+    constexpr double dmaStartCycles{ 80 };           // descriptor fetch and first beats
+    constexpr double maintenanceCyclesPerLine{ 3 };
+
+    double cpuCopyCycles(const RegionTiming& source, const RegionTiming& destination, const std::uint32_t bytes)
+    {
+        return cpuFixedCycles + bytes / source.cpuRead + bytes / destination.cpuWrite;
+    }
+
+    double dmaRate(const RegionTiming& source, const RegionTiming& destination)
+    {
+        // One bus for both sides: reads and writes take turns
+        if (source.axi == destination.axi) { return 1.0 / (1.0 / source.dmaRate + 1.0 / destination.dmaRate); }
+        return source.dmaRate < destination.dmaRate ? source.dmaRate : destination.dmaRate;
+    }
+
+    double maintenanceCycles(const bool cached, const std::uint32_t bytes, const std::uint32_t passes)
+    {
+        return cached ? passes * maintenanceCyclesPerLine * (bytes + 31) / 32 : 0.0;
+    }
+
+    double dmaCopyCycles(const std::size_t source, const std::size_t destination, const std::uint32_t bytes)
+    {
+        return dmaFixedCycles + dmaStartCycles + bytes / dmaRate(timings[source], timings[destination]) +
+               maintenanceCycles(AsyncMemory::isCached(static_cast<Region>(source)), bytes, 1) +
+               maintenanceCycles(AsyncMemory::isCached(static_cast<Region>(destination)), bytes, 2);
+    }
+
+    void printThreshold(const std::uint32_t threshold)
+    {
+        if (threshold == AsyncMemory::never) {
+            std::printf(" %6s", "never");
+        } else {
+            std::printf(" %6u", threshold);
+        }
+    }
+
+    void crossoverTable()
+    {
+        std::printf("  copy crossover in bytes, model (rows: source, columns: destination)\n  %-9s", "");
+        for (const RegionTiming& timing : timings) { std::printf(" %8.8s", timing.name); }
+        std::printf("\n");
+        for (std::size_t source = 0; source < AsyncMemory::regionCount; ++source) {
+            std::printf("  %-9s", timings[source].name);
+            for (std::size_t destination = 0; destination < AsyncMemory::regionCount; ++destination) {
+                const std::uint32_t threshold{ AsyncMemory::findCrossover(
+                    [&](const std::uint32_t bytes) { return cpuCopyCycles(timings[source], timings[destination], bytes); },
+                    [&](const std::uint32_t bytes) { return dmaCopyCycles(source, destination, bytes); }) };
+                std::printf("  ");
+                printThreshold(threshold);
+            }
+            std::printf("\n");
+        }
+
+        // The fill pattern is read from the copier, in AXI SRAM
+        std::printf("  fill crossover in bytes, model\n  %-9s", "");
+        for (std::size_t destination = 0; destination < AsyncMemory::regionCount; ++destination) {
+            const std::uint32_t threshold{ AsyncMemory::findCrossover(
+                [&](const std::uint32_t bytes) { return cpuFixedCycles + bytes / timings[destination].cpuWrite; },
+                [&](const std::uint32_t bytes) {
+                    return dmaFixedCycles + dmaStartCycles + bytes / dmaRate(timings[2], timings[destination]) +
+                           maintenanceCycles(AsyncMemory::isCached(static_cast<Region>(destination)), bytes, 2);
+                }) };
+            std::printf("  ");
+            printThreshold(threshold);
+        }
+        std::printf("\n  CPU cycles freed by a 16 KiB AXI SRAM -> D2 SRAM copy: %.0f of %.0f\n",
+                    cpuCopyCycles(timings[2], timings[3], 16384) - dmaFixedCycles - maintenanceCycles(true, 16384, 3),
+                    cpuCopyCycles(timings[2], timings[3], 16384));
+    }
+
+    // Channel registers as plain variables: the CPU path never starts the channel
+    std::array<volatile std::uint32_t, 13> registers{};
+
+    template<typename Operation>
+    void measure(const char* name, const std::size_t bytes, Operation&& operation)
+    {
+        constexpr std::size_t runs{ 20000 };
+        Benchmark::Samples samples;
+        samples.reserve(runs);
+        for (std::size_t run = 0; run < runs; ++run) {
+            const auto start{ Benchmark::Clock::now() };
+            operation();
+            samples.add(start, Benchmark::Clock::now());
+        }
+        char label[40];
+        std::snprintf(label, sizeof(label), "%s %zu B", name, bytes);
+        Benchmark::print(label, samples);
+    }
+
+    void cpuPath()
+    {
+        MdmaChannelHandler channel{ 0, &registers[0], &registers[1], &registers[2], &registers[3], &registers[4], &registers[5], &registers[6],
+                                    &registers[7], &registers[8], &registers[9], &registers[10], &registers[11], &registers[12] };
+        AsyncMemory::AsyncCopier<8> copier{ channel };
+        std::vector<std::uint8_t> source(4096, 0x5A);
+        std::vector<std::uint8_t> destination(4096);
+
+        for (const std::size_t bytes : { 64, 1024 }) {
+            measure("std::memcpy", bytes, [&] { std::memcpy(destination.data(), source.data(), bytes); });
+            measure("cpuCopy", bytes, [&] { AsyncMemory::cpuCopy(destination.data(), source.data(), bytes); });
+            measure("copyAsync, CPU path", bytes, [&] {
+                const auto token{ copier.copyAsync(destination.data(), source.data(), bytes, AsyncMemory::Dispatch::cpu) };
+                if (token) { static_cast<void>(copier.wait(token.value())); }
+            });
+            measure("cpuFill", bytes, [&] { AsyncMemory::cpuFill(destination.data() + 1, 0xA5, bytes); });
+        }
+    }
+};
+
+void runAsyncMemoryBenchmark()
+{
+    std::printf("=== Asynchronous copies: MDMA crossover (target model) and CPU path (host) ===\n");
+    crossoverTable();
+    cpuPath();
+    std::printf("\n");
+}
@@ -0,0 +1,73 @@
+#ifndef __BENCHMARK_H__
+#define __BENCHMARK_H__
+
+/**
+ * @file Benchmark.hh
+ * @brief Timing helpers for the host benchmark executable.
+ *
+ * Each Benchmarks/<Module>Benchmark.cpp file exposes a run<Module>Benchmark() function
+ * called from main(). Results are host figures: they compare algorithms, not cycle counts
+ * of the target.
+ */
+
+//<------------------------------INCLUDES------------------------------>//
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+//<-------------------------------------------------------------------->//
+
+namespace Benchmark
+{
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Collects durations of single operations in nanoseconds.
+     */
+    class Samples
+    {
+    private:
+        std::vector<std::uint32_t> values;
+
+    public:
+        void reserve(const std::size_t count) { values.reserve(count); }
+
+        void add(const Clock::time_point start, const Clock::time_point stop)
+        {
+            values.push_back(static_cast<std::uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count()));
+        }
+
+        double mean() const
+        {
+            if (values.empty()) { return 0.0; }
+            std::uint64_t sum{ 0 };
+            for (const std::uint32_t value : values) { sum += value; }
+            return static_cast<double>(sum) / static_cast<double>(values.size());
+        }
+
+        /// Percentile from 0 to 100, 100 being the worst case.
+        std::uint32_t percentile(const double percent) const
+        {
+            if (values.empty()) { return 0; }
+            std::vector<std::uint32_t> sorted{ values };
+            std::sort(sorted.begin(), sorted.end());
+            const std::size_t index{ static_cast<std::size_t>(percent / 100.0 * static_cast<double>(sorted.size() - 1)) };
+            return sorted[index];
+        }
+    };
+
+    /**
+     * @brief Print one result line: mean, p99, p99.9 and worst case.
+     *
+     * The worst case of a host run includes preemption by the OS, p99.9 is the better
+     * indication of an algorithm's bound.
+     */
+    inline void print(const char* name, const Samples& samples)
+    {
+        std::printf("  %-28s mean %7.1f ns   p99 %6u ns   p99.9 %6u ns   max %7u ns\n", name, samples.mean(),
+                    samples.percentile(99.0), samples.percentile(99.9), samples.percentile(100.0));
+    }
+};
+
+#endif // __BENCHMARK_H__
@@ -0,0 +1,94 @@
+#include "Benchmark.hh"
+#include <DriverError.hh>
+#include <cstdint>
+#include <cstdio>
+
+/*
+ * Cost of reporting a driver error with DriverStatus compared to throwing it.
+ *
+ * The benchmark executable keeps exceptions enabled, only for this comparison: the
+ * library itself builds with -fno-exceptions. Each call goes through a non-inlined
+ * "init" validating one parameter and writing one register, three calls deep, as a
+ * driver init calling its helpers would. The failure path is what matters for the worst
+ * case: a Result costs the same as success, a throw walks the unwind tables of every frame.
+ */
+
+namespace
+{
+    volatile std::uint32_t fakeRegister{ 0 };
+    constexpr std::uint32_t limit{ 15 };
+
+    __attribute__((noinline)) DriverStatus writeChecked(const std::uint32_t value)
+    {
+        if (value > limit) { return Utils::fail(DriverError::invalidParameter); }
+        fakeRegister = value;
+        return {};
+    }
+
+    __attribute__((noinline)) DriverStatus configureChecked(const std::uint32_t value)
+    {
+        RESULT_TRY(writeChecked(value));
+        return writeChecked(value / 2);
+    }
+
+    __attribute__((noinline)) DriverStatus initChecked(const std::uint32_t value)
+    {
+        RESULT_TRY(configureChecked(value));
+        fakeRegister = 1;
+        return {};
+    }
+
+    __attribute__((noinline)) void writeThrowing(const std::uint32_t value)
+    {
+        if (value > limit) { throw DriverError::invalidParameter; }
+        fakeRegister = value;
+    }
+
+    __attribute__((noinline)) void configureThrowing(const std::uint32_t value)
+    {
+        writeThrowing(value);
+        writeThrowing(value / 2);
+    }
+
+    __attribute__((noinline)) void initThrowing(const std::uint32_t value)
+    {
+        configureThrowing(value);
+        fakeRegister = 1;
+    }
+
+    constexpr std::size_t iterations{ 200000 };
+
+    void measure(const char* name, const std::uint32_t value, const bool throwing)
+    {
+        Benchmark::Samples samples;
+        samples.reserve(iterations);
+        std::size_t failures{ 0 };
+        for (std::size_t iteration = 0; iteration < iterations; ++iteration) {
+            const auto start{ Benchmark::Clock::now() };
+            if (throwing) {
+                try {
+                    initThrowing(value);
+                } catch (const DriverError&) {
+                    ++failures;
+                }
+            } else if (!initChecked(value)) {
+                ++failures;
+            }
+            samples.add(start, Benchmark::Clock::now());
+        }
+        Benchmark::print(name, samples);
+        if (failures != 0 && failures != iterations) { std::printf("  unexpected failure count %zu\n", failures); }
+    }
+};
+
+void runErrorBenchmark()
+{
+    std::printf("=== Driver error reporting: DriverStatus vs exceptions ===\n");
+    std::printf("Success path\n");
+    measure("DriverStatus", 7, false);
+    measure("exception", 7, true);
+    std::printf("Failure path, error raised 3 frames deep\n");
+    measure("DriverStatus", 40, false);
+    measure("exception", 40, true);
+    std::printf("\n");
+}
@@ -0,0 +1,137 @@
+#include "Benchmark.hh"
+#include <Offload.hh>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <vector>
+
+/*
+ * Discrete-event simulation of the CM7 feeding jobs to the CM4, in CM7 cycles.
+ *
+ * Bursts of jobs arrive at the CM7 every period. Each job is either run by the CM7 or
+ * submitted (a fixed submission cost on the CM7, half the transfer cost each way) to the
+ * CM4, which serves its queue in order at half the CM7 clock. Three strategies decide:
+ *  - local: everything on the CM7.
+ *  - offload all: everything to the CM4 while fewer than maxDepth jobs are in flight.
+ *  - adaptive: OffloadStats::shouldOffload(), fed with the simulated timings the way
+ *    OffloadClient feeds it with measured ones.
+ * Reported per scenario: CM7 busy share, share of offloaded jobs, mean and p99 latency
+ * from arrival to completion. The figures are properties of the policy, not host timings.
+ */
+
+namespace
+{
+    enum : std::uint16_t { heavyJob, lightJob, functionCount };
+
+    enum class Strategy : std::uint8_t { local, offloadAll, adaptive };
+
+    struct Workload {
+        const char* name;
+        std::uint32_t period;               ///< Cycles between bursts.
+        std::uint32_t burst;                ///< Jobs per burst, one light job out of lightEvery.
+        std::uint32_t lightEvery;
+    };
+
+    constexpr std::uint32_t heavyLocalCycles{ 6000 };
+    constexpr std::uint32_t heavyWorkerCycles{ 4000 };      // 8000 CM7 cycles
+    constexpr std::uint32_t lightLocalCycles{ 200 };
+    constexpr std::uint32_t lightWorkerCycles{ 150 };
+    constexpr std::uint32_t submitCycles{ 150 };
+    constexpr std::uint32_t bursts{ 2000 };
+
+    struct Pending {
+        std::uint64_t done;
+        std::uint16_t function;
+        std::uint32_t workerCycles;
+        std::uint32_t latency;
+        std::uint32_t estimate;
+    };
+
+    void simulate(const Workload& workload, const Strategy strategy, const char* strategyName)
+    {
+        const Ipc::OffloadPolicy policy{};
+        Ipc::OffloadStats<functionCount> stats{ policy };
+        std::deque<Pending> pending;
+        std::vector<std::uint32_t> latencies;
+        latencies.reserve(static_cast<std::size_t>(bursts) * workload.burst);
+
+        std::uint64_t cm7Free{ 0 };
+        std::uint64_t cm4Free{ 0 };
+        std::uint64_t cm7Busy{ 0 };
+        std::uint32_t offloaded{ 0 };
+        std::uint32_t seed{ 12345 };
+
+        const auto complete = [&](const std::uint64_t now) {
+            while (!pending.empty() && pending.front().done <= now) {
+                const Pending& job{ pending.front() };
+                stats.recordCompletion(job.function, job.workerCycles, job.latency, job.estimate);
+                pending.pop_front();
+            }
+        };
+
+        for (std::uint32_t burst = 0; burst < bursts; ++burst) {
+            // Up to 1/8 period of jitter on the arrival of the burst
+            seed = seed * 1664525U + 1013904223U;
+            const std::uint64_t arrival{ static_cast<std::uint64_t>(burst) * workload.period + (seed >> 8) % (workload.period / 8 + 1) };
+            for (std::uint32_t index = 0; index < workload.burst; ++index) {
+                const bool light{ workload.lightEvery != 0 && index % workload.lightEvery == 0 };
+                const std::uint16_t function{ light ? lightJob : heavyJob };
+                const std::uint32_t localCycles{ light ? lightLocalCycles : heavyLocalCycles };
+                const std::uint32_t workerCycles{ light ? lightWorkerCycles : heavyWorkerCycles };
+
+                const std::uint64_t start{ std::max(cm7Free, arrival) };
+                complete(start);
+                bool offload{ false };
+                switch (strategy) {
+                    case Strategy::local: break;
+                    case Strategy::offloadAll: offload = stats.depth() < policy.maxDepth; break;
+                    case Strategy::adaptive: offload = stats.shouldOffload(function); break;
+                }
+
+                if (offload) {
+                    cm7Free = start + submitCycles;
+                    cm7Busy += submitCycles;
+                    const std::uint64_t queued{ cm7Free + policy.transferCycles / 2 };
+                    cm4Free = std::max(cm4Free, queued) + stats.toClientCycles(workerCycles);
+                    const std::uint64_t done{ cm4Free + policy.transferCycles / 2 };
+                    const std::uint32_t latency{ static_cast<std::uint32_t>(done - arrival) };
+                    pending.push_back(Pending{ done, function, workerCycles, latency, stats.recordSubmit(function) });
+                    latencies.push_back(latency);
+                    ++offloaded;
+                } else {
+                    cm7Free = start + localCycles;
+                    cm7Busy += localCycles;
+                    stats.recordLocal(function, localCycles);
+                    latencies.push_back(static_cast<std::uint32_t>(cm7Free - arrival));
+                }
+            }
+        }
+        complete(~std::uint64_t{ 0 });
+
+        const std::uint64_t span{ std::max(cm7Free, cm4Free) };
+        std::uint64_t sum{ 0 };
+        for (const std::uint32_t latency : latencies) { sum += latency; }
+        std::sort(latencies.begin(), latencies.end());
+        std::printf("  %-10s %-12s CM7 busy %5.1f %%   offloaded %5.1f %%   latency mean %8.0f   p99 %8u cycles\n", workload.name,
+                    strategyName, 100.0 * static_cast<double>(cm7Busy) / static_cast<double>(span),
+                    100.0 * offloaded / static_cast<double>(latencies.size()), static_cast<double>(sum) / static_cast<double>(latencies.size()),
+                    latencies[latencies.size() * 99 / 100]);
+    }
+
+    void compare(const Workload& workload)
+    {
+        simulate(workload, Strategy::local, "local");
+        simulate(workload, Strategy::offloadAll, "offload all");
+        simulate(workload, Strategy::adaptive, "adaptive");
+    }
+};
+
+void runOffloadBenchmark()
+{
+    std::printf("=== CM7 to CM4 offload, simulated scheduling (CM7 cycles) ===\n");
+    compare(Workload{ "light load", 40000, 2, 2 });
+    compare(Workload{ "bursty", 60000, 8, 4 });
+    compare(Workload{ "saturated", 40000, 8, 0 });
+    std::printf("\n");
+}
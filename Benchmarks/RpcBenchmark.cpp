@@ -0,0 +1,139 @@
+#include "Benchmark.hh"
+#include <Rpc.hh>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+/*
+ * Inter-core RPC modeled with two host threads, the client and the server.
+ *
+ * For 8 B, 256 B and 4 KB payloads, three round trips are timed:
+ *  - rpc, one thread: client and server polled in turn by the same thread, the cost
+ *    of the framework alone (slot, envelopes, correlation, dispatch).
+ *  - rpc, two threads: the request is built in the shared slot, only envelopes cross.
+ *  - copy, two threads: the same exchange with the payloads copied through SpscRings,
+ *    the way a serializing transport moves them.
+ * The handler reads the whole request and writes the whole response in every case. On a
+ * host with a single CPU every two-thread hand-over is a context switch.
+ */
+
+namespace
+{
+    template<std::size_t Size>
+    struct Blob {
+        std::uint8_t bytes[Size];
+    };
+
+    enum class Echo : std::uint8_t { small, medium, large };
+    using Requests = Utils::TypeList<pair<Echo::small, Blob<8>>, pair<Echo::medium, Blob<256>>, pair<Echo::large, Blob<4096>>>;
+    using Channel = Ipc::RpcChannel<Ipc::RpcSchema<Requests, Requests>, 4>;
+    Channel channel;
+
+    using CopyRing = Ipc::SpscRing<16384>;
+    CopyRing forward;
+    CopyRing backward;
+
+    constexpr std::size_t iterations{ 2000 };
+
+    // Reads every byte of the request, writes every byte of the response
+    void transform(const std::uint8_t* __restrict request, std::uint8_t* __restrict response, const std::size_t size)
+    {
+        for (std::size_t index = 0; index < size; ++index) { response[index] = static_cast<std::uint8_t>(request[index] + 1); }
+    }
+
+    template<std::size_t Size>
+    void echo(const Blob<Size>& request, Blob<Size>& response) { transform(request.bytes, response.bytes, Size); }
+
+    template<Echo Method, std::size_t Size>
+    void rpcRoundTrip(Ipc::RpcClient<Channel>& client, Ipc::RpcServer<Channel>* server, Benchmark::Samples& samples)
+    {
+        const auto start{ Benchmark::Clock::now() };
+        const auto call{ client.prepare<Method>().value() };
+        std::memset(client.request(call).bytes, 1, Size);
+        static_cast<void>(client.send(call));
+        if (server != nullptr) { server->poll(); }
+        const auto response{ client.wait(call) };
+        volatile std::uint8_t last{ response.value()->bytes[Size - 1] };
+        static_cast<void>(last);
+        client.release(call);
+        samples.add(start, Benchmark::Clock::now());
+    }
+
+    template<Echo Method, std::size_t Size>
+    void measure()
+    {
+        char name[40];
+        Ipc::RpcServer<Channel> server{ channel };
+        server.bind<Echo::small, &echo<8>>();
+        server.bind<Echo::medium, &echo<256>>();
+        server.bind<Echo::large, &echo<4096>>();
+
+        {
+            channel.reset();
+            Ipc::RpcClient<Channel> client{ channel };
+            Benchmark::Samples samples;
+            samples.reserve(iterations);
+            for (std::size_t index = 0; index < iterations; ++index) { rpcRoundTrip<Method, Size>(client, &server, samples); }
+            std::snprintf(name, sizeof(name), "rpc one thread %zu B", Size);
+            Benchmark::print(name, samples);
+        }
+
+        {
+            channel.reset();
+            std::thread serverThread([&] {
+                std::size_t served{ 0 };
+                while (served < iterations) {
+                    channel.requests.waitForData();
+                    served += server.poll();
+                }
+            });
+            Ipc::RpcClient<Channel> client{ channel };
+            Benchmark::Samples samples;
+            samples.reserve(iterations);
+            for (std::size_t index = 0; index < iterations; ++index) { rpcRoundTrip<Method, Size>(client, nullptr, samples); }
+            serverThread.join();
+            std::snprintf(name, sizeof(name), "rpc two threads %zu B", Size);
+            Benchmark::print(name, samples);
+        }
+
+        {
+            forward.reset();
+            backward.reset();
+            std::thread serverThread([&] {
+                std::uint8_t request[Size];
+                std::uint8_t response[Size];
+                for (std::size_t index = 0; index < iterations; ++index) {
+                    forward.waitForData();
+                    static_cast<void>(forward.pop(request, sizeof(request)));
+                    transform(request, response, Size);
+                    while (!backward.push(response, sizeof(response))) { std::this_thread::yield(); }
+                }
+            });
+            std::uint8_t request[Size];
+            std::uint8_t response[Size];
+            Benchmark::Samples samples;
+            samples.reserve(iterations);
+            for (std::size_t index = 0; index < iterations; ++index) {
+                const auto start{ Benchmark::Clock::now() };
+                std::memset(request, 1, Size);
+                while (!forward.push(request, sizeof(request))) { std::this_thread::yield(); }
+                backward.waitForData();
+                static_cast<void>(backward.pop(response, sizeof(response)));
+                samples.add(start, Benchmark::Clock::now());
+            }
+            serverThread.join();
+            std::snprintf(name, sizeof(name), "copy two threads %zu B", Size);
+            Benchmark::print(name, samples);
+        }
+    }
+};
+
+void runRpcBenchmark()
+{
+    std::printf("=== Inter-core RPC round trip, host two-thread model (%u CPUs) ===\n", std::thread::hardware_concurrency());
+    measure<Echo::small, 8>();
+    measure<Echo::medium, 256>();
+    measure<Echo::large, 4096>();
+    std::printf("\n");
+}
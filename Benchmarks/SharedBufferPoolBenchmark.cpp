@@ -0,0 +1,139 @@
+#include "Benchmark.hh"
+#include <SharedBufferPool.hh>
+#include <SpscRing.hh>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+/*
+ * Shared buffer pool, host model of the two cores with two threads.
+ *
+ *  - allocate + release: one pair, uncontended then with a second thread doing the same.
+ *  - frame throughput: a producer fills frames, a consumer reads every word of them.
+ *    "handles" passes pool blocks through an SpscRing, "copy" pushes the frames themselves
+ *    through a ring, the way it is done without the pool.
+ */
+
+namespace
+{
+    using Pool = Ipc::SharedBufferPool<1536, 32, Ipc::HsemSpinLock<7>>;
+    Pool pool;
+    using Ring = Ipc::SpscRing<16384>;
+    Ring ring;
+
+    constexpr std::size_t pairs{ 200000 };
+
+    void allocateRelease(const bool contended)
+    {
+        pool.reset();
+        std::atomic<bool> stop{ false };
+        std::thread other;
+        if (contended) {
+            other = std::thread([&] {
+                while (!stop.load(std::memory_order_relaxed)) {
+                    const auto handle{ pool.allocate() };
+                    if (handle) { static_cast<void>(pool.release(handle.value())); }
+                }
+            });
+        }
+        Benchmark::Samples samples;
+        samples.reserve(pairs);
+        for (std::size_t index = 0; index < pairs; ++index) {
+            const auto start{ Benchmark::Clock::now() };
+            const auto handle{ pool.allocate() };
+            if (handle) { static_cast<void>(pool.release(handle.value())); }
+            samples.add(start, Benchmark::Clock::now());
+        }
+        stop.store(true);
+        if (other.joinable()) { other.join(); }
+        Benchmark::print(contended ? "allocate + release, 2 threads" : "allocate + release", samples);
+    }
+
+    void report(const char* name, const std::size_t size, const std::size_t count, const Benchmark::Clock::time_point start, const bool ok)
+    {
+        const double seconds{ std::chrono::duration<double>(Benchmark::Clock::now() - start).count() };
+        std::printf("  %-8s %5zu B  %9.0f frames/s  %8.1f MB/s  (checksum %s)\n", name, size, static_cast<double>(count) / seconds,
+                    static_cast<double>(count * size) / seconds / 1e6, ok ? "ok" : "BAD");
+    }
+
+    std::uint32_t readFrame(const std::uint8_t* frame, const std::size_t size)
+    {
+        std::uint32_t sum{ 0 };
+        for (std::size_t index = 0; index < size; index += 4) { sum += frame[index]; }
+        return sum;
+    }
+
+    void throughputHandles(const std::size_t size, const std::size_t count)
+    {
+        pool.reset();
+        ring.reset();
+        std::uint32_t checksum{ 0 };
+        std::thread consumer([&] {
+            std::uint32_t sum{ 0 };
+            for (std::size_t received = 0; received < count;) {
+                Ipc::BufferHandle handle;
+                if (ring.pop(&handle, sizeof(handle)) != sizeof(handle)) {
+                    ring.waitForData();
+                    continue;
+                }
+                pool.receive(handle, size);
+                sum += readFrame(pool.data(handle), size);
+                static_cast<void>(pool.release(handle));
+                ++received;
+            }
+            checksum = sum;
+        });
+
+        const auto start{ Benchmark::Clock::now() };
+        for (std::size_t sent = 0; sent < count; ++sent) {
+            auto handle{ pool.allocate() };
+            while (!handle) {
+                std::this_thread::yield();
+                handle = pool.allocate();
+            }
+            std::memset(pool.data(handle.value()), 1, size);
+            pool.publish(handle.value(), size);
+            while (!ring.push(&handle.value(), sizeof(Ipc::BufferHandle))) { std::this_thread::yield(); }
+        }
+        consumer.join();
+        report("handles", size, count, start, checksum == count * ((size + 3) / 4));
+    }
+
+    void throughputCopy(const std::size_t size, const std::size_t count)
+    {
+        ring.reset();
+        std::uint32_t checksum{ 0 };
+        std::thread consumer([&] {
+            std::uint32_t sum{ 0 };
+            std::uint8_t frame[1536];
+            for (std::size_t received = 0; received < count; ++received) {
+                ring.waitForData();
+                const std::size_t length{ ring.pop(frame, sizeof(frame)) };
+                sum += readFrame(frame, length);
+            }
+            checksum = sum;
+        });
+
+        std::uint8_t frame[1536];
+        const auto start{ Benchmark::Clock::now() };
+        for (std::size_t sent = 0; sent < count; ++sent) {
+            std::memset(frame, 1, size);
+            while (!ring.push(frame, size)) { std::this_thread::yield(); }
+        }
+        consumer.join();
+        report("copy", size, count, start, checksum == count * ((size + 3) / 4));
+    }
+};
+
+void runSharedBufferPoolBenchmark()
+{
+    std::printf("=== Shared buffer pool, host two-thread model (%u CPUs) ===\n", std::thread::hardware_concurrency());
+    allocateRelease(false);
+    allocateRelease(true);
+    for (const std::size_t size : { 256, 1536 }) {
+        throughputHandles(size, 200000);
+        throughputCopy(size, 200000);
+    }
+    std::printf("\n");
+}
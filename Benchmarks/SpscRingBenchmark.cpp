@@ -0,0 +1,96 @@
+#include "Benchmark.hh"
+#include <SpscRing.hh>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+/*
+ * Inter-core ring modeled with two host threads: one producer, one consumer.
+ *
+ * Throughput: the producer copies messages in with push(), the consumer reads them in
+ * place with front()/pop() and sums one byte per word so the payload is really read.
+ * Latency: ping-pong over two rings, the figure printed is the round trip. On a host
+ * with a single CPU both threads share it and every hand-over is a context switch, so
+ * the round trip measures the scheduler rather than the ring.
+ */
+
+namespace
+{
+    using Ring = Ipc::SpscRing<16384>;
+    Ring forward;
+    Ring backward;
+
+    constexpr std::size_t messageSizes[]{ 4, 16, 64, 256, 1024, 4096 };
+
+    void throughput(const std::size_t size)
+    {
+        forward.reset();
+        const std::size_t count{ std::min<std::size_t>(200000, (32U << 20) / size) };
+        std::uint32_t checksum{ 0 };
+
+        std::thread consumer([&] {
+            std::uint32_t sum{ 0 };
+            for (std::size_t received = 0; received < count; ++received) {
+                forward.waitForData();
+                const Ring::Message message{ forward.front() };
+                for (std::size_t index = 0; index < message.size; index += 4) { sum += message.data[index]; }
+                forward.pop();
+            }
+            checksum = sum;
+        });
+
+        std::uint8_t payload[4096];
+        std::memset(payload, 1, sizeof(payload));
+        const auto start{ Benchmark::Clock::now() };
+        for (std::size_t sent = 0; sent < count; ++sent) {
+            while (!forward.push(payload, size)) { std::this_thread::yield(); }
+        }
+        consumer.join();
+        const double seconds{ std::chrono::duration<double>(Benchmark::Clock::now() - start).count() };
+        std::printf("  %5zu B  %9.0f msg/s  %8.1f MB/s  (checksum %s)\n", size, static_cast<double>(count) / seconds,
+                    static_cast<double>(count * size) / seconds / 1e6, checksum == count * ((size + 3) / 4) ? "ok" : "BAD");
+    }
+
+    void roundTrip(const std::size_t size)
+    {
+        forward.reset();
+        backward.reset();
+        constexpr std::size_t count{ 2000 };
+
+        std::thread echo([&] {
+            std::uint8_t buffer[4096];
+            for (std::size_t index = 0; index < count; ++index) {
+                forward.waitForData();
+                const std::size_t received{ forward.pop(buffer, sizeof(buffer)) };
+                while (!backward.push(buffer, received)) { std::this_thread::yield(); }
+            }
+        });
+
+        std::uint8_t payload[4096]{};
+        std::uint8_t reply[4096];
+        Benchmark::Samples samples;
+        samples.reserve(count);
+        for (std::size_t index = 0; index < count; ++index) {
+            const auto start{ Benchmark::Clock::now() };
+            forward.push(payload, size);
+            backward.waitForData();
+            static_cast<void>(backward.pop(reply, sizeof(reply)));
+            samples.add(start, Benchmark::Clock::now());
+        }
+        echo.join();
+        char name[32];
+        std::snprintf(name, sizeof(name), "round trip %zu B", size);
+        Benchmark::print(name, samples);
+    }
+};
+
+void runSpscRingBenchmark()
+{
+    std::printf("=== Inter-core SPSC ring, host two-thread model (%u CPUs) ===\n", std::thread::hardware_concurrency());
+    std::printf("Throughput, 16 KB ring\n");
+    for (const std::size_t size : messageSizes) { throughput(size); }
+    std::printf("Latency\n");
+    for (const std::size_t size : messageSizes) { roundTrip(size); }
+    std::printf("\n");
+}
@@ -0,0 +1,187 @@
+#include "Benchmark.hh"
+#include <TlsfHeap.hh>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+using Memory::TlsfHeap;
+
+namespace
+{
+    /**
+     * @brief Model of the newlib-nano allocator (nano-mallocr.c): one address ordered
+     * free list searched first fit, chunks split from the tail, merged on release,
+     * growing from a bump pointer when no free chunk fits.
+     */
+    class FirstFitHeap
+    {
+    private:
+        struct Chunk {
+            std::size_t size;
+            Chunk* next;
+        };
+
+        static constexpr std::size_t header{ 2 * sizeof(void*) };
+        static constexpr std::size_t minChunk{ header + sizeof(Chunk) };
+
+        std::uint8_t* top;
+        std::uint8_t* limit;
+        Chunk* freeList{ nullptr };
+
+    public:
+        /// Longest free list walk of one call: the first fit worst case grows with fragmentation.
+        std::size_t longestSearch{ 0 };
+
+    private:
+
+        static void mergeWithNext(Chunk* chunk)
+        {
+            if (chunk->next != nullptr && reinterpret_cast<std::uint8_t*>(chunk) + chunk->size == reinterpret_cast<std::uint8_t*>(chunk->next)) {
+                chunk->size += chunk->next->size;
+                chunk->next = chunk->next->next;
+            }
+        }
+
+    public:
+        FirstFitHeap(std::uint8_t* memory, const std::size_t size) : top{ memory }, limit{ memory + size } {}
+
+        void* allocate(const std::size_t size)
+        {
+            std::size_t need{ (size + header + header - 1) & ~(header - 1) };
+            if (need < minChunk) { need = minChunk; }
+            Chunk** link{ &freeList };
+            std::size_t visited{ 0 };
+            for (Chunk* chunk = freeList; chunk != nullptr; link = &chunk->next, chunk = chunk->next) {
+                if (++visited > longestSearch) { longestSearch = visited; }
+                if (chunk->size < need) { continue; }
+                if (chunk->size - need >= minChunk) {
+                    chunk->size -= need;
+                    Chunk* taken{ reinterpret_cast<Chunk*>(reinterpret_cast<std::uint8_t*>(chunk) + chunk->size) };
+                    taken->size = need;
+                    return reinterpret_cast<std::uint8_t*>(taken) + header;
+                }
+                *link = chunk->next;
+                return reinterpret_cast<std::uint8_t*>(chunk) + header;
+            }
+            if (top + need > limit) { return nullptr; }
+            Chunk* chunk{ reinterpret_cast<Chunk*>(top) };
+            chunk->size = need;
+            top += need;
+            return reinterpret_cast<std::uint8_t*>(chunk) + header;
+        }
+
+        void deallocate(void* pointer)
+        {
+            if (pointer == nullptr) { return; }
+            Chunk* chunk{ reinterpret_cast<Chunk*>(static_cast<std::uint8_t*>(pointer) - header) };
+            if (freeList == nullptr || chunk < freeList) {
+                chunk->next = freeList;
+                freeList = chunk;
+                mergeWithNext(chunk);
+                return;
+            }
+            Chunk* previous{ freeList };
+            std::size_t visited{ 1 };
+            while (previous->next != nullptr && previous->next < chunk) {
+                previous = previous->next;
+                ++visited;
+            }
+            if (visited > longestSearch) { longestSearch = visited; }
+            chunk->next = previous->next;
+            previous->next = chunk;
+            mergeWithNext(chunk);
+            mergeWithNext(previous);
+        }
+    };
+
+    struct Operation {
+        bool allocate;
+        std::size_t value;      // Size to allocate, or index of the live block to release
+    };
+
+    /**
+     * @brief Steady state trace: allocations and releases keeping about liveTarget blocks alive.
+     * @param largeShare One allocation in largeShare is a buffer of 1 to 8 KB, 0 for none.
+     */
+    std::vector<Operation> makeTrace(const std::size_t count, const std::size_t liveTarget, const std::size_t minSize,
+                                     const std::size_t maxSize, const std::uint32_t largeShare, const std::uint32_t seed)
+    {
+        std::mt19937 random{ seed };
+        std::vector<Operation> trace;
+        std::size_t live{ 0 };
+        for (std::size_t step = 0; step < count; ++step) {
+            const bool allocate{ live == 0 || (live < liveTarget ? random() % 4 != 0 : random() % 4 == 0) };
+            if (allocate) {
+                std::size_t size{ minSize + random() % (maxSize - minSize + 1) };
+                if (largeShare != 0 && random() % largeShare == 0) { size = 1024 + random() % (7 * 1024); }
+                trace.push_back(Operation{ true, size });
+                ++live;
+            } else {
+                trace.push_back(Operation{ false, random() % live });
+                --live;
+            }
+        }
+        return trace;
+    }
+
+    template<typename Allocate, typename Release>
+    void replay(const char* name, const std::vector<Operation>& trace, Allocate allocate, Release release)
+    {
+        Benchmark::Samples allocations;
+        Benchmark::Samples releases;
+        allocations.reserve(trace.size());
+        releases.reserve(trace.size());
+        std::vector<void*> live;
+        std::size_t failed{ 0 };
+        for (const Operation& operation : trace) {
+            if (operation.allocate) {
+                const auto start{ Benchmark::Clock::now() };
+                void* pointer{ allocate(operation.value) };
+                allocations.add(start, Benchmark::Clock::now());
+                if (pointer == nullptr) { ++failed; }
+                live.push_back(pointer);
+            } else {
+                void* pointer{ live[operation.value] };
+                live[operation.value] = live.back();
+                live.pop_back();
+                const auto start{ Benchmark::Clock::now() };
+                release(pointer);
+                releases.add(start, Benchmark::Clock::now());
+            }
+        }
+        for (void* pointer : live) { release(pointer); }
+
+        std::printf(" %s (%zu failed allocations)\n", name, failed);
+        Benchmark::print("allocate", allocations);
+        Benchmark::print("release", releases);
+    }
+
+    alignas(16) std::uint8_t arena[256 * 1024];
+
+    void runTrace(const char* title, const std::vector<Operation>& trace)
+    {
+        std::printf("%s, %zu operations\n", title, trace.size());
+        // Fault the arena in so page faults do not end up in the worst cases
+        std::memset(arena, 0, sizeof(arena));
+
+        TlsfHeap tlsf;
+        tlsf.addRegion(arena, sizeof(arena));
+        replay("TLSF", trace, [&](std::size_t size) { return tlsf.allocate(size); }, [&](void* pointer) { tlsf.deallocate(pointer); });
+        const TlsfHeap::Statistics stats{ tlsf.getStatistics() };
+        std::printf("  peak use %zu B of %zu B\n", stats.peakUsedBytes, stats.totalBytes);
+
+        FirstFitHeap firstFit{ arena, sizeof(arena) };
+        replay("first fit (newlib-nano model)", trace, [&](std::size_t size) { return firstFit.allocate(size); }, [&](void* pointer) { firstFit.deallocate(pointer); });
+        std::printf("  longest free list walk %zu chunks (TLSF: 2 bitmap scans)\n", firstFit.longestSearch);
+
+        replay("host malloc", trace, [](std::size_t size) { return std::malloc(size); }, [](void* pointer) { std::free(pointer); });
+        std::printf("\n");
+    }
+};
+
+void runTlsfBenchmark()
+{
+    std::printf("=== TLSF heap vs first fit vs host malloc ===\n");
+    runTrace("Small objects 8-128 B, ~1000 live", makeTrace(200000, 1000, 8, 128, 0, 1));
+    runTrace("Messages 16-256 B + 1 in 16 buffers of 1-8 KB, ~100 live", makeTrace(200000, 100, 16, 256, 16, 2));
+}
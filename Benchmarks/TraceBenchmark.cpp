@@ -0,0 +1,44 @@
+#include "Benchmark.hh"
+#include <Trace.hh>
+#include <cstdint>
+#include <cstdio>
+
+/*
+ * Cost of one trace record, measured over batches of 100 writes so the clock reads do
+ * not dominate. On the target the same path is a DWT read, an LDREX/STREX increment and
+ * four stores.
+ */
+
+namespace
+{
+    Trace::Area<1024> area;
+
+    constexpr std::size_t batches{ 20000 };
+    constexpr std::size_t batchSize{ 100 };
+
+    template<typename Write>
+    void measure(const char* name, Write write)
+    {
+        Benchmark::Samples samples;
+        samples.reserve(batches);
+        for (std::size_t batch = 0; batch < batches; ++batch) {
+            const auto start{ Benchmark::Clock::now() };
+            for (std::size_t index = 0; index < batchSize; ++index) { write(static_cast<std::uint32_t>(index)); }
+            samples.add(start, start + (Benchmark::Clock::now() - start) / batchSize);
+        }
+        Benchmark::print(name, samples);
+    }
+};
+
+void runTraceBenchmark()
+{
+    std::printf("=== Trace log, cost per record (host) ===\n");
+    area.cm7.reset(1000000000);
+    measure("instant", [](const std::uint32_t value) { area.cm7.instant(1, value); });
+    measure("begin + end", [](const std::uint32_t value) { Trace::Scope scope{ area.cm7, 2, value }; });
+    measure("clock read alone", [](const std::uint32_t) {
+        volatile std::uint32_t cycles{ CycleCounter::now() };
+        static_cast<void>(cycles);
+    });
+    std::printf("\n");
+}
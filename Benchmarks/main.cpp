@@ -0,0 +1,23 @@
+void runTlsfBenchmark();
+void runErrorBenchmark();
+void runSpscRingBenchmark();
+void runRpcBenchmark();
+void runOffloadBenchmark();
+void runSharedBufferPoolBenchmark();
+void runTraceBenchmark();
+void runAsyncMemoryBenchmark();
+void runDma2dBenchmark();
+
+int main(void)
+{
+    runTlsfBenchmark();
+    runErrorBenchmark();
+    runSpscRingBenchmark();
+    runRpcBenchmark();
+    runOffloadBenchmark();
+    runSharedBufferPoolBenchmark();
+    runTraceBenchmark();
+    runAsyncMemoryBenchmark();
+    runDma2dBenchmark();
+    return 0;
+}
@@ -0,0 +1,437 @@
+#ifndef __BDMA_H__
+#define __BDMA_H__
+
+/**
+ * @file Bdma.hh
+ * @brief BDMA channel driver for the D3 domain, DMAMUX2 routing and a double-buffered SRAM4 capture.
+ *
+ * The BDMA serves the D3 peripherals (LPUART1, SPI6, I2C4, SAI4, ADC3) and only reaches
+ * SRAM4: start() refuses any buffer elsewhere. Each BdmaChannelHandler drives one of the
+ * 8 channels and the DMAMUX2 channel of the same number. The register model is the one of
+ * the DMA1/DMA2 streams without FIFO and bursts (see Dma.hh): normal, circular and
+ * double-buffer modes, flags in one ISR/IFCR pair, 4 bits per channel.
+ *
+ * BdmaCapture is the low-power receive path: the channel fills two SRAM4 blocks of Items
+ * data items in turn (double-buffer mode) and only the transfer complete interrupt is
+ * enabled, so the cores wake once per full block instead of once per item or half
+ * buffer. The core taking the interrupt may forward the wakeup to the other one with the
+ * Wakeup policy (see Wakeup.hh). The consumer reads a block with front() while the
+ * channel fills the other one and gives it back with pop(); a block the channel got
+ * back to before pop() is an overrun, counted and reported by pop().
+ *
+ * Keeping the capture running while D1 and D2 sleep: Bdma::runAutonomously() keeps the
+ * BDMA, SRAM4 and the listed D3 peripherals clocked in the D3 autonomous mode and D3 in
+ * Run whatever the cores do. A core in Sleep wakes on the BDMA channel interrupt; a core
+ * in Stop needs the interrupt routed as a wakeup through its EXTI.
+ *
+ * SRAM4 is non-cacheable in the boot MPU plan (Mpu.hh), blocks need no cache maintenance.
+ *
+ * Usage example:
+ * ```
+ * SRAM4_SHARED BdmaCapture<std::uint16_t, 256, Ipc::SevWakeup> adcCapture;
+ *
+ * Bdma::init();
+ * Bdma::runAutonomously<Bdma::D3Peripheral::adc3>();
+ * adcCapture.start(Bdma::channel<0>(), Bdma::Request::adc3, reinterpret_cast<std::uint32_t>(&ADC3->DR));
+ * extern "C" void BDMA_Channel0_IRQHandler() { Bdma::channel<0>().handleInterrupt(); }
+ *
+ * // consumer: sleeps until a block is full
+ * const auto ready = [] { return adcCapture.front().isValid(); };
+ * while (!ready()) { Ipc::SevWakeup::wait(ready); }
+ * process(adcCapture.front().data, adcCapture.front().items);
+ * adcCapture.pop();
+ * ```
+ */
+
+//<------------------------------INCLUDES------------------------------>//
+#include <atomic>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <PeripheralBaseHandler.hh>
+#include <DriverError.hh>
+#include <MemorySections.hh>
+#include <DmaChannel.hh>
+#include <Wakeup.hh>
+#if defined(CORE_CM7) || defined(CORE_CM4)
+#include <stm32h755xx.h>
+#endif
+//<-------------------------------------------------------------------->//
+
+namespace Bdma
+{
+    inline constexpr std::uint8_t channelCount{ 8 };
+
+    // CCR
+    inline constexpr std::uint32_t enablePos{ 0 };
+    inline constexpr std::uint32_t transferCompleteInterruptPos{ 1 };
+    inline constexpr std::uint32_t halfTransferInterruptPos{ 2 };
+    inline constexpr std::uint32_t transferErrorInterruptPos{ 3 };
+    inline constexpr std::uint32_t directionPos{ 4 };
+    inline constexpr std::uint32_t circularPos{ 5 };
+    inline constexpr std::uint32_t peripheralIncrementPos{ 6 };
+    inline constexpr std::uint32_t memoryIncrementPos{ 7 };
+    inline constexpr std::uint32_t peripheralSizePos{ 8 };
+    inline constexpr std::uint32_t memorySizePos{ 10 };
+    inline constexpr std::uint32_t priorityPos{ 12 };
+    inline constexpr std::uint32_t doubleBufferPos{ 15 };
+    inline constexpr std::uint32_t currentTargetPos{ 16 };
+
+    // Flags of one channel in ISR and IFCR, relative to its group
+    inline constexpr std::uint32_t globalFlag{ 1U << 0 };
+    inline constexpr std::uint32_t transferCompleteFlag{ 1U << 1 };
+    inline constexpr std::uint32_t halfTransferFlag{ 1U << 2 };
+    inline constexpr std::uint32_t transferErrorFlag{ 1U << 3 };
+    inline constexpr std::uint32_t allFlags{ 0xFU };
+
+    constexpr std::uint32_t flagShift(const std::uint8_t channel) { return 4U * channel; }
+
+    /**
+     * @brief DMAMUX2 request inputs (RM0399, DMAMUX2 request mapping).
+     */
+    enum class Request : std::uint8_t {
+        generator0 = 1, generator1, generator2, generator3, generator4, generator5, generator6, generator7,
+        lpuart1Rx = 9, lpuart1Tx = 10,
+        spi6Rx = 11, spi6Tx = 12,
+        i2c4Rx = 13, i2c4Tx = 14,
+        sai4A = 15, sai4B = 16,
+        adc3 = 17
+    };
+
+    /**
+     * @brief D3 peripherals that can run on the BDMA while the cores sleep.
+     */
+    enum class D3Peripheral : std::uint8_t { lpuart1, spi6, i2c4, sai4, adc3 };
+};
+
+enum class BdmaDirection : std::uint8_t { peripheralToMemory, memoryToPeripheral };
+
+/**
+ * @brief Events reported to the channel callback.
+ */
+enum class BdmaEvent : std::uint8_t {
+    halfTransfer,           ///< Half of the current buffer transferred.
+    transferComplete,       ///< Buffer done; in double-buffer mode the channel already moved to the other one.
+    transferError           ///< Bus error, e.g. a buffer outside SRAM4, the channel is disabled.
+};
+
+/**
+ * @brief Configuration of a channel, fixed for the transfers that follow.
+ */
+struct BdmaConfig {
+    Bdma::Request request{ Bdma::Request::generator0 };
+    BdmaDirection direction{ BdmaDirection::peripheralToMemory };
+    DmaDataSize peripheralSize{ DmaDataSize::byte };
+    DmaDataSize memorySize{ DmaDataSize::byte };
+    bool peripheralIncrement{ false };
+    bool memoryIncrement{ true };
+    DmaMode mode{ DmaMode::normal };
+    DmaPriority priority{ DmaPriority::low };
+    bool halfTransferInterrupt{ false };
+};
+
+enum class BdmaChannelProperties { channel };
+using BdmaChannelPropertiesTypeList = Utils::TypeList<
+    pair<BdmaChannelProperties::channel, std::uint8_t>
+>;
+
+enum class BdmaChannelRegisters { control, count, peripheralAddress, memory0Address, memory1Address, interruptStatus, interruptClear, muxControl };
+using BdmaChannelRegistersTypeList = Utils::TypeList<
+    pair<BdmaChannelRegisters::control, volatile std::uint32_t*>,            // CCR
+    pair<BdmaChannelRegisters::count, volatile std::uint32_t*>,              // CNDTR
+    pair<BdmaChannelRegisters::peripheralAddress, volatile std::uint32_t*>,  // CPAR
+    pair<BdmaChannelRegisters::memory0Address, volatile std::uint32_t*>,     // CM0AR
+    pair<BdmaChannelRegisters::memory1Address, volatile std::uint32_t*>,     // CM1AR
+    pair<BdmaChannelRegisters::interruptStatus, volatile std::uint32_t*>,    // ISR
+    pair<BdmaChannelRegisters::interruptClear, volatile std::uint32_t*>,     // IFCR
+    pair<BdmaChannelRegisters::muxControl, volatile std::uint32_t*>          // DMAMUX2 CxCR
+>;
+
+namespace Bdma
+{
+    /// A BDMA channel for DmaChannelBase, see DmaChannel.hh.
+    struct ChannelLayout {
+        using Config = BdmaConfig;
+        using Event = BdmaEvent;
+        using Registers = BdmaChannelRegisters;
+        using PropertiesList = BdmaChannelPropertiesTypeList;
+        using RegistersList = BdmaChannelRegistersTypeList;
+        static constexpr BdmaChannelProperties index{ BdmaChannelProperties::channel };
+
+        static constexpr std::uint32_t enablePos{ Bdma::enablePos };
+        static constexpr std::uint32_t transferCompleteInterruptPos{ Bdma::transferCompleteInterruptPos };
+        static constexpr std::uint32_t halfTransferInterruptPos{ Bdma::halfTransferInterruptPos };
+        static constexpr std::uint32_t transferErrorInterruptPos{ Bdma::transferErrorInterruptPos };
+        static constexpr std::uint32_t directionPos{ Bdma::directionPos };
+        static constexpr std::uint32_t circularPos{ Bdma::circularPos };
+        static constexpr std::uint32_t peripheralIncrementPos{ Bdma::peripheralIncrementPos };
+        static constexpr std::uint32_t memoryIncrementPos{ Bdma::memoryIncrementPos };
+        static constexpr std::uint32_t peripheralSizePos{ Bdma::peripheralSizePos };
+        static constexpr std::uint32_t memorySizePos{ Bdma::memorySizePos };
+        static constexpr std::uint32_t priorityPos{ Bdma::priorityPos };
+        static constexpr std::uint32_t doubleBufferPos{ Bdma::doubleBufferPos };
+        static constexpr std::uint32_t currentTargetPos{ Bdma::currentTargetPos };
+
+        static constexpr std::uint32_t transferCompleteFlag{ Bdma::transferCompleteFlag };
+        static constexpr std::uint32_t halfTransferFlag{ Bdma::halfTransferFlag };
+        static constexpr std::uint32_t transferErrorFlag{ Bdma::transferErrorFlag };
+        static constexpr std::uint32_t allFlags{ Bdma::allFlags };
+
+        static constexpr std::uint32_t flagShift(const std::uint8_t channel) { return Bdma::flagShift(channel); }
+
+        static constexpr std::array<Dma::FlagEvent<BdmaEvent>, 3> events{ {
+            { Bdma::transferErrorFlag, BdmaEvent::transferError },
+            { Bdma::halfTransferFlag, BdmaEvent::halfTransfer },
+            { Bdma::transferCompleteFlag, BdmaEvent::transferComplete },
+        } };
+    };
+
+    /// CCR value of a configuration, without EN and the interrupt enables.
+    constexpr std::uint32_t controlValue(const BdmaConfig& config) { return Dma::channelControl<ChannelLayout>(config); }
+};
+
+class BdmaChannelHandler : public DmaChannelBase<Bdma::ChannelLayout, BdmaChannelHandler>
+{
+    private:
+        using classParent = DmaChannelBase<Bdma::ChannelLayout, BdmaChannelHandler>;
+        friend classParent;
+
+        /// The memory side of a transfer of bytes per buffer must be in SRAM4.
+        DriverStatus checkBuffers([[maybe_unused]] const std::uint32_t peripheral, const std::uint32_t memory, const std::uint32_t bytes)
+        {
+            const BdmaConfig& config{ configuration() };
+            const std::uint32_t memoryItem{ Dma::bytesOf(config.memorySize) };
+            if (memory % memoryItem != 0) { return Utils::fail(DriverError::invalidParameter); }
+            if (!MemorySections::isBdmaReachable(memory, config.memoryIncrement ? bytes : memoryItem)) { return Utils::fail(DriverError::invalidParameter); }
+            return {};
+        }
+
+    public:
+        /**
+         * @param channel 0 to 7.
+         * @param addresses CCR, CNDTR, CPAR, CM0AR, CM1AR, ISR, IFCR and DMAMUX2 CxCR.
+         */
+        template<typename... RegisterAddress>
+        requires ((Utils::UnsignedIntegralPointerConcept<std::decay_t<RegisterAddress>> && ...))
+        explicit BdmaChannelHandler(const std::uint8_t channel, RegisterAddress&&... addresses)
+            : classParent(this, std::forward<RegisterAddress>(addresses)...) {
+            setParam<BdmaChannelProperties::channel>(channel);
+        }
+
+        template<typename... Handles>
+        explicit BdmaChannelHandler(const std::uint8_t channel, RegisterHandlesTag tag, Handles*... handles)
+            : classParent(this, tag, handles...) {
+            setParam<BdmaChannelProperties::channel>(channel);
+        }
+
+        /**
+         * @brief Route the request and program the channel, which must be stopped.
+         * @param callback Called from handleInterrupt(), nullptr leaves the channel interrupts off.
+         * @return DriverStatus DriverError::busy if the channel is running.
+         */
+        DriverStatus configure(const BdmaConfig& newConfig, const Callback newCallback = nullptr, void* newContext = nullptr)
+        {
+            RESULT_TRY(status());
+            if (static_cast<std::uint8_t>(newConfig.peripheralSize) > static_cast<std::uint8_t>(DmaDataSize::word) ||
+                static_cast<std::uint8_t>(newConfig.memorySize) > static_cast<std::uint8_t>(DmaDataSize::word)) {
+                return Utils::fail(DriverError::invalidParameter);
+            }
+            if (isEnabled()) { return Utils::fail(DriverError::busy); }
+            program(newConfig, Bdma::controlValue(newConfig), 0, newCallback, newContext);
+            return {};
+        }
+};
+
+/**
+ * @brief Continuous peripheral-to-memory capture into two SRAM4 blocks, one wakeup per full block.
+ * @tparam T Data item of the peripheral: 1, 2 or 4 bytes.
+ * @tparam Items Data items per block.
+ * @tparam Wakeup Policy signalled on every full block, for a consumer on the other core.
+ *
+ * The object holds the blocks: declare it SRAM4_SHARED. The interrupt side writes the
+ * count of full blocks, the consumer the count of blocks it gave back, so the two may run
+ * on different cores.
+ */
+template<typename T, std::size_t Items, typename Wakeup = Ipc::NoWakeup>
+class BdmaCapture
+{
+    static_assert(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4, "The BDMA moves bytes, half-words or words");
+    static_assert(Items > 0 && Items <= Dma::maxItems, "A BDMA block holds 1 to 65535 items");
+    static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "BdmaCapture needs lock-free 32-bit atomics");
+
+    public:
+        /// A full block, valid until pop().
+        struct Block {
+            const T* data{ nullptr };
+            std::size_t items{ 0 };
+            std::uint32_t sequence{ 0 };        ///< Blocks filled before this one since start().
+
+            constexpr bool isValid() const { return data != nullptr; }
+        };
+
+        /// Counters since start().
+        struct Statistics {
+            std::uint32_t blocks;               ///< Full blocks, one wakeup each.
+            std::uint32_t overruns;             ///< Blocks overwritten before pop().
+            std::uint32_t errors;               ///< Transfer errors, each stopped the capture.
+        };
+
+    private:
+        alignas(32) std::array<std::array<T, Items>, 2> blocks;
+        std::atomic<std::uint32_t> filled{ 0 };
+        std::atomic<std::uint32_t> consumed{ 0 };
+        std::uint32_t overruns{ 0 };            ///< Written by the consumer only.
+        volatile std::uint32_t errors{ 0 };
+        BdmaChannelHandler* channel{ nullptr };
+
+        static constexpr DmaDataSize sizeOfItem() { return sizeof(T) == 1 ? DmaDataSize::byte : sizeof(T) == 2 ? DmaDataSize::halfWord : DmaDataSize::word; }
+
+        static void onEvent(void* context, const BdmaEvent event, [[maybe_unused]] const std::uint8_t buffer)
+        {
+            auto& self{ *static_cast<BdmaCapture*>(context) };
+            if (event == BdmaEvent::transferError) {
+                self.errors = self.errors + 1;
+            } else {
+                self.filled.store(self.filled.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+            }
+            Wakeup::signal();
+        }
+
+        /// Skip the blocks the channel overwrote since they were filled.
+        std::uint32_t skipOverrun()
+        {
+            const std::uint32_t full{ filled.load(std::memory_order_acquire) };
+            std::uint32_t next{ consumed.load(std::memory_order_relaxed) };
+            if (full - next > 1) {
+                overruns += full - 1 - next;
+                next = full - 1;
+                consumed.store(next, std::memory_order_release);
+            }
+            return full;
+        }
+
+    public:
+        BdmaCapture() = default;
+        BdmaCapture(const BdmaCapture&) = delete;
+        BdmaCapture& operator=(const BdmaCapture&) = delete;
+
+        /**
+         * @brief Configure the channel for the capture and start it.
+         * @param peripheral Data register of the peripheral, e.g. &ADC3->DR.
+         * @param busAddress Address the BDMA sees the object at, 0 for the CPU's; for host models.
+         * @return DriverStatus DriverError::invalidParameter if the object is not in SRAM4.
+         */
+        DriverStatus start(BdmaChannelHandler& newChannel, const Bdma::Request request, const std::uint32_t peripheral,
+                           const DmaPriority priority = DmaPriority::medium, const std::uint32_t busAddress = 0)
+        {
+            const std::uint32_t base{ busAddress != 0 ? busAddress : static_cast<std::uint32_t>(reinterpret_cast<std::uintptr_t>(this)) };
+            const std::uint32_t first{ base + static_cast<std::uint32_t>(reinterpret_cast<std::uintptr_t>(blocks[0].data()) - reinterpret_cast<std::uintptr_t>(this)) };
+            const BdmaConfig config{ .request = request, .peripheralSize = sizeOfItem(), .memorySize = sizeOfItem(),
+                                     .mode = DmaMode::doubleBuffer, .priority = priority };
+            RESULT_TRY(newChannel.configure(config, &onEvent, this));
+            filled.store(0, std::memory_order_relaxed);
+            consumed.store(0, std::memory_order_relaxed);
+            overruns = 0;
+            errors = 0;
+            channel = &newChannel;
+            return newChannel.startDoubleBuffer(peripheral, first, first + static_cast<std::uint32_t>(sizeof(blocks[0])), static_cast<std::uint32_t>(Items));
+        }
+
+        DriverStatus stop()
+        {
+            if (channel == nullptr) { return Utils::fail(DriverError::notInitialized); }
+            return channel->stop();
+        }
+
+        /**
+         * @brief Oldest full block the channel is not writing, skipping the overwritten ones.
+         * @return Block Invalid if no block is full.
+         */
+        Block front()
+        {
+            const std::uint32_t full{ skipOverrun() };
+            const std::uint32_t next{ consumed.load(std::memory_order_relaxed) };
+            if (next == full) { return Block{}; }
+            return Block{ blocks[next & 1U].data(), Items, next };
+        }
+
+        /**
+         * @brief Give the front block back to the channel.
+         * @return bool false if the channel started overwriting it before the call: the data read may be torn.
+         */
+        bool pop()
+        {
+            const std::uint32_t full{ filled.load(std::memory_order_acquire) };
+            const std::uint32_t next{ consumed.load(std::memory_order_relaxed) };
+            if (next == full) { return true; }
+            const bool intact{ full - next == 1 };
+            if (!intact) { ++overruns; }
+            consumed.store(next + 1, std::memory_order_release);
+            return intact;
+        }
+
+        bool isRunning() { return channel != nullptr && channel->isEnabled(); }
+
+        Statistics statistics() const { return Statistics{ filled.load(std::memory_order_relaxed), overruns, errors }; }
+
+        static constexpr std::size_t blockItems() { return Items; }
+};
+
+namespace Bdma
+{
+    #if defined(CORE_CM7) || defined(CORE_CM4)
+        /**
+         * @brief Enable the BDMA clock of the calling core (DMAMUX2 runs on the same clock).
+         */
+        inline void init()
+        {
+            RCC->AHB4ENR = RCC->AHB4ENR | RCC_AHB4ENR_BDMAEN;
+            static_cast<void>(RCC->AHB4ENR);
+        }
+
+        /**
+         * @brief Keep the BDMA, SRAM4 and Peripherals clocked and D3 in Run while both cores are in Stop.
+         */
+        template<D3Peripheral... Peripherals>
+        void runAutonomously()
+        {
+            constexpr auto bitOf = [](const D3Peripheral peripheral) -> std::uint32_t {
+                switch (peripheral) {
+                    case D3Peripheral::lpuart1: return RCC_D3AMR_LPUART1AMEN;
+                    case D3Peripheral::spi6: return RCC_D3AMR_SPI6AMEN;
+                    case D3Peripheral::i2c4: return RCC_D3AMR_I2C4AMEN;
+                    case D3Peripheral::sai4: return RCC_D3AMR_SAI4AMEN;
+                    case D3Peripheral::adc3: return RCC_D3AMR_ADC3AMEN;
+                }
+                return 0;
+            };
+            RCC->D3AMR = RCC->D3AMR | RCC_D3AMR_BDMAAMEN | RCC_D3AMR_SRAM4AMEN | (bitOf(Peripherals) | ... | 0U);
+            PWR->CPUCR = PWR->CPUCR | PWR_CPUCR_RUN_D3;
+        }
+
+        /// Interrupt line of a channel, for NVIC_EnableIRQ().
+        template<std::uint8_t Channel>
+        constexpr IRQn_Type irq()
+        {
+            static_assert(Channel < channelCount, "The BDMA has 8 channels");
+            return static_cast<IRQn_Type>(BDMA_Channel0_IRQn + Channel);
+        }
+
+        /**
+         * @brief Handler of a channel, created on first use.
+         */
+        template<std::uint8_t Channel>
+        BdmaChannelHandler& channel()
+        {
+            static_assert(Channel < channelCount, "The BDMA has 8 channels");
+            BDMA_Channel_TypeDef* const registers{ reinterpret_cast<BDMA_Channel_TypeDef*>(BDMA_Channel0_BASE + 0x14U * Channel) };
+            DMAMUX_Channel_TypeDef* const mux{ reinterpret_cast<DMAMUX_Channel_TypeDef*>(DMAMUX2_Channel0_BASE + 4U * Channel) };
+            static BdmaChannelHandler handler{ Channel, &registers->CCR, &registers->CNDTR, &registers->CPAR, &registers->CM0AR,
+                                               &registers->CM1AR, &BDMA->ISR, &BDMA->IFCR, &mux->CCR };
+            return handler;
+        }
+    #endif
+};
+
+#endif // __BDMA_H__
@@ -0,0 +1,156 @@
+#ifndef __COMPLETIONQUEUE_H__
+#define __COMPLETIONQUEUE_H__
+
+/**
+ * @file CompletionQueue.hh
+ * @brief Operations waiting for a DMA engine that runs one at a time, started back to back from its interrupt.
+ *
+ * The queue names each operation by a Token holding the sequence of its submission.
+ * Operations complete in that order, so a token is complete once the completed count
+ * reaches it. The engine reports the end of its work with engineDone(), once per
+ * interrupt; the queue then completes the operation and starts the next one.
+ *
+ * The owner derives from CompletionQueue, declares it a friend and provides:
+ *  - void prepareOperation(const Operation&): at submission, with the interrupts enabled, e.g. cache maintenance;
+ *  - bool startOperation(Operation&): program the engine, false if it refused the operation;
+ *  - void finishOperation(const Operation&): on completion, successful or not;
+ *  - void serveEngine(): the interrupt handler of the engine, for poll().
+ * startOperation() may run an operation in parts, see engineDone().
+ */
+
+//<------------------------------INCLUDES------------------------------>//
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <BusyWait.hh>
+#include <CriticalSection.hh>
+#include <DriverError.hh>
+//<-------------------------------------------------------------------->//
+
+/**
+ * @tparam Owner The queue of an engine, see above.
+ * @tparam Token Completion token, an aggregate of the std::uint32_t sequence.
+ * @tparam Pending Operations queued, the one running included; a power of two.
+ */
+template<typename Owner, typename Operation, typename Token, std::size_t Pending>
+class CompletionQueue
+{
+    static_assert(Pending > 0 && (Pending & (Pending - 1)) == 0, "The pending operation count must be a power of two");
+
+    private:
+        std::array<Operation, Pending> queue{};
+        volatile std::uint32_t issued{ 0 };
+        volatile std::uint32_t completed{ 0 };
+        volatile std::uint32_t lastFailed{ 0 };
+        bool running{ false };
+
+        Owner& owner() { return *static_cast<Owner*>(this); }
+
+        void finish(const bool success)
+        {
+            owner().finishOperation(front());
+            const std::uint32_t sequence{ completed + 1 };
+            if (!success) { lastFailed = sequence; }
+            completed = sequence;
+        }
+
+        /// Start the oldest queued operation, with the interrupts masked.
+        void startNext()
+        {
+            while (completed != issued) {
+                if (owner().startOperation(front())) {
+                    running = true;
+                    return;
+                }
+                finish(false);
+            }
+            running = false;
+        }
+
+    protected:
+        /// Operation on the engine, or the next one.
+        Operation& front() { return queue[completed & (Pending - 1)]; }
+
+        bool isIdle() const { return completed == issued; }
+
+        /**
+         * @brief Prepare an operation, then queue it, started at once if the engine is idle.
+         *
+         * Only the queueing masks the interrupts: the preparation of an operation the
+         * queue then refuses is wasted, not harmful.
+         * @return Utils::Result<Token, DriverError> DriverError::outOfResources if Pending operations wait.
+         */
+        Utils::Result<Token, DriverError> enqueue(const Operation& operation)
+        {
+            owner().prepareOperation(operation);
+            CriticalSection guard;
+            if (issued - completed == Pending) { return Utils::fail(DriverError::outOfResources); }
+            queue[issued & (Pending - 1)] = operation;
+            issued = issued + 1;
+            const Token token{ issued };
+            if (!running) { startNext(); }
+            return token;
+        }
+
+        /**
+         * @brief Reserve the sequence of an operation the caller runs itself, on an idle queue; with the interrupts masked.
+         *
+         * The queue holds the operations submitted meanwhile until completeInline().
+         */
+        Token reserveInline()
+        {
+            issued = issued + 1;
+            running = true;
+            return Token{ issued };
+        }
+
+        /// The operation of reserveInline() is over, start the ones queued behind it.
+        void completeInline()
+        {
+            CriticalSection guard;
+            completed = completed + 1;
+            running = false;
+            startNext();
+        }
+
+        /**
+         * @brief The engine stopped, once per interrupt: a second call would end the operation started by the first.
+         * @param done Whether the front operation is over; false starts its next part.
+         */
+        void engineDone(const bool success, const bool done = true)
+        {
+            if (!running) { return; }
+            running = false;
+            if (!success || done) { finish(success); }
+            startNext();
+        }
+
+    public:
+        bool isComplete(const Token token) const { return static_cast<std::int32_t>(completed - token.sequence) >= 0; }
+
+        /// Serve the engine without its interrupt, e.g. from a polling loop.
+        void poll()
+        {
+            CriticalSection guard;
+            owner().serveEngine();
+        }
+
+        /**
+         * @brief Wait for an operation and the ones before it.
+         * @return DriverStatus DriverError::hardwareFault if the last failed operation is this one.
+         */
+        DriverStatus wait(const Token token)
+        {
+            while (!isComplete(token)) {
+                poll();
+                BusyWait::relax();
+            }
+            if (lastFailed == token.sequence) { return Utils::fail(DriverError::hardwareFault); }
+            return {};
+        }
+
+        /// Operations queued or running.
+        std::uint32_t pending() const { return issued - completed; }
+};
+
+#endif // __COMPLETIONQUEUE_H__
@@ -0,0 +1,31 @@
+#ifndef __DRIVERERROR_H__
+#define __DRIVERERROR_H__
+
+/**
+ * @file DriverError.hh
+ * @brief Error codes returned by the drivers and the DriverStatus shorthand.
+ *
+ * The library is built with -fno-exceptions: driver functions that can fail return a
+ * Utils::Result<T, DriverError>, or a DriverStatus when there is no value to return.
+ */
+
+//<------------------------------INCLUDES------------------------------>//
+#include <cstdint>
+#include <Result.hh>
+//<-------------------------------------------------------------------->//
+
+enum class DriverError : std::uint8_t {
+    invalidParameter,       ///< An argument or a property is out of the range the hardware accepts.
+    outOfResources,         ///< A register handle or another static resource could not be allocated.
+    notInitialized,         ///< The peripheral was used before init().
+    busy,                   ///< The peripheral or the resource is owned by someone else.
+    timeout,                ///< The hardware did not reach the expected state in time.
+    hardwareFault           ///< The hardware reported an error.
+};
+
+template<typename T>
+using DriverResult = Utils::Result<T, DriverError>;
+
+using DriverStatus = Utils::Result<void, DriverError>;
+
+#endif // __DRIVERERROR_H__
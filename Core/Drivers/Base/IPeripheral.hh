@@ -1,6 +1,10 @@
 #ifndef __IPERIPHERAL_H__
 #define __IPERIPHERAL_H__
 
+//<------------------------------INCLUDES------------------------------>//
+#include <DriverError.hh>
+//<-------------------------------------------------------------------->//
+
 /**
  * @brief Basic interface followed by all peripherals
  */
@@ -11,13 +15,14 @@ private:
 public:
     /**
      * @brief Method to initialize hardware, i.e write the hardware register.
+     * @return DriverStatus The first error met, the hardware may be partly configured then.
      */
-    virtual void init() = 0;
+    virtual DriverStatus init() = 0;
 
     /**
      * @brief Method to reset hardware to default values.
      */
-    virtual void reset() = 0;
+    virtual DriverStatus reset() = 0;
 };
 
 #endif // __IPERIPHERAL_H__
\ No newline at end of file
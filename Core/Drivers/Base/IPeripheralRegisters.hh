@@ -9,10 +9,10 @@
 //<-------------------------------------------------------------------->//
 
 // Helper function to transform raw address to IRegister instance
-template <typename T>
+template <typename AllocationPolicy = Memory::DefaultAllocation, typename T>
 requires Utils::UnsignedIntegralPointerConcept<T>
 IRegister<T>* createRegisterInstance(T address) {
-    return SRegister<T>::getInstance(address);
+    return SRegister<T, AllocationPolicy>::getInstance(address);
 }
 
 
@@ -36,8 +36,17 @@ struct TransformPeripheralRegistersPairs<TypeList<Pairs...>> {
 };
 
 
+/**
+ * @brief Tag selecting the constructors taking ready-made IRegister handles instead of
+ * addresses, e.g. models of a peripheral's register semantics in host tests.
+ */
+struct RegisterHandlesTag {};
+inline constexpr RegisterHandlesTag registerHandles{};
+
+
 // Your IPeripheralRegisters class
-template<typename PeripheralRegistersPairs>
+// AllocationPolicy selects where the register handles are allocated (static pools by default), see AllocationPolicy.hh
+template<typename PeripheralRegistersPairs, typename AllocationPolicy = Memory::DefaultAllocation>
 requires ((Utils::IsTypeListOfPairs<PeripheralRegistersPairs>))
 class IPeripheralRegisters {
     private:
@@ -46,11 +55,21 @@ class IPeripheralRegisters {
             typename TransformPeripheralRegistersPairs<PeripheralRegistersPairs>::type
         > registers;
 
+        template<template<typename...> class TypeList, typename... Pairs>
+        constexpr bool allAllocated(TypeList<Pairs...>*) const { return ((registers.template get<Pairs::tag::value>() != nullptr) && ...); }
+
     public:
         // Constructor
         template<typename... Addresses>
+        requires ((Utils::UnsignedIntegralPointerConcept<std::decay_t<Addresses>> && ...))
         constexpr explicit IPeripheralRegisters(Addresses&&... addresses)
-            : registers(createRegisterInstance(addresses)...) {
+            : registers(createRegisterInstance<AllocationPolicy>(addresses)...) {
+        }
+
+        // Constructor from handles, in the order of the pairs. The handles are not owned.
+        template<typename... Handles>
+        constexpr explicit IPeripheralRegisters(RegisterHandlesTag, Handles*... handles)
+            : registers(handles...) {
         }
 
         template<auto T>
@@ -86,6 +105,12 @@ class IPeripheralRegisters {
         template<auto T>
         constexpr auto getAddress() const { return registers.template get<T>()->getAddress();}
 
+        /**
+         * @brief Check that every register handle was allocated. With the pool policy a
+         * handle is null once its pool is exhausted, and the accessors must not be used.
+         */
+        constexpr bool isValid() const { return allAllocated(static_cast<PeripheralRegistersPairs*>(nullptr)); }
+
         // Other methods and functionality...
 };
 
@@ -7,6 +7,7 @@
 #include <Register.hh>
 #include <IPeripheralProperties.hh>
 #include <IPeripheralRegisters.hh>
+#include <DriverError.hh>
 //<-------------------------------------------------------------------->//
 
 
@@ -35,12 +36,26 @@ public:
     template<typename... RegisterAddressess>
     requires ((Utils::UnsignedIntegralPointerConcept<RegisterAddressess> && ...))
     constexpr explicit PeripheralHandlerBase(PeripheralHandlerBase* handler, RegisterAddressess&&... registerAddresses) 
-        : peripheralHandler(handler), registers(registerAddresses...) {
+        : peripheralHandler(static_cast<PeripheralHandler*>(handler)), registers(registerAddresses...) {
+    }
+
+    template<typename... Handles>
+    constexpr explicit PeripheralHandlerBase(PeripheralHandlerBase* handler, RegisterHandlesTag tag, Handles*... handles)
+        : peripheralHandler(static_cast<PeripheralHandler*>(handler)), registers(tag, handles...) {
     }
 
 
     ~PeripheralHandlerBase() { peripheralHandler = nullptr; }
 
+    /**
+     * @brief Check that the handler is usable: every register handle was allocated.
+     * @return DriverStatus DriverError::outOfResources if a register pool was exhausted.
+     */
+    constexpr DriverStatus status() const {
+        if (!registers.isValid()) { return Utils::fail(DriverError::outOfResources); }
+        return {};
+    }
+
     template <auto EnumValue>
     constexpr auto& getParam() {
         return this->members.template get<EnumValue>();
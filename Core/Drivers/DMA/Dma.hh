@@ -0,0 +1,448 @@
+#ifndef __DMA_H__
+#define __DMA_H__
+
+/**
+ * @file Dma.hh
+ * @brief DMA1/DMA2 stream driver: DMAMUX1 request routing, FIFO and bursts, circular and double-buffer modes.
+ *
+ * Each DmaStreamHandler drives one of the 16 streams and the DMAMUX1 channel in front of
+ * it (channel = 8 * (controller - 1) + stream). configure() checks the configuration
+ * against the rules of the reference manual before writing anything:
+ *  - bursts need the FIFO: direct mode transfers single data items;
+ *  - a memory burst (beats x MSIZE) must divide the FIFO threshold, a peripheral burst
+ *    (beats x PSIZE) must fit in the 16-byte FIFO;
+ *  - memory-to-memory transfers use the FIFO and are neither circular nor double-buffered;
+ *  - double-buffer mode is circular by construction.
+ * start() adds the checks depending on the buffers: count, alignment, TCM (unreachable by
+ * DMA1/DMA2), and count in whole bursts in circular mode.
+ *
+ * Streams are allocated at compile time: the project lists which user owns which stream
+ * in one Dma::StreamAllocation, which refuses a stream given twice, and obtains its
+ * handler with Dma::stream<Allocation, user>(). Two drivers can no longer grab the same
+ * stream by accident.
+ *
+ * Double-buffer mode: the stream alternates between memory 0 and memory 1 without
+ * stopping. The transfer complete callback reports the buffer just filled (or emptied),
+ * which the CPU may process (or refill) while the DMA works on the other one; setMemory()
+ * moves the idle buffer elsewhere. A write to the address of the buffer in use is refused
+ * with DriverError::busy, the hardware would flag a transfer error and stop.
+ *
+ * On the CM7, buffers in cacheable memory need Cache::clean() before a memory-to-peripheral
+ * transfer and Cache::invalidate() after a peripheral-to-memory one, see Cache.hh.
+ *
+ * Usage example:
+ * ```
+ * enum class DmaUser { uartRx, spiTx };
+ * using DmaStreams = Dma::StreamAllocation<pair<DmaUser::uartRx, Dma::StreamId<1, 0>>, pair<DmaUser::spiTx, Dma::StreamId<1, 1>>>;
+ *
+ * DmaStreamHandler& rx{ Dma::stream<DmaStreams, DmaUser::uartRx>() };
+ * rx.configure(DmaConfig{ .request = Dma::Request::usart1Rx, .mode = DmaMode::doubleBuffer }, &onBlock, nullptr);
+ * rx.startDoubleBuffer(reinterpret_cast<std::uint32_t>(&USART1->RDR), ping, pong, 64);
+ * // void onBlock(void* context, DmaEvent event, std::uint8_t buffer): buffer 0 or 1 is ready
+ * extern "C" void DMA1_Stream0_IRQHandler() { Dma::stream<1, 0>().handleInterrupt(); }
+ * ```
+ */
+
+//<------------------------------INCLUDES------------------------------>//
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <PeripheralBaseHandler.hh>
+#include <DriverError.hh>
+#include <MemorySections.hh>
+#include <DmaChannel.hh>
+#if defined(CORE_CM7) || defined(CORE_CM4)
+#include <stm32h755xx.h>
+#endif
+//<-------------------------------------------------------------------->//
+
+namespace Dma
+{
+    inline constexpr std::uint8_t controllerCount{ 2 };
+    inline constexpr std::uint8_t streamsPerController{ 8 };
+    inline constexpr std::uint32_t fifoBytes{ 16 };
+
+    // SxCR
+    inline constexpr std::uint32_t enablePos{ 0 };
+    inline constexpr std::uint32_t directModeErrorInterruptPos{ 1 };
+    inline constexpr std::uint32_t transferErrorInterruptPos{ 2 };
+    inline constexpr std::uint32_t halfTransferInterruptPos{ 3 };
+    inline constexpr std::uint32_t transferCompleteInterruptPos{ 4 };
+    inline constexpr std::uint32_t directionPos{ 6 };
+    inline constexpr std::uint32_t circularPos{ 8 };
+    inline constexpr std::uint32_t peripheralIncrementPos{ 9 };
+    inline constexpr std::uint32_t memoryIncrementPos{ 10 };
+    inline constexpr std::uint32_t peripheralSizePos{ 11 };
+    inline constexpr std::uint32_t memorySizePos{ 13 };
+    inline constexpr std::uint32_t priorityPos{ 16 };
+    inline constexpr std::uint32_t doubleBufferPos{ 18 };
+    inline constexpr std::uint32_t currentTargetPos{ 19 };
+    inline constexpr std::uint32_t bufferablePos{ 20 };
+    inline constexpr std::uint32_t peripheralBurstPos{ 21 };
+    inline constexpr std::uint32_t memoryBurstPos{ 23 };
+
+    // SxFCR
+    inline constexpr std::uint32_t fifoThresholdPos{ 0 };
+    inline constexpr std::uint32_t directModeDisablePos{ 2 };
+    inline constexpr std::uint32_t fifoErrorInterruptPos{ 7 };
+
+    // Flags of one stream in LISR/HISR and LIFCR/HIFCR, relative to its group
+    inline constexpr std::uint32_t fifoErrorFlag{ 1U << 0 };
+    inline constexpr std::uint32_t directModeErrorFlag{ 1U << 2 };
+    inline constexpr std::uint32_t transferErrorFlag{ 1U << 3 };
+    inline constexpr std::uint32_t halfTransferFlag{ 1U << 4 };
+    inline constexpr std::uint32_t transferCompleteFlag{ 1U << 5 };
+    inline constexpr std::uint32_t allFlags{ 0x3DU };
+
+    /// Position of a stream's flag group: streams 0-3 in LISR, 4-7 in HISR.
+    constexpr std::uint32_t flagShift(const std::uint8_t stream)
+    {
+        constexpr std::array<std::uint32_t, 4> shifts{ 0, 6, 16, 22 };
+        return shifts[stream % 4];
+    }
+
+    /// DMAMUX1 channel in front of a stream.
+    constexpr std::uint8_t muxChannel(const std::uint8_t controller, const std::uint8_t stream)
+    {
+        return static_cast<std::uint8_t>((controller - 1) * streamsPerController + stream);
+    }
+
+    /**
+     * @brief DMAMUX1 request inputs (RM0399, DMAMUX1 request mapping), more can be cast from their number.
+     */
+    enum class Request : std::uint8_t {
+        memoryToMemory = 0,
+        generator0 = 1, generator1, generator2, generator3, generator4, generator5, generator6, generator7,
+        adc1 = 9,
+        adc2 = 10,
+        spi1Rx = 37, spi1Tx = 38,
+        spi2Rx = 39, spi2Tx = 40,
+        usart1Rx = 41, usart1Tx = 42,
+        usart2Rx = 43, usart2Tx = 44,
+        usart3Rx = 45, usart3Tx = 46
+    };
+
+    /**
+     * @brief Compile-time name of a stream.
+     */
+    template<std::uint8_t Controller, std::uint8_t Stream>
+    struct StreamId {
+        static_assert(Controller >= 1 && Controller <= controllerCount, "DMA controllers are DMA1 and DMA2");
+        static_assert(Stream < streamsPerController, "DMA controllers have 8 streams");
+
+        static constexpr std::uint8_t controller{ Controller };
+        static constexpr std::uint8_t stream{ Stream };
+        static constexpr std::uint8_t channel{ muxChannel(Controller, Stream) };
+    };
+
+    /// Whether no stream and no user appears twice in a list of pair<user, StreamId>.
+    template<typename... Pairs>
+    constexpr bool isValidAllocation()
+    {
+        constexpr std::array<std::uint8_t, sizeof...(Pairs)> channels{ Pairs::type::channel... };
+        constexpr std::array<std::size_t, sizeof...(Pairs)> users{ static_cast<std::size_t>(Pairs::tag::value)... };
+        for (std::size_t first = 0; first < sizeof...(Pairs); ++first) {
+            for (std::size_t second = first + 1; second < sizeof...(Pairs); ++second) {
+                if (channels[first] == channels[second] || users[first] == users[second]) { return false; }
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Streams of the project, one pair<user, StreamId<controller, stream>> per user.
+     */
+    template<typename... Pairs>
+    struct StreamAllocation {
+        static_assert(isValidAllocation<Pairs...>(), "A DMA stream or a DMA user appears twice in the allocation");
+
+        template<auto User>
+        using Stream = std::tuple_element_t<Utils::indexOfEnumValue<User, Pairs...>::value, std::tuple<typename Pairs::type...>>;
+    };
+};
+
+enum class DmaDirection : std::uint8_t { peripheralToMemory, memoryToPeripheral, memoryToMemory };
+enum class DmaFifo : std::uint8_t { direct, quarter, half, threeQuarters, full };
+enum class DmaBurst : std::uint8_t { single, incr4, incr8, incr16 };
+
+/**
+ * @brief Events reported to the stream callback.
+ */
+enum class DmaEvent : std::uint8_t {
+    halfTransfer,           ///< Half of the current buffer transferred.
+    transferComplete,       ///< Buffer done; in double-buffer mode the stream already moved to the other one.
+    transferError,          ///< Bus error or write to the memory address in use, the stream is disabled.
+    directModeError,        ///< Direct mode only: a request came before the previous data was transferred.
+    fifoError               ///< FIFO underrun or overrun.
+};
+
+/**
+ * @brief Configuration of a stream, fixed for the transfers that follow.
+ */
+struct DmaConfig {
+    Dma::Request request{ Dma::Request::memoryToMemory };
+    DmaDirection direction{ DmaDirection::peripheralToMemory };
+    DmaDataSize peripheralSize{ DmaDataSize::byte };
+    DmaDataSize memorySize{ DmaDataSize::byte };
+    bool peripheralIncrement{ false };
+    bool memoryIncrement{ true };
+    DmaMode mode{ DmaMode::normal };
+    DmaPriority priority{ DmaPriority::low };
+    DmaFifo fifo{ DmaFifo::direct };
+    DmaBurst peripheralBurst{ DmaBurst::single };
+    DmaBurst memoryBurst{ DmaBurst::single };
+    bool halfTransferInterrupt{ false };
+    bool bufferable{ false };               ///< TRBUFF, required for the U(S)ART peripherals.
+};
+
+enum class DmaStreamProperties { controller, stream };
+using DmaStreamPropertiesTypeList = Utils::TypeList<
+    pair<DmaStreamProperties::controller, std::uint8_t>,
+    pair<DmaStreamProperties::stream, std::uint8_t>
+>;
+
+enum class DmaStreamRegisters { control, count, peripheralAddress, memory0Address, memory1Address, fifoControl, interruptStatus, interruptClear, muxControl };
+using DmaStreamRegistersTypeList = Utils::TypeList<
+    pair<DmaStreamRegisters::control, volatile std::uint32_t*>,            // SxCR
+    pair<DmaStreamRegisters::count, volatile std::uint32_t*>,              // SxNDTR
+    pair<DmaStreamRegisters::peripheralAddress, volatile std::uint32_t*>,  // SxPAR
+    pair<DmaStreamRegisters::memory0Address, volatile std::uint32_t*>,     // SxM0AR
+    pair<DmaStreamRegisters::memory1Address, volatile std::uint32_t*>,     // SxM1AR
+    pair<DmaStreamRegisters::fifoControl, volatile std::uint32_t*>,        // SxFCR
+    pair<DmaStreamRegisters::interruptStatus, volatile std::uint32_t*>,    // LISR or HISR
+    pair<DmaStreamRegisters::interruptClear, volatile std::uint32_t*>,     // LIFCR or HIFCR
+    pair<DmaStreamRegisters::muxControl, volatile std::uint32_t*>          // DMAMUX1 CxCR
+>;
+
+namespace Dma
+{
+    /// A DMA1/DMA2 stream for DmaChannelBase, see DmaChannel.hh.
+    struct StreamLayout {
+        using Config = DmaConfig;
+        using Event = DmaEvent;
+        using Registers = DmaStreamRegisters;
+        using PropertiesList = DmaStreamPropertiesTypeList;
+        using RegistersList = DmaStreamRegistersTypeList;
+        static constexpr DmaStreamProperties index{ DmaStreamProperties::stream };
+
+        static constexpr std::uint32_t enablePos{ Dma::enablePos };
+        static constexpr std::uint32_t transferErrorInterruptPos{ Dma::transferErrorInterruptPos };
+        static constexpr std::uint32_t halfTransferInterruptPos{ Dma::halfTransferInterruptPos };
+        static constexpr std::uint32_t transferCompleteInterruptPos{ Dma::transferCompleteInterruptPos };
+        static constexpr std::uint32_t directionPos{ Dma::directionPos };
+        static constexpr std::uint32_t circularPos{ Dma::circularPos };
+        static constexpr std::uint32_t peripheralIncrementPos{ Dma::peripheralIncrementPos };
+        static constexpr std::uint32_t memoryIncrementPos{ Dma::memoryIncrementPos };
+        static constexpr std::uint32_t peripheralSizePos{ Dma::peripheralSizePos };
+        static constexpr std::uint32_t memorySizePos{ Dma::memorySizePos };
+        static constexpr std::uint32_t priorityPos{ Dma::priorityPos };
+        static constexpr std::uint32_t doubleBufferPos{ Dma::doubleBufferPos };
+        static constexpr std::uint32_t currentTargetPos{ Dma::currentTargetPos };
+
+        static constexpr std::uint32_t transferCompleteFlag{ Dma::transferCompleteFlag };
+        static constexpr std::uint32_t halfTransferFlag{ Dma::halfTransferFlag };
+        static constexpr std::uint32_t transferErrorFlag{ Dma::transferErrorFlag };
+        static constexpr std::uint32_t allFlags{ Dma::allFlags };
+
+        static constexpr std::uint32_t flagShift(const std::uint8_t stream) { return Dma::flagShift(stream); }
+
+        static constexpr std::array<FlagEvent<DmaEvent>, 5> events{ {
+            { Dma::transferErrorFlag, DmaEvent::transferError },
+            { Dma::directModeErrorFlag, DmaEvent::directModeError },
+            { Dma::fifoErrorFlag, DmaEvent::fifoError },
+            { Dma::halfTransferFlag, DmaEvent::halfTransfer },
+            { Dma::transferCompleteFlag, DmaEvent::transferComplete },
+        } };
+    };
+
+    constexpr std::uint32_t beatsOf(const DmaBurst burst) { return burst == DmaBurst::single ? 1U : 2U << static_cast<std::uint32_t>(burst); }
+
+    constexpr std::uint32_t thresholdBytes(const DmaFifo fifo) { return 4U * static_cast<std::uint32_t>(fifo); }
+
+    /**
+     * @brief Check a configuration against the FIFO, burst and mode rules.
+     * @return bool true if the hardware accepts it.
+     */
+    constexpr bool isValid(const DmaConfig& config)
+    {
+        const bool direct{ config.fifo == DmaFifo::direct };
+        const bool memoryToMemory{ config.direction == DmaDirection::memoryToMemory };
+        if (direct && (config.memoryBurst != DmaBurst::single || config.peripheralBurst != DmaBurst::single)) { return false; }
+        if (direct && config.memorySize != config.peripheralSize) { return false; }
+        if (memoryToMemory && (direct || config.mode != DmaMode::normal)) { return false; }
+        if (!direct && thresholdBytes(config.fifo) % (beatsOf(config.memoryBurst) * bytesOf(config.memorySize)) != 0) { return false; }
+        if (beatsOf(config.peripheralBurst) * bytesOf(config.peripheralSize) > fifoBytes) { return false; }
+        return static_cast<std::uint8_t>(config.memorySize) <= static_cast<std::uint8_t>(DmaDataSize::word) &&
+               static_cast<std::uint8_t>(config.peripheralSize) <= static_cast<std::uint8_t>(DmaDataSize::word);
+    }
+
+    /// SxCR value of a configuration, without EN and the interrupt enables.
+    constexpr std::uint32_t controlValue(const DmaConfig& config)
+    {
+        return channelControl<StreamLayout>(config) |
+               ((config.bufferable ? 1U : 0U) << bufferablePos) |
+               (static_cast<std::uint32_t>(config.peripheralBurst) << peripheralBurstPos) |
+               (static_cast<std::uint32_t>(config.memoryBurst) << memoryBurstPos);
+    }
+
+    /// SxFCR value of a configuration, without the FIFO error interrupt enable.
+    constexpr std::uint32_t fifoValue(const DmaConfig& config)
+    {
+        if (config.fifo == DmaFifo::direct) { return 0; }
+        return (1U << directModeDisablePos) | ((static_cast<std::uint32_t>(config.fifo) - 1U) << fifoThresholdPos);
+    }
+};
+
+class DmaStreamHandler : public DmaChannelBase<Dma::StreamLayout, DmaStreamHandler>
+{
+    private:
+        using classParent = DmaChannelBase<Dma::StreamLayout, DmaStreamHandler>;
+        friend classParent;
+
+        void setProperties(const std::uint8_t controller, const std::uint8_t streamNumber)
+        {
+            setParam<DmaStreamProperties::controller>(controller);
+            setParam<DmaStreamProperties::stream>(streamNumber);
+        }
+
+        DriverStatus checkBuffer(const std::uint32_t address, const std::uint32_t count, const DmaDataSize size, const bool increment)
+        {
+            const std::uint32_t bytes{ Dma::bytesOf(size) };
+            if (address % bytes != 0) { return Utils::fail(DriverError::invalidParameter); }
+            if (MemorySections::isInTcm(address, increment ? count * bytes : bytes)) { return Utils::fail(DriverError::invalidParameter); }
+            return {};
+        }
+
+        /// Alignment, bursts and reach of the buffers of a transfer of bytes per buffer.
+        DriverStatus checkBuffers(const std::uint32_t peripheral, const std::uint32_t memory, const std::uint32_t bytes)
+        {
+            const DmaConfig& config{ configuration() };
+            if (config.mode != DmaMode::normal && config.memoryBurst != DmaBurst::single &&
+                bytes % (Dma::beatsOf(config.memoryBurst) * Dma::bytesOf(config.memorySize)) != 0) {
+                return Utils::fail(DriverError::invalidParameter);
+            }
+            // Memory-to-memory: the source is in PAR
+            const bool sourceIncrement{ config.direction == DmaDirection::memoryToMemory || config.peripheralIncrement };
+            RESULT_TRY(checkBuffer(peripheral, bytes / Dma::bytesOf(config.peripheralSize), config.peripheralSize, sourceIncrement));
+            return checkBuffer(memory, bytes / Dma::bytesOf(config.memorySize), config.memorySize, config.memoryIncrement);
+        }
+
+    public:
+        /**
+         * @param controller 1 or 2.
+         * @param streamNumber 0 to 7.
+         * @param addresses SxCR, SxNDTR, SxPAR, SxM0AR, SxM1AR, SxFCR, LISR/HISR, LIFCR/HIFCR and DMAMUX1 CxCR.
+         */
+        template<typename... RegisterAddress>
+        requires ((Utils::UnsignedIntegralPointerConcept<std::decay_t<RegisterAddress>> && ...))
+        explicit DmaStreamHandler(const std::uint8_t controller, const std::uint8_t streamNumber, RegisterAddress&&... addresses)
+            : classParent(this, std::forward<RegisterAddress>(addresses)...) {
+            setProperties(controller, streamNumber);
+        }
+
+        template<typename... Handles>
+        explicit DmaStreamHandler(const std::uint8_t controller, const std::uint8_t streamNumber, RegisterHandlesTag tag, Handles*... handles)
+            : classParent(this, tag, handles...) {
+            setProperties(controller, streamNumber);
+        }
+
+        /**
+         * @brief Route the request and program the stream, which must be stopped.
+         * @param callback Called from handleInterrupt(), nullptr leaves the stream interrupts off.
+         * @return DriverStatus DriverError::invalidParameter for a configuration the hardware refuses,
+         * DriverError::busy if the stream is running.
+         */
+        DriverStatus configure(const DmaConfig& newConfig, const Callback newCallback = nullptr, void* newContext = nullptr)
+        {
+            RESULT_TRY(status());
+            if (!Dma::isValid(newConfig)) { return Utils::fail(DriverError::invalidParameter); }
+            if (isEnabled()) { return Utils::fail(DriverError::busy); }
+
+            std::uint32_t control{ Dma::controlValue(newConfig) };
+            std::uint32_t fifo{ Dma::fifoValue(newConfig) };
+            std::uint32_t errors{ 0 };
+            if (newCallback != nullptr) {
+                control |= 1U << Dma::directModeErrorInterruptPos;
+                errors = Dma::directModeErrorFlag;
+                if (newConfig.fifo != DmaFifo::direct) {
+                    fifo |= 1U << Dma::fifoErrorInterruptPos;
+                    errors |= Dma::fifoErrorFlag;
+                }
+            }
+            setRegisterValue<DmaStreamRegisters::fifoControl>(fifo);
+            program(newConfig, control, errors, newCallback, newContext);
+            return {};
+        }
+
+        /**
+         * @brief Move the buffer the stream is not using, in double-buffer mode.
+         * @return DriverStatus DriverError::busy if buffer is the one in use.
+         */
+        DriverStatus setMemory(const std::uint8_t buffer, const std::uint32_t address)
+        {
+            RESULT_TRY(status());
+            if (buffer > 1 || address % Dma::bytesOf(configuration().memorySize) != 0) { return Utils::fail(DriverError::invalidParameter); }
+            if (isEnabled() && currentBuffer() == buffer) { return Utils::fail(DriverError::busy); }
+            if (buffer == 0) {
+                setRegisterValue<DmaStreamRegisters::memory0Address>(address);
+            } else {
+                setRegisterValue<DmaStreamRegisters::memory1Address>(address);
+            }
+            return {};
+        }
+};
+
+namespace Dma
+{
+    #if defined(CORE_CM7) || defined(CORE_CM4)
+        /**
+         * @brief Enable the DMA1, DMA2 and DMAMUX1 clocks of the calling core.
+         */
+        inline void init()
+        {
+            RCC->AHB1ENR = RCC->AHB1ENR | RCC_AHB1ENR_DMA1EN | RCC_AHB1ENR_DMA2EN;
+            static_cast<void>(RCC->AHB1ENR);
+        }
+
+        /// Interrupt line of a stream, for NVIC_EnableIRQ().
+        template<std::uint8_t Controller, std::uint8_t Stream>
+        constexpr IRQn_Type irq()
+        {
+            constexpr std::array<IRQn_Type, 8> dma1{ DMA1_Stream0_IRQn, DMA1_Stream1_IRQn, DMA1_Stream2_IRQn, DMA1_Stream3_IRQn,
+                                                     DMA1_Stream4_IRQn, DMA1_Stream5_IRQn, DMA1_Stream6_IRQn, DMA1_Stream7_IRQn };
+            constexpr std::array<IRQn_Type, 8> dma2{ DMA2_Stream0_IRQn, DMA2_Stream1_IRQn, DMA2_Stream2_IRQn, DMA2_Stream3_IRQn,
+                                                     DMA2_Stream4_IRQn, DMA2_Stream5_IRQn, DMA2_Stream6_IRQn, DMA2_Stream7_IRQn };
+            return Controller == 1 ? dma1[Stream] : dma2[Stream];
+        }
+
+        /**
+         * @brief Handler of a stream, created on first use.
+         */
+        template<std::uint8_t Controller, std::uint8_t Stream>
+        DmaStreamHandler& stream()
+        {
+            using Id = StreamId<Controller, Stream>;
+            DMA_TypeDef* const dma{ Controller == 1 ? DMA1 : DMA2 };
+            DMA_Stream_TypeDef* const registers{ reinterpret_cast<DMA_Stream_TypeDef*>((Controller == 1 ? DMA1_Stream0_BASE : DMA2_Stream0_BASE) + 0x18U * Stream) };
+            DMAMUX_Channel_TypeDef* const mux{ reinterpret_cast<DMAMUX_Channel_TypeDef*>(DMAMUX1_Channel0_BASE + 4U * Id::channel) };
+            static DmaStreamHandler handler{ Controller, Stream, &registers->CR, &registers->NDTR, &registers->PAR, &registers->M0AR,
+                                             &registers->M1AR, &registers->FCR, Stream < 4 ? &dma->LISR : &dma->HISR,
+                                             Stream < 4 ? &dma->LIFCR : &dma->HIFCR, &mux->CCR };
+            return handler;
+        }
+
+        /**
+         * @brief Handler of the stream a user owns in the project's allocation.
+         */
+        template<typename Allocation, auto User>
+        DmaStreamHandler& stream()
+        {
+            using Id = typename Allocation::template Stream<User>;
+            return stream<Id::controller, Id::stream>();
+        }
+    #endif
+};
+
+#endif // __DMA_H__
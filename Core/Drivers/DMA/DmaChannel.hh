@@ -0,0 +1,240 @@
+#ifndef __DMACHANNEL_H__
+#define __DMACHANNEL_H__
+
+/**
+ * @file DmaChannel.hh
+ * @brief What the DMA1/DMA2 streams and the BDMA channels share: data sizes, modes and the channel handler core.
+ *
+ * A BDMA channel is a DMA1/DMA2 stream without FIFO and bursts: the same control fields
+ * at other positions, an item counter, a peripheral and two memory addresses with the
+ * current target bit of double-buffer mode, and a group of flags per channel in a
+ * status and clear register pair. DmaChannelBase drives that register model once; each
+ * driver describes its controller in a layout and adds its own checks and registers
+ * (see Dma.hh and Bdma.hh).
+ *
+ * A layout provides:
+ *  - Config, Event, Registers, PropertiesList and RegistersList of the handler, and
+ *    index, the property holding the stream or channel number;
+ *  - the control positions: enable, the three interrupt enables, direction, circular,
+ *    the increments, the sizes, priority, double buffer and current target;
+ *  - the flags: transferComplete, halfTransfer, transferError and all, flagShift() of a
+ *    channel, and events, the flags in the order handleInterrupt() reports them.
+ */
+
+//<------------------------------INCLUDES------------------------------>//
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <PeripheralBaseHandler.hh>
+#include <DriverError.hh>
+//<-------------------------------------------------------------------->//
+
+enum class DmaDataSize : std::uint8_t { byte, halfWord, word };
+enum class DmaMode : std::uint8_t { normal, circular, doubleBuffer };
+enum class DmaPriority : std::uint8_t { low, medium, high, veryHigh };
+
+namespace Dma
+{
+    inline constexpr std::uint32_t maxItems{ 0xFFFF };
+
+    /// Polling iterations stop() waits for the channel to finish its current beat.
+    inline constexpr std::uint32_t stopTimeoutLoops{ 0xFFFF };
+
+    constexpr std::uint32_t bytesOf(const DmaDataSize size) { return 1U << static_cast<std::uint32_t>(size); }
+
+    /// A flag of a channel and the event it reports.
+    template<typename Event>
+    struct FlagEvent {
+        std::uint32_t flag;
+        Event event;
+    };
+
+    /// Control fields every controller has, at the positions of Layout. Double-buffer mode is circular.
+    template<typename Layout, typename Config>
+    constexpr std::uint32_t channelControl(const Config& config)
+    {
+        return (static_cast<std::uint32_t>(config.direction) << Layout::directionPos) |
+               ((config.mode != DmaMode::normal ? 1U : 0U) << Layout::circularPos) |
+               ((config.peripheralIncrement ? 1U : 0U) << Layout::peripheralIncrementPos) |
+               ((config.memoryIncrement ? 1U : 0U) << Layout::memoryIncrementPos) |
+               (static_cast<std::uint32_t>(config.peripheralSize) << Layout::peripheralSizePos) |
+               (static_cast<std::uint32_t>(config.memorySize) << Layout::memorySizePos) |
+               (static_cast<std::uint32_t>(config.priority) << Layout::priorityPos) |
+               ((config.mode == DmaMode::doubleBuffer ? 1U : 0U) << Layout::doubleBufferPos);
+    }
+
+    /**
+     * @brief Poll a disabled channel until it has finished its current beat.
+     * @return DriverStatus DriverError::timeout if it is still enabled after stopTimeoutLoops polls.
+     */
+    template<typename IsEnabled>
+    DriverStatus awaitDisabled(IsEnabled&& isEnabled)
+    {
+        for (std::uint32_t loop = 0; isEnabled(); ++loop) {
+            if (loop == stopTimeoutLoops) { return Utils::fail(DriverError::timeout); }
+        }
+        return {};
+    }
+};
+
+/**
+ * @brief Handler of a DMA stream or BDMA channel, on the register model of Layout.
+ * @tparam Handler The driver's handler, which checks the buffers of a transfer in
+ * checkBuffers(peripheral, memory, bytes).
+ */
+template<typename Layout, typename Handler>
+class DmaChannelBase : public PeripheralHandlerBase<typename Layout::PropertiesList, typename Layout::RegistersList, Handler>
+{
+    public:
+        using Config = typename Layout::Config;
+        using Event = typename Layout::Event;
+        using Callback = void (*)(void* context, Event event, std::uint8_t buffer);
+
+    private:
+        using classParent = PeripheralHandlerBase<typename Layout::PropertiesList, typename Layout::RegistersList, Handler>;
+        using Registers = typename Layout::Registers;
+
+        Config config{};
+        bool configured{ false };
+        Callback callback{ nullptr };
+        void* context{ nullptr };
+        std::uint32_t reported{ 0 };
+
+        std::uint32_t shift() { return Layout::flagShift(this->template getParam<Layout::index>()); }
+
+        DriverStatus checkTransfer(const std::uint32_t peripheral, const std::uint32_t memory, const std::uint32_t count)
+        {
+            RESULT_TRY(this->status());
+            if (!configured) { return Utils::fail(DriverError::notInitialized); }
+            if (isEnabled()) { return Utils::fail(DriverError::busy); }
+            if (count == 0 || count > Dma::maxItems) { return Utils::fail(DriverError::invalidParameter); }
+            // The count is in peripheral items, the memory side must end on whole items too
+            const std::uint32_t bytes{ count * Dma::bytesOf(config.peripheralSize) };
+            if (bytes % Dma::bytesOf(config.memorySize) != 0) { return Utils::fail(DriverError::invalidParameter); }
+            return static_cast<Handler*>(this)->checkBuffers(peripheral, memory, bytes);
+        }
+
+        void enable(const std::uint32_t count)
+        {
+            clearFlags(Layout::allFlags);
+            this->template setRegisterValue<Registers::count>(count);
+            this->template setRegisterValue<Registers::control>(this->template getRegisterValue<Registers::control>() | (1U << Layout::enablePos));
+        }
+
+    protected:
+        using classParent::classParent;
+
+        /**
+         * @brief Route the request and write the control register of a stopped channel.
+         * @param control Control value of newConfig with the interrupt enables of the controller's own errors.
+         * @param errorFlags The flags of those errors, reported as well when there is a callback.
+         */
+        void program(const Config& newConfig, std::uint32_t control, const std::uint32_t errorFlags, const Callback newCallback, void* newContext)
+        {
+            reported = 0;
+            if (newCallback != nullptr) {
+                control |= (1U << Layout::transferCompleteInterruptPos) | (1U << Layout::transferErrorInterruptPos);
+                reported = Layout::transferCompleteFlag | Layout::transferErrorFlag | errorFlags;
+                if (newConfig.halfTransferInterrupt) {
+                    control |= 1U << Layout::halfTransferInterruptPos;
+                    reported |= Layout::halfTransferFlag;
+                }
+            }
+            this->template setRegisterValue<Registers::muxControl>(static_cast<std::uint32_t>(newConfig.request));
+            this->template setRegisterValue<Registers::control>(control);
+            clearFlags(Layout::allFlags);
+
+            config = newConfig;
+            callback = newCallback;
+            context = newContext;
+            configured = true;
+        }
+
+    public:
+        /**
+         * @brief Start a normal or circular transfer.
+         * @param peripheral Peripheral data register, or the source of a memory-to-memory copy.
+         * @param memory Memory buffer, or the destination of a memory-to-memory copy.
+         * @param count Data items of the peripheral size, 1 to 65535.
+         */
+        DriverStatus start(const std::uint32_t peripheral, const std::uint32_t memory, const std::uint32_t count)
+        {
+            if (config.mode == DmaMode::doubleBuffer) { return Utils::fail(DriverError::invalidParameter); }
+            RESULT_TRY(checkTransfer(peripheral, memory, count));
+            this->template setRegisterValue<Registers::peripheralAddress>(peripheral);
+            this->template setRegisterValue<Registers::memory0Address>(memory);
+            enable(count);
+            return {};
+        }
+
+        /**
+         * @brief Start a double-buffer transfer, memory 0 first.
+         * @param count Data items per buffer.
+         */
+        DriverStatus startDoubleBuffer(const std::uint32_t peripheral, const std::uint32_t memory0, const std::uint32_t memory1, const std::uint32_t count)
+        {
+            if (config.mode != DmaMode::doubleBuffer) { return Utils::fail(DriverError::invalidParameter); }
+            RESULT_TRY(checkTransfer(peripheral, memory0, count));
+            RESULT_TRY(checkTransfer(peripheral, memory1, count));
+            this->template setRegisterValue<Registers::peripheralAddress>(peripheral);
+            this->template setRegisterValue<Registers::memory0Address>(memory0);
+            this->template setRegisterValue<Registers::memory1Address>(memory1);
+            this->template setRegisterValue<Registers::control>(this->template getRegisterValue<Registers::control>() & ~(1U << Layout::currentTargetPos));
+            enable(count);
+            return {};
+        }
+
+        /**
+         * @brief Disable the channel and wait until the current beat completes.
+         * @return DriverStatus DriverError::timeout, see Dma::awaitDisabled().
+         */
+        DriverStatus stop()
+        {
+            RESULT_TRY(this->status());
+            this->template setRegisterValue<Registers::control>(this->template getRegisterValue<Registers::control>() & ~(1U << Layout::enablePos));
+            RESULT_TRY(Dma::awaitDisabled([this] { return isEnabled(); }));
+            clearFlags(Layout::allFlags);
+            return {};
+        }
+
+        bool isEnabled() { return this->template checkBit<Registers::control>(Layout::enablePos); }
+
+        /// Data items left in the current buffer.
+        std::uint32_t remaining() { return this->template getRegisterValue<Registers::count>() & Dma::maxItems; }
+
+        /// Buffer the channel is working on in double-buffer mode, 0 or 1.
+        std::uint8_t currentBuffer() { return this->template checkBit<Registers::control>(Layout::currentTargetPos) ? 1 : 0; }
+
+        /// Flags of this channel, as the *Flag constants of its controller.
+        std::uint32_t flags() { return (this->template getRegisterValue<Registers::interruptStatus>() >> shift()) & Layout::allFlags; }
+
+        void clearFlags(const std::uint32_t mask) { this->template setRegisterValue<Registers::interruptClear>((mask & Layout::allFlags) << shift()); }
+
+        /**
+         * @brief Acknowledge the flags of the channel and report them to the callback, from its IRQ handler.
+         *
+         * Errors come first, then half transfer, then transfer complete. The flags whose
+         * interrupt is off are left for polling with flags().
+         * @return std::uint32_t Flags handled.
+         */
+        std::uint32_t handleInterrupt()
+        {
+            const std::uint32_t pending{ flags() & reported };
+            if (pending == 0) { return 0; }
+            clearFlags(pending);
+
+            const std::uint8_t current{ currentBuffer() };
+            for (const Dma::FlagEvent<Event>& entry : Layout::events) {
+                if ((pending & entry.flag) == 0) { continue; }
+                // The target toggles when a buffer completes: the finished one is the other
+                const bool toggled{ entry.flag == Layout::transferCompleteFlag && config.mode == DmaMode::doubleBuffer };
+                callback(context, entry.event, toggled ? static_cast<std::uint8_t>(current ^ 1U) : current);
+            }
+            return pending;
+        }
+
+        const Config& configuration() const { return config; }
+};
+
+#endif // __DMACHANNEL_H__
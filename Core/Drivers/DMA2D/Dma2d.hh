@@ -0,0 +1,715 @@
+#ifndef __DMA2D_H__
+#define __DMA2D_H__
+
+/**
+ * @file Dma2d.hh
+ * @brief DMA2D (Chrom-ART) driver: fill, copy, pixel format conversion and blending of rectangles, with a queue.
+ *
+ * An operation works on a rectangle of width x height pixels. Dma2dSurface names a frame
+ * buffer (address, pitch in pixels, format) and the builders of namespace Dma2d turn a
+ * surface and a rectangle into the Dma2dOperation the hardware runs:
+ *  - fill(): register-to-memory, the rectangle set to one color;
+ *  - copy(): memory-to-memory, with pixel format conversion when the formats differ or
+ *    the alpha of the source is changed;
+ *  - blend(): a foreground rectangle over a background one, written to a third surface
+ *    or back to the background.
+ * Formats are ARGB8888, RGB888, RGB565, ARGB1555 and ARGB4444 on both sides, and A8 on
+ * the input side (glyphs: the color comes with the operation, the pixels are the alpha).
+ * Indexed formats, which need a CLUT load, are not supported.
+ *
+ * Dma2dHandler runs one operation at a time; Dma2dQueue keeps Pending of them and starts
+ * each from the transfer complete interrupt of the previous one, so a screen worth of
+ * small blits runs back to back without the CPU.
+ *
+ * Dma2d::render() is the reference of what an operation produces, pixel by pixel, after
+ * the formulas of the reference manual (RM0399, DMA2D): expansion to 8 bits per channel
+ * by replicating the high bits, alpha modes, then
+ *      alphaMult = alphaFg * alphaBg / 255
+ *      alphaOut  = alphaFg + alphaBg - alphaMult
+ *      C         = (Cfg * alphaFg + Cbg * alphaBg - Cbg * alphaMult) / alphaOut
+ * with truncating divisions, and reduction by dropping the low bits. The host model
+ * executes operations with it and the benchmark checks CPU blits against it. It is written for
+ * exactness, not speed: several times slower than a hand-written blit.
+ *
+ * On the CM7 the queue cleans the source rectangles and cleans and invalidates the output
+ * one at submission, and invalidates the output again on completion. The DMA2D cannot
+ * reach the TCMs.
+ *
+ * Usage example:
+ * ```
+ * AXI_BSS std::uint16_t frame[272][480];
+ * constexpr Dma2dSurface screen{ reinterpret_cast<std::uint32_t>(frame), 480, Dma2dFormat::rgb565 };
+ * Dma2dQueue<16> blitter{ Dma2d::handler() };
+ * extern "C" void DMA2D_IRQHandler() { Dma2d::handler().handleInterrupt(); }
+ *
+ * static_cast<void>(Dma2d::fill(screen, { 0, 0, 480, 272 }, 0xFF202020).andThen([](const Dma2dOperation& op) { return blitter.submit(op); }));
+ * const auto token{ Dma2d::blend(screen, 16, 16, icon, { 0, 0, 64, 64 }).andThen([](const Dma2dOperation& op) { return blitter.submit(op); }) };
+ * if (token) { blitter.wait(token.value()); }
+ * ```
+ */
+
+//<------------------------------INCLUDES------------------------------>//
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <PeripheralBaseHandler.hh>
+#include <DriverError.hh>
+#include <Cache.hh>
+#include <CompletionQueue.hh>
+#include <MemorySections.hh>
+#include <Result.hh>
+#if defined(CORE_CM7) || defined(CORE_CM4)
+#include <stm32h755xx.h>
+#endif
+//<-------------------------------------------------------------------->//
+
+enum class Dma2dFormat : std::uint8_t { argb8888, rgb888, rgb565, argb1555, argb4444, a8 };
+
+/// Alpha of the input pixels: as read, replaced by the layer alpha, or multiplied by it.
+enum class Dma2dAlphaMode : std::uint8_t { keep, replace, multiply };
+
+/// CR MODE values.
+enum class Dma2dMode : std::uint8_t { copy = 0, convert = 1, blend = 2, fill = 3 };
+
+/**
+ * @brief Events reported to the handler callback, one per operation.
+ */
+enum class Dma2dEvent : std::uint8_t {
+    transferComplete,
+    transferError,          ///< Bus error, the operation stopped.
+    configurationError      ///< Format, size or alignment refused by the hardware, nothing ran.
+};
+
+/**
+ * @brief A frame buffer: first pixel, pixels per line in memory and format.
+ */
+struct Dma2dSurface {
+    std::uint32_t address;
+    std::uint16_t pitch;
+    Dma2dFormat format;
+};
+
+struct Dma2dRect {
+    std::uint16_t x;
+    std::uint16_t y;
+    std::uint16_t width;
+    std::uint16_t height;
+};
+
+/**
+ * @brief Alpha and color of an input layer.
+ */
+struct Dma2dLayerOptions {
+    Dma2dAlphaMode alphaMode{ Dma2dAlphaMode::keep };
+    std::uint8_t alpha{ 0xFF };
+    std::uint32_t color{ 0 };           ///< RGB of A8 pixels.
+};
+
+/**
+ * @brief An input layer as the hardware sees it: first pixel of the rectangle and pixels skipped per line.
+ */
+struct Dma2dLayer {
+    std::uint32_t address{ 0 };
+    std::uint16_t offset{ 0 };
+    Dma2dFormat format{ Dma2dFormat::argb8888 };
+    Dma2dLayerOptions options{};
+};
+
+/**
+ * @brief One DMA2D operation, register values in a readable form.
+ */
+struct Dma2dOperation {
+    Dma2dMode mode{ Dma2dMode::copy };
+    Dma2dLayer foreground{};
+    Dma2dLayer background{};            ///< Blend only.
+    std::uint32_t output{ 0 };
+    std::uint16_t outputOffset{ 0 };
+    Dma2dFormat outputFormat{ Dma2dFormat::argb8888 };
+    std::uint32_t color{ 0 };           ///< Fill only, in the output format.
+    std::uint16_t width{ 0 };
+    std::uint16_t height{ 0 };
+};
+
+namespace Dma2d
+{
+    inline constexpr std::uint32_t maxWidth{ 0x3FFF };
+    inline constexpr std::uint32_t maxHeight{ 0xFFFF };
+    inline constexpr std::uint32_t maxOffset{ 0x3FFF };
+
+    /// Default polling iterations abort() waits for the operation to stop.
+    inline constexpr std::uint32_t abortTimeoutLoops{ 0xFFFF };
+
+    // CR
+    inline constexpr std::uint32_t startPos{ 0 };
+    inline constexpr std::uint32_t abortPos{ 2 };
+    inline constexpr std::uint32_t transferErrorInterruptPos{ 8 };
+    inline constexpr std::uint32_t transferCompleteInterruptPos{ 9 };
+    inline constexpr std::uint32_t configurationErrorInterruptPos{ 13 };
+    inline constexpr std::uint32_t modePos{ 16 };
+
+    // xPFCCR
+    inline constexpr std::uint32_t colorModePos{ 0 };
+    inline constexpr std::uint32_t alphaModePos{ 16 };
+    inline constexpr std::uint32_t alphaPos{ 24 };
+
+    // NLR
+    inline constexpr std::uint32_t pixelsPerLinePos{ 16 };
+
+    // ISR and IFCR
+    inline constexpr std::uint32_t transferErrorFlag{ 1U << 0 };
+    inline constexpr std::uint32_t transferCompleteFlag{ 1U << 1 };
+    inline constexpr std::uint32_t configurationErrorFlag{ 1U << 5 };
+    inline constexpr std::uint32_t allFlags{ 0x3FU };
+
+    constexpr std::uint32_t bytesPerPixel(const Dma2dFormat format)
+    {
+        switch (format) {
+            case Dma2dFormat::argb8888: return 4;
+            case Dma2dFormat::rgb888: return 3;
+            case Dma2dFormat::a8: return 1;
+            default: return 2;
+        }
+    }
+
+    /// CM field of the input and output PFC registers.
+    constexpr std::uint32_t colorMode(const Dma2dFormat format) { return format == Dma2dFormat::a8 ? 9U : static_cast<std::uint32_t>(format); }
+
+    /// Format of a CM field, false for the ones the driver does not use.
+    constexpr bool formatOf(const std::uint32_t mode, Dma2dFormat& format)
+    {
+        if (mode <= static_cast<std::uint32_t>(Dma2dFormat::argb4444)) {
+            format = static_cast<Dma2dFormat>(mode);
+            return true;
+        }
+        if (mode == 9U) {
+            format = Dma2dFormat::a8;
+            return true;
+        }
+        return false;
+    }
+
+    constexpr std::uint32_t layerControl(const Dma2dLayer& layer)
+    {
+        return (colorMode(layer.format) << colorModePos) | (static_cast<std::uint32_t>(layer.options.alphaMode) << alphaModePos) |
+               (static_cast<std::uint32_t>(layer.options.alpha) << alphaPos);
+    }
+
+    //<------------------------------PIXELS------------------------------>//
+
+    constexpr std::uint32_t argb(const std::uint32_t a, const std::uint32_t r, const std::uint32_t g, const std::uint32_t b)
+    {
+        return (a << 24) | (r << 16) | (g << 8) | b;
+    }
+
+    constexpr std::uint32_t expand5(const std::uint32_t value) { return (value << 3) | (value >> 2); }
+    constexpr std::uint32_t expand6(const std::uint32_t value) { return (value << 2) | (value >> 4); }
+    constexpr std::uint32_t expand4(const std::uint32_t value) { return (value << 4) | value; }
+
+    constexpr std::uint32_t multiply(const std::uint32_t first, const std::uint32_t second) { return first * second / 255U; }
+
+    /**
+     * @brief Raw pixel value of a format to ARGB8888.
+     * @param color RGB of A8 pixels.
+     */
+    constexpr std::uint32_t unpack(const std::uint32_t raw, const Dma2dFormat format, const std::uint32_t color = 0)
+    {
+        switch (format) {
+            case Dma2dFormat::argb8888: return raw;
+            case Dma2dFormat::rgb888: return 0xFF000000U | (raw & 0xFFFFFFU);
+            case Dma2dFormat::rgb565: return argb(0xFF, expand5(raw >> 11), expand6((raw >> 5) & 0x3FU), expand5(raw & 0x1FU));
+            case Dma2dFormat::argb1555:
+                return argb((raw & 0x8000U) != 0 ? 0xFFU : 0U, expand5((raw >> 10) & 0x1FU), expand5((raw >> 5) & 0x1FU), expand5(raw & 0x1FU));
+            case Dma2dFormat::argb4444:
+                return argb(expand4(raw >> 12), expand4((raw >> 8) & 0xFU), expand4((raw >> 4) & 0xFU), expand4(raw & 0xFU));
+            case Dma2dFormat::a8: return ((raw & 0xFFU) << 24) | (color & 0xFFFFFFU);
+        }
+        return 0;
+    }
+
+    /// ARGB8888 to the raw pixel value of an output format.
+    constexpr std::uint32_t pack(const std::uint32_t pixel, const Dma2dFormat format)
+    {
+        const std::uint32_t a{ pixel >> 24 };
+        const std::uint32_t r{ (pixel >> 16) & 0xFFU };
+        const std::uint32_t g{ (pixel >> 8) & 0xFFU };
+        const std::uint32_t b{ pixel & 0xFFU };
+        switch (format) {
+            case Dma2dFormat::argb8888: return pixel;
+            case Dma2dFormat::rgb888: return pixel & 0xFFFFFFU;
+            case Dma2dFormat::rgb565: return ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+            case Dma2dFormat::argb1555: return ((a >> 7) << 15) | ((r >> 3) << 10) | ((g >> 3) << 5) | (b >> 3);
+            case Dma2dFormat::argb4444: return ((a >> 4) << 12) | ((r >> 4) << 8) | ((g >> 4) << 4) | (b >> 4);
+            case Dma2dFormat::a8: return a;
+        }
+        return 0;
+    }
+
+    constexpr std::uint32_t applyAlpha(const std::uint32_t pixel, const Dma2dLayerOptions& options)
+    {
+        const std::uint32_t alpha{ pixel >> 24 };
+        switch (options.alphaMode) {
+            case Dma2dAlphaMode::replace: return (pixel & 0xFFFFFFU) | (static_cast<std::uint32_t>(options.alpha) << 24);
+            case Dma2dAlphaMode::multiply: return (pixel & 0xFFFFFFU) | (multiply(alpha, options.alpha) << 24);
+            default: return pixel;
+        }
+    }
+
+    /// Foreground over background, both ARGB8888.
+    constexpr std::uint32_t blendPixel(const std::uint32_t foreground, const std::uint32_t background)
+    {
+        const std::uint32_t alphaFg{ foreground >> 24 };
+        const std::uint32_t alphaBg{ background >> 24 };
+        const std::uint32_t alphaMult{ multiply(alphaFg, alphaBg) };
+        const std::uint32_t alphaOut{ alphaFg + alphaBg - alphaMult };
+        if (alphaOut == 0) { return 0; }
+        std::uint32_t result{ alphaOut << 24 };
+        for (std::uint32_t shift = 0; shift < 24; shift += 8) {
+            const std::uint32_t fg{ (foreground >> shift) & 0xFFU };
+            const std::uint32_t bg{ (background >> shift) & 0xFFU };
+            result |= ((fg * alphaFg + bg * alphaBg - bg * alphaMult) / alphaOut) << shift;
+        }
+        return result;
+    }
+
+    inline std::uint32_t readPixel(const std::uint8_t* pixel, const std::uint32_t bytes)
+    {
+        // Little endian, like the bus; fixed sizes keep the copies inline
+        std::uint32_t raw{ 0 };
+        switch (bytes) {
+            case 1: raw = *pixel; break;
+            case 2: std::memcpy(&raw, pixel, 2); break;
+            case 3: std::memcpy(&raw, pixel, 3); break;
+            default: std::memcpy(&raw, pixel, 4); break;
+        }
+        return raw;
+    }
+
+    inline void writePixel(std::uint8_t* pixel, const std::uint32_t raw, const std::uint32_t bytes)
+    {
+        switch (bytes) {
+            case 1: *pixel = static_cast<std::uint8_t>(raw); break;
+            case 2: std::memcpy(pixel, &raw, 2); break;
+            case 3: std::memcpy(pixel, &raw, 3); break;
+            default: std::memcpy(pixel, &raw, 4); break;
+        }
+    }
+
+    /**
+     * @brief Run an operation on the CPU, pixel for pixel what the DMA2D produces.
+     * @param pointerOf Maps a bus address and a byte count to a std::uint8_t*; nullptr stops the operation as a bus error would.
+     * @return bool false on an address pointerOf does not map.
+     */
+    template<typename PointerOf>
+    bool render(const Dma2dOperation& operation, PointerOf&& pointerOf)
+    {
+        const std::uint32_t outputBytes{ bytesPerPixel(operation.outputFormat) };
+        const std::uint32_t foregroundBytes{ bytesPerPixel(operation.foreground.format) };
+        const std::uint32_t backgroundBytes{ bytesPerPixel(operation.background.format) };
+        for (std::uint32_t line = 0; line < operation.height; ++line) {
+            const std::uint32_t outputLine{ operation.output + line * (operation.width + operation.outputOffset) * outputBytes };
+            const std::uint32_t foregroundLine{ operation.foreground.address + line * (operation.width + operation.foreground.offset) * foregroundBytes };
+            const std::uint32_t backgroundLine{ operation.background.address + line * (operation.width + operation.background.offset) * backgroundBytes };
+            std::uint8_t* output{ pointerOf(outputLine, operation.width * outputBytes) };
+            if (output == nullptr) { return false; }
+            if (operation.mode == Dma2dMode::fill) {
+                for (std::uint32_t column = 0; column < operation.width; ++column) { writePixel(output + column * outputBytes, operation.color, outputBytes); }
+                continue;
+            }
+            const std::uint8_t* foreground{ pointerOf(foregroundLine, operation.width * foregroundBytes) };
+            if (foreground == nullptr) { return false; }
+            if (operation.mode == Dma2dMode::copy) {
+                std::memmove(output, foreground, operation.width * outputBytes);
+                continue;
+            }
+            const std::uint8_t* background{ operation.mode == Dma2dMode::blend ? pointerOf(backgroundLine, operation.width * backgroundBytes) : foreground };
+            if (background == nullptr) { return false; }
+            for (std::uint32_t column = 0; column < operation.width; ++column) {
+                std::uint32_t pixel{ applyAlpha(unpack(readPixel(foreground + column * foregroundBytes, foregroundBytes), operation.foreground.format,
+                                                       operation.foreground.options.color), operation.foreground.options) };
+                if (operation.mode == Dma2dMode::blend) {
+                    const std::uint32_t under{ applyAlpha(unpack(readPixel(background + column * backgroundBytes, backgroundBytes), operation.background.format,
+                                                                 operation.background.options.color), operation.background.options) };
+                    pixel = blendPixel(pixel, under);
+                }
+                writePixel(output + column * outputBytes, pack(pixel, operation.outputFormat), outputBytes);
+            }
+        }
+        return true;
+    }
+
+    //<-----------------------------BUILDERS----------------------------->//
+
+    constexpr bool isOutputFormat(const Dma2dFormat format) { return format != Dma2dFormat::a8; }
+
+    constexpr bool isAligned(const std::uint32_t address, const Dma2dFormat format)
+    {
+        const std::uint32_t bytes{ bytesPerPixel(format) };
+        return bytes == 3 || address % bytes == 0;
+    }
+
+    /// Bytes from the first pixel of a rectangle to the end of its last one.
+    constexpr std::uint32_t spanBytes(const std::uint16_t width, const std::uint16_t height, const std::uint16_t offset, const Dma2dFormat format)
+    {
+        return ((height - 1U) * (width + offset) + width) * bytesPerPixel(format);
+    }
+
+    /**
+     * @brief Check an operation against the limits of the hardware.
+     * @return bool true if the hardware runs it without a configuration error.
+     */
+    constexpr bool isValid(const Dma2dOperation& operation)
+    {
+        if (operation.width == 0 || operation.height == 0 || operation.width > maxWidth) { return false; }
+        if (!isOutputFormat(operation.outputFormat) || !isAligned(operation.output, operation.outputFormat) || operation.outputOffset > maxOffset) { return false; }
+        if (MemorySections::isInTcm(operation.output, spanBytes(operation.width, operation.height, operation.outputOffset, operation.outputFormat))) { return false; }
+        const auto layerValid = [&](const Dma2dLayer& layer) {
+            return layer.offset <= maxOffset && isAligned(layer.address, layer.format) &&
+                   !MemorySections::isInTcm(layer.address, spanBytes(operation.width, operation.height, layer.offset, layer.format));
+        };
+        switch (operation.mode) {
+            case Dma2dMode::fill: return true;
+            case Dma2dMode::copy: return operation.foreground.format == operation.outputFormat && layerValid(operation.foreground);
+            case Dma2dMode::convert: return layerValid(operation.foreground);
+            case Dma2dMode::blend: return layerValid(operation.foreground) && layerValid(operation.background);
+        }
+        return false;
+    }
+
+    /// Address of pixel (x, y) of a surface.
+    constexpr std::uint32_t pixelAddress(const Dma2dSurface& surface, const std::uint16_t x, const std::uint16_t y)
+    {
+        return surface.address + (static_cast<std::uint32_t>(y) * surface.pitch + x) * bytesPerPixel(surface.format);
+    }
+
+    constexpr bool fits(const Dma2dSurface& surface, const std::uint16_t x, const std::uint16_t width)
+    {
+        return width > 0 && static_cast<std::uint32_t>(x) + width <= surface.pitch;
+    }
+
+    constexpr Dma2dLayer layerOf(const Dma2dSurface& surface, const std::uint16_t x, const std::uint16_t y, const std::uint16_t width, const Dma2dLayerOptions& options)
+    {
+        return Dma2dLayer{ pixelAddress(surface, x, y), static_cast<std::uint16_t>(surface.pitch - width), surface.format, options };
+    }
+
+    constexpr Utils::Result<Dma2dOperation, DriverError> checked(const Dma2dOperation& operation)
+    {
+        if (!isValid(operation)) { return Utils::fail(DriverError::invalidParameter); }
+        return operation;
+    }
+
+    /**
+     * @brief Set a rectangle of a surface to one color.
+     * @param color ARGB8888, reduced to the surface format.
+     */
+    constexpr Utils::Result<Dma2dOperation, DriverError> fill(const Dma2dSurface& target, const Dma2dRect& rect, const std::uint32_t color)
+    {
+        if (!fits(target, rect.x, rect.width)) { return Utils::fail(DriverError::invalidParameter); }
+        Dma2dOperation operation{};
+        operation.mode = Dma2dMode::fill;
+        operation.output = pixelAddress(target, rect.x, rect.y);
+        operation.outputOffset = static_cast<std::uint16_t>(target.pitch - rect.width);
+        operation.outputFormat = target.format;
+        operation.color = pack(color, target.format);
+        operation.width = rect.width;
+        operation.height = rect.height;
+        return checked(operation);
+    }
+
+    /**
+     * @brief Copy a rectangle of source to (x, y) of target, converting the pixel format if they differ.
+     * @param options Alpha and A8 color of the source; anything but the defaults makes it a conversion.
+     */
+    constexpr Utils::Result<Dma2dOperation, DriverError> copy(const Dma2dSurface& target, const std::uint16_t x, const std::uint16_t y,
+                                                              const Dma2dSurface& source, const Dma2dRect& area, const Dma2dLayerOptions& options = {})
+    {
+        if (!fits(target, x, area.width) || !fits(source, area.x, area.width)) { return Utils::fail(DriverError::invalidParameter); }
+        const bool plain{ source.format == target.format && options.alphaMode == Dma2dAlphaMode::keep };
+        Dma2dOperation operation{};
+        operation.mode = plain ? Dma2dMode::copy : Dma2dMode::convert;
+        operation.foreground = layerOf(source, area.x, area.y, area.width, options);
+        operation.output = pixelAddress(target, x, y);
+        operation.outputOffset = static_cast<std::uint16_t>(target.pitch - area.width);
+        operation.outputFormat = target.format;
+        operation.width = area.width;
+        operation.height = area.height;
+        return checked(operation);
+    }
+
+    /**
+     * @brief Blend a rectangle of foreground over the background at (bx, by), written to target at (x, y).
+     */
+    constexpr Utils::Result<Dma2dOperation, DriverError> blend(const Dma2dSurface& target, const std::uint16_t x, const std::uint16_t y,
+                                                               const Dma2dSurface& foreground, const Dma2dRect& area,
+                                                               const Dma2dSurface& background, const std::uint16_t bx, const std::uint16_t by,
+                                                               const Dma2dLayerOptions& foregroundOptions = {}, const Dma2dLayerOptions& backgroundOptions = {})
+    {
+        if (!fits(target, x, area.width) || !fits(foreground, area.x, area.width) || !fits(background, bx, area.width)) {
+            return Utils::fail(DriverError::invalidParameter);
+        }
+        Dma2dOperation operation{};
+        operation.mode = Dma2dMode::blend;
+        operation.foreground = layerOf(foreground, area.x, area.y, area.width, foregroundOptions);
+        operation.background = layerOf(background, bx, by, area.width, backgroundOptions);
+        operation.output = pixelAddress(target, x, y);
+        operation.outputOffset = static_cast<std::uint16_t>(target.pitch - area.width);
+        operation.outputFormat = target.format;
+        operation.width = area.width;
+        operation.height = area.height;
+        return checked(operation);
+    }
+
+    /// Blend a rectangle of foreground onto target at (x, y), in place.
+    constexpr Utils::Result<Dma2dOperation, DriverError> blend(const Dma2dSurface& target, const std::uint16_t x, const std::uint16_t y,
+                                                               const Dma2dSurface& foreground, const Dma2dRect& area, const Dma2dLayerOptions& options = {})
+    {
+        return blend(target, x, y, foreground, area, target, x, y, options);
+    }
+};
+
+enum class Dma2dProperties { abortTimeout };
+using Dma2dPropertiesTypeList = Utils::TypeList<
+    pair<Dma2dProperties::abortTimeout, std::uint32_t>
+>;
+
+enum class Dma2dRegisters {
+    control, interruptStatus, interruptClear, foregroundAddress, foregroundOffset, backgroundAddress, backgroundOffset,
+    foregroundControl, foregroundColor, backgroundControl, backgroundColor, outputControl, outputColor, outputAddress, outputOffset, lineCount
+};
+using Dma2dRegistersTypeList = Utils::TypeList<
+    pair<Dma2dRegisters::control, volatile std::uint32_t*>,              // CR
+    pair<Dma2dRegisters::interruptStatus, volatile std::uint32_t*>,      // ISR
+    pair<Dma2dRegisters::interruptClear, volatile std::uint32_t*>,       // IFCR
+    pair<Dma2dRegisters::foregroundAddress, volatile std::uint32_t*>,    // FGMAR
+    pair<Dma2dRegisters::foregroundOffset, volatile std::uint32_t*>,     // FGOR
+    pair<Dma2dRegisters::backgroundAddress, volatile std::uint32_t*>,    // BGMAR
+    pair<Dma2dRegisters::backgroundOffset, volatile std::uint32_t*>,     // BGOR
+    pair<Dma2dRegisters::foregroundControl, volatile std::uint32_t*>,    // FGPFCCR
+    pair<Dma2dRegisters::foregroundColor, volatile std::uint32_t*>,      // FGCOLR
+    pair<Dma2dRegisters::backgroundControl, volatile std::uint32_t*>,    // BGPFCCR
+    pair<Dma2dRegisters::backgroundColor, volatile std::uint32_t*>,      // BGCOLR
+    pair<Dma2dRegisters::outputControl, volatile std::uint32_t*>,        // OPFCCR
+    pair<Dma2dRegisters::outputColor, volatile std::uint32_t*>,          // OCOLR
+    pair<Dma2dRegisters::outputAddress, volatile std::uint32_t*>,        // OMAR
+    pair<Dma2dRegisters::outputOffset, volatile std::uint32_t*>,         // OOR
+    pair<Dma2dRegisters::lineCount, volatile std::uint32_t*>             // NLR
+>;
+
+class Dma2dHandler : public PeripheralHandlerBase<Dma2dPropertiesTypeList, Dma2dRegistersTypeList, Dma2dHandler>
+{
+    public:
+        using Callback = void (*)(void* context, Dma2dEvent event);
+
+    private:
+        using classParent = PeripheralHandlerBase<Dma2dPropertiesTypeList, Dma2dRegistersTypeList, Dma2dHandler>;
+
+        Callback callback{ nullptr };
+        void* context{ nullptr };
+        std::uint32_t interrupts{ 0 };
+        std::uint32_t reported{ 0 };
+
+    public:
+        /**
+         * @param abortTimeout Polling iterations abort() waits for, Dma2d::abortTimeoutLoops usually.
+         * @param addresses CR, ISR, IFCR, FGMAR, FGOR, BGMAR, BGOR, FGPFCCR, FGCOLR, BGPFCCR, BGCOLR, OPFCCR, OCOLR, OMAR, OOR and NLR.
+         */
+        template<typename... RegisterAddress>
+        requires ((Utils::UnsignedIntegralPointerConcept<std::decay_t<RegisterAddress>> && ...))
+        explicit Dma2dHandler(const std::uint32_t abortTimeout, RegisterAddress&&... addresses)
+            : classParent(this, std::forward<RegisterAddress>(addresses)...) {
+            setParam<Dma2dProperties::abortTimeout>(abortTimeout);
+        }
+
+        template<typename... Handles>
+        explicit Dma2dHandler(const std::uint32_t abortTimeout, RegisterHandlesTag tag, Handles*... handles)
+            : classParent(this, tag, handles...) {
+            setParam<Dma2dProperties::abortTimeout>(abortTimeout);
+        }
+
+        /**
+         * @brief Set the callback of the operations that follow.
+         * @param callback Called from handleInterrupt(), nullptr leaves the interrupts off.
+         */
+        DriverStatus configure(const Callback newCallback, void* newContext = nullptr)
+        {
+            RESULT_TRY(status());
+            if (isBusy()) { return Utils::fail(DriverError::busy); }
+            callback = newCallback;
+            context = newContext;
+            interrupts = newCallback == nullptr ? 0U : (1U << Dma2d::transferCompleteInterruptPos) | (1U << Dma2d::transferErrorInterruptPos) |
+                                                       (1U << Dma2d::configurationErrorInterruptPos);
+            reported = newCallback == nullptr ? 0U : Dma2d::transferCompleteFlag | Dma2d::transferErrorFlag | Dma2d::configurationErrorFlag;
+            return {};
+        }
+
+        /**
+         * @brief Program and start an operation.
+         * @return DriverStatus DriverError::busy if one is running, DriverError::invalidParameter if the hardware would refuse it.
+         */
+        DriverStatus start(const Dma2dOperation& operation)
+        {
+            RESULT_TRY(status());
+            if (!Dma2d::isValid(operation)) { return Utils::fail(DriverError::invalidParameter); }
+            if (isBusy()) { return Utils::fail(DriverError::busy); }
+
+            setRegisterValue<Dma2dRegisters::foregroundAddress>(operation.foreground.address);
+            setRegisterValue<Dma2dRegisters::foregroundOffset>(operation.foreground.offset);
+            setRegisterValue<Dma2dRegisters::foregroundControl>(Dma2d::layerControl(operation.foreground));
+            setRegisterValue<Dma2dRegisters::foregroundColor>(operation.foreground.options.color & 0xFFFFFFU);
+            setRegisterValue<Dma2dRegisters::backgroundAddress>(operation.background.address);
+            setRegisterValue<Dma2dRegisters::backgroundOffset>(operation.background.offset);
+            setRegisterValue<Dma2dRegisters::backgroundControl>(Dma2d::layerControl(operation.background));
+            setRegisterValue<Dma2dRegisters::backgroundColor>(operation.background.options.color & 0xFFFFFFU);
+            setRegisterValue<Dma2dRegisters::outputControl>(Dma2d::colorMode(operation.outputFormat));
+            setRegisterValue<Dma2dRegisters::outputColor>(operation.color);
+            setRegisterValue<Dma2dRegisters::outputAddress>(operation.output);
+            setRegisterValue<Dma2dRegisters::outputOffset>(operation.outputOffset);
+            setRegisterValue<Dma2dRegisters::lineCount>((static_cast<std::uint32_t>(operation.width) << Dma2d::pixelsPerLinePos) | operation.height);
+            clearFlags(Dma2d::allFlags);
+            setRegisterValue<Dma2dRegisters::control>((static_cast<std::uint32_t>(operation.mode) << Dma2d::modePos) | interrupts | (1U << Dma2d::startPos));
+            return {};
+        }
+
+        /**
+         * @brief Stop the running operation, the output is left partly written.
+         * @return DriverStatus DriverError::timeout if START did not clear within the abort timeout.
+         */
+        DriverStatus abort()
+        {
+            RESULT_TRY(status());
+            if (!isBusy()) { return {}; }
+            setRegisterValue<Dma2dRegisters::control>(getRegisterValue<Dma2dRegisters::control>() | (1U << Dma2d::abortPos));
+            const std::uint32_t timeout{ getParam<Dma2dProperties::abortTimeout>() };
+            for (std::uint32_t loop = 0; isBusy(); ++loop) {
+                if (loop == timeout) { return Utils::fail(DriverError::timeout); }
+            }
+            clearFlags(Dma2d::allFlags);
+            return {};
+        }
+
+        bool isBusy() { return checkBit<Dma2dRegisters::control>(Dma2d::startPos); }
+
+        /// Flags, as the Dma2d::*Flag constants.
+        std::uint32_t flags() { return getRegisterValue<Dma2dRegisters::interruptStatus>() & Dma2d::allFlags; }
+
+        void clearFlags(const std::uint32_t mask) { setRegisterValue<Dma2dRegisters::interruptClear>(mask & Dma2d::allFlags); }
+
+        /**
+         * @brief Acknowledge the flags and report the end of the operation to the callback, from the DMA2D IRQ handler.
+         *
+         * The callback runs once whatever the flags raised together: an error wins over
+         * the transfer complete flag of the same operation.
+         * @return std::uint32_t Flags handled.
+         */
+        std::uint32_t handleInterrupt()
+        {
+            const std::uint32_t pending{ flags() & reported };
+            if (pending == 0) { return 0; }
+            clearFlags(pending);
+            if ((pending & Dma2d::configurationErrorFlag) != 0) {
+                callback(context, Dma2dEvent::configurationError);
+            } else if ((pending & Dma2d::transferErrorFlag) != 0) {
+                callback(context, Dma2dEvent::transferError);
+            } else {
+                callback(context, Dma2dEvent::transferComplete);
+            }
+            return pending;
+        }
+};
+
+/**
+ * @brief Completion token of one queued operation.
+ */
+struct Dma2dToken {
+    std::uint32_t sequence;
+};
+
+/**
+ * @brief Operations waiting for the DMA2D, started back to back from its interrupt, see CompletionQueue.hh.
+ * @tparam Pending Operations queued, the one running included; a power of two.
+ */
+template<std::size_t Pending>
+class Dma2dQueue : public CompletionQueue<Dma2dQueue<Pending>, Dma2dOperation, Dma2dToken, Pending>
+{
+    private:
+        using classParent = CompletionQueue<Dma2dQueue<Pending>, Dma2dOperation, Dma2dToken, Pending>;
+        friend classParent;
+
+        Dma2dHandler& handler;
+
+        static void* pointerOf(const std::uint32_t address) { return reinterpret_cast<void*>(static_cast<std::uintptr_t>(address)); }
+
+        /// Clean the inputs and clean and invalidate the output at submission.
+        void prepareOperation(const Dma2dOperation& operation)
+        {
+            if (operation.mode != Dma2dMode::fill) {
+                Cache::clean(pointerOf(operation.foreground.address),
+                             Dma2d::spanBytes(operation.width, operation.height, operation.foreground.offset, operation.foreground.format));
+            }
+            if (operation.mode == Dma2dMode::blend) {
+                Cache::clean(pointerOf(operation.background.address),
+                             Dma2d::spanBytes(operation.width, operation.height, operation.background.offset, operation.background.format));
+            }
+            Cache::cleanInvalidate(pointerOf(operation.output), Dma2d::spanBytes(operation.width, operation.height, operation.outputOffset, operation.outputFormat));
+        }
+
+        bool startOperation(const Dma2dOperation& operation) { return static_cast<bool>(handler.start(operation)); }
+
+        void finishOperation(const Dma2dOperation& operation)
+        {
+            Cache::invalidate(pointerOf(operation.output), Dma2d::spanBytes(operation.width, operation.height, operation.outputOffset, operation.outputFormat));
+        }
+
+        void serveEngine() { handler.handleInterrupt(); }
+
+        static void onEvent(void* context, const Dma2dEvent event) { static_cast<Dma2dQueue*>(context)->engineDone(event == Dma2dEvent::transferComplete); }
+
+    public:
+        explicit Dma2dQueue(Dma2dHandler& handler) : handler(handler)
+        {
+            static_cast<void>(handler.configure(&onEvent, this));
+        }
+
+        Dma2dQueue(const Dma2dQueue&) = delete;
+        Dma2dQueue& operator=(const Dma2dQueue&) = delete;
+
+        /**
+         * @brief Queue an operation, started at once if the DMA2D is idle.
+         * @return Utils::Result<Dma2dToken, DriverError> DriverError::outOfResources if Pending operations wait.
+         */
+        Utils::Result<Dma2dToken, DriverError> submit(const Dma2dOperation& operation)
+        {
+            if (!Dma2d::isValid(operation)) { return Utils::fail(DriverError::invalidParameter); }
+            return this->enqueue(operation);
+        }
+};
+
+namespace Dma2d
+{
+    #if defined(CORE_CM7) || defined(CORE_CM4)
+        /**
+         * @brief Enable the DMA2D clock.
+         */
+        inline void init()
+        {
+            RCC->AHB3ENR = RCC->AHB3ENR | RCC_AHB3ENR_DMA2DEN;
+            static_cast<void>(RCC->AHB3ENR);
+        }
+
+        inline constexpr IRQn_Type irq{ DMA2D_IRQn };
+
+        /**
+         * @brief Handler of the DMA2D, created on first use.
+         */
+        inline Dma2dHandler& handler()
+        {
+            static Dma2dHandler instance{ Dma2d::abortTimeoutLoops, &DMA2D->CR, &DMA2D->ISR, &DMA2D->IFCR, &DMA2D->FGMAR, &DMA2D->FGOR, &DMA2D->BGMAR, &DMA2D->BGOR,
+                                          &DMA2D->FGPFCCR, &DMA2D->FGCOLR, &DMA2D->BGPFCCR, &DMA2D->BGCOLR, &DMA2D->OPFCCR, &DMA2D->OCOLR,
+                                          &DMA2D->OMAR, &DMA2D->OOR, &DMA2D->NLR };
+            return instance;
+        }
+    #endif
+};
+
+#endif // __DMA2D_H__
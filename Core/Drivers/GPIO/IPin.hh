@@ -21,6 +21,8 @@ public:
 };
 
 
+inline constexpr std::size_t pinsPerPort{ 16 };
+
 enum class IPinModes { input, output, alternateFunction };
 enum class IPinHandlerProperties { pinNumber, mode };
 using PinNumberPair = pair<IPinHandlerProperties::pinNumber, std::size_t>;
@@ -50,11 +52,18 @@ class IPinHandler : public IPinHandlerParent<PinHandler, ExtendedPeripheralPrope
             : classParent(this, std::forward<RegisterAddress>(addresses)...) {
         }
 
-        void setMode() { 
-            
+        /**
+         * @brief Write the mode property to the mode register.
+         * @return DriverStatus DriverError::invalidParameter for a pin number above 15,
+         * DriverError::outOfResources if the register handles could not be allocated.
+         */
+        DriverStatus setMode() { 
+            RESULT_TRY(this->status());
             std::size_t mode { static_cast<std::size_t>(this->template getParam<IPinHandlerProperties::mode>()) };
             std::size_t pinNumber { static_cast<std::size_t>(this->template getParam<IPinHandlerProperties::pinNumber>()) };
+            if (pinNumber >= pinsPerPort) { return Utils::fail(DriverError::invalidParameter); }
             classParent::template setBits<IPinHandlerProperties::mode>(mode, pinNumber);
+            return {};
         }
 };
 
@@ -29,7 +29,8 @@ class InputPinHandler : public InputPinHandlerParent<InputPinHandler>
         constexpr explicit InputPinHandler(RegisterAddress&&... addresses) 
             : InputPinHandlerParent<InputPinHandler>(std::forward<RegisterAddress>(addresses)...) {
                 setParam<IPinHandlerProperties::mode>(IPinModes::input);
-                setMode();
+                // A failure is reported again by InputPin::init()
+                static_cast<void>(setMode());
         }
 };
 
@@ -55,8 +56,8 @@ public:
     }
     ~InputPin() {}
 
-    void init() override {}
-    void reset() override {}
+    DriverStatus init() override { return _handler.setMode(); }
+    DriverStatus reset() override { return _handler.status(); }
     bool read() override {
         //return _handler.checkBit<InputPinProperties::pinState>(PinNumber); 
         return true;
@@ -0,0 +1,297 @@
+#ifndef __HSEM_H__
+#define __HSEM_H__
+
+/**
+ * @file Hsem.hh
+ * @brief Hardware semaphore (HSEM) driver: cross-core locks with release notification.
+ *
+ * The H755 has 32 semaphores shared by the cores. A semaphore is owned by a
+ * (core ID, process ID) pair, the process ID letting several tasks of one core use
+ * the same semaphore independently:
+ *  - 2-step lock: write LOCK | COREID | PROCID to R[n], then read R[n] back. The write
+ *    only takes effect if the semaphore was free, the read tells who owns it.
+ *  - 1-step (fast) lock: read RLR[n]. The read locks a free semaphore with process ID 0
+ *    and returns the owner.
+ *  - Release: write COREID | PROCID with LOCK cleared, ignored unless it matches the owner.
+ *  - releaseAll(key): write CR, frees every semaphore of the core whose key matches KEYR.
+ *
+ * When a semaphore is freed, every core that enabled it in its interface IER gets the
+ * HSEM interrupt (HSEM1 on the CM7, HSEM2 on the CM4). lockWaiting() relies on it:
+ * between attempts the core sleeps in WFI instead of polling the shared bus. Call
+ * Hsem::handleInterrupt() from the HSEM1_IRQHandler/HSEM2_IRQHandler of the core.
+ *
+ * Each HsemHandler drives one semaphore. On the target Hsem::semaphore<Id>() returns the
+ * handler of semaphore Id on the calling core's interface. Host tests build handlers
+ * over a model of the register semantics with the registerHandles constructor.
+ *
+ * Usage example:
+ * ```
+ * HsemHandler& lock{ Hsem::semaphore<5>() };
+ * if (lock.lockWaiting(processId)) {
+ *     // ... shared resource ...
+ *     lock.release(processId);
+ * }
+ * ```
+ */
+
+//<------------------------------INCLUDES------------------------------>//
+#include <atomic>
+#include <cstdint>
+#include <DriverError.hh>
+#include <CriticalSection.hh>
+#include <PeripheralBaseHandler.hh>
+#if defined(CORE_CM7) || defined(CORE_CM4)
+#include <stm32h755xx.h>
+#else
+#include <thread>
+#endif
+//<-------------------------------------------------------------------->//
+
+namespace Hsem
+{
+    inline constexpr std::uint32_t semaphoreCount{ 32 };
+
+    // COREID field values, RM0399 HSEM section
+    inline constexpr std::uint32_t cm7CoreId{ 3 };
+    inline constexpr std::uint32_t cm4CoreId{ 1 };
+
+    // Register fields, identical for R[n], RLR[n] and CR
+    inline constexpr std::uint32_t procIdMask{ 0xFFU };
+    inline constexpr std::uint32_t coreIdPos{ 8 };
+    inline constexpr std::uint32_t coreIdMask{ 0xFFU << coreIdPos };
+    inline constexpr std::uint32_t lockBit{ 1U << 31 };
+    inline constexpr std::uint32_t keyPos{ 16 };
+
+    /// Core ID of the running core, CM7 on the host.
+    constexpr std::uint32_t currentCoreId()
+    {
+        #if defined(CORE_CM4)
+            return cm4CoreId;
+        #else
+            return cm7CoreId;
+        #endif
+    }
+
+    /// Value of R[n] when locked by (core, process).
+    constexpr std::uint32_t lockValue(const std::uint32_t core, const std::uint8_t process)
+    {
+        return lockBit | (core << coreIdPos) | process;
+    }
+
+    /// Releases seen by handleInterrupt() and not yet consumed by a waiter, one bit per semaphore.
+    inline std::atomic<std::uint32_t>& releaseEvents()
+    {
+        static std::atomic<std::uint32_t> events{ 0 };
+        return events;
+    }
+};
+
+enum class HsemProperties { semaphoreId, coreId };
+using HsemSemaphoreIdPair = pair<HsemProperties::semaphoreId, std::uint32_t>;
+using HsemCoreIdPair = pair<HsemProperties::coreId, std::uint32_t>;
+using HsemPropertiesTypeList = Utils::TypeList<HsemSemaphoreIdPair, HsemCoreIdPair>;
+
+enum class HsemRegisters { semaphore, readLock, interruptEnable, interruptClear, interruptStatus, clear, clearKey };
+using HsemRegistersTypeList = Utils::TypeList<
+    pair<HsemRegisters::semaphore, volatile std::uint32_t*>,           // R[n]
+    pair<HsemRegisters::readLock, volatile std::uint32_t*>,            // RLR[n]
+    pair<HsemRegisters::interruptEnable, volatile std::uint32_t*>,     // CxIER of this core
+    pair<HsemRegisters::interruptClear, volatile std::uint32_t*>,      // CxICR
+    pair<HsemRegisters::interruptStatus, volatile std::uint32_t*>,     // CxMISR
+    pair<HsemRegisters::clear, volatile std::uint32_t*>,               // CR
+    pair<HsemRegisters::clearKey, volatile std::uint32_t*>             // KEYR
+>;
+
+class HsemHandler : public PeripheralHandlerBase<HsemPropertiesTypeList, HsemRegistersTypeList, HsemHandler>
+{
+    private:
+        using classParent = PeripheralHandlerBase<HsemPropertiesTypeList, HsemRegistersTypeList, HsemHandler>;
+
+        std::uint32_t id() { return getParam<HsemProperties::semaphoreId>(); }
+        std::uint32_t core() { return getParam<HsemProperties::coreId>(); }
+
+        void setProperties(const std::uint32_t semaphoreId, const std::uint32_t coreId)
+        {
+            setParam<HsemProperties::semaphoreId>(semaphoreId);
+            setParam<HsemProperties::coreId>(coreId);
+        }
+
+        /// Consume a release of this semaphore, seen by the ISR or still pending in MISR.
+        bool consumeRelease()
+        {
+            const std::uint32_t bit{ 1U << id() };
+            bool released{ (Hsem::releaseEvents().fetch_and(~bit) & bit) != 0 };
+            if (checkBit<HsemRegisters::interruptStatus>(id())) {
+                setRegisterValue<HsemRegisters::interruptClear>(bit);
+                released = true;
+            }
+            return released;
+        }
+
+        static void waitForInterrupt()
+        {
+            #if defined(CORE_CM7) || defined(CORE_CM4)
+                // Wakes up on a pending interrupt even with PRIMASK set, the handler runs after
+                __WFI();
+            #else
+                std::this_thread::yield();
+            #endif
+        }
+
+    public:
+        /**
+         * @param semaphoreId Semaphore number, 0 to 31.
+         * @param coreId Core ID written by this handler, the calling core's one on the target.
+         * @param addresses R[n], RLR[n], CxIER, CxICR, CxMISR, CR and KEYR.
+         */
+        template<typename... RegisterAddress>
+        requires ((Utils::UnsignedIntegralPointerConcept<std::decay_t<RegisterAddress>> && ...))
+        explicit HsemHandler(const std::uint32_t semaphoreId, const std::uint32_t coreId, RegisterAddress&&... addresses)
+            : classParent(this, std::forward<RegisterAddress>(addresses)...) {
+            setProperties(semaphoreId, coreId);
+        }
+
+        template<typename... Handles>
+        explicit HsemHandler(const std::uint32_t semaphoreId, const std::uint32_t coreId, RegisterHandlesTag tag, Handles*... handles)
+            : classParent(this, tag, handles...) {
+            setProperties(semaphoreId, coreId);
+        }
+
+        /**
+         * @brief 2-step lock for a process.
+         * @return DriverStatus DriverError::busy if another core or process holds it.
+         */
+        DriverStatus lock(const std::uint8_t processId)
+        {
+            RESULT_TRY(status());
+            const std::uint32_t expected{ Hsem::lockValue(core(), processId) };
+            setRegisterValue<HsemRegisters::semaphore>(expected);
+            if (getRegisterValue<HsemRegisters::semaphore>() != expected) { return Utils::fail(DriverError::busy); }
+            return {};
+        }
+
+        /**
+         * @brief 1-step lock with a single read, process ID 0.
+         * @return DriverStatus DriverError::busy if the semaphore is held by someone else.
+         */
+        DriverStatus fastLock()
+        {
+            RESULT_TRY(status());
+            if (getRegisterValue<HsemRegisters::readLock>() != Hsem::lockValue(core(), 0)) { return Utils::fail(DriverError::busy); }
+            return {};
+        }
+
+        /**
+         * @brief Lock, sleeping until the owner releases the semaphore.
+         *
+         * The release interrupt of the semaphore is enabled while waiting. A failed attempt
+         * and the sleep that follows are done with interrupts masked, so a release landing
+         * in between wakes the WFI up instead of being lost.
+         * @param maxSleeps Number of wake-ups before giving up.
+         * @return DriverStatus DriverError::timeout after maxSleeps wake-ups without the lock.
+         */
+        DriverStatus lockWaiting(const std::uint8_t processId, const std::uint32_t maxSleeps = 0xFFFFFFFFU)
+        {
+            RESULT_TRY(status());
+            enableNotification();
+            for (std::uint32_t sleeps = 0;; ++sleeps) {
+                {
+                    CriticalSection guard;
+                    if (lock(processId)) {
+                        disableNotification();
+                        return {};
+                    }
+                    if (sleeps == maxSleeps) { break; }
+                    if (!consumeRelease()) { waitForInterrupt(); }
+                }
+                consumeRelease();
+            }
+            disableNotification();
+            return Utils::fail(DriverError::timeout);
+        }
+
+        /// Release a semaphore locked with lock(processId) (or fastLock() with process 0).
+        void release(const std::uint8_t processId = 0)
+        {
+            setRegisterValue<HsemRegisters::semaphore>((core() << Hsem::coreIdPos) | processId);
+        }
+
+        /**
+         * @brief Release every semaphore this core holds, provided key matches KEYR.
+         */
+        void releaseAll(const std::uint16_t key)
+        {
+            setRegisterValue<HsemRegisters::clear>((static_cast<std::uint32_t>(key) << Hsem::keyPos) | (core() << Hsem::coreIdPos));
+        }
+
+        /// Set the key releaseAll() must present, shared by all semaphores.
+        void setClearKey(const std::uint16_t key) { setRegisterValue<HsemRegisters::clearKey>(static_cast<std::uint32_t>(key) << Hsem::keyPos); }
+
+        bool isLocked() { return (getRegisterValue<HsemRegisters::semaphore>() & Hsem::lockBit) != 0; }
+
+        /// Core ID of the owner, meaningful while isLocked().
+        std::uint32_t ownerCore() { return (getRegisterValue<HsemRegisters::semaphore>() & Hsem::coreIdMask) >> Hsem::coreIdPos; }
+
+        /// Process ID of the owner, meaningful while isLocked().
+        std::uint8_t ownerProcess() { return static_cast<std::uint8_t>(getRegisterValue<HsemRegisters::semaphore>() & Hsem::procIdMask); }
+
+        /// Raise this core's HSEM interrupt when the semaphore is released.
+        void enableNotification()
+        {
+            setRegisterValue<HsemRegisters::interruptClear>(1U << id());
+            Hsem::releaseEvents().fetch_and(~(1U << id()));
+            setBit<HsemRegisters::interruptEnable>(id());
+        }
+
+        void disableNotification() { clearBit<HsemRegisters::interruptEnable>(id()); }
+
+        /// Check and acknowledge a release notification, without sleeping.
+        bool takeNotification() { return consumeRelease(); }
+};
+
+namespace Hsem
+{
+    #if defined(CORE_CM7) || defined(CORE_CM4)
+        /**
+         * @brief Enable the HSEM clock (shared, either core may do it) and its interrupt on this core.
+         */
+        inline void init()
+        {
+            RCC->AHB4ENR = RCC->AHB4ENR | RCC_AHB4ENR_HSEMEN;
+            static_cast<void>(RCC->AHB4ENR);
+            #if defined(CORE_CM7)
+                NVIC_EnableIRQ(HSEM1_IRQn);
+            #else
+                NVIC_EnableIRQ(HSEM2_IRQn);
+            #endif
+        }
+
+        /**
+         * @brief Handler of semaphore Id on the calling core's interface, created on first use.
+         */
+        template<std::uint32_t Id>
+        HsemHandler& semaphore()
+        {
+            static_assert(Id < semaphoreCount, "The H755 has 32 hardware semaphores");
+            static HsemHandler handler{ Id, currentCoreId(), &HSEM->R[Id], &HSEM->RLR[Id], &HSEM_COMMON->IER, &HSEM_COMMON->ICR,
+                                        &HSEM_COMMON->MISR, &HSEM->CR, &HSEM->KEYR };
+            return handler;
+        }
+
+        /**
+         * @brief Acknowledge release notifications, call from HSEM1_IRQHandler (CM7) or HSEM2_IRQHandler (CM4).
+         *
+         * The releases are recorded in releaseEvents() for the waiters of lockWaiting().
+         * @return std::uint32_t Bit mask of the semaphores released since the last call.
+         */
+        inline std::uint32_t handleInterrupt()
+        {
+            const std::uint32_t released{ HSEM_COMMON->MISR };
+            HSEM_COMMON->ICR = released;
+            releaseEvents().fetch_or(released);
+            return released;
+        }
+    #endif
+};
+
+#endif // __HSEM_H__
@@ -0,0 +1,593 @@
+#ifndef __MDMA_H__
+#define __MDMA_H__
+
+/**
+ * @file Mdma.hh
+ * @brief MDMA driver: linked-list descriptor chains for scatter-gather, 2D and triggered transfers.
+ *
+ * The MDMA runs a chain of descriptors: when the transfer of a node ends, the channel loads
+ * the next node from memory (CLAR) into its registers and continues without the CPU. An
+ * MdmaChain holds the nodes and builds them from what the transfer is:
+ *  - copy(): memory to memory of any size, split in 64 KiB blocks, with the widest data
+ *    size and a burst the alignment allows;
+ *  - fill(): memory set to a repeated 8-byte pattern;
+ *  - copy2d(): a rectangle of rows out of a larger 2D buffer (block repeat, one node);
+ *  - writeRegister(): store a word to a peripheral register, e.g. to start a peripheral
+ *    once the data is in place (the word travels in the node itself);
+ *  - triggered(): peripheral transfers paced by a hardware trigger, e.g. a DMA stream
+ *    transfer complete, with an optional mask write to acknowledge the peripheral.
+ * Software nodes run back to back after one request. A triggered node waits for its
+ * trigger, each trigger moving one buffer of up to 128 bytes; it ends the software part
+ * of a chain, so triggered nodes go last.
+ *
+ * Every node is checked when it is added and the whole chain again by start(), so a bad
+ * descriptor is reported as DriverError::invalidParameter instead of a bus error halfway
+ * through. Mdma::isValid() holds the rules, it runs on the host as well.
+ *
+ * The MDMA reaches the whole memory map, TCMs included through its AHBS port (the bus of
+ * each side is selected from the address). The chain itself must be in AXI SRAM, D2 SRAM
+ * or SRAM4, where the channel fetches it: declare it DMA_BUFFER. start() cleans it from the
+ * CM7 data cache; the data buffers are the caller's responsibility, see Cache.hh.
+ *
+ * Usage example:
+ * ```
+ * DMA_BUFFER MdmaChain<8> chain;
+ * chain.reset();
+ * chain.copy(sram1Address, axiAddress, 48 * 1024);                     // AXI SRAM -> SRAM1
+ * chain.copy2d(tileAddress, 64 * 2, frameAddress + offset, 480 * 2, 64 * 2, 64);
+ * Mdma::init();
+ * MdmaChannelHandler& mdma{ Mdma::channel<0>() };
+ * mdma.configure(MdmaPriority::high, &onDone, nullptr);
+ * mdma.start(chain);
+ * // void onDone(void* context, MdmaEvent event, std::uint32_t errorStatus)
+ * extern "C" void MDMA_IRQHandler() { Mdma::handleInterrupt<0>(); }
+ * ```
+ */
+
+//<------------------------------INCLUDES------------------------------>//
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <PeripheralBaseHandler.hh>
+#include <DriverError.hh>
+#include <MemorySections.hh>
+#include <Cache.hh>
+#include <DmaChannel.hh>
+#if defined(CORE_CM7) || defined(CORE_CM4)
+#include <stm32h755xx.h>
+#endif
+//<-------------------------------------------------------------------->//
+
+namespace Mdma
+{
+    inline constexpr std::uint8_t channelCount{ 16 };
+    inline constexpr std::uint32_t maxBlockBytes{ 65536 };
+    inline constexpr std::uint32_t maxBufferBytes{ 128 };
+    inline constexpr std::uint32_t maxBlockRepeats{ 4096 };
+    inline constexpr std::uint32_t maxAddressUpdate{ 0xFFFF };
+
+    // CxCCR
+    inline constexpr std::uint32_t enablePos{ 0 };
+    inline constexpr std::uint32_t transferErrorInterruptPos{ 1 };
+    inline constexpr std::uint32_t channelCompleteInterruptPos{ 2 };
+    inline constexpr std::uint32_t priorityPos{ 6 };
+    inline constexpr std::uint32_t softwareRequestPos{ 16 };
+
+    // CxTCR
+    inline constexpr std::uint32_t sourceIncrementPos{ 0 };
+    inline constexpr std::uint32_t destinationIncrementPos{ 2 };
+    inline constexpr std::uint32_t sourceSizePos{ 4 };
+    inline constexpr std::uint32_t destinationSizePos{ 6 };
+    inline constexpr std::uint32_t sourceOffsetSizePos{ 8 };
+    inline constexpr std::uint32_t destinationOffsetSizePos{ 10 };
+    inline constexpr std::uint32_t sourceBurstPos{ 12 };
+    inline constexpr std::uint32_t destinationBurstPos{ 15 };
+    inline constexpr std::uint32_t bufferLengthPos{ 18 };
+    inline constexpr std::uint32_t triggerModePos{ 28 };
+    inline constexpr std::uint32_t softwareModePos{ 30 };
+    inline constexpr std::uint32_t bufferableWritePos{ 31 };
+    inline constexpr std::uint32_t incrementValue{ 2 };     ///< SINC/DINC: 0 fixed, 2 increment.
+
+    // CxBNDTR
+    inline constexpr std::uint32_t blockBytesMask{ 0x1FFFF };
+    inline constexpr std::uint32_t blockRepeatPos{ 20 };
+
+    // CxBRUR
+    inline constexpr std::uint32_t destinationUpdatePos{ 16 };
+
+    // CxTBR
+    inline constexpr std::uint32_t triggerMask{ 0x3F };
+    inline constexpr std::uint32_t sourceBusPos{ 16 };
+    inline constexpr std::uint32_t destinationBusPos{ 17 };
+
+    // CxISR and CxIFCR
+    inline constexpr std::uint32_t transferErrorFlag{ 1U << 0 };
+    inline constexpr std::uint32_t channelCompleteFlag{ 1U << 1 };
+    inline constexpr std::uint32_t blockRepeatCompleteFlag{ 1U << 2 };
+    inline constexpr std::uint32_t blockCompleteFlag{ 1U << 3 };
+    inline constexpr std::uint32_t bufferCompleteFlag{ 1U << 4 };
+    inline constexpr std::uint32_t allFlags{ 0x1F };
+
+    /**
+     * @brief Hardware triggers (RM0399, MDMA triggers), more can be cast from their number.
+     */
+    enum class Trigger : std::uint8_t {
+        dma1Stream0 = 0, dma1Stream1, dma1Stream2, dma1Stream3, dma1Stream4, dma1Stream5, dma1Stream6, dma1Stream7,
+        dma2Stream0 = 8, dma2Stream1, dma2Stream2, dma2Stream3, dma2Stream4, dma2Stream5, dma2Stream6, dma2Stream7,
+        quadspiFifoThreshold = 22, quadspiTransferComplete = 23,
+        dma2dClutTransferComplete = 24, dma2dTransferComplete = 25, dma2dTransferWatermark = 26,
+        sdmmc1EndData = 29
+    };
+};
+
+enum class MdmaDataSize : std::uint8_t { byte, halfWord, word, doubleWord };
+enum class MdmaPriority : std::uint8_t { low, medium, high, veryHigh };
+
+/// Data moved by one request: CxTCR.TRGM.
+enum class MdmaTriggerMode : std::uint8_t { buffer, block, repeatedBlock, linkedList };
+
+enum class MdmaEvent : std::uint8_t {
+    channelComplete,    ///< Last node done, the channel is disabled.
+    transferError       ///< Bus or descriptor error, the channel is disabled; see the error status (CxESR).
+};
+
+/**
+ * @brief One linked-list node, as the channel loads it into CxTCR..CxMDR.
+ */
+struct alignas(8) MdmaDescriptor {
+    std::uint32_t transferConfig;   ///< CxTCR
+    std::uint32_t blockCount;       ///< CxBNDTR
+    std::uint32_t source;           ///< CxSAR
+    std::uint32_t destination;      ///< CxDAR
+    std::uint32_t repeatUpdate;     ///< CxBRUR
+    std::uint32_t link;             ///< CxLAR, 0 for the last node.
+    std::uint32_t triggerBus;       ///< CxTBR
+    std::uint32_t payload;          ///< Reserved register slot, holds the word of writeRegister() nodes.
+    std::uint32_t maskAddress;      ///< CxMAR, 0 for no mask write.
+    std::uint32_t maskData;         ///< CxMDR
+};
+static_assert(sizeof(MdmaDescriptor) == 40, "MDMA nodes are the 10 words from CxTCR to CxMDR");
+
+/**
+ * @brief Triggered transfer between a peripheral register and memory.
+ */
+struct MdmaTriggeredTransfer {
+    Mdma::Trigger trigger{ Mdma::Trigger::dma1Stream0 };
+    bool toPeripheral{ false };
+    std::uint32_t peripheral{ 0 };          ///< Register address, not incremented.
+    std::uint32_t memory{ 0 };
+    MdmaDataSize size{ MdmaDataSize::word };
+    std::uint32_t bytes{ 0 };               ///< Total, up to maxBlockBytes.
+    std::uint32_t bytesPerTrigger{ 4 };     ///< 1 to maxBufferBytes.
+    std::uint32_t maskAddress{ 0 };         ///< Register written with maskData after each trigger, 0 for none.
+    std::uint32_t maskData{ 0 };
+};
+
+namespace Mdma
+{
+    constexpr std::uint32_t bytesOf(const MdmaDataSize size) { return 1U << static_cast<std::uint32_t>(size); }
+
+    constexpr std::uint32_t field(const std::uint32_t value, const std::uint32_t position, const std::uint32_t mask) { return (value >> position) & mask; }
+
+    /// Widest data size the addresses and the length are aligned to.
+    constexpr MdmaDataSize widestSize(const std::uint32_t source, const std::uint32_t destination, const std::uint32_t bytes)
+    {
+        const std::uint32_t alignment{ source | destination | bytes };
+        if ((alignment & 7U) == 0) { return MdmaDataSize::doubleWord; }
+        if ((alignment & 3U) == 0) { return MdmaDataSize::word; }
+        if ((alignment & 1U) == 0) { return MdmaDataSize::halfWord; }
+        return MdmaDataSize::byte;
+    }
+
+    /// Bus of an address: the AHBS port for the TCMs, AXI otherwise.
+    constexpr std::uint32_t busOf(const std::uint32_t address) { return MemorySections::isInTcm(address, 1) ? 1U : 0U; }
+
+    /**
+     * @brief CxTCR value of a transfer with the same size on both sides.
+     * @param bufferBytes Bytes per buffer transfer, 1 to maxBufferBytes.
+     */
+    constexpr std::uint32_t transferConfig(const MdmaDataSize size, const bool sourceIncrement, const bool destinationIncrement,
+                                           const std::uint32_t bufferBytes, const MdmaTriggerMode mode, const bool software)
+    {
+        const std::uint32_t sizeValue{ static_cast<std::uint32_t>(size) };
+        // Bursts of 16 beats at most, within one buffer, incremented sides only
+        std::uint32_t burst{ 0 };
+        while (burst < 4 && (2U << burst) * bytesOf(size) <= bufferBytes) { ++burst; }
+        return ((sourceIncrement ? incrementValue : 0U) << sourceIncrementPos) |
+               ((destinationIncrement ? incrementValue : 0U) << destinationIncrementPos) |
+               (sizeValue << sourceSizePos) | (sizeValue << destinationSizePos) |
+               (sizeValue << sourceOffsetSizePos) | (sizeValue << destinationOffsetSizePos) |
+               ((sourceIncrement ? burst : 0U) << sourceBurstPos) | ((destinationIncrement ? burst : 0U) << destinationBurstPos) |
+               ((bufferBytes - 1U) << bufferLengthPos) | (static_cast<std::uint32_t>(mode) << triggerModePos) |
+               ((software ? 1U : 0U) << softwareModePos) | ((destinationIncrement ? 1U : 0U) << bufferableWritePos);
+    }
+
+    /**
+     * @brief Check a node against the data size, burst, buffer and bus rules.
+     * @return bool true if the channel can run it.
+     */
+    constexpr bool isValid(const MdmaDescriptor& node)
+    {
+        const std::uint32_t config{ node.transferConfig };
+        const std::uint32_t sourceBytes{ 1U << field(config, sourceSizePos, 3) };
+        const std::uint32_t destinationBytes{ 1U << field(config, destinationSizePos, 3) };
+        const std::uint32_t bufferBytes{ field(config, bufferLengthPos, 0x7F) + 1U };
+        const std::uint32_t blockBytes{ node.blockCount & blockBytesMask };
+        const std::uint32_t sourceIncrement{ field(config, sourceIncrementPos, 3) };
+        const std::uint32_t destinationIncrement{ field(config, destinationIncrementPos, 3) };
+
+        if (blockBytes == 0 || blockBytes > maxBlockBytes) { return false; }
+        if (blockBytes % sourceBytes != 0 || blockBytes % destinationBytes != 0) { return false; }
+        if (bufferBytes % sourceBytes != 0 || bufferBytes % destinationBytes != 0) { return false; }
+        if (node.source % sourceBytes != 0 || node.destination % destinationBytes != 0) { return false; }
+        // Increments of one data item, fixed addresses read or write single beats
+        if ((sourceIncrement != 0 && (sourceIncrement != incrementValue || field(config, sourceOffsetSizePos, 3) != field(config, sourceSizePos, 3))) ||
+            (destinationIncrement != 0 && (destinationIncrement != incrementValue || field(config, destinationOffsetSizePos, 3) != field(config, destinationSizePos, 3)))) {
+            return false;
+        }
+        if ((sourceIncrement == 0 && field(config, sourceBurstPos, 7) != 0) || (destinationIncrement == 0 && field(config, destinationBurstPos, 7) != 0)) { return false; }
+        if ((1U << field(config, sourceBurstPos, 7)) * sourceBytes > bufferBytes) { return false; }
+        if ((1U << field(config, destinationBurstPos, 7)) * destinationBytes > bufferBytes) { return false; }
+        if ((node.link & 7U) != 0 || (node.maskAddress & 3U) != 0) { return false; }
+        return field(node.triggerBus, sourceBusPos, 1) == busOf(node.source) && field(node.triggerBus, destinationBusPos, 1) == busOf(node.destination);
+    }
+};
+
+/**
+ * @brief Descriptor chain with room for Nodes nodes, built in place.
+ *
+ * The nodes are linked in the order they are added. A chain must not move once built:
+ * the links are addresses.
+ */
+template<std::size_t Nodes>
+class MdmaChain
+{
+    static_assert(Nodes > 0, "An MDMA chain holds at least one node");
+
+    private:
+        std::array<MdmaDescriptor, Nodes> nodes{};
+        std::size_t used{ 0 };
+        std::uint32_t base;
+
+        DriverStatus append(const MdmaDescriptor& node)
+        {
+            if (!Mdma::isValid(node)) { return Utils::fail(DriverError::invalidParameter); }
+            if (used >= Nodes) { return Utils::fail(DriverError::outOfResources); }
+            const std::size_t index{ used };
+            nodes[index] = node;
+            // A single node has nothing to link to
+            if constexpr (Nodes > 1) {
+                if (index > 0) { nodes[index - 1].link = addressOf(index); }
+            }
+            used = index + 1;
+            return {};
+        }
+
+    public:
+        /// The MDMA sees the nodes where the CPU does.
+        MdmaChain() : base(static_cast<std::uint32_t>(reinterpret_cast<std::uintptr_t>(nodes.data()))) {}
+
+        /// @param busAddress Address the MDMA sees the nodes at, for host models of the bus.
+        explicit MdmaChain(const std::uint32_t busAddress) : base(busAddress) {}
+
+        MdmaChain(const MdmaChain&) = delete;
+        MdmaChain& operator=(const MdmaChain&) = delete;
+
+        void reset() { used = 0; }
+
+        /**
+         * @brief Memory to memory copy, any alignment.
+         * @return DriverStatus DriverError::outOfResources if the chain has no room for all its blocks.
+         */
+        DriverStatus copy(const std::uint32_t destination, const std::uint32_t source, const std::uint32_t bytes)
+        {
+            if (bytes == 0) { return Utils::fail(DriverError::invalidParameter); }
+            const std::size_t blocks{ (bytes + Mdma::maxBlockBytes - 1) / Mdma::maxBlockBytes };
+            if (used + blocks > Nodes) { return Utils::fail(DriverError::outOfResources); }
+            for (std::uint32_t offset = 0; offset < bytes; offset += Mdma::maxBlockBytes) {
+                const std::uint32_t length{ bytes - offset < Mdma::maxBlockBytes ? bytes - offset : Mdma::maxBlockBytes };
+                const MdmaDataSize size{ Mdma::widestSize(source + offset, destination + offset, length) };
+                const std::uint32_t buffer{ length < Mdma::maxBufferBytes ? length : Mdma::maxBufferBytes };
+                RESULT_TRY(append(MdmaDescriptor{
+                    .transferConfig = Mdma::transferConfig(size, true, true, buffer - buffer % Mdma::bytesOf(size), MdmaTriggerMode::linkedList, true),
+                    .blockCount = length,
+                    .source = source + offset,
+                    .destination = destination + offset,
+                    .triggerBus = (Mdma::busOf(source + offset) << Mdma::sourceBusPos) | (Mdma::busOf(destination + offset) << Mdma::destinationBusPos) }));
+            }
+            return {};
+        }
+
+        /**
+         * @brief Fill memory with a repeated pattern.
+         * @param pattern Address of 8 bytes holding the pattern, 8-byte aligned, read for every data item.
+         */
+        DriverStatus fill(const std::uint32_t destination, const std::uint32_t pattern, const std::uint32_t bytes)
+        {
+            if (bytes == 0 || (pattern & 7U) != 0) { return Utils::fail(DriverError::invalidParameter); }
+            const std::size_t blocks{ (bytes + Mdma::maxBlockBytes - 1) / Mdma::maxBlockBytes };
+            if (used + blocks > Nodes) { return Utils::fail(DriverError::outOfResources); }
+            for (std::uint32_t offset = 0; offset < bytes; offset += Mdma::maxBlockBytes) {
+                const std::uint32_t length{ bytes - offset < Mdma::maxBlockBytes ? bytes - offset : Mdma::maxBlockBytes };
+                const MdmaDataSize size{ Mdma::widestSize(pattern, destination + offset, length) };
+                const std::uint32_t buffer{ length < Mdma::maxBufferBytes ? length : Mdma::maxBufferBytes };
+                RESULT_TRY(append(MdmaDescriptor{
+                    .transferConfig = Mdma::transferConfig(size, false, true, buffer, MdmaTriggerMode::linkedList, true),
+                    .blockCount = length,
+                    .source = pattern,
+                    .destination = destination + offset,
+                    .triggerBus = (Mdma::busOf(pattern) << Mdma::sourceBusPos) | (Mdma::busOf(destination + offset) << Mdma::destinationBusPos) }));
+            }
+            return {};
+        }
+
+        /**
+         * @brief Copy rows rows of rowBytes bytes between 2D buffers of different strides.
+         * @param destinationStride, sourceStride Bytes from the start of a row to the next, rowBytes + 65535 at most.
+         */
+        DriverStatus copy2d(const std::uint32_t destination, const std::uint32_t destinationStride, const std::uint32_t source,
+                            const std::uint32_t sourceStride, const std::uint32_t rowBytes, const std::uint32_t rows)
+        {
+            if (rows == 0 || rows > Mdma::maxBlockRepeats || sourceStride < rowBytes || destinationStride < rowBytes ||
+                sourceStride - rowBytes > Mdma::maxAddressUpdate || destinationStride - rowBytes > Mdma::maxAddressUpdate) {
+                return Utils::fail(DriverError::invalidParameter);
+            }
+            const MdmaDataSize size{ Mdma::widestSize(source | sourceStride, destination | destinationStride, rowBytes) };
+            const std::uint32_t buffer{ rowBytes < Mdma::maxBufferBytes ? rowBytes : Mdma::maxBufferBytes };
+            return append(MdmaDescriptor{
+                .transferConfig = Mdma::transferConfig(size, true, true, buffer - buffer % Mdma::bytesOf(size), MdmaTriggerMode::linkedList, true),
+                .blockCount = rowBytes | ((rows - 1U) << Mdma::blockRepeatPos),
+                .source = source,
+                .destination = destination,
+                .repeatUpdate = (sourceStride - rowBytes) | ((destinationStride - rowBytes) << Mdma::destinationUpdatePos),
+                .triggerBus = (Mdma::busOf(source) << Mdma::sourceBusPos) | (Mdma::busOf(destination) << Mdma::destinationBusPos) });
+        }
+
+        /**
+         * @brief Write value to a 32-bit register when the chain gets there.
+         */
+        DriverStatus writeRegister(const std::uint32_t address, const std::uint32_t value)
+        {
+            if (used == Nodes) { return Utils::fail(DriverError::outOfResources); }
+            const std::uint32_t payload{ addressOf(used) + static_cast<std::uint32_t>(offsetof(MdmaDescriptor, payload)) };
+            return append(MdmaDescriptor{
+                .transferConfig = Mdma::transferConfig(MdmaDataSize::word, false, false, 4, MdmaTriggerMode::linkedList, true),
+                .blockCount = 4,
+                .source = payload,
+                .destination = address,
+                .triggerBus = (Mdma::busOf(payload) << Mdma::sourceBusPos) | (Mdma::busOf(address) << Mdma::destinationBusPos),
+                .payload = value });
+        }
+
+        /**
+         * @brief Peripheral transfer, one buffer of bytesPerTrigger bytes per trigger.
+         */
+        DriverStatus triggered(const MdmaTriggeredTransfer& transfer)
+        {
+            if (transfer.bytesPerTrigger == 0 || transfer.bytesPerTrigger > Mdma::maxBufferBytes) { return Utils::fail(DriverError::invalidParameter); }
+            const std::uint32_t source{ transfer.toPeripheral ? transfer.memory : transfer.peripheral };
+            const std::uint32_t destination{ transfer.toPeripheral ? transfer.peripheral : transfer.memory };
+            return append(MdmaDescriptor{
+                .transferConfig = Mdma::transferConfig(transfer.size, transfer.toPeripheral, !transfer.toPeripheral, transfer.bytesPerTrigger,
+                                                       MdmaTriggerMode::buffer, false),
+                .blockCount = transfer.bytes,
+                .source = source,
+                .destination = destination,
+                .triggerBus = (static_cast<std::uint32_t>(transfer.trigger) & Mdma::triggerMask) |
+                              (Mdma::busOf(source) << Mdma::sourceBusPos) | (Mdma::busOf(destination) << Mdma::destinationBusPos),
+                .maskAddress = transfer.maskAddress,
+                .maskData = transfer.maskData });
+        }
+
+        /**
+         * @brief Check the chain: valid nodes linked in order, in memory the channel can fetch.
+         */
+        DriverStatus validate() const
+        {
+            if (used == 0 || (base & 7U) != 0 || !MemorySections::isDmaReachable(base, used * sizeof(MdmaDescriptor))) {
+                return Utils::fail(DriverError::invalidParameter);
+            }
+            for (std::size_t index = 0; index < used; ++index) {
+                const std::uint32_t next{ index + 1 < used ? addressOf(index + 1) : 0U };
+                if (!Mdma::isValid(nodes[index]) || nodes[index].link != next) { return Utils::fail(DriverError::invalidParameter); }
+            }
+            return {};
+        }
+
+        /// Bus address of a node.
+        std::uint32_t addressOf(const std::size_t index) const { return base + static_cast<std::uint32_t>(index * sizeof(MdmaDescriptor)); }
+
+        const MdmaDescriptor& node(const std::size_t index) const { return nodes[index]; }
+        const MdmaDescriptor* data() const { return nodes.data(); }
+        std::size_t size() const { return used; }
+        static constexpr std::size_t capacity() { return Nodes; }
+};
+
+enum class MdmaChannelProperties { channel };
+using MdmaChannelPropertiesTypeList = Utils::TypeList<
+    pair<MdmaChannelProperties::channel, std::uint8_t>
+>;
+
+enum class MdmaChannelRegisters { status, clear, errorStatus, control, transferConfig, blockCount, source, destination, repeatUpdate, link, triggerBus, maskAddress, maskData };
+using MdmaChannelRegistersTypeList = Utils::TypeList<
+    pair<MdmaChannelRegisters::status, volatile std::uint32_t*>,           // CxISR
+    pair<MdmaChannelRegisters::clear, volatile std::uint32_t*>,            // CxIFCR
+    pair<MdmaChannelRegisters::errorStatus, volatile std::uint32_t*>,      // CxESR
+    pair<MdmaChannelRegisters::control, volatile std::uint32_t*>,          // CxCR
+    pair<MdmaChannelRegisters::transferConfig, volatile std::uint32_t*>,   // CxTCR
+    pair<MdmaChannelRegisters::blockCount, volatile std::uint32_t*>,       // CxBNDTR
+    pair<MdmaChannelRegisters::source, volatile std::uint32_t*>,           // CxSAR
+    pair<MdmaChannelRegisters::destination, volatile std::uint32_t*>,      // CxDAR
+    pair<MdmaChannelRegisters::repeatUpdate, volatile std::uint32_t*>,     // CxBRUR
+    pair<MdmaChannelRegisters::link, volatile std::uint32_t*>,             // CxLAR
+    pair<MdmaChannelRegisters::triggerBus, volatile std::uint32_t*>,       // CxTBR
+    pair<MdmaChannelRegisters::maskAddress, volatile std::uint32_t*>,      // CxMAR
+    pair<MdmaChannelRegisters::maskData, volatile std::uint32_t*>          // CxMDR
+>;
+
+class MdmaChannelHandler : public PeripheralHandlerBase<MdmaChannelPropertiesTypeList, MdmaChannelRegistersTypeList, MdmaChannelHandler>
+{
+    public:
+        using Callback = void (*)(void* context, MdmaEvent event, std::uint32_t errorStatus);
+
+    private:
+        using classParent = PeripheralHandlerBase<MdmaChannelPropertiesTypeList, MdmaChannelRegistersTypeList, MdmaChannelHandler>;
+
+        MdmaPriority priority{ MdmaPriority::low };
+        Callback callback{ nullptr };
+        void* context{ nullptr };
+
+    public:
+        /**
+         * @param channel 0 to 15.
+         * @param addresses CxISR, CxIFCR, CxESR, CxCR, CxTCR, CxBNDTR, CxSAR, CxDAR, CxBRUR, CxLAR, CxTBR, CxMAR and CxMDR.
+         */
+        template<typename... RegisterAddress>
+        requires ((Utils::UnsignedIntegralPointerConcept<std::decay_t<RegisterAddress>> && ...))
+        explicit MdmaChannelHandler(const std::uint8_t channel, RegisterAddress&&... addresses)
+            : classParent(this, std::forward<RegisterAddress>(addresses)...) {
+            setParam<MdmaChannelProperties::channel>(channel);
+        }
+
+        template<typename... Handles>
+        explicit MdmaChannelHandler(const std::uint8_t channel, RegisterHandlesTag tag, Handles*... handles)
+            : classParent(this, tag, handles...) {
+            setParam<MdmaChannelProperties::channel>(channel);
+        }
+
+        /**
+         * @brief Set the priority and the completion callback of the next transfers.
+         * @param callback Called from handleInterrupt(), nullptr leaves the channel interrupts off.
+         */
+        DriverStatus configure(const MdmaPriority newPriority, const Callback newCallback = nullptr, void* newContext = nullptr)
+        {
+            RESULT_TRY(status());
+            if (isBusy()) { return Utils::fail(DriverError::busy); }
+            priority = newPriority;
+            callback = newCallback;
+            context = newContext;
+            return {};
+        }
+
+        /**
+         * @brief Run a chain, the first node is loaded from the CPU.
+         * @return DriverStatus DriverError::invalidParameter for an invalid chain, DriverError::busy if the channel runs.
+         */
+        template<std::size_t Nodes>
+        DriverStatus start(const MdmaChain<Nodes>& chain)
+        {
+            RESULT_TRY(status());
+            if (isBusy()) { return Utils::fail(DriverError::busy); }
+            RESULT_TRY(chain.validate());
+            Cache::clean(chain.data(), chain.size() * sizeof(MdmaDescriptor));
+
+            const MdmaDescriptor& first{ chain.node(0) };
+            setRegisterValue<MdmaChannelRegisters::clear>(Mdma::allFlags);
+            setRegisterValue<MdmaChannelRegisters::transferConfig>(first.transferConfig);
+            setRegisterValue<MdmaChannelRegisters::blockCount>(first.blockCount);
+            setRegisterValue<MdmaChannelRegisters::source>(first.source);
+            setRegisterValue<MdmaChannelRegisters::destination>(first.destination);
+            setRegisterValue<MdmaChannelRegisters::repeatUpdate>(first.repeatUpdate);
+            setRegisterValue<MdmaChannelRegisters::link>(first.link);
+            setRegisterValue<MdmaChannelRegisters::triggerBus>(first.triggerBus);
+            setRegisterValue<MdmaChannelRegisters::maskAddress>(first.maskAddress);
+            setRegisterValue<MdmaChannelRegisters::maskData>(first.maskData);
+
+            std::uint32_t control{ static_cast<std::uint32_t>(priority) << Mdma::priorityPos };
+            if (callback != nullptr) { control |= (1U << Mdma::transferErrorInterruptPos) | (1U << Mdma::channelCompleteInterruptPos); }
+            setRegisterValue<MdmaChannelRegisters::control>(control | (1U << Mdma::enablePos));
+            if (((first.transferConfig >> Mdma::softwareModePos) & 1U) != 0) {
+                setRegisterValue<MdmaChannelRegisters::control>(control | (1U << Mdma::enablePos) | (1U << Mdma::softwareRequestPos));
+            }
+            return {};
+        }
+
+        /**
+         * @brief Disable the channel and wait until the current beat completes.
+         * @return DriverStatus DriverError::timeout, see Dma::awaitDisabled().
+         */
+        DriverStatus stop()
+        {
+            RESULT_TRY(status());
+            setRegisterValue<MdmaChannelRegisters::control>(getRegisterValue<MdmaChannelRegisters::control>() & ~(1U << Mdma::enablePos));
+            RESULT_TRY(Dma::awaitDisabled([this] { return isBusy(); }));
+            setRegisterValue<MdmaChannelRegisters::clear>(Mdma::allFlags);
+            return {};
+        }
+
+        /// Whether the channel is enabled: the hardware disables it at the end of the chain or on an error.
+        bool isBusy() { return checkBit<MdmaChannelRegisters::control>(Mdma::enablePos); }
+
+        /// Flags of the channel, as the Mdma::*Flag constants.
+        std::uint32_t flags() { return getRegisterValue<MdmaChannelRegisters::status>() & Mdma::allFlags; }
+
+        void clearFlags(const std::uint32_t mask) { setRegisterValue<MdmaChannelRegisters::clear>(mask & Mdma::allFlags); }
+
+        /// CxESR: address and direction of the last error.
+        std::uint32_t errorStatus() { return getRegisterValue<MdmaChannelRegisters::errorStatus>(); }
+
+        /// Bytes left in the current block of the current node.
+        std::uint32_t remaining() { return getRegisterValue<MdmaChannelRegisters::blockCount>() & Mdma::blockBytesMask; }
+
+        /**
+         * @brief Acknowledge the channel flags and report the end of the transfer to the callback, from MDMA_IRQHandler.
+         *
+         * The callback runs once: a transfer error wins over the channel complete flag raised with it.
+         * @return std::uint32_t Flags handled.
+         */
+        std::uint32_t handleInterrupt()
+        {
+            const std::uint32_t pending{ flags() & (Mdma::transferErrorFlag | Mdma::channelCompleteFlag) };
+            if (pending == 0) { return 0; }
+            const std::uint32_t error{ (pending & Mdma::transferErrorFlag) != 0 ? errorStatus() : 0U };
+            clearFlags(pending);
+            if (callback == nullptr) { return pending; }
+            if ((pending & Mdma::transferErrorFlag) != 0) {
+                callback(context, MdmaEvent::transferError, error);
+            } else {
+                callback(context, MdmaEvent::channelComplete, 0);
+            }
+            return pending;
+        }
+};
+
+namespace Mdma
+{
+    #if defined(CORE_CM7) || defined(CORE_CM4)
+        /**
+         * @brief Enable the MDMA clock and interrupt of the calling core.
+         */
+        inline void init()
+        {
+            RCC->AHB3ENR = RCC->AHB3ENR | RCC_AHB3ENR_MDMAEN;
+            static_cast<void>(RCC->AHB3ENR);
+            NVIC_EnableIRQ(MDMA_IRQn);
+        }
+
+        /**
+         * @brief Handler of a channel, created on first use.
+         */
+        template<std::uint8_t Channel>
+        MdmaChannelHandler& channel()
+        {
+            static_assert(Channel < channelCount, "The MDMA has 16 channels");
+            MDMA_Channel_TypeDef* const registers{ reinterpret_cast<MDMA_Channel_TypeDef*>(MDMA_Channel0_BASE + 0x40U * Channel) };
+            static MdmaChannelHandler handler{ Channel, &registers->CISR, &registers->CIFCR, &registers->CESR, &registers->CCR, &registers->CTCR,
+                                               &registers->CBNDTR, &registers->CSAR, &registers->CDAR, &registers->CBRUR, &registers->CLAR,
+                                               &registers->CTBR, &registers->CMAR, &registers->CMDR };
+            return handler;
+        }
+
+        /**
+         * @brief Serve the channels the project uses, from MDMA_IRQHandler (one line for all channels).
+         */
+        template<std::uint8_t... Channels>
+        void handleInterrupt()
+        {
+            const std::uint32_t pending{ MDMA->GISR0 };
+            ((((pending >> Channels) & 1U) != 0 ? static_cast<void>(channel<Channels>().handleInterrupt()) : static_cast<void>(0)), ...);
+        }
+    #endif
+};
+
+#endif // __MDMA_H__
@@ -0,0 +1,490 @@
+#ifndef __USART_H__
+#define __USART_H__
+
+/**
+ * @file Usart.hh
+ * @brief USART receiver driver and a zero-copy receive path on a circular DMA stream with idle-line framing.
+ *
+ * UsartHandler drives the receive side of one USART: baud rate (oversampling by 16, or by
+ * 8 when the kernel clock is short of 16 times the baud rate), 8 data bits, no parity, one
+ * stop bit, DMA requests, and the idle line and receiver timeout events reported from the
+ * USART interrupt together with the reception errors.
+ *
+ * UartDmaReceiver is the receive path for high baud rates: a DMA1/DMA2 stream (Dma.hh)
+ * writes every byte into a circular buffer of Size bytes without the CPU, and the CPU only
+ * runs on framing events:
+ *  - idle line: the line stayed idle for one character after a byte, the end of a burst;
+ *  - receiver timeout: no start bit for the configured number of bit times;
+ *  - half transfer and transfer complete of the stream, so that a burst longer than the
+ *    buffer is delivered in halves and the position never laps unnoticed.
+ * Each event publishes the bytes the stream wrote since the last one. The consumer gets
+ * them with front() as a span pointing into the DMA buffer, at most two per wrap, reads
+ * them in place and releases them with pop(); nothing is copied. The stream keeps writing
+ * while the consumer works: if it falls a whole buffer behind, front() drops what is
+ * pending and counts an overrun, and pop() reports a span overwritten while it was read.
+ * A byte the DMA did not take in time is a USART overrun (ORE), counted separately.
+ *
+ * Requirements:
+ *  - the USART and the DMA stream interrupts share one priority, both publish bytes;
+ *  - the interrupt latency stays below Size / 2 character times (0.83 us each at
+ *    12 Mbaud with the 10-bit frame), or a lap goes unnoticed;
+ *  - the stream uses direct mode, its FIFO would hold bytes back from the idle event.
+ * On the CM7, front() invalidates the lines of the span it returns; the CPU never writes
+ * the buffer, so placing the receiver in non-cacheable memory (DMA_BUFFER) works as well.
+ * The DMA1/DMA2 streams cannot reach the TCMs.
+ *
+ * Usage example:
+ * ```
+ * DMA_BUFFER UartDmaReceiver<4096, Ipc::SevWakeup> telemetry;
+ * UsartHandler usart1{ 120000000, &USART1->CR1, &USART1->CR2, &USART1->CR3, &USART1->BRR, &USART1->RTOR, &USART1->ISR, &USART1->ICR, &USART1->RDR };
+ *
+ * telemetry.start(usart1, Dma::stream<1, 0>(), Dma::Request::usart1Rx, reinterpret_cast<std::uint32_t>(&USART1->RDR),
+ *                 UsartConfig{ .baudRate = 12000000, .receiverTimeout = 40 });
+ * extern "C" void USART1_IRQHandler() { usart1.handleInterrupt(); }
+ * extern "C" void DMA1_Stream0_IRQHandler() { Dma::stream<1, 0>().handleInterrupt(); }
+ *
+ * // consumer
+ * for (auto span{ telemetry.front() }; span.isValid(); span = telemetry.front()) {
+ *     parse(span.data, span.size);
+ *     telemetry.pop(span.size);
+ * }
+ * ```
+ */
+
+//<------------------------------INCLUDES------------------------------>//
+#include <atomic>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <PeripheralBaseHandler.hh>
+#include <DriverError.hh>
+#include <Cache.hh>
+#include <Dma.hh>
+#include <Wakeup.hh>
+#if defined(CORE_CM7) || defined(CORE_CM4)
+#include <stm32h755xx.h>
+#endif
+//<-------------------------------------------------------------------->//
+
+namespace Usart
+{
+    /// Smallest USARTDIV the hardware accepts.
+    inline constexpr std::uint32_t minDivider{ 16 };
+    inline constexpr std::uint32_t maxDivider{ 0xFFFF };
+    inline constexpr std::uint32_t maxReceiverTimeout{ 0xFFFFFF };
+
+    // CR1
+    inline constexpr std::uint32_t enablePos{ 0 };
+    inline constexpr std::uint32_t receiverEnablePos{ 2 };
+    inline constexpr std::uint32_t idleInterruptPos{ 4 };
+    inline constexpr std::uint32_t oversampling8Pos{ 15 };
+    inline constexpr std::uint32_t receiverTimeoutInterruptPos{ 26 };
+
+    // CR2
+    inline constexpr std::uint32_t receiverTimeoutEnablePos{ 23 };
+
+    // CR3
+    inline constexpr std::uint32_t errorInterruptPos{ 0 };
+    inline constexpr std::uint32_t dmaReceivePos{ 6 };
+
+    // ISR and ICR
+    inline constexpr std::uint32_t parityErrorFlag{ 1U << 0 };
+    inline constexpr std::uint32_t framingErrorFlag{ 1U << 1 };
+    inline constexpr std::uint32_t noiseFlag{ 1U << 2 };
+    inline constexpr std::uint32_t overrunFlag{ 1U << 3 };
+    inline constexpr std::uint32_t idleFlag{ 1U << 4 };
+    inline constexpr std::uint32_t receiveNotEmptyFlag{ 1U << 5 };
+    inline constexpr std::uint32_t receiverTimeoutFlag{ 1U << 11 };
+    /// Flags cleared through ICR, RXNE is cleared by reading RDR.
+    inline constexpr std::uint32_t allFlags{ parityErrorFlag | framingErrorFlag | noiseFlag | overrunFlag | idleFlag | receiverTimeoutFlag };
+};
+
+/**
+ * @brief Events reported to the handler callback.
+ */
+enum class UsartEvent : std::uint8_t {
+    idle,                   ///< The line went idle after a byte.
+    receiverTimeout,        ///< No start bit for the configured timeout.
+    overrun,                ///< A byte arrived before the previous one left RDR and was lost.
+    framingError,
+    noise
+};
+
+/**
+ * @brief Receive configuration, 8 data bits, no parity, one stop bit.
+ */
+struct UsartConfig {
+    std::uint32_t baudRate{ 115200 };
+    std::uint32_t receiverTimeout{ 0 };     ///< Bit times without a start bit before the timeout event, 0 for none.
+    bool idleInterrupt{ true };
+    bool dmaReceive{ true };
+};
+
+namespace Usart
+{
+    /// BRR value and oversampling for a baud rate.
+    struct Divider {
+        std::uint32_t brr;
+        bool oversampling8;
+
+        constexpr bool isValid() const { return brr != 0; }
+    };
+
+    /**
+     * @brief BRR for a baud rate, rounded to the nearest, by 16 oversampling when the kernel clock allows it.
+     * @return Divider Invalid if the baud rate is out of reach.
+     */
+    constexpr Divider divider(const std::uint32_t kernelClock, const std::uint32_t baudRate)
+    {
+        if (baudRate == 0) { return Divider{ 0, false }; }
+        const std::uint64_t divider16{ (static_cast<std::uint64_t>(kernelClock) + baudRate / 2) / baudRate };
+        if (divider16 >= minDivider && divider16 <= maxDivider) { return Divider{ static_cast<std::uint32_t>(divider16), false }; }
+        // By 8: BRR[3] stays clear and BRR[2:0] holds USARTDIV[3:0] >> 1
+        const std::uint64_t divider8{ (2ULL * kernelClock + baudRate / 2) / baudRate };
+        if (divider8 < minDivider || divider8 > maxDivider) { return Divider{ 0, false }; }
+        return Divider{ static_cast<std::uint32_t>((divider8 & ~0xFULL) | ((divider8 & 0xFULL) >> 1)), true };
+    }
+
+    /// Baud rate a divider produces, to check the error against the other end.
+    constexpr std::uint32_t baudRateOf(const std::uint32_t kernelClock, const Divider& divider)
+    {
+        if (!divider.isValid()) { return 0; }
+        if (!divider.oversampling8) { return kernelClock / divider.brr; }
+        const std::uint32_t usartDivider{ (divider.brr & ~0xFU) | ((divider.brr & 0x7U) << 1) };
+        return static_cast<std::uint32_t>(2ULL * kernelClock / usartDivider);
+    }
+};
+
+enum class UsartProperties { kernelClock };
+using UsartPropertiesTypeList = Utils::TypeList<
+    pair<UsartProperties::kernelClock, std::uint32_t>
+>;
+
+enum class UsartRegisters { control1, control2, control3, baudRate, receiverTimeout, interruptStatus, interruptClear, receiveData };
+using UsartRegistersTypeList = Utils::TypeList<
+    pair<UsartRegisters::control1, volatile std::uint32_t*>,         // CR1
+    pair<UsartRegisters::control2, volatile std::uint32_t*>,         // CR2
+    pair<UsartRegisters::control3, volatile std::uint32_t*>,         // CR3
+    pair<UsartRegisters::baudRate, volatile std::uint32_t*>,         // BRR
+    pair<UsartRegisters::receiverTimeout, volatile std::uint32_t*>,  // RTOR
+    pair<UsartRegisters::interruptStatus, volatile std::uint32_t*>,  // ISR
+    pair<UsartRegisters::interruptClear, volatile std::uint32_t*>,   // ICR
+    pair<UsartRegisters::receiveData, volatile std::uint32_t*>       // RDR
+>;
+
+class UsartHandler : public PeripheralHandlerBase<UsartPropertiesTypeList, UsartRegistersTypeList, UsartHandler>
+{
+    public:
+        using Callback = void (*)(void* context, UsartEvent event);
+
+    private:
+        using classParent = PeripheralHandlerBase<UsartPropertiesTypeList, UsartRegistersTypeList, UsartHandler>;
+
+        Callback callback{ nullptr };
+        void* context{ nullptr };
+        std::uint32_t reported{ 0 };
+        bool configured{ false };
+
+    public:
+        /**
+         * @param kernelClock Kernel clock of the USART in Hz, see ClockTree.hh.
+         * @param addresses CR1, CR2, CR3, BRR, RTOR, ISR, ICR and RDR.
+         */
+        template<typename... RegisterAddress>
+        requires ((Utils::UnsignedIntegralPointerConcept<std::decay_t<RegisterAddress>> && ...))
+        explicit UsartHandler(const std::uint32_t kernelClock, RegisterAddress&&... addresses)
+            : classParent(this, std::forward<RegisterAddress>(addresses)...) {
+            setParam<UsartProperties::kernelClock>(kernelClock);
+        }
+
+        template<typename... Handles>
+        explicit UsartHandler(const std::uint32_t kernelClock, RegisterHandlesTag tag, Handles*... handles)
+            : classParent(this, tag, handles...) {
+            setParam<UsartProperties::kernelClock>(kernelClock);
+        }
+
+        /**
+         * @brief Program the receiver, which must be disabled.
+         * @param callback Called from handleInterrupt(), nullptr leaves the USART interrupts off.
+         * @return DriverStatus DriverError::invalidParameter for a baud rate or timeout out of reach,
+         * DriverError::busy if the USART is enabled.
+         */
+        DriverStatus configure(const UsartConfig& config, const Callback newCallback = nullptr, void* newContext = nullptr)
+        {
+            RESULT_TRY(status());
+            const Usart::Divider divider{ Usart::divider(getParam<UsartProperties::kernelClock>(), config.baudRate) };
+            if (!divider.isValid() || config.receiverTimeout > Usart::maxReceiverTimeout) { return Utils::fail(DriverError::invalidParameter); }
+            if (isEnabled()) { return Utils::fail(DriverError::busy); }
+
+            const bool interrupts{ newCallback != nullptr };
+            const bool timeout{ config.receiverTimeout != 0 };
+            std::uint32_t control1{ (divider.oversampling8 ? 1U : 0U) << Usart::oversampling8Pos };
+            reported = 0;
+            if (interrupts) {
+                reported = Usart::overrunFlag | Usart::framingErrorFlag | Usart::noiseFlag;
+                if (config.idleInterrupt) {
+                    control1 |= 1U << Usart::idleInterruptPos;
+                    reported |= Usart::idleFlag;
+                }
+                if (timeout) {
+                    control1 |= 1U << Usart::receiverTimeoutInterruptPos;
+                    reported |= Usart::receiverTimeoutFlag;
+                }
+            }
+            setRegisterValue<UsartRegisters::control1>(control1);
+            setRegisterValue<UsartRegisters::control2>((timeout ? 1U : 0U) << Usart::receiverTimeoutEnablePos);
+            setRegisterValue<UsartRegisters::control3>(((config.dmaReceive ? 1U : 0U) << Usart::dmaReceivePos) | ((interrupts ? 1U : 0U) << Usart::errorInterruptPos));
+            setRegisterValue<UsartRegisters::baudRate>(divider.brr);
+            setRegisterValue<UsartRegisters::receiverTimeout>(config.receiverTimeout);
+            clearFlags(Usart::allFlags);
+
+            callback = newCallback;
+            context = newContext;
+            configured = true;
+            return {};
+        }
+
+        /**
+         * @brief Enable the USART and its receiver.
+         */
+        DriverStatus enable()
+        {
+            RESULT_TRY(status());
+            if (!configured) { return Utils::fail(DriverError::notInitialized); }
+            clearFlags(Usart::allFlags);
+            setRegisterValue<UsartRegisters::control1>(getRegisterValue<UsartRegisters::control1>() | (1U << Usart::enablePos) | (1U << Usart::receiverEnablePos));
+            return {};
+        }
+
+        DriverStatus disable()
+        {
+            RESULT_TRY(status());
+            setRegisterValue<UsartRegisters::control1>(getRegisterValue<UsartRegisters::control1>() & ~((1U << Usart::enablePos) | (1U << Usart::receiverEnablePos)));
+            return {};
+        }
+
+        bool isEnabled() { return checkBit<UsartRegisters::control1>(Usart::enablePos); }
+
+        /// Flags, as the Usart::*Flag constants.
+        std::uint32_t flags() { return getRegisterValue<UsartRegisters::interruptStatus>() & (Usart::allFlags | Usart::receiveNotEmptyFlag); }
+
+        void clearFlags(const std::uint32_t mask) { setRegisterValue<UsartRegisters::interruptClear>(mask & Usart::allFlags); }
+
+        /// Read RDR, without DMA.
+        std::uint8_t read() { return static_cast<std::uint8_t>(getRegisterValue<UsartRegisters::receiveData>()); }
+
+        /**
+         * @brief Acknowledge the flags and report them to the callback, from the USART IRQ handler.
+         *
+         * Errors come first, then the idle line, then the receiver timeout.
+         * @return std::uint32_t Flags handled.
+         */
+        std::uint32_t handleInterrupt()
+        {
+            const std::uint32_t pending{ flags() & reported };
+            if (pending == 0) { return 0; }
+            clearFlags(pending);
+            if ((pending & Usart::overrunFlag) != 0) { callback(context, UsartEvent::overrun); }
+            if ((pending & Usart::framingErrorFlag) != 0) { callback(context, UsartEvent::framingError); }
+            if ((pending & Usart::noiseFlag) != 0) { callback(context, UsartEvent::noise); }
+            if ((pending & Usart::idleFlag) != 0) { callback(context, UsartEvent::idle); }
+            if ((pending & Usart::receiverTimeoutFlag) != 0) { callback(context, UsartEvent::receiverTimeout); }
+            return pending;
+        }
+};
+
+/**
+ * @brief Zero-copy receive into a circular DMA buffer, delivered on idle line, receiver timeout and half buffers.
+ * @tparam Size Buffer bytes, a power of two from 32 to 32768.
+ * @tparam Wakeup Signaled on each framing event, see Wakeup.hh.
+ */
+template<std::size_t Size, typename Wakeup = Ipc::NoWakeup>
+class UartDmaReceiver
+{
+    static_assert(Size >= Cache::lineSize && Size <= 32768 && (Size & (Size - 1)) == 0, "The receive buffer must be a power of two from 32 to 32768 bytes");
+    static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "UartDmaReceiver needs lock-free 32-bit atomics");
+
+    public:
+        /// Received bytes in the DMA buffer, valid until pop().
+        struct Span {
+            const std::uint8_t* data{ nullptr };
+            std::size_t size{ 0 };
+
+            constexpr bool isValid() const { return data != nullptr; }
+        };
+
+        /// Counters since start().
+        struct Statistics {
+            std::uint32_t bytes;                ///< Bytes published.
+            std::uint32_t frames;               ///< Idle line and receiver timeout events.
+            std::uint32_t overruns;             ///< Times the consumer fell a buffer behind.
+            std::uint32_t lostBytes;            ///< Bytes dropped by those overruns.
+            std::uint32_t usartOverruns;        ///< Bytes the DMA did not take in time (ORE).
+            std::uint32_t errors;               ///< Framing, noise and DMA transfer errors.
+        };
+
+    private:
+        static constexpr std::uint32_t mask{ static_cast<std::uint32_t>(Size - 1) };
+
+        alignas(Cache::lineSize) std::array<std::uint8_t, Size> buffer;
+        std::atomic<std::uint32_t> written{ 0 };
+        std::atomic<std::uint32_t> consumed{ 0 };
+        std::uint32_t position{ 0 };            ///< Buffer index of written, interrupt side only.
+        volatile std::uint32_t frames{ 0 };
+        volatile std::uint32_t usartOverruns{ 0 };
+        volatile std::uint32_t errors{ 0 };
+        std::uint32_t overruns{ 0 };            ///< Written by the consumer only.
+        std::uint32_t lostBytes{ 0 };
+        UsartHandler* usart{ nullptr };
+        DmaStreamHandler* stream{ nullptr };
+
+        /// Index the stream writes next.
+        std::uint32_t streamPosition() { return (static_cast<std::uint32_t>(Size) - stream->remaining()) & mask; }
+
+        /// Publish the bytes the stream wrote since the last event.
+        void publish()
+        {
+            const std::uint32_t next{ streamPosition() };
+            const std::uint32_t bytes{ (next - position) & mask };
+            position = next;
+            if (bytes != 0) { written.store(written.load(std::memory_order_relaxed) + bytes, std::memory_order_release); }
+        }
+
+        static void onUsartEvent(void* context, const UsartEvent event)
+        {
+            auto& self{ *static_cast<UartDmaReceiver*>(context) };
+            switch (event) {
+                case UsartEvent::overrun: self.usartOverruns = self.usartOverruns + 1; return;
+                case UsartEvent::framingError:
+                case UsartEvent::noise: self.errors = self.errors + 1; return;
+                default: break;
+            }
+            self.publish();
+            self.frames = self.frames + 1;
+            Wakeup::signal();
+        }
+
+        static void onDmaEvent(void* context, const DmaEvent event, [[maybe_unused]] const std::uint8_t buffer)
+        {
+            auto& self{ *static_cast<UartDmaReceiver*>(context) };
+            if (event == DmaEvent::halfTransfer || event == DmaEvent::transferComplete) {
+                self.publish();
+                Wakeup::signal();
+            } else {
+                self.errors = self.errors + 1;
+            }
+        }
+
+        /// Bytes the stream wrote after consumed, published or not.
+        std::uint32_t distance(const std::uint32_t from)
+        {
+            const std::uint32_t published{ written.load(std::memory_order_acquire) };
+            return published - from + ((streamPosition() - published) & mask);
+        }
+
+    public:
+        UartDmaReceiver() = default;
+        UartDmaReceiver(const UartDmaReceiver&) = delete;
+        UartDmaReceiver& operator=(const UartDmaReceiver&) = delete;
+
+        /**
+         * @brief Configure the USART and the stream for the reception and start both.
+         * @param dataRegister Bus address of RDR, e.g. &USART1->RDR.
+         * @param busAddress Address the DMA sees the object at, 0 for the CPU's; for host models.
+         * @return DriverStatus DriverError::invalidParameter if the object is in a TCM or the configuration is refused.
+         */
+        DriverStatus start(UsartHandler& newUsart, DmaStreamHandler& newStream, const Dma::Request request, const std::uint32_t dataRegister,
+                           const UsartConfig& config, const DmaPriority priority = DmaPriority::high, const std::uint32_t busAddress = 0)
+        {
+            const std::uint32_t base{ busAddress != 0 ? busAddress : static_cast<std::uint32_t>(reinterpret_cast<std::uintptr_t>(this)) };
+            const std::uint32_t first{ base + static_cast<std::uint32_t>(reinterpret_cast<std::uintptr_t>(buffer.data()) - reinterpret_cast<std::uintptr_t>(this)) };
+            UsartConfig usartConfig{ config };
+            usartConfig.dmaReceive = true;
+            RESULT_TRY(newUsart.configure(usartConfig, &onUsartEvent, this));
+            const DmaConfig streamConfig{ .request = request, .mode = DmaMode::circular, .priority = priority, .halfTransferInterrupt = true, .bufferable = true };
+            RESULT_TRY(newStream.configure(streamConfig, &onDmaEvent, this));
+
+            written.store(0, std::memory_order_relaxed);
+            consumed.store(0, std::memory_order_relaxed);
+            position = 0;
+            frames = 0;
+            usartOverruns = 0;
+            errors = 0;
+            overruns = 0;
+            lostBytes = 0;
+            usart = &newUsart;
+            stream = &newStream;
+            RESULT_TRY(newStream.start(dataRegister, first, static_cast<std::uint32_t>(Size)));
+            return newUsart.enable();
+        }
+
+        /**
+         * @brief Stop the USART then the stream, and publish the bytes received until then.
+         */
+        DriverStatus stop()
+        {
+            if (usart == nullptr) { return Utils::fail(DriverError::notInitialized); }
+            RESULT_TRY(usart->disable());
+            RESULT_TRY(stream->stop());
+            publish();
+            return {};
+        }
+
+        /**
+         * @brief Oldest received bytes, contiguous: up to the last event or the end of the buffer.
+         *
+         * If the stream got a whole buffer ahead of the consumer, the pending bytes are dropped
+         * and counted as an overrun first.
+         * @return Span Invalid if nothing was received since the last pop().
+         */
+        Span front()
+        {
+            std::uint32_t next{ consumed.load(std::memory_order_relaxed) };
+            if (stream != nullptr && distance(next) > Size) {
+                const std::uint32_t published{ written.load(std::memory_order_acquire) };
+                ++overruns;
+                lostBytes += published - next;
+                next = published;
+                consumed.store(next, std::memory_order_release);
+            }
+            const std::uint32_t published{ written.load(std::memory_order_acquire) };
+            if (next == published) { return Span{}; }
+            const std::uint32_t index{ next & mask };
+            const std::uint32_t available{ published - next };
+            const std::size_t size{ available < Size - index ? available : Size - index };
+            Cache::invalidate(buffer.data() + index, size);
+            return Span{ buffer.data() + index, size };
+        }
+
+        /**
+         * @brief Release bytes from the front.
+         * @param bytes Up to the size of the span front() returned.
+         * @return bool false if the stream started overwriting them before the call: the data read may be torn.
+         */
+        bool pop(const std::size_t bytes)
+        {
+            const std::uint32_t next{ consumed.load(std::memory_order_relaxed) };
+            const std::uint32_t available{ written.load(std::memory_order_acquire) - next };
+            const std::uint32_t released{ bytes < available ? static_cast<std::uint32_t>(bytes) : available };
+            if (released == 0) { return true; }
+            const bool intact{ distance(next) <= Size };
+            if (!intact) { ++overruns; }
+            consumed.store(next + released, std::memory_order_release);
+            return intact;
+        }
+
+        /// Bytes received and not popped.
+        std::size_t available() const { return written.load(std::memory_order_acquire) - consumed.load(std::memory_order_relaxed); }
+
+        bool isRunning() { return stream != nullptr && stream->isEnabled(); }
+
+        Statistics statistics() const
+        {
+            return Statistics{ written.load(std::memory_order_relaxed), frames, overruns, lostBytes, usartOverruns, errors };
+        }
+
+        static constexpr std::size_t capacity() { return Size; }
+};
+
+#endif // __USART_H__
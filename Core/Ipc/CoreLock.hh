@@ -0,0 +1,81 @@
+#ifndef __CORELOCK_H__
+#define __CORELOCK_H__
+
+/**
+ * @file CoreLock.hh
+ * @brief Scoped spin lock shared by the two cores, for read-modify-write sections of a few cycles.
+ *
+ * The exclusive monitors of the cores (LDREX/STREX) do not arbitrate accesses coming from
+ * the other core to the shared SRAMs, so a std::atomic read-modify-write is not atomic
+ * across the cores. HsemSpinLock serializes such sections with a 1-step lock of a hardware
+ * semaphore instead, with the interrupts of the calling core masked while it is held: an
+ * ISR of the same core would otherwise read the semaphore as already locked by its own
+ * core and enter the section too. On the host the semaphore is a std::atomic_flag, so
+ * threads standing for the cores contend for real.
+ *
+ * Usage example:
+ * ```
+ * {
+ *     Ipc::HsemSpinLock<6> guard;
+ *     // ... update data shared by the cores ...
+ * }
+ * ```
+ */
+
+//<------------------------------INCLUDES------------------------------>//
+#include <atomic>
+#include <cstdint>
+#include <CriticalSection.hh>
+#include <Hsem.hh>
+#if defined(CORE_CM7) || defined(CORE_CM4)
+#include <stm32h755xx.h>
+#else
+#include <thread>
+#endif
+//<-------------------------------------------------------------------->//
+
+namespace Ipc
+{
+    /**
+     * @brief Cross-core lock held for the lifetime of the object.
+     * @tparam Id Semaphore number, 0 to 31, reserved for this lock.
+     */
+    template<std::uint32_t Id>
+    class HsemSpinLock
+    {
+        static_assert(Id < Hsem::semaphoreCount, "The H755 has 32 hardware semaphores");
+
+    private:
+        CriticalSection guard;
+
+        #if !defined(CORE_CM7) && !defined(CORE_CM4)
+            static inline std::atomic_flag flag{};
+        #endif
+
+    public:
+        HsemSpinLock()
+        {
+            #if defined(CORE_CM7) || defined(CORE_CM4)
+                while (HSEM->RLR[Id] != Hsem::lockValue(Hsem::currentCoreId(), 0)) {}
+                __DMB();
+            #else
+                while (flag.test_and_set(std::memory_order_acquire)) { std::this_thread::yield(); }
+            #endif
+        }
+
+        ~HsemSpinLock()
+        {
+            #if defined(CORE_CM7) || defined(CORE_CM4)
+                __DMB();
+                HSEM->R[Id] = Hsem::currentCoreId() << Hsem::coreIdPos;
+            #else
+                flag.clear(std::memory_order_release);
+            #endif
+        }
+
+        HsemSpinLock(const HsemSpinLock&) = delete;
+        HsemSpinLock& operator=(const HsemSpinLock&) = delete;
+    };
+};
+
+#endif // __CORELOCK_H__
@@ -0,0 +1,458 @@
+#ifndef __OFFLOAD_H__
+#define __OFFLOAD_H__
+
+/**
+ * @file Offload.hh
+ * @brief Work offload from the CM7 to the CM4, with the statistics deciding where a job runs.
+ *
+ * A job is a function ID plus its arguments. The CM7 (OffloadClient) either runs it
+ * itself or copies it into the job ring of the shared OffloadQueue. The CM4
+ * (OffloadWorker) runs the jobs in place in the ring and posts completions (function
+ * result, service time) to the completion ring. Both ways end in the same completion
+ * callback on the CM7, so the caller does not care where the job ran.
+ *
+ * OffloadStats keeps, per function, moving averages of the local run time, the remote
+ * service time and the end-to-end latency, plus the queue depth, the remote backlog and
+ * the busy time of both sides. shouldOffload() compares the expected remote latency
+ * (transfer + backlog + service) with the local run time scaled by a slack factor:
+ * offloading frees the CM7 for the other work as long as the result does not come back
+ * much later than a local run would give it. OffloadStats is pure bookkeeping on
+ * timestamps, so the scheduling runs unchanged in host simulations.
+ *
+ * Usage example:
+ * ```
+ * SRAM4_SHARED Ipc::OffloadQueue<4096> offloadQueue;
+ * // CM4
+ * Ipc::OffloadWorker<decltype(offloadQueue), 4> worker{ offloadQueue };
+ * worker.bind(fftJob, &runFft);                       // std::uint32_t runFft(const std::byte* args, std::size_t size)
+ * worker.serve();
+ * // CM7
+ * Ipc::OffloadClient<decltype(offloadQueue), 4> client{ offloadQueue, &onDone, nullptr };
+ * client.run(fftJob, &args, sizeof(args), &runFft);   // local or offloaded
+ * client.poll();                                      // completions of offloaded jobs
+ * ```
+ */
+
+//<------------------------------INCLUDES------------------------------>//
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <Result.hh>
+#include <CycleCounter.hh>
+#include <SpscRing.hh>
+#include <Wakeup.hh>
+//<-------------------------------------------------------------------->//
+
+namespace Ipc
+{
+    enum class OffloadError : std::uint8_t {
+        unknownFunction,    ///< Function ID out of range.
+        argsTooLarge,       ///< Arguments larger than a ring record.
+        queueFull           ///< No room in the job ring or maxDepth jobs in flight.
+    };
+
+    /**
+     * @brief Tuning of the offload decision.
+     */
+    struct OffloadPolicy {
+        std::uint32_t maxDepth{ 16 };                   ///< Jobs in flight at most.
+        std::uint32_t slackPercent{ 400 };              ///< Accepted remote latency, in % of the local run time.
+        std::uint32_t transferCycles{ 400 };            ///< Cost of a trip through both rings, in client cycles.
+        std::uint32_t remoteCycleNumerator{ 2 };        ///< Worker cycles to client cycles: CM7 480 MHz / CM4 240 MHz.
+        std::uint32_t remoteCycleDenominator{ 1 };
+    };
+
+    /**
+     * @brief Exponential moving average with a weight of 1/8 for the new sample.
+     */
+    struct Ewma {
+        std::uint32_t value{ 0 };
+        std::uint32_t samples{ 0 };
+
+        constexpr void add(const std::uint32_t sample)
+        {
+            value = samples == 0 ? sample : static_cast<std::uint32_t>(static_cast<std::int64_t>(value) + (static_cast<std::int64_t>(sample) - value) / 8);
+            ++samples;
+        }
+
+        constexpr bool isValid() const { return samples != 0; }
+    };
+
+    /**
+     * @brief Counters and estimates behind the offload decision, all times in client cycles.
+     * @tparam Functions Number of function IDs, 0 to Functions - 1.
+     */
+    template<std::size_t Functions>
+    class OffloadStats
+    {
+    public:
+        struct FunctionStats {
+            Ewma local;             ///< Run time on the client.
+            Ewma remote;            ///< Service time on the worker, converted to client cycles.
+            Ewma latency;           ///< Submission to completion seen by the client.
+            std::uint32_t localRuns{ 0 };
+            std::uint32_t offloaded{ 0 };
+        };
+
+    private:
+        OffloadPolicy policy;
+        std::array<FunctionStats, Functions> functions{};
+        std::uint32_t inFlight{ 0 };
+        std::uint32_t deepest{ 0 };
+        std::uint32_t backlog{ 0 };
+        std::uint32_t refused{ 0 };
+        std::uint32_t dropped{ 0 };
+        std::uint32_t windowStart{ 0 };
+        std::uint32_t localBusy{ 0 };
+        std::uint32_t remoteBusy{ 0 };
+
+    public:
+        constexpr explicit OffloadStats(const OffloadPolicy& policy = OffloadPolicy{}) : policy(policy) {}
+
+        constexpr const OffloadPolicy& getPolicy() const { return policy; }
+
+        constexpr std::uint32_t toClientCycles(const std::uint32_t workerCycles) const
+        {
+            return static_cast<std::uint32_t>(static_cast<std::uint64_t>(workerCycles) * policy.remoteCycleNumerator / policy.remoteCycleDenominator);
+        }
+
+        /// Expected service time of one job on the worker, the local time until measured.
+        constexpr std::uint32_t remoteEstimate(const std::size_t function) const
+        {
+            const FunctionStats& stats{ functions[function] };
+            return stats.remote.isValid() ? stats.remote.value : stats.local.value;
+        }
+
+        /// Expected submission to completion time of a job offloaded now.
+        constexpr std::uint32_t expectedRemoteLatency(const std::size_t function) const
+        {
+            return policy.transferCycles + backlog + remoteEstimate(function);
+        }
+
+        /**
+         * @brief Decide where the next job of a function runs.
+         *
+         * The first job of a function runs locally to learn its cost, the next one is
+         * offloaded to learn the remote one. Then a job is offloaded when the queue has
+         * room and its expected latency stays within the slack.
+         */
+        constexpr bool shouldOffload(const std::size_t function) const
+        {
+            const FunctionStats& stats{ functions[function] };
+            if (inFlight >= policy.maxDepth || !stats.local.isValid()) { return false; }
+            if (!stats.remote.isValid()) { return stats.offloaded == 0; }
+            return static_cast<std::uint64_t>(expectedRemoteLatency(function)) * 100 <= static_cast<std::uint64_t>(stats.local.value) * policy.slackPercent;
+        }
+
+        constexpr void recordLocal(const std::size_t function, const std::uint32_t cycles)
+        {
+            functions[function].local.add(cycles);
+            ++functions[function].localRuns;
+            localBusy += cycles;
+        }
+
+        /// A job was queued, returns the backlog estimate to hand back to recordCompletion().
+        constexpr std::uint32_t recordSubmit(const std::size_t function)
+        {
+            const std::uint32_t estimate{ remoteEstimate(function) };
+            ++functions[function].offloaded;
+            ++inFlight;
+            deepest = inFlight > deepest ? inFlight : deepest;
+            backlog += estimate;
+            return estimate;
+        }
+
+        constexpr void recordRefused() { ++refused; }
+
+        /**
+         * @param serviceCycles Run time reported by the worker, in worker cycles.
+         * @param latencyCycles Submission to completion, in client cycles.
+         * @param estimate Value returned by recordSubmit() for the job.
+         * @param succeeded Whether the worker ran the job; a failed one takes no sample.
+         */
+        constexpr void recordCompletion(const std::size_t function, const std::uint32_t serviceCycles, const std::uint32_t latencyCycles, const std::uint32_t estimate, const bool succeeded = true)
+        {
+            if (succeeded) {
+                const std::uint32_t service{ toClientCycles(serviceCycles) };
+                functions[function].remote.add(service);
+                functions[function].latency.add(latencyCycles);
+                remoteBusy += service;
+            }
+            release(estimate);
+        }
+
+        /// A completion naming no function: the job leaves the queue, nothing else is known of it.
+        constexpr void recordDropped(const std::uint32_t estimate)
+        {
+            ++dropped;
+            release(estimate);
+        }
+
+        /// Start a new utilization window.
+        constexpr void resetWindow(const std::uint32_t now)
+        {
+            windowStart = now;
+            localBusy = 0;
+            remoteBusy = 0;
+        }
+
+        /// Share of the window the client spent running jobs, in %.
+        constexpr std::uint32_t localUtilization(const std::uint32_t now) const { return percentOfWindow(localBusy, now); }
+
+        /// Share of the window the worker spent running jobs, in %.
+        constexpr std::uint32_t remoteUtilization(const std::uint32_t now) const { return percentOfWindow(remoteBusy, now); }
+
+        constexpr const FunctionStats& function(const std::size_t function) const { return functions[function]; }
+        constexpr std::uint32_t depth() const { return inFlight; }
+        constexpr std::uint32_t maxDepthSeen() const { return deepest; }
+        constexpr std::uint32_t backlogCycles() const { return backlog; }
+        constexpr std::uint32_t refusedCount() const { return refused; }
+        constexpr std::uint32_t droppedCount() const { return dropped; }
+
+    private:
+        constexpr void release(const std::uint32_t estimate)
+        {
+            inFlight = inFlight != 0 ? inFlight - 1 : 0;
+            backlog = backlog > estimate ? backlog - estimate : 0;
+        }
+
+        constexpr std::uint32_t percentOfWindow(const std::uint32_t busy, const std::uint32_t now) const
+        {
+            const std::uint32_t window{ now - windowStart };
+            return window == 0 ? 0 : static_cast<std::uint32_t>(static_cast<std::uint64_t>(busy) * 100 / window);
+        }
+    };
+
+    /// Job header in the job ring, followed by the arguments.
+    struct OffloadJob {
+        std::uint32_t id;
+        std::uint32_t submitStamp;          ///< Client clock.
+        std::uint32_t estimate;             ///< Backlog share, echoed back.
+        std::uint16_t function;
+        std::uint16_t argsSize;
+    };
+
+    /// Completion record, client and worker side.
+    struct OffloadCompletion {
+        std::uint32_t id;
+        std::uint32_t submitStamp;
+        std::uint32_t estimate;
+        std::uint32_t result;               ///< Return value of the function.
+        std::uint32_t serviceCycles;        ///< Worker clock.
+        std::uint16_t function;
+        std::uint8_t status;                ///< 0 or 1 + OffloadError.
+        std::uint8_t reserved;
+    };
+
+    /**
+     * @brief What the completion callback receives, wherever the job ran.
+     */
+    struct OffloadResult {
+        std::uint32_t id;
+        std::uint16_t function;
+        bool offloaded;
+        bool ok;                            ///< false if the worker had no handler for the function.
+        std::uint32_t result;
+        std::uint32_t latencyCycles;
+    };
+
+    /**
+     * @brief Shared part: the job ring and the completion ring.
+     * @tparam Capacity Size of the job ring, jobs and arguments included.
+     */
+    template<std::size_t Capacity, typename JobWakeup = NoWakeup, typename CompletionWakeup = JobWakeup>
+    class OffloadQueue
+    {
+    public:
+        static constexpr std::size_t maxArgsSize{ SpscRing<Capacity>::maxMessageSize() - sizeof(OffloadJob) };
+
+        SpscRing<Capacity, JobWakeup> jobs;
+        SpscRing<Capacity, CompletionWakeup> completions;
+
+        /**
+         * @brief Empty both rings. Call from one core while the other does not use the queue yet.
+         */
+        void reset()
+        {
+            jobs.reset();
+            completions.reset();
+        }
+    };
+
+    /**
+     * @brief CM7 side: runs jobs locally or offloads them, collects completions.
+     * @tparam Functions Number of function IDs.
+     */
+    template<typename Queue, std::size_t Functions>
+    class OffloadClient
+    {
+    public:
+        using Function = std::uint32_t (*)(const std::byte* args, std::size_t size);
+        using Completion = void (*)(void* context, const OffloadResult& result);
+
+    private:
+        Queue& queue;
+        Completion completion;
+        void* context;
+        OffloadStats<Functions> stats;
+        std::uint32_t nextId{ 1 };
+
+    public:
+        OffloadClient(Queue& queue, const Completion completion, void* context, const OffloadPolicy& policy = OffloadPolicy{})
+            : queue(queue), completion(completion), context(context), stats(policy) {}
+
+        /**
+         * @brief Queue a job for the worker, whatever the statistics say.
+         * @return std::uint32_t Job ID, reported back in the completion.
+         */
+        Utils::Result<std::uint32_t, OffloadError> submit(const std::uint16_t function, const void* args, const std::size_t size)
+        {
+            if (function >= Functions) { return Utils::fail(OffloadError::unknownFunction); }
+            if (size > Queue::maxArgsSize) { return Utils::fail(OffloadError::argsTooLarge); }
+            if (stats.depth() >= stats.getPolicy().maxDepth) {
+                stats.recordRefused();
+                return Utils::fail(OffloadError::queueFull);
+            }
+            std::uint8_t* record{ queue.jobs.prepare(sizeof(OffloadJob) + size) };
+            if (record == nullptr) {
+                stats.recordRefused();
+                return Utils::fail(OffloadError::queueFull);
+            }
+            const OffloadJob job{ nextId++, CycleCounter::now(), stats.recordSubmit(function), function, static_cast<std::uint16_t>(size) };
+            std::memcpy(record, &job, sizeof(job));
+            if (size != 0) { std::memcpy(record + sizeof(job), args, size); }
+            queue.jobs.commit(sizeof(job) + size);
+            return job.id;
+        }
+
+        /**
+         * @brief Run a job where the statistics say, locally through local if not offloaded.
+         *
+         * A local run completes before returning, the callback included. A job the queue
+         * refuses runs locally as well.
+         * @return std::uint32_t Job ID.
+         */
+        Utils::Result<std::uint32_t, OffloadError> run(const std::uint16_t function, const void* args, const std::size_t size, const Function local)
+        {
+            if (function >= Functions) { return Utils::fail(OffloadError::unknownFunction); }
+            if (stats.shouldOffload(function)) {
+                const auto submitted{ submit(function, args, size) };
+                if (submitted) { return submitted; }
+            }
+            const std::uint32_t id{ nextId++ };
+            const std::uint32_t start{ CycleCounter::now() };
+            const std::uint32_t result{ local(static_cast<const std::byte*>(args), size) };
+            const std::uint32_t cycles{ CycleCounter::now() - start };
+            stats.recordLocal(function, cycles);
+            completion(context, OffloadResult{ id, function, false, true, result, cycles });
+            return id;
+        }
+
+        /**
+         * @brief Collect the completions of offloaded jobs and run the callback for each.
+         *
+         * The completions come from the memory of the other core: one naming a function
+         * past Functions is dropped without callback, see OffloadStats::droppedCount().
+         * @return std::size_t Completions collected, dropped ones included.
+         */
+        std::size_t poll()
+        {
+            std::size_t count{ 0 };
+            OffloadCompletion done;
+            while (queue.completions.pop(&done, sizeof(done)) == sizeof(done)) {
+                ++count;
+                if (done.function >= Functions) {
+                    stats.recordDropped(done.estimate);
+                    continue;
+                }
+                const std::uint32_t latency{ CycleCounter::now() - done.submitStamp };
+                stats.recordCompletion(done.function, done.serviceCycles, latency, done.estimate, done.status == 0);
+                completion(context, OffloadResult{ done.id, done.function, true, done.status == 0, done.result, latency });
+            }
+            return count;
+        }
+
+        /// Poll until no job is in flight.
+        void drain()
+        {
+            while (stats.depth() != 0) {
+                if (poll() == 0) { queue.completions.waitForData(); }
+            }
+        }
+
+        const OffloadStats<Functions>& statistics() const { return stats; }
+        OffloadStats<Functions>& statistics() { return stats; }
+    };
+
+    /**
+     * @brief CM4 side: runs the queued jobs and posts their completions.
+     */
+    template<typename Queue, std::size_t Functions>
+    class OffloadWorker
+    {
+    public:
+        using Function = std::uint32_t (*)(const std::byte* args, std::size_t size);
+
+    private:
+        Queue& queue;
+        std::array<Function, Functions> handlers{};
+        std::uint32_t executed{ 0 };
+        std::uint32_t busyCycles{ 0 };
+
+    public:
+        explicit OffloadWorker(Queue& queue) : queue(queue) {}
+
+        void bind(const std::uint16_t function, const Function handler)
+        {
+            if (function < Functions) { handlers[function] = handler; }
+        }
+
+        /**
+         * @brief Run the jobs queued so far, arguments read in place from the ring.
+         * @return std::size_t Jobs run.
+         */
+        std::size_t poll()
+        {
+            std::size_t count{ 0 };
+            for (auto message{ queue.jobs.front() }; message.isValid(); message = queue.jobs.front()) {
+                OffloadJob job;
+                std::memcpy(&job, message.data, sizeof(job));
+                OffloadCompletion done{ job.id, job.submitStamp, job.estimate, 0, 0, job.function, 0, 0 };
+                const Function handler{ job.function < Functions ? handlers[job.function] : nullptr };
+                if (handler != nullptr) {
+                    const std::uint32_t start{ CycleCounter::now() };
+                    done.result = handler(reinterpret_cast<const std::byte*>(message.data + sizeof(job)), job.argsSize);
+                    done.serviceCycles = CycleCounter::now() - start;
+                } else {
+                    done.status = static_cast<std::uint8_t>(OffloadError::unknownFunction) + 1;
+                }
+                queue.jobs.pop();
+                // The client bounds the jobs in flight, this only waits on a client late in polling
+                while (!queue.completions.push(&done, sizeof(done))) { NoWakeup::wait(); }
+                busyCycles += done.serviceCycles;
+                ++executed;
+                ++count;
+            }
+            return count;
+        }
+
+        /**
+         * @brief Run jobs forever, sleeping with the job Wakeup when there is none.
+         */
+        [[noreturn]] void serve()
+        {
+            while (true) {
+                queue.jobs.waitForData();
+                static_cast<void>(poll());
+            }
+        }
+
+        std::uint32_t executedCount() const { return executed; }
+
+        /// Worker cycles spent in handlers since construction.
+        std::uint32_t busy() const { return busyCycles; }
+    };
+};
+
+#endif // __OFFLOAD_H__
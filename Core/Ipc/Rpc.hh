@@ -0,0 +1,490 @@
+#ifndef __RPC_H__
+#define __RPC_H__
+
+/**
+ * @file Rpc.hh
+ * @brief Typed remote procedure calls between the cores, payloads passed by handle.
+ *
+ * A service is described by two schemas, TypeLists of pair<Method, Type> like the
+ * ones of classMembersWithTags: the request type and the response type of every
+ * method of one enum. The shared RpcChannel holds one buffer slot per call in flight,
+ * large enough for the largest request and the largest response, and two SpscRings
+ * carrying small envelopes (method, slot, correlation ID) instead of payloads.
+ *
+ *  - The client (RpcClient, one core) takes a slot with prepare<Method>(), builds the
+ *    request in place and send()s it. Only the slot number crosses the ring.
+ *  - The server (RpcServer, other core) runs the bound handler on the request and the
+ *    response areas of the slot, both in place, and sends the envelope back.
+ *  - The client matches the response with the call through the slot and the
+ *    correlation ID. Completion is either polled through the Call (isDone(),
+ *    response(), wait()) or delivered to a callback from poll().
+ *
+ * Slots are allocated and freed by the client only, so the slot bookkeeping needs no
+ * cross-core synchronization: the rings order every access to the slot contents.
+ * Place the channel in SRAM4 (SRAM4_SHARED), non-cacheable on both cores, and reset()
+ * it as MemorySections.hh describes. Payload types must be trivially copyable: the two
+ * images do not share code, only bytes.
+ *
+ * Usage example:
+ * ```
+ * enum class Fusion : std::uint8_t { update, reset };
+ * using Requests = Utils::TypeList<pair<Fusion::update, ImuSample>, pair<Fusion::reset, Empty>>;
+ * using Responses = Utils::TypeList<pair<Fusion::update, Attitude>, pair<Fusion::reset, Empty>>;
+ * using Channel = Ipc::RpcChannel<Ipc::RpcSchema<Requests, Responses>, 8>;
+ * SRAM4_SHARED Channel fusionChannel;
+ *
+ * // CM4
+ * Ipc::RpcServer<Channel> server{ fusionChannel };
+ * server.bind<Fusion::update, &updateAttitude>();      // void updateAttitude(const ImuSample&, Attitude&)
+ * server.serve();
+ *
+ * // CM7
+ * Ipc::RpcClient<Channel> client{ fusionChannel };
+ * auto call{ client.prepare<Fusion::update>() };
+ * readImu(client.request(call.value()));
+ * client.send(call.value());
+ * const Attitude* attitude{ client.wait(call.value()).value() };
+ * client.release(call.value());
+ * ```
+ */
+
+//<------------------------------INCLUDES------------------------------>//
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <Utils.hh>
+#include <ClassMembersWithTagHandler.hh>
+#include <Result.hh>
+#include <SpscRing.hh>
+#include <Wakeup.hh>
+//<-------------------------------------------------------------------->//
+
+namespace Ipc
+{
+    /**
+     * @brief Reason a call could not be made or completed.
+     */
+    enum class RpcError : std::uint8_t {
+        noSlot,             ///< Every slot is in use by a call in flight.
+        queueFull,          ///< The request ring is full, cannot happen with a correctly sized channel.
+        notReady,           ///< No response yet.
+        unknownMethod,      ///< The server has no handler bound to the method.
+        timeout,            ///< wait() gave up.
+        notWaitable         ///< wait() on a call sent with a completion callback, or released.
+    };
+
+    template<typename Requests, typename Responses>
+    struct RpcSchema;
+
+    /**
+     * @brief Request and response types of every method of a service.
+     * @tparam Requests TypeList of pair<Method, RequestType>.
+     * @tparam Responses TypeList of pair<Method, ResponseType>, same methods.
+     */
+    template<typename... RequestPairs, typename... ResponsePairs>
+    requires (Utils::IsTypeListOfPairs<Utils::TypeList<RequestPairs...>> && Utils::IsTypeListOfPairs<Utils::TypeList<ResponsePairs...>>)
+    struct RpcSchema<Utils::TypeList<RequestPairs...>, Utils::TypeList<ResponsePairs...>>
+    {
+        static_assert(sizeof...(RequestPairs) == sizeof...(ResponsePairs), "Every method needs a request and a response type");
+        static_assert(sizeof...(RequestPairs) <= 256, "Methods are encoded on 8 bits");
+        static_assert((std::is_trivially_copyable_v<typename RequestPairs::type> && ...), "Request types must be trivially copyable");
+        static_assert((std::is_trivially_copyable_v<typename ResponsePairs::type> && ...), "Response types must be trivially copyable");
+
+        static constexpr std::size_t methodCount{ sizeof...(RequestPairs) };
+
+        /// Position of a method in the schema, its number on the wire.
+        template<auto Method>
+        requires (Utils::EnumInPairs<Method, RequestPairs...> && Utils::EnumInPairs<Method, ResponsePairs...>)
+        static constexpr std::size_t index{ Utils::indexOfEnumValue<Method, RequestPairs...>::value };
+
+        template<auto Method>
+        using Request = std::tuple_element_t<index<Method>, std::tuple<typename RequestPairs::type...>>;
+
+        template<auto Method>
+        using Response = std::tuple_element_t<Utils::indexOfEnumValue<Method, ResponsePairs...>::value, std::tuple<typename ResponsePairs::type...>>;
+
+        static constexpr std::size_t requestSize{ std::max({ sizeof(typename RequestPairs::type)... }) };
+        static constexpr std::size_t responseSize{ std::max({ sizeof(typename ResponsePairs::type)... }) };
+        static constexpr std::size_t alignment{ std::max({ alignof(typename RequestPairs::type)..., alignof(typename ResponsePairs::type)..., alignof(std::max_align_t) }) };
+    };
+
+    /**
+     * @brief Ring size holding one envelope per slot, plus as much again for the wrap gap.
+     */
+    constexpr std::size_t rpcRingCapacity(const std::size_t slots, const std::size_t envelopeSize)
+    {
+        const std::size_t needed{ 2 * slots * (sizeof(std::uint32_t) + envelopeSize) };
+        std::size_t capacity{ 64 };
+        while (capacity < needed) { capacity *= 2; }
+        return capacity;
+    }
+
+    /**
+     * @brief Shared state of one service: the rings and the payload slots.
+     * @tparam Schema RpcSchema of the service.
+     * @tparam Slots Calls in flight at most, up to 32.
+     * @tparam RequestWakeup Wakeup of the server when a request arrives.
+     * @tparam ResponseWakeup Wakeup of the client when a response arrives.
+     */
+    template<typename Schema, std::size_t Slots, typename RequestWakeup = NoWakeup, typename ResponseWakeup = RequestWakeup>
+    class RpcChannel
+    {
+        static_assert(Slots >= 1 && Slots <= 32, "RpcChannel supports 1 to 32 slots");
+
+    public:
+        using SchemaType = Schema;
+        static constexpr std::size_t slotCount{ Slots };
+
+        /// What crosses the rings, in both directions.
+        struct Envelope {
+            std::uint32_t correlation;
+            std::uint16_t slot;
+            std::uint8_t method;
+            std::uint8_t status;            ///< Responses only: 0 or 1 + RpcError.
+        };
+
+        /// Payload area of one call: the request, then the response.
+        struct alignas(Schema::alignment > Cache::lineSize ? Schema::alignment : Cache::lineSize) Slot {
+            alignas(Schema::alignment) std::byte request[Schema::requestSize];
+            alignas(Schema::alignment) std::byte response[Schema::responseSize];
+        };
+
+        SpscRing<rpcRingCapacity(Slots, sizeof(Envelope)), RequestWakeup> requests;
+        SpscRing<rpcRingCapacity(Slots, sizeof(Envelope)), ResponseWakeup> responses;
+        std::array<Slot, Slots> slots;
+
+        /**
+         * @brief Empty both rings. Call from one core while the other does not use the channel yet.
+         */
+        void reset()
+        {
+            requests.reset();
+            responses.reset();
+        }
+
+        /// Sleep once with the response Wakeup unless a response is already there, may return spuriously.
+        void waitForResponse()
+        {
+            ResponseWakeup::wait([this] { return !responses.empty(); });
+        }
+    };
+
+    /**
+     * @brief Calling side of a channel.
+     */
+    template<typename Channel>
+    class RpcClient
+    {
+    public:
+        using Schema = typename Channel::SchemaType;
+        template<auto Method> using Request = typename Schema::template Request<Method>;
+        template<auto Method> using Response = typename Schema::template Response<Method>;
+
+        /// Result delivered to a completion callback: the response, valid during the call only, or the error.
+        template<auto Method> using Outcome = Utils::Result<const Response<Method>*, RpcError>;
+
+        /// Completion callback, the slot is released when it returns.
+        template<auto Method> using Completion = void (*)(void* context, Outcome<Method> outcome);
+
+        /**
+         * @brief One call in flight, a plain handle to its slot.
+         */
+        template<auto Method>
+        struct Call {
+            std::uint16_t slot;
+            std::uint32_t correlation;
+        };
+
+    private:
+        using Envelope = typename Channel::Envelope;
+        using ErasedCompletion = void (*)();
+        using Dispatch = void (*)(ErasedCompletion callback, void* context, const void* response, std::uint8_t status);
+
+        struct Pending {
+            std::uint32_t correlation{ 0 };
+            ErasedCompletion callback{ nullptr };
+            Dispatch dispatch{ nullptr };
+            void* context{ nullptr };
+            std::uint8_t status{ 0 };
+            bool sent{ false };
+            bool done{ false };
+            bool abandoned{ false };        ///< Released in flight, the slot is freed when the response arrives.
+        };
+
+        Channel& channel;
+        std::uint32_t freeSlots{ Channel::slotCount == 32 ? 0xFFFFFFFFU : (1U << Channel::slotCount) - 1 };
+        std::uint32_t nextCorrelation{ 1 };
+        std::uint32_t staleResponses{ 0 };
+        std::array<Pending, Channel::slotCount> pending{};
+
+        static RpcError decode(const std::uint8_t status) { return static_cast<RpcError>(status - 1); }
+
+        template<auto Method>
+        static void dispatch(ErasedCompletion callback, void* context, const void* response, const std::uint8_t status)
+        {
+            const Completion<Method> typed{ reinterpret_cast<Completion<Method>>(callback) };
+            if (status == 0) {
+                typed(context, Outcome<Method>{ static_cast<const Response<Method>*>(response) });
+            } else {
+                typed(context, Utils::fail(decode(status)));
+            }
+        }
+
+        void free(const std::uint16_t slot)
+        {
+            pending[slot] = Pending{};
+            freeSlots |= 1U << slot;
+        }
+
+    public:
+        explicit RpcClient(Channel& channel) : channel(channel) {}
+
+        /**
+         * @brief Take a slot for a call and start the lifetime of its request in place.
+         *
+         * The request is default-initialized, not zeroed: every field must be written before send().
+         * @return Call handle, RpcError::noSlot if every slot is in flight.
+         */
+        template<auto Method>
+        Utils::Result<Call<Method>, RpcError> prepare()
+        {
+            if (freeSlots == 0) { return Utils::fail(RpcError::noSlot); }
+            const std::uint16_t slot{ static_cast<std::uint16_t>(__builtin_ctz(freeSlots)) };
+            freeSlots &= ~(1U << slot);
+            pending[slot].correlation = nextCorrelation++;
+            new (channel.slots[slot].request) Request<Method>;
+            return Call<Method>{ slot, pending[slot].correlation };
+        }
+
+        /// Request of a prepared call, to be filled in place before send().
+        template<auto Method>
+        Request<Method>& request(const Call<Method>& call)
+        {
+            return *std::launder(reinterpret_cast<Request<Method>*>(channel.slots[call.slot].request));
+        }
+
+        /**
+         * @brief Hand a prepared call over to the server.
+         * @param callback Optional completion run from poll(), the slot is then released automatically.
+         */
+        template<auto Method>
+        Utils::Result<void, RpcError> send(const Call<Method>& call, const Completion<Method> callback = nullptr, void* context = nullptr)
+        {
+            Pending& entry{ pending[call.slot] };
+            entry.callback = reinterpret_cast<ErasedCompletion>(callback);
+            entry.dispatch = callback != nullptr ? &dispatch<Method> : nullptr;
+            entry.context = context;
+            const Envelope envelope{ call.correlation, call.slot, static_cast<std::uint8_t>(Schema::template index<Method>), 0 };
+            if (!channel.requests.push(&envelope, sizeof(envelope))) { return Utils::fail(RpcError::queueFull); }
+            entry.sent = true;
+            return {};
+        }
+
+        /**
+         * @brief prepare() and send() a copy of a request, for payloads not worth building in place.
+         */
+        template<auto Method>
+        Utils::Result<Call<Method>, RpcError> call(const Request<Method>& value, const Completion<Method> callback = nullptr, void* context = nullptr)
+        {
+            const auto prepared{ prepare<Method>() };
+            if (!prepared) { return prepared; }
+            request(prepared.value()) = value;
+            if (const auto sent{ send(prepared.value(), callback, context) }; !sent) {
+                free(prepared.value().slot);
+                return Utils::fail(sent.error());
+            }
+            return prepared;
+        }
+
+        /**
+         * @brief Collect the responses received so far and run the completion callbacks.
+         * @return std::size_t Number of responses collected.
+         */
+        std::size_t poll()
+        {
+            std::size_t collected{ 0 };
+            Envelope envelope;
+            while (channel.responses.pop(&envelope, sizeof(envelope)) == sizeof(envelope)) {
+                if (envelope.slot >= Channel::slotCount || pending[envelope.slot].correlation != envelope.correlation || pending[envelope.slot].done) {
+                    ++staleResponses;
+                    continue;
+                }
+                Pending& entry{ pending[envelope.slot] };
+                if (entry.abandoned) {
+                    ++staleResponses;
+                    free(envelope.slot);
+                    continue;
+                }
+                ++collected;
+                entry.status = envelope.status;
+                entry.done = true;
+                if (entry.dispatch != nullptr) {
+                    entry.dispatch(entry.callback, entry.context, channel.slots[envelope.slot].response, envelope.status);
+                    free(envelope.slot);
+                }
+            }
+            return collected;
+        }
+
+        template<auto Method>
+        bool isDone(const Call<Method>& call) const
+        {
+            return pending[call.slot].correlation == call.correlation && pending[call.slot].done;
+        }
+
+        /**
+         * @brief Response of a completed call, valid until release().
+         * @return RpcError::notReady before completion, or the error reported by the server.
+         */
+        template<auto Method>
+        Utils::Result<const Response<Method>*, RpcError> response(const Call<Method>& call)
+        {
+            if (!isDone(call)) { return Utils::fail(RpcError::notReady); }
+            if (pending[call.slot].status != 0) { return Utils::fail(decode(pending[call.slot].status)); }
+            return std::launder(reinterpret_cast<const Response<Method>*>(channel.slots[call.slot].response));
+        }
+
+        /**
+         * @brief Poll, sleeping with the response Wakeup, until the call completes.
+         *
+         * A call sent with a completion callback completes through it: poll() releases its
+         * slot right after, so wait() refuses it rather than never seeing it done.
+         * @param maxWaits Wakeups before giving up with RpcError::timeout.
+         * @return RpcError::notWaitable for a call with a callback or no longer in flight.
+         */
+        template<auto Method>
+        Utils::Result<const Response<Method>*, RpcError> wait(const Call<Method>& call, const std::uint32_t maxWaits = 0xFFFFFFFFU)
+        {
+            const Pending& entry{ pending[call.slot] };
+            if (entry.correlation != call.correlation || entry.dispatch != nullptr || entry.abandoned) { return Utils::fail(RpcError::notWaitable); }
+            for (std::uint32_t waits = 0; !isDone(call); ++waits) {
+                if (poll() == 0 && !isDone(call)) {
+                    if (waits == maxWaits) { return Utils::fail(RpcError::timeout); }
+                    channel.waitForResponse();
+                }
+            }
+            return response(call);
+        }
+
+        /**
+         * @brief Give the slot of a call back, its response must not be used afterwards.
+         *
+         * A completed or unsent call frees the slot at once. A call still in flight, e.g.
+         * after wait() timed out, is abandoned: the server may still be reading the slot, so
+         * poll() frees it when the response arrives and drops that response. A call with a
+         * completion callback is left alone, it completes through the callback.
+         */
+        template<auto Method>
+        void release(const Call<Method>& call)
+        {
+            Pending& entry{ pending[call.slot] };
+            if (entry.correlation != call.correlation || entry.dispatch != nullptr) { return; }
+            if (entry.sent && !entry.done) {
+                entry.abandoned = true;
+                return;
+            }
+            free(call.slot);
+        }
+
+        /// Calls that can still be prepared.
+        std::size_t freeSlotCount() const { return static_cast<std::size_t>(__builtin_popcount(freeSlots)); }
+
+        /// Responses dropped because they matched no call in flight, or a released one.
+        std::uint32_t staleCount() const { return staleResponses; }
+    };
+
+    /**
+     * @brief Serving side of a channel.
+     */
+    template<typename Channel>
+    class RpcServer
+    {
+    public:
+        using Schema = typename Channel::SchemaType;
+        template<auto Method> using Request = typename Schema::template Request<Method>;
+        template<auto Method> using Response = typename Schema::template Response<Method>;
+
+    private:
+        using Envelope = typename Channel::Envelope;
+        using Handler = void (*)(const void* request, void* response);
+
+        Channel& channel;
+        std::array<Handler, Schema::methodCount> handlers{};
+        std::uint32_t served{ 0 };
+        std::uint32_t rejected{ 0 };
+
+        template<auto Method, auto Function>
+        static void thunk(const void* request, void* response)
+        {
+            Function(*std::launder(reinterpret_cast<const Request<Method>*>(request)), *new (response) Response<Method>);
+        }
+
+    public:
+        explicit RpcServer(Channel& channel) : channel(channel) {}
+
+        /**
+         * @brief Bind the handler of a method.
+         * @tparam Function void(const Request<Method>&, Response<Method>&), both in the shared slot.
+         * The response is default-initialized, the handler writes every field.
+         */
+        template<auto Method, auto Function>
+        requires std::is_invocable_v<decltype(Function), const Request<Method>&, Response<Method>&>
+        void bind()
+        {
+            handlers[Schema::template index<Method>] = &thunk<Method, Function>;
+        }
+
+        /**
+         * @brief Serve the requests received so far.
+         * @param maxRequests Requests to serve at most.
+         * @return std::size_t Requests served.
+         */
+        std::size_t poll(const std::size_t maxRequests = static_cast<std::size_t>(-1))
+        {
+            std::size_t count{ 0 };
+            Envelope envelope;
+            while (count < maxRequests && channel.requests.pop(&envelope, sizeof(envelope)) == sizeof(envelope)) {
+                // The envelope comes from the other core's memory: a slot out of range is dropped, not answered
+                if (envelope.slot >= Channel::slotCount) {
+                    ++rejected;
+                    continue;
+                }
+                typename Channel::Slot& slot{ channel.slots[envelope.slot] };
+                const Handler handler{ envelope.method < handlers.size() ? handlers[envelope.method] : nullptr };
+                if (handler != nullptr) {
+                    handler(slot.request, slot.response);
+                    envelope.status = 0;
+                } else {
+                    envelope.status = static_cast<std::uint8_t>(RpcError::unknownMethod) + 1;
+                }
+                // The response ring is sized for every slot, a push only fails transiently
+                while (!channel.responses.push(&envelope, sizeof(envelope))) { NoWakeup::wait(); }
+                ++count;
+            }
+            served += static_cast<std::uint32_t>(count);
+            return count;
+        }
+
+        /**
+         * @brief Serve forever, sleeping with the request Wakeup between requests.
+         */
+        [[noreturn]] void serve()
+        {
+            while (true) {
+                channel.requests.waitForData();
+                static_cast<void>(poll());
+            }
+        }
+
+        std::uint32_t servedCount() const { return served; }
+
+        /// Requests dropped because their slot was out of range.
+        std::uint32_t rejectedCount() const { return rejected; }
+    };
+};
+
+#endif // __RPC_H__
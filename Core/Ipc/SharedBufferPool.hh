@@ -0,0 +1,262 @@
+#ifndef __SHAREDBUFFERPOOL_H__
+#define __SHAREDBUFFERPOOL_H__
+
+/**
+ * @file SharedBufferPool.hh
+ * @brief Fixed-block buffer pool shared by the cores, with reference counted blocks.
+ *
+ * Large frames (ADC blocks, network packets) cross the cores as 2-byte handles instead
+ * of being copied: the producer allocates a block, fills it and sends its handle through
+ * an SpscRing or an RPC; the consumer reads the block in place. Ownership rules:
+ *  - allocate() returns a block with one reference, owned by the caller.
+ *  - Sending a handle transfers the sender's reference: the sender must not touch the
+ *    block afterwards, the receiver now owns the reference.
+ *  - To keep using a block while another core reads it, retain() first and send the
+ *    new reference: both sides then release() their own.
+ *  - Whichever core drops the last reference frees the block, nobody else needs to know.
+ *
+ * The reference counts and the free list are updated under a cross-core Lock
+ * (HsemSpinLock), a section of a few cycles per call. Allocation pops the free list,
+ * freeing pushes it: both run in constant time.
+ *
+ * Cache coherence: a pool placed with SRAM4_SHARED is non cacheable and needs nothing.
+ * For a pool in cacheable memory (AXI SRAM, D2 SRAM) set Cacheable: the metadata is then
+ * maintained by the pool and the CM7 calls publish() on a block before sending it and
+ * receive() before reading a block it received. Blocks are whole cache lines, so the
+ * maintenance of one never touches another. The hooks compile to nothing otherwise and
+ * on the CM4, which has no data cache.
+ *
+ * A pool placed with SRAM4_SHARED is reset() by one core first, see MemorySections.hh.
+ *
+ * Usage example:
+ * ```
+ * SRAM4_SHARED Ipc::SharedBufferPool<1536, 16, Ipc::HsemSpinLock<6>> frames;
+ * // CM7
+ * const Ipc::BufferHandle frame{ frames.allocate().value() };
+ * receivePacket(frames.data(frame));
+ * frames.publish(frame, length);
+ * toCm4.push(&frame, sizeof(frame));                  // the reference goes along
+ * // CM4
+ * Ipc::BufferHandle frame;
+ * toCm4.pop(&frame, sizeof(frame));
+ * process(frames.data(frame));
+ * frames.release(frame);                              // last reference: the block is free
+ * ```
+ */
+
+//<------------------------------INCLUDES------------------------------>//
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <Cache.hh>
+#include <CoreLock.hh>
+#include <Result.hh>
+//<-------------------------------------------------------------------->//
+
+namespace Ipc
+{
+    enum class BufferPoolError : std::uint8_t {
+        exhausted,          ///< No free block.
+        invalidHandle       ///< Out of range, or a block without references.
+    };
+
+    /// Block index of a SharedBufferPool, what crosses the cores.
+    struct BufferHandle {
+        std::uint16_t index;
+
+        constexpr bool operator==(const BufferHandle&) const = default;
+    };
+
+    /**
+     * @brief Pool of Blocks blocks of BlockSize bytes, each with a reference count.
+     * @tparam BlockSize Usable bytes per block, rounded up to whole cache lines.
+     * @tparam Blocks Number of blocks, 1 to 65534.
+     * @tparam Lock Scoped cross-core lock guarding the metadata, e.g. HsemSpinLock<Id>.
+     * @tparam Cacheable Set when the pool is in memory the CM7 caches.
+     */
+    template<std::size_t BlockSize, std::size_t Blocks, typename Lock, bool Cacheable = false>
+    requires (BlockSize > 0 && Blocks > 0 && Blocks < 0xFFFF)
+    class SharedBufferPool
+    {
+    public:
+        static constexpr std::size_t blockSize{ Cache::roundUpToLines(BlockSize) };
+
+        /// Statistics since reset(), maintained under the lock.
+        struct Counters {
+            std::uint32_t allocations;
+            std::uint32_t frees;
+            std::uint32_t exhausted;            ///< allocate() calls refused.
+            std::uint32_t invalidReleases;      ///< retain()/release() on a free block.
+            std::uint16_t inUse;
+            std::uint16_t peakInUse;
+        };
+
+    private:
+        using Index = std::uint16_t;
+        static constexpr Index endOfList{ 0xFFFF };
+
+        struct alignas(Cache::lineSize) Metadata {
+            std::uint16_t references[Blocks];
+            Index nextFree[Blocks];
+            Index firstFree;
+            Counters counters;
+        };
+
+        Metadata metadata;
+        alignas(Cache::lineSize) std::uint8_t storage[Blocks][blockSize];
+
+        static void clean([[maybe_unused]] const void* address, [[maybe_unused]] const std::size_t size)
+        {
+            if constexpr (Cacheable) { Cache::clean(address, size); }
+        }
+
+        static void invalidate([[maybe_unused]] const void* address, [[maybe_unused]] const std::size_t size)
+        {
+            if constexpr (Cacheable) { Cache::invalidate(address, size); }
+        }
+
+        // Section updating the metadata: the other core's last writes are seen on entry, ours are published on exit
+        class Section
+        {
+        private:
+            Lock lock;
+            Metadata& metadata;
+
+        public:
+            explicit Section(Metadata& metadata) : metadata(metadata) { invalidate(&metadata, sizeof(metadata)); }
+            ~Section() { clean(&metadata, sizeof(metadata)); }
+
+            Section(const Section&) = delete;
+            Section& operator=(const Section&) = delete;
+        };
+
+        static constexpr bool isValid(const BufferHandle handle) { return handle.index < Blocks; }
+
+        void push(const Index index)
+        {
+            metadata.nextFree[index] = metadata.firstFree;
+            metadata.firstFree = index;
+            ++metadata.counters.frees;
+            --metadata.counters.inUse;
+        }
+
+    public:
+        /**
+         * @brief Free every block. Call from one core while the other does not use the pool yet.
+         */
+        void reset()
+        {
+            {
+                Section section{ metadata };
+                for (std::size_t index = 0; index < Blocks; ++index) {
+                    metadata.references[index] = 0;
+                    metadata.nextFree[index] = index + 1 < Blocks ? static_cast<Index>(index + 1) : endOfList;
+                }
+                metadata.firstFree = 0;
+                metadata.counters = Counters{};
+            }
+            std::atomic_thread_fence(std::memory_order_release);
+        }
+
+        /// Number of blocks.
+        static constexpr std::size_t capacity() { return Blocks; }
+
+        /**
+         * @brief Take a free block, with one reference owned by the caller.
+         * @return BufferHandle BufferPoolError::exhausted if no block is free.
+         */
+        Utils::Result<BufferHandle, BufferPoolError> allocate()
+        {
+            Section section{ metadata };
+            const Index index{ metadata.firstFree };
+            if (index == endOfList) {
+                ++metadata.counters.exhausted;
+                return Utils::fail(BufferPoolError::exhausted);
+            }
+            metadata.firstFree = metadata.nextFree[index];
+            metadata.references[index] = 1;
+            ++metadata.counters.allocations;
+            ++metadata.counters.inUse;
+            if (metadata.counters.inUse > metadata.counters.peakInUse) { metadata.counters.peakInUse = metadata.counters.inUse; }
+            return BufferHandle{ index };
+        }
+
+        /**
+         * @brief Add a reference to a block the caller holds one of, to share it.
+         */
+        Utils::Result<void, BufferPoolError> retain(const BufferHandle handle)
+        {
+            if (!isValid(handle)) { return Utils::fail(BufferPoolError::invalidHandle); }
+            Section section{ metadata };
+            if (metadata.references[handle.index] == 0) {
+                ++metadata.counters.invalidReleases;
+                return Utils::fail(BufferPoolError::invalidHandle);
+            }
+            ++metadata.references[handle.index];
+            return {};
+        }
+
+        /**
+         * @brief Drop the caller's reference, freeing the block if it was the last one.
+         * @return bool true if the block was freed.
+         */
+        Utils::Result<bool, BufferPoolError> release(const BufferHandle handle)
+        {
+            if (!isValid(handle)) { return Utils::fail(BufferPoolError::invalidHandle); }
+            Section section{ metadata };
+            std::uint16_t& references{ metadata.references[handle.index] };
+            if (references == 0) {
+                ++metadata.counters.invalidReleases;
+                return Utils::fail(BufferPoolError::invalidHandle);
+            }
+            if (--references != 0) { return false; }
+            push(handle.index);
+            return true;
+        }
+
+        /// Start of a block, blockSize bytes.
+        std::uint8_t* data(const BufferHandle handle) { return storage[handle.index]; }
+        const std::uint8_t* data(const BufferHandle handle) const { return storage[handle.index]; }
+
+        /**
+         * @brief Handle of a pointer into a block, for APIs passing pointers around.
+         * @return BufferHandle BufferPoolError::invalidHandle if the pointer is outside the pool.
+         */
+        Utils::Result<BufferHandle, BufferPoolError> handleOf(const void* pointer) const
+        {
+            const auto* byte{ static_cast<const std::uint8_t*>(pointer) };
+            if (byte < storage[0] || byte >= storage[0] + sizeof(storage)) { return Utils::fail(BufferPoolError::invalidHandle); }
+            return BufferHandle{ static_cast<Index>(static_cast<std::size_t>(byte - storage[0]) / blockSize) };
+        }
+
+        /**
+         * @brief Write back the first size bytes of a block before another core or a DMA reads it.
+         */
+        void publish(const BufferHandle handle, const std::size_t size = blockSize) const { clean(storage[handle.index], size); }
+
+        /**
+         * @brief Drop the cached copy of the first size bytes of a block written by another core or a DMA.
+         */
+        void receive(const BufferHandle handle, const std::size_t size = blockSize) const
+        {
+            // Only whole lines of the block are dropped, never a neighbour's
+            invalidate(storage[handle.index], Cache::roundUpToLines(size));
+        }
+
+        /// Current references of a block, a snapshot.
+        std::uint16_t useCount(const BufferHandle handle)
+        {
+            Section section{ metadata };
+            return metadata.references[handle.index];
+        }
+
+        /// Copy of the statistics.
+        Counters counters()
+        {
+            Section section{ metadata };
+            return metadata.counters;
+        }
+    };
+};
+
+#endif // __SHAREDBUFFERPOOL_H__
@@ -0,0 +1,297 @@
+#ifndef __SPSCRING_H__
+#define __SPSCRING_H__
+
+/**
+ * @file SpscRing.hh
+ * @brief Lock-free single-producer/single-consumer message ring shared between the cores.
+ *
+ * One core writes, the other reads. Messages of any size up to maxMessageSize() are
+ * stored back to back as a 4-byte length followed by the payload padded to 4 bytes.
+ * A record never wraps: when it does not fit before the end of the storage the
+ * producer writes a wrap marker and starts again at offset 0.
+ *
+ * The write index (head) and the read index (tail) are free-running byte counters, each
+ * alone on its own cache line with the fields only its owner touches, so the cores never
+ * write the same line. Publication follows the usual acquire/release pairing: the
+ * producer writes the record, then stores head with release semantics (a DMB before the
+ * store), the consumer loads head with acquire semantics (a DMB after the load) before
+ * reading the record. The same holds for tail in the other direction.
+ *
+ * Cache coherence: the CM4 has no data cache and the CM7 boot MPU plan maps SRAM4 non
+ * cacheable, so a ring placed with SRAM4_SHARED needs nothing more. For a ring in
+ * cacheable memory (AXI SRAM, D2 SRAM) set Cacheable: the CM7 side then cleans what it
+ * writes and invalidates what it reads, whole lines at a time, around every access to
+ * the indices and the records.
+ *
+ * A ring placed with SRAM4_SHARED is reset() by one core first, see MemorySections.hh.
+ * The Wakeup policy (Wakeup.hh) lets the consumer sleep until the producer signals.
+ *
+ * Usage example:
+ * ```
+ * SRAM4_SHARED Ipc::SpscRing<8192, Ipc::SevWakeup> toCm4;
+ * // CM7
+ * toCm4.push(&sample, sizeof(sample));
+ * // CM4
+ * toCm4.waitForData();
+ * Ipc::SpscRing<8192>::Message message{ toCm4.front() };
+ * process(message.data, message.size);
+ * toCm4.pop();
+ * ```
+ */
+
+//<------------------------------INCLUDES------------------------------>//
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <Cache.hh>
+#include <Wakeup.hh>
+//<-------------------------------------------------------------------->//
+
+namespace Ipc
+{
+    /**
+     * @brief Byte ring of variable length messages between one producer and one consumer.
+     * @tparam Capacity Storage size in bytes, a power of two and a multiple of the cache line size.
+     * @tparam Wakeup Policy signaling the consumer, NoWakeup polls.
+     * @tparam Cacheable Set when the ring is in memory the CM7 caches.
+     */
+    template<std::size_t Capacity, typename Wakeup = NoWakeup, bool Cacheable = false>
+    class SpscRing
+    {
+        static_assert(Capacity >= 64 && (Capacity & (Capacity - 1)) == 0, "SpscRing capacity must be a power of two of at least 64 bytes");
+        static_assert(Capacity % Cache::lineSize == 0, "SpscRing capacity must be a whole number of cache lines");
+        static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "SpscRing needs lock-free 32-bit atomics");
+
+    public:
+        /// A message as stored in the ring, valid until pop().
+        struct Message {
+            const std::uint8_t* data{ nullptr };
+            std::size_t size{ 0 };
+
+            constexpr bool isValid() const { return data != nullptr; }
+        };
+
+        static constexpr std::size_t headerSize{ sizeof(std::uint32_t) };
+
+        /// Largest message that fits, whatever the position of the indices.
+        static constexpr std::size_t maxMessageSize() { return Capacity / 2 - headerSize; }
+
+        static constexpr std::size_t capacity() { return Capacity; }
+
+    private:
+        static constexpr std::uint32_t wrapMarker{ 0xFFFFFFFFU };
+        static constexpr std::uint32_t mask{ Capacity - 1 };
+
+        static constexpr std::uint32_t recordSize(const std::size_t size)
+        {
+            return static_cast<std::uint32_t>(headerSize + ((size + 3) & ~std::size_t{ 3 }));
+        }
+
+        // Producer line: head plus the producer's private bookkeeping
+        struct alignas(Cache::lineSize) ProducerSide {
+            std::atomic<std::uint32_t> head;
+            std::uint32_t reservedOffset;       ///< Storage offset of the prepared record.
+            std::uint32_t pushed;               ///< Messages committed since reset().
+            std::uint32_t full;                 ///< prepare() calls refused for lack of space.
+        };
+
+        // Consumer line: tail plus the consumer's private bookkeeping
+        struct alignas(Cache::lineSize) ConsumerSide {
+            std::atomic<std::uint32_t> tail;
+            std::uint32_t popped;               ///< Messages released since reset().
+        };
+
+        ProducerSide producer;
+        ConsumerSide consumer;
+        alignas(Cache::lineSize) std::uint8_t storage[Capacity];
+
+        static void clean([[maybe_unused]] const void* address, [[maybe_unused]] const std::size_t size)
+        {
+            if constexpr (Cacheable) { Cache::clean(address, size); }
+        }
+
+        static void invalidate([[maybe_unused]] const void* address, [[maybe_unused]] const std::size_t size)
+        {
+            if constexpr (Cacheable) { Cache::invalidate(address, size); }
+        }
+
+        std::uint32_t loadHead() const
+        {
+            invalidate(&producer, sizeof(producer.head));
+            return producer.head.load(std::memory_order_acquire);
+        }
+
+        std::uint32_t loadTail() const
+        {
+            invalidate(&consumer, sizeof(consumer.tail));
+            return consumer.tail.load(std::memory_order_acquire);
+        }
+
+        void release(const std::size_t size)
+        {
+            const std::uint32_t tail{ consumer.tail.load(std::memory_order_relaxed) };
+            ++consumer.popped;
+            consumer.tail.store(tail + recordSize(size), std::memory_order_release);
+            clean(&consumer, sizeof(consumer));
+        }
+
+        void writeHeader(const std::uint32_t offset, const std::uint32_t value)
+        {
+            std::memcpy(&storage[offset], &value, headerSize);
+        }
+
+    public:
+        /**
+         * @brief Empty the ring. Call from one core while the other does not use it yet.
+         */
+        void reset()
+        {
+            producer.head.store(0, std::memory_order_relaxed);
+            producer.reservedOffset = 0;
+            producer.pushed = 0;
+            producer.full = 0;
+            consumer.tail.store(0, std::memory_order_relaxed);
+            consumer.popped = 0;
+            std::atomic_thread_fence(std::memory_order_release);
+            clean(this, sizeof(*this) - Capacity);
+        }
+
+        //<------------------------------PRODUCER------------------------------>//
+
+        /**
+         * @brief Reserve room for a message and return where to write its payload.
+         *
+         * Nothing is visible to the consumer until commit(). Only one reservation can be
+         * pending, a second prepare() replaces the first.
+         * @param size Payload size in bytes, at most maxMessageSize().
+         * @return std::uint8_t* Payload area of size bytes, nullptr if the ring is full.
+         */
+        std::uint8_t* prepare(const std::size_t size)
+        {
+            if (size > maxMessageSize()) { return nullptr; }
+            const std::uint32_t head{ producer.head.load(std::memory_order_relaxed) };
+            const std::uint32_t used{ head - loadTail() };
+            const std::uint32_t offset{ head & mask };
+            const std::uint32_t contiguous{ static_cast<std::uint32_t>(Capacity) - offset };
+            const std::uint32_t needed{ recordSize(size) };
+            // A record that does not fit before the end also consumes the bytes up to it
+            const std::uint32_t advance{ needed <= contiguous ? needed : contiguous + needed };
+            if (advance > Capacity - used) {
+                ++producer.full;
+                return nullptr;
+            }
+            producer.reservedOffset = needed <= contiguous ? offset : 0;
+            if (needed > contiguous) { writeHeader(offset, wrapMarker); }
+            return &storage[producer.reservedOffset + headerSize];
+        }
+
+        /**
+         * @brief Publish the message prepared last.
+         * @param size Payload size actually written, at most the size given to prepare().
+         */
+        void commit(const std::size_t size)
+        {
+            const std::uint32_t head{ producer.head.load(std::memory_order_relaxed) };
+            const bool wrapped{ producer.reservedOffset != (head & mask) };
+            // The record may be shorter than reserved, the wrap gap stays the same
+            const std::uint32_t advance{ (wrapped ? static_cast<std::uint32_t>(Capacity) - (head & mask) : 0) + recordSize(size) };
+            writeHeader(producer.reservedOffset, static_cast<std::uint32_t>(size));
+            clean(&storage[producer.reservedOffset], headerSize + size);
+            if (wrapped) { clean(&storage[head & mask], headerSize); }
+            ++producer.pushed;
+            producer.head.store(head + advance, std::memory_order_release);
+            clean(&producer, sizeof(producer));
+            Wakeup::signal();
+        }
+
+        /**
+         * @brief Copy a message into the ring.
+         * @return bool false if the ring is full or the message too large.
+         */
+        bool push(const void* data, const std::size_t size)
+        {
+            std::uint8_t* payload{ prepare(size) };
+            if (payload == nullptr) { return false; }
+            std::memcpy(payload, data, size);
+            commit(size);
+            return true;
+        }
+
+        //<------------------------------CONSUMER------------------------------>//
+
+        /**
+         * @brief Oldest message, left in place until pop().
+         * @return Message Invalid (data == nullptr) if the ring is empty.
+         */
+        Message front()
+        {
+            std::uint32_t tail{ consumer.tail.load(std::memory_order_relaxed) };
+            const std::uint32_t head{ loadHead() };
+            if (tail == head) { return Message{}; }
+
+            std::uint32_t offset{ tail & mask };
+            std::uint32_t size{ 0 };
+            invalidate(&storage[offset], headerSize);
+            std::memcpy(&size, &storage[offset], headerSize);
+            if (size == wrapMarker) {
+                // Skip the unused end of the storage, the record is at offset 0
+                tail += static_cast<std::uint32_t>(Capacity) - offset;
+                consumer.tail.store(tail, std::memory_order_release);
+                clean(&consumer, sizeof(consumer));
+                offset = 0;
+                invalidate(&storage[0], headerSize);
+                std::memcpy(&size, &storage[0], headerSize);
+            }
+            invalidate(&storage[offset + headerSize], size);
+            return Message{ &storage[offset + headerSize], size };
+        }
+
+        /**
+         * @brief Release the message returned by front(), making its room available again.
+         */
+        void pop()
+        {
+            // front() steps over a wrap marker, so tail then points at the message itself
+            const Message message{ front() };
+            if (message.isValid()) { release(message.size); }
+        }
+
+        /**
+         * @brief Copy the oldest message out and release it.
+         * @param buffer Destination of at least capacity bytes.
+         * @param capacity Size of buffer, a larger message is dropped.
+         * @return std::size_t Size of the message, 0 if the ring was empty or the message dropped.
+         */
+        std::size_t pop(void* buffer, const std::size_t capacity)
+        {
+            const Message message{ front() };
+            if (!message.isValid()) { return 0; }
+            const std::size_t size{ message.size <= capacity ? message.size : 0 };
+            std::memcpy(buffer, message.data, size);
+            release(message.size);
+            return size;
+        }
+
+        /**
+         * @brief Sleep with the Wakeup policy until a message is available.
+         */
+        void waitForData()
+        {
+            while (empty()) { Wakeup::wait([this] { return !empty(); }); }
+        }
+
+        //<------------------------------STATUS------------------------------>//
+
+        bool empty() const { return loadHead() == consumer.tail.load(std::memory_order_relaxed); }
+
+        /// Bytes in use, records, padding and wrap gap included. Exact from either side when idle.
+        std::size_t usedBytes() const { return loadHead() - loadTail(); }
+
+        std::uint32_t pushedCount() const { return producer.pushed; }
+        std::uint32_t poppedCount() const { return consumer.popped; }
+        std::uint32_t fullCount() const { return producer.full; }
+    };
+};
+
+#endif // __SPSCRING_H__
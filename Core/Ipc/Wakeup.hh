@@ -0,0 +1,174 @@
+#ifndef __WAKEUP_H__
+#define __WAKEUP_H__
+
+/**
+ * @file Wakeup.hh
+ * @brief Policies letting one core wake the other after publishing data.
+ *
+ * A policy provides static signal(), called by the producer after it published
+ * something, and static wait(ready), called by the consumer in a loop until there is
+ * something to read: it sleeps once unless ready() already holds. ready() is checked
+ * with the wakeup armed, so a signal arriving between the check and the sleep ends the
+ * sleep instead of being lost. wait() may return spuriously, the caller always re-checks.
+ *
+ *  - NoWakeup: wait() returns at once, the consumer polls.
+ *  - SevWakeup: SEV on one core raises the event input of the other (CM7_SEV/CM4_SEV),
+ *    the consumer sleeps in WFE. The event register latches a SEV sent after the check.
+ *    Costs nothing to set up, wakes up on any event.
+ *  - HsemWakeup<Id>: the producer takes and releases hardware semaphore Id, which raises
+ *    the HSEM interrupt of the consumer core, the consumer sleeps in WFI. The check runs
+ *    with PRIMASK set, see sleepUnless(). Use one semaphore per direction and call
+ *    HsemWakeup<Id>::enable() on the consumer core.
+ *
+ * On the host signal() does nothing and every wait() yields the thread, so a polling
+ * consumer does not starve the producer when both share a CPU.
+ */
+
+//<------------------------------INCLUDES------------------------------>//
+#include <cstdint>
+#include <Hsem.hh>
+#if defined(CORE_CM7) || defined(CORE_CM4)
+#include <stm32h755xx.h>
+#else
+#include <thread>
+#endif
+//<-------------------------------------------------------------------->//
+
+namespace Ipc
+{
+    /**
+     * @brief Interrupt masking and WFI of the running core, yielding the thread on the host.
+     */
+    struct CoreInterrupts {
+        /// Set PRIMASK, return its previous value.
+        static std::uint32_t mask()
+        {
+            #if defined(CORE_CM7) || defined(CORE_CM4)
+                const std::uint32_t primask{ __get_PRIMASK() };
+                __disable_irq();
+                return primask;
+            #else
+                return 0;
+            #endif
+        }
+
+        static void restore([[maybe_unused]] const std::uint32_t primask)
+        {
+            #if defined(CORE_CM7) || defined(CORE_CM4)
+                __set_PRIMASK(primask);
+            #endif
+        }
+
+        /// Sleep until an interrupt is pending, masked or not.
+        static void waitForInterrupt()
+        {
+            #if defined(CORE_CM7) || defined(CORE_CM4)
+                __DSB();
+                __WFI();
+            #else
+                std::this_thread::yield();
+            #endif
+        }
+    };
+
+    /**
+     * @brief Sleep in WFI once unless ready() holds, without losing the interrupt that makes it hold.
+     *
+     * ready() runs with interrupts masked. An interrupt raised after it stays pending, which
+     * ends WFI at once even under PRIMASK, and its handler runs when the mask is restored.
+     * Checking unmasked and then sleeping would let the handler run in between and the core
+     * sleep until an unrelated interrupt.
+     * @tparam Interrupts CoreInterrupts, or a model of it in host tests.
+     */
+    template<typename Interrupts = CoreInterrupts, typename Condition>
+    void sleepUnless(Condition&& ready)
+    {
+        const std::uint32_t primask{ Interrupts::mask() };
+        if (!ready()) { Interrupts::waitForInterrupt(); }
+        Interrupts::restore(primask);
+    }
+
+    struct NoWakeup {
+        static void signal() {}
+
+        template<typename Condition>
+        static void wait(Condition&&) { wait(); }
+
+        /// Yield on the host, for retry loops with nothing to wait for.
+        static void wait()
+        {
+            #if !defined(CORE_CM7) && !defined(CORE_CM4)
+                std::this_thread::yield();
+            #endif
+        }
+    };
+
+    struct SevWakeup {
+        static void signal()
+        {
+            #if defined(CORE_CM7) || defined(CORE_CM4)
+                __DSB();
+                __SEV();
+            #endif
+        }
+
+        template<typename Condition>
+        static void wait(Condition&& ready)
+        {
+            #if defined(CORE_CM7) || defined(CORE_CM4)
+                if (!ready()) { __WFE(); }
+            #else
+                static_cast<void>(ready);
+                std::this_thread::yield();
+            #endif
+        }
+    };
+
+    /**
+     * @brief Wakeup through the release interrupt of a hardware semaphore.
+     * @tparam Id Semaphore number, 0 to 31, reserved for this direction.
+     */
+    template<std::uint32_t Id>
+    struct HsemWakeup {
+        static_assert(Id < Hsem::semaphoreCount, "The H755 has 32 hardware semaphores");
+
+        /// Enable the release interrupt of the semaphore on the calling (consumer) core.
+        static void enable()
+        {
+            #if defined(CORE_CM7) || defined(CORE_CM4)
+                HSEM_COMMON->ICR = 1U << Id;
+                HSEM_COMMON->IER = HSEM_COMMON->IER | (1U << Id);
+                #if defined(CORE_CM7)
+                    NVIC_EnableIRQ(HSEM1_IRQn);
+                #else
+                    NVIC_EnableIRQ(HSEM2_IRQn);
+                #endif
+            #endif
+        }
+
+        /// Acknowledge the release interrupt, from the HSEM1/HSEM2 handler of the consumer core.
+        static bool handleInterrupt()
+        {
+            #if defined(CORE_CM7) || defined(CORE_CM4)
+                if ((HSEM_COMMON->MISR & (1U << Id)) == 0) { return false; }
+                HSEM_COMMON->ICR = 1U << Id;
+            #endif
+            return true;
+        }
+
+        static void signal()
+        {
+            #if defined(CORE_CM7) || defined(CORE_CM4)
+                __DMB();
+                // 1-step lock then release, process ID 0: the release raises the interrupt
+                static_cast<void>(HSEM->RLR[Id]);
+                HSEM->R[Id] = Hsem::currentCoreId() << Hsem::coreIdPos;
+            #endif
+        }
+
+        template<typename Condition>
+        static void wait(Condition&& ready) { sleepUnless(ready); }
+    };
+};
+
+#endif // __WAKEUP_H__
@@ -0,0 +1,96 @@
+#ifndef __ALLOCATIONPOLICY_H__
+#define __ALLOCATIONPOLICY_H__
+
+/**
+ * @file AllocationPolicy.hh
+ * @brief Policies deciding where driver-internal objects are allocated.
+ *
+ * A policy provides:
+ *  - create<T>(args...) returning a new T* or nullptr when out of memory,
+ *  - destroy<T>(object) releasing it,
+ *  - Registry<Element>, the container used to keep track of instances.
+ *
+ * Register.hh and IPeripheralRegisters take a policy as template parameter.
+ * Memory::DefaultAllocation is a set of static pools, so bring-up of the peripherals
+ * never touches the heap. HeapAllocation keeps the previous new/std::vector behaviour.
+ * Types whose constructor is private must declare the policy as a friend.
+ *
+ * The pool capacity per type defaults to 32 and can be changed with -DDRIVER_POOL_CAPACITY=<n>.
+ */
+
+//<------------------------------INCLUDES------------------------------>//
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+#include <ObjectPool.hh>
+#include <StaticVector.hh>
+//<-------------------------------------------------------------------->//
+
+#if !defined(DRIVER_POOL_CAPACITY)
+#define DRIVER_POOL_CAPACITY 32
+#endif
+
+namespace Memory
+{
+    /**
+     * @brief Objects allocated with new/delete, instances tracked in a std::vector.
+     */
+    struct HeapAllocation {
+        template<typename Element>
+        using Registry = std::vector<Element>;
+
+        template<typename T, typename... Args>
+        static T* create(Args&&... args) { return new (std::nothrow) T(std::forward<Args>(args)...); }
+
+        template<typename T>
+        static void destroy(T* object) { delete object; }
+    };
+
+    /**
+     * @brief Objects taken from one static ObjectPool<T, N> per type, instances tracked in a StaticVector.
+     * @tparam N Capacity of every pool.
+     */
+    template<std::size_t N>
+    struct PoolAllocation {
+        template<typename Element>
+        using Registry = StaticVector<Element, N>;
+
+        /// The pool of type T, constant initialized in .bss.
+        template<typename T>
+        static ObjectPool<T, N>& pool()
+        {
+            static ObjectPool<T, N> instance;
+            return instance;
+        }
+
+        template<typename T, typename... Args>
+        static T* create(Args&&... args)
+        {
+            void* slot{ pool<T>().allocate() };
+            return slot != nullptr ? ::new (slot) T(std::forward<Args>(args)...) : nullptr;
+        }
+
+        template<typename T>
+        static void destroy(T* object)
+        {
+            if (object == nullptr) { return; }
+            object->~T();
+            pool<T>().deallocate(object);
+        }
+    };
+
+    /// Policy used by the drivers unless told otherwise.
+    using DefaultAllocation = PoolAllocation<DRIVER_POOL_CAPACITY>;
+
+    /**
+     * @brief std::unique_ptr deleter releasing through a policy.
+     */
+    template<typename Policy>
+    struct PolicyDeleter {
+        template<typename T>
+        void operator()(T* object) const { Policy::template destroy<T>(object); }
+    };
+};
+
+#endif // __ALLOCATIONPOLICY_H__
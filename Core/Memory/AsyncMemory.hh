@@ -0,0 +1,348 @@
+#ifndef __ASYNCMEMORY_H__
+#define __ASYNCMEMORY_H__
+
+/**
+ * @file AsyncMemory.hh
+ * @brief Asynchronous memcpy/memset on the MDMA, with a CPU path below a per-region threshold.
+ *
+ * copyAsync() and fillAsync() return a CopyToken at once. Below the threshold of the
+ * source and destination regions the work is done on the CPU before returning (the token
+ * is already complete); above it the operation is queued for an MDMA channel and the CPU
+ * is free until wait(). Operations complete in submission order: the CPU path is only
+ * taken while no MDMA work is pending, so a small copy never overtakes a large one it
+ * depends on.
+ *
+ * The MDMA is the engine because it reaches every region, the TCMs included; DMA1/DMA2
+ * cannot reach the TCMs and would need a stream per copy. One channel serves the queue,
+ * large operations are cut in chains of Nodes 64 KiB blocks. The copier holds the chain,
+ * so it lives where the MDMA fetches descriptors: declare it DMA_BUFFER.
+ *
+ * Thresholds: the crossover between the CPU and the MDMA depends on the buses of both
+ * sides (64-bit AXI, 32-bit AHB, TCM). The defaults come from the timing model of
+ * Benchmarks/AsyncMemoryBenchmark.cpp; calibrate() measures the real crossover of one
+ * region pair on the target and the result goes into the table.
+ *
+ * Cache maintenance (CM7): the source is cleaned and the destination cleaned and
+ * invalidated at submission, the destination invalidated again on completion, so the CPU
+ * reads the data the MDMA wrote. TCM ranges are not cached and are left alone. Sources
+ * and destinations need not be cache-line aligned, but the CPU must not write the lines
+ * of a destination until the operation completes.
+ *
+ * Usage example:
+ * ```
+ * DMA_BUFFER AsyncMemory::AsyncCopier<8> copier{ Mdma::channel<1>() };     // holds the MDMA chain
+ * extern "C" void MDMA_IRQHandler() { Mdma::handleInterrupt<1>(); }
+ *
+ * auto token{ copier.copyAsync(sram1Frame, axiFrame, sizeof(axiFrame)) };
+ * // ... other work ...
+ * if (token) { copier.wait(token.value()); }
+ * ```
+ */
+
+//<------------------------------INCLUDES------------------------------>//
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <Mdma.hh>
+#include <Cache.hh>
+#include <CompletionQueue.hh>
+#include <CriticalSection.hh>
+#include <CycleCounter.hh>
+#include <MemorySections.hh>
+#include <Result.hh>
+//<-------------------------------------------------------------------->//
+
+namespace AsyncMemory
+{
+    /**
+     * @brief Memory regions with distinct bus paths.
+     */
+    enum class Region : std::uint8_t { itcm, dtcm, axiSram, d2Sram, sram4, other };
+    inline constexpr std::size_t regionCount{ 6 };
+
+    constexpr Region regionOf(const std::uint32_t address)
+    {
+        if (address >= MemorySections::itcmStart && address < MemorySections::itcmEnd) { return Region::itcm; }
+        if (address >= MemorySections::dtcmStart && address < MemorySections::dtcmEnd) { return Region::dtcm; }
+        if (address >= MemorySections::axiSramStart && address < MemorySections::axiSramEnd) { return Region::axiSram; }
+        if (address >= MemorySections::d2SramStart && address < MemorySections::d2SramEnd) { return Region::d2Sram; }
+        if (address >= MemorySections::sram4Start && address < MemorySections::sram4End) { return Region::sram4; }
+        return Region::other;
+    }
+
+    constexpr bool isCached(const Region region) { return region != Region::itcm && region != Region::dtcm; }
+
+    /// Threshold that keeps every size on the CPU.
+    inline constexpr std::uint32_t never{ 0xFFFFFFFF };
+
+    /**
+     * @brief Sizes in bytes from which the MDMA is used, per region pair.
+     */
+    struct Thresholds {
+        std::array<std::array<std::uint32_t, regionCount>, regionCount> copy;     ///< [source][destination]
+        std::array<std::uint32_t, regionCount> fill;                             ///< [destination]
+
+        constexpr std::uint32_t copyFrom(const Region source, const Region destination) const
+        {
+            return copy[static_cast<std::size_t>(source)][static_cast<std::size_t>(destination)];
+        }
+
+        constexpr std::uint32_t fillOf(const Region destination) const { return fill[static_cast<std::size_t>(destination)]; }
+    };
+
+    /**
+     * @brief Defaults from the model of Benchmarks/AsyncMemoryBenchmark.cpp (CM7 at 480 MHz, buses at 240 MHz).
+     * Order: ITCM, DTCM, AXI SRAM, D2 SRAM, SRAM4, other.
+     */
+    inline constexpr Thresholds defaultThresholds{
+        .copy = { {
+            { never, never, 16384, 2048, 1024, 2048 },
+            { never, never, 16384, 2048, 1024, 2048 },
+            { 1024, 1024, 1024, 1024, 1024, 1024 },
+            { 512, 512, 1024, 512, 512, 512 },
+            { 512, 512, 512, 512, 512, 512 },
+            { 256, 256, 256, 256, 256, 256 },
+        } },
+        .fill = { never, never, never, 16384, 4096, 16384 }
+    };
+
+    /**
+     * @brief Smallest power of two from which the MDMA is as fast as the CPU, for all larger sizes.
+     * @param cpuCost, dmaCost Cost of a size, in any unit.
+     * @return std::uint32_t Threshold for Thresholds, never if the CPU wins at maxBytes.
+     */
+    template<typename CpuCost, typename DmaCost>
+    constexpr std::uint32_t findCrossover(CpuCost&& cpuCost, DmaCost&& dmaCost, const std::uint32_t maxBytes = 64 * 1024)
+    {
+        std::uint32_t crossover{ never };
+        for (std::uint32_t bytes = 16; bytes <= maxBytes; bytes *= 2) {
+            if (dmaCost(bytes) > cpuCost(bytes)) {
+                crossover = never;
+            } else if (crossover == never) {
+                crossover = bytes;
+            }
+        }
+        return crossover;
+    }
+
+    /// Word-wise copy, the CPU path; newlib-nano's memcpy goes byte by byte.
+    inline void cpuCopy(void* destination, const void* source, std::size_t bytes)
+    {
+        auto* to{ static_cast<std::uint8_t*>(destination) };
+        const auto* from{ static_cast<const std::uint8_t*>(source) };
+        while (bytes >= 32) {
+            std::uint32_t block[8];
+            std::memcpy(block, from, sizeof(block));
+            std::memcpy(to, block, sizeof(block));
+            to += 32;
+            from += 32;
+            bytes -= 32;
+        }
+        for (; bytes >= 4; bytes -= 4, to += 4, from += 4) {
+            std::uint32_t word;
+            std::memcpy(&word, from, 4);
+            std::memcpy(to, &word, 4);
+        }
+        for (; bytes > 0; --bytes) { *to++ = *from++; }
+    }
+
+    inline void cpuFill(void* destination, const std::uint8_t value, std::size_t bytes)
+    {
+        auto* to{ static_cast<std::uint8_t*>(destination) };
+        const std::uint32_t word{ value * 0x01010101U };
+        for (; bytes > 0 && (reinterpret_cast<std::uintptr_t>(to) & 3U) != 0; --bytes) { *to++ = value; }
+        for (; bytes >= 4; bytes -= 4, to += 4) { std::memcpy(to, &word, 4); }
+        for (; bytes > 0; --bytes) { *to++ = value; }
+    }
+
+    /**
+     * @brief Completion token of one operation.
+     */
+    struct CopyToken {
+        std::uint32_t sequence;
+    };
+
+    enum class Dispatch : std::uint8_t { automatic, cpu, dma };
+
+    /**
+     * @brief Addresses as the MDMA sees them: the CPU's.
+     */
+    struct DirectAddress {
+        static std::uint32_t of(const void* pointer) { return static_cast<std::uint32_t>(reinterpret_cast<std::uintptr_t>(pointer)); }
+    };
+
+    /**
+     * @brief A copy or fill queued for the MDMA.
+     */
+    struct CopyOperation {
+        std::uint32_t destination;
+        std::uint32_t source;           ///< Unused by fills.
+        std::uint32_t bytes;
+        std::uint32_t done;
+        std::uint8_t value;
+        bool fill;
+    };
+
+    /**
+     * @brief Queue of copies and fills served by one MDMA channel, see CompletionQueue.hh.
+     * @tparam Pending Operations waiting for the channel, the one running included; a power of two.
+     * @tparam Nodes 64 KiB blocks per chain; longer operations take several chains.
+     * @tparam Address Bus address of a CPU pointer, for host models.
+     */
+    template<std::size_t Pending, std::size_t Nodes = 4, typename Address = DirectAddress>
+    class AsyncCopier : public CompletionQueue<AsyncCopier<Pending, Nodes, Address>, CopyOperation, CopyToken, Pending>
+    {
+    private:
+        using classParent = CompletionQueue<AsyncCopier<Pending, Nodes, Address>, CopyOperation, CopyToken, Pending>;
+        friend classParent;
+        using Operation = CopyOperation;
+
+        MdmaChannelHandler& channel;
+        Thresholds thresholds;
+        MdmaChain<Nodes> chain;
+        alignas(8) std::uint8_t pattern[8]{};
+
+        static void* pointerOf(const std::uint32_t address) { return reinterpret_cast<void*>(static_cast<std::uintptr_t>(address)); }
+
+        static void maintain(const std::uint32_t address, const std::uint32_t bytes, const bool beforeWrite, const bool source)
+        {
+            if (!isCached(regionOf(address))) { return; }
+            if (source) {
+                Cache::clean(pointerOf(address), bytes);
+            } else if (beforeWrite) {
+                Cache::cleanInvalidate(pointerOf(address), bytes);
+            } else {
+                Cache::invalidate(pointerOf(address), bytes);
+            }
+        }
+
+        void prepareOperation(const Operation& operation)
+        {
+            if (!operation.fill) { maintain(operation.source, operation.bytes, true, true); }
+            maintain(operation.destination, operation.bytes, true, false);
+        }
+
+        /// Program the next chain of an operation.
+        bool startOperation(Operation& operation)
+        {
+            const std::uint32_t left{ operation.bytes - operation.done };
+            const std::uint32_t length{ left < Nodes * Mdma::maxBlockBytes ? left : static_cast<std::uint32_t>(Nodes * Mdma::maxBlockBytes) };
+            chain.reset();
+            DriverStatus built{ operation.fill ? chain.fill(operation.destination + operation.done, Address::of(pattern), length)
+                                               : chain.copy(operation.destination + operation.done, operation.source + operation.done, length) };
+            if (operation.fill) {
+                std::memset(pattern, operation.value, sizeof(pattern));
+                Cache::clean(pattern, sizeof(pattern));
+            }
+            if (built) { built = channel.start(chain); }
+            if (!built) { return false; }
+            operation.done += length;
+            return true;
+        }
+
+        void finishOperation(const Operation& operation) { maintain(operation.destination, operation.bytes, false, false); }
+
+        void serveEngine() { channel.handleInterrupt(); }
+
+        static void onChannelEvent(void* context, const MdmaEvent event, [[maybe_unused]] const std::uint32_t errorStatus)
+        {
+            auto& self{ *static_cast<AsyncCopier*>(context) };
+            const Operation& operation{ self.front() };
+            self.engineDone(event != MdmaEvent::transferError, operation.done == operation.bytes);
+        }
+
+        Utils::Result<CopyToken, DriverError> submit(const Operation& operation, const Dispatch dispatch, const std::uint32_t threshold,
+                                              void* destination, const void* source)
+        {
+            bool onCpu{ false };
+            CopyToken token{};
+            {
+                CriticalSection guard;
+                const bool idle{ this->isIdle() };
+                onCpu = dispatch == Dispatch::cpu || (dispatch == Dispatch::automatic && idle && operation.bytes < threshold);
+                if (onCpu) {
+                    if (!idle) { return Utils::fail(DriverError::busy); }
+                    token = this->reserveInline();
+                }
+            }
+            if (!onCpu) { return this->enqueue(operation); }
+            // The copy runs with the interrupts enabled, the queue holding the MDMA work submitted meanwhile
+            if (operation.fill) {
+                cpuFill(destination, operation.value, operation.bytes);
+            } else {
+                cpuCopy(destination, source, operation.bytes);
+            }
+            this->completeInline();
+            return token;
+        }
+
+    public:
+        /// The chain opens with its nodes: the MDMA fetches them at the address of the chain.
+        explicit AsyncCopier(MdmaChannelHandler& channel, const Thresholds& thresholds = defaultThresholds, const MdmaPriority priority = MdmaPriority::medium)
+            : channel(channel), thresholds(thresholds), chain(Address::of(&chain))
+        {
+            static_cast<void>(channel.configure(priority, &onChannelEvent, this));
+        }
+
+        AsyncCopier(const AsyncCopier&) = delete;
+        AsyncCopier& operator=(const AsyncCopier&) = delete;
+
+        /**
+         * @brief Copy bytes from source to destination, the ranges must not overlap.
+         * @return Utils::Result<CopyToken, DriverError> DriverError::outOfResources if Pending operations wait,
+         * DriverError::busy for Dispatch::cpu while other work is pending.
+         */
+        Utils::Result<CopyToken, DriverError> copyAsync(void* destination, const void* source, const std::size_t bytes, const Dispatch dispatch = Dispatch::automatic)
+        {
+            const std::uint32_t to{ Address::of(destination) };
+            const std::uint32_t from{ Address::of(source) };
+            if (bytes == 0 || bytes > 0xFFFFFFFFU - to || (to < from + bytes && from < to + bytes)) { return Utils::fail(DriverError::invalidParameter); }
+            const Operation operation{ to, from, static_cast<std::uint32_t>(bytes), 0, 0, false };
+            return submit(operation, dispatch, thresholds.copyFrom(regionOf(from), regionOf(to)), destination, source);
+        }
+
+        /**
+         * @brief Set bytes bytes of destination to value.
+         */
+        Utils::Result<CopyToken, DriverError> fillAsync(void* destination, const std::uint8_t value, const std::size_t bytes, const Dispatch dispatch = Dispatch::automatic)
+        {
+            const std::uint32_t to{ Address::of(destination) };
+            if (bytes == 0 || bytes > 0xFFFFFFFFU - to) { return Utils::fail(DriverError::invalidParameter); }
+            const Operation operation{ to, 0, static_cast<std::uint32_t>(bytes), 0, value, true };
+            return submit(operation, dispatch, thresholds.fillOf(regionOf(to)), destination, nullptr);
+        }
+
+        const Thresholds& thresholdTable() const { return thresholds; }
+        void setThresholds(const Thresholds& table) { thresholds = table; }
+    };
+
+    /**
+     * @brief Measure the copy crossover of one region pair, on the target.
+     *
+     * Times the CPU path and the MDMA path (submission, transfer, completion and cache
+     * maintenance) for powers of two up to maxBytes, best of a few runs each.
+     * @param destination, source Buffers of maxBytes bytes in the regions to measure.
+     * @return std::uint32_t Value for Thresholds::copy[source region][destination region].
+     */
+    template<typename Copier>
+    std::uint32_t calibrate(Copier& copier, void* destination, const void* source, const std::uint32_t maxBytes)
+    {
+        constexpr std::uint32_t runs{ 4 };
+        auto measure = [&](const std::uint32_t bytes, const Dispatch dispatch) {
+            std::uint32_t best{ never };
+            for (std::uint32_t run = 0; run < runs; ++run) {
+                const std::uint32_t start{ CycleCounter::now() };
+                const auto token{ copier.copyAsync(destination, source, bytes, dispatch) };
+                if (token) { static_cast<void>(copier.wait(token.value())); }
+                const std::uint32_t cycles{ CycleCounter::now() - start };
+                best = cycles < best ? cycles : best;
+            }
+            return best;
+        };
+        return findCrossover([&](const std::uint32_t bytes) { return measure(bytes, Dispatch::cpu); },
+                             [&](const std::uint32_t bytes) { return measure(bytes, Dispatch::dma); }, maxBytes);
+    }
+};
+
+#endif // __ASYNCMEMORY_H__
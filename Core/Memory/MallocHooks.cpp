@@ -0,0 +1,128 @@
+/**
+ * @file MallocHooks.cpp
+ * @brief Replace the newlib allocator with the TLSF heaps of SystemHeap.hh.
+ *
+ * Both the public functions and the reentrant _r variants newlib uses internally
+ * (stdio, strdup, ...) are defined here, so the linker never pulls nano-mallocr and
+ * _sbrk is no longer called. Host builds keep the system allocator.
+ *
+ * operator new/delete are defined here too: libstdc++'s operator new throws std::bad_alloc,
+ * which pulls the whole unwinder into a -fno-exceptions image. These trap instead, and the
+ * std::nothrow versions return nullptr.
+ *
+ * With NO_HEAP (make NO_HEAP=1) none of this is compiled and the makefile turns every
+ * reference to an allocation function into a link error.
+ */
+
+#if defined(__arm__) && !defined(NO_HEAP)
+
+//<------------------------------INCLUDES------------------------------>//
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <reent.h>
+#include <SystemHeap.hh>
+//<-------------------------------------------------------------------->//
+
+extern "C" {
+
+void* malloc(std::size_t size)
+{
+    return Memory::SystemHeap::allocate(size);
+}
+
+void free(void* pointer)
+{
+    Memory::SystemHeap::deallocate(pointer);
+}
+
+void* calloc(std::size_t count, std::size_t size)
+{
+    if (size != 0 && count > static_cast<std::size_t>(-1) / size) { return nullptr; }
+    void* pointer{ Memory::SystemHeap::allocate(count * size) };
+    if (pointer != nullptr) { std::memset(pointer, 0, count * size); }
+    return pointer;
+}
+
+void* realloc(void* pointer, std::size_t size)
+{
+    return Memory::SystemHeap::reallocate(pointer, size);
+}
+
+void* memalign(std::size_t align, std::size_t size)
+{
+    return Memory::SystemHeap::allocateAligned(size, align);
+}
+
+void* aligned_alloc(std::size_t align, std::size_t size)
+{
+    return Memory::SystemHeap::allocateAligned(size, align);
+}
+
+int posix_memalign(void** result, std::size_t align, std::size_t size)
+{
+    if (align < sizeof(void*) || (align & (align - 1)) != 0) { return EINVAL; }
+    void* pointer{ Memory::SystemHeap::allocateAligned(size, align) };
+    if (pointer == nullptr) { return ENOMEM; }
+    *result = pointer;
+    return 0;
+}
+
+std::size_t malloc_usable_size(void* pointer)
+{
+    return Memory::TlsfHeap::usableSize(pointer);
+}
+
+void* _malloc_r(struct _reent*, std::size_t size) { return malloc(size); }
+void _free_r(struct _reent*, void* pointer) { free(pointer); }
+void* _calloc_r(struct _reent*, std::size_t count, std::size_t size) { return calloc(count, size); }
+void* _realloc_r(struct _reent*, void* pointer, std::size_t size) { return realloc(pointer, size); }
+void* _memalign_r(struct _reent*, std::size_t align, std::size_t size) { return memalign(align, size); }
+std::size_t _malloc_usable_size_r(struct _reent*, void* pointer) { return malloc_usable_size(pointer); }
+
+}
+
+namespace
+{
+    void* allocateOrTrap(const std::size_t size, const std::size_t align = 0)
+    {
+        void* pointer{ align != 0 ? Memory::SystemHeap::allocateAligned(size, align) : Memory::SystemHeap::allocate(size) };
+        // Out of memory in code that cannot handle it: stop in the HardFault handler
+        if (pointer == nullptr) { __builtin_trap(); }
+        return pointer;
+    }
+};
+
+void* operator new(std::size_t size) { return allocateOrTrap(size); }
+void* operator new[](std::size_t size) { return allocateOrTrap(size); }
+void* operator new(std::size_t size, std::align_val_t align) { return allocateOrTrap(size, static_cast<std::size_t>(align)); }
+void* operator new[](std::size_t size, std::align_val_t align) { return allocateOrTrap(size, static_cast<std::size_t>(align)); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return malloc(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return malloc(size); }
+
+void operator delete(void* pointer) noexcept { free(pointer); }
+void operator delete[](void* pointer) noexcept { free(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { free(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept { free(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept { free(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept { free(pointer); }
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept { free(pointer); }
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept { free(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { free(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { free(pointer); }
+
+#elif defined(__arm__) && defined(NO_HEAP)
+
+//<------------------------------INCLUDES------------------------------>//
+#include <cstddef>
+//<-------------------------------------------------------------------->//
+
+// Deleting destructors of classes with a virtual destructor reference operator delete even
+// if nothing is ever deleted. Empty definitions keep libstdc++'s versions, and free(), out.
+void operator delete(void*) noexcept {}
+void operator delete(void*, std::size_t) noexcept {}
+void operator delete[](void*) noexcept {}
+void operator delete[](void*, std::size_t) noexcept {}
+
+#endif
@@ -0,0 +1,142 @@
+#ifndef __OBJECTPOOL_H__
+#define __OBJECTPOOL_H__
+
+/**
+ * @file ObjectPool.hh
+ * @brief Fixed capacity storage for N objects of type T, without any heap.
+ *
+ * The slots live inside the pool object, so a pool with static storage duration
+ * places its objects in .bss. Free slots are chained through an index list: create()
+ * and destroy() run in constant time and never fail for another reason than the pool
+ * being full, in which case create() returns nullptr.
+ *
+ * Usage example:
+ * ```
+ * static Memory::ObjectPool<Message, 16> messages;
+ * Message* message = messages.create(id, payload);
+ * messages.destroy(message);
+ * ```
+ */
+
+//<------------------------------INCLUDES------------------------------>//
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+//<-------------------------------------------------------------------->//
+
+namespace Memory
+{
+    /**
+     * @brief Pool of N slots for objects of type T.
+     * @tparam T Object type.
+     * @tparam N Number of slots, 1 to 65535.
+     */
+    template<typename T, std::size_t N>
+    requires (N > 0 && N < 0xFFFF)
+    class ObjectPool
+    {
+    private:
+        using Index = std::uint16_t;
+        static constexpr Index endOfList{ 0xFFFF };
+
+        struct alignas(T) Slot {
+            std::uint8_t bytes[sizeof(T)];
+        };
+
+        std::array<Slot, N> slots{};
+        std::array<Index, N> nextFree{ makeFreeList() };
+        std::array<bool, N> used{};
+        Index firstFree{ 0 };
+        std::size_t count{ 0 };
+
+        static constexpr std::array<Index, N> makeFreeList()
+        {
+            std::array<Index, N> list{};
+            for (std::size_t index = 0; index < N; ++index) {
+                list[index] = index + 1 < N ? static_cast<Index>(index + 1) : endOfList;
+            }
+            return list;
+        }
+
+        std::size_t indexOf(const void* pointer) const
+        {
+            return static_cast<std::size_t>(static_cast<const Slot*>(pointer) - slots.data());
+        }
+
+    public:
+        constexpr ObjectPool() = default;
+        ObjectPool(const ObjectPool&) = delete;
+        ObjectPool& operator=(const ObjectPool&) = delete;
+
+        /// Number of slots.
+        static constexpr std::size_t capacity() { return N; }
+
+        /// Number of slots in use.
+        std::size_t size() const { return count; }
+
+        /// Number of free slots.
+        std::size_t available() const { return N - count; }
+
+        /**
+         * @brief Take a slot without constructing an object in it.
+         * @return void* Storage for one T, nullptr if the pool is full.
+         */
+        void* allocate()
+        {
+            if (firstFree == endOfList) { return nullptr; }
+            const Index index{ firstFree };
+            firstFree = nextFree[index];
+            used[index] = true;
+            ++count;
+            return slots[index].bytes;
+        }
+
+        /**
+         * @brief Give back a slot obtained with allocate(), its object already destroyed.
+         */
+        void deallocate(void* pointer)
+        {
+            if (!owns(pointer)) { return; }
+            const std::size_t index{ indexOf(pointer) };
+            if (!used[index]) { return; }
+            used[index] = false;
+            nextFree[index] = firstFree;
+            firstFree = static_cast<Index>(index);
+            --count;
+        }
+
+        /**
+         * @brief Construct an object in a free slot.
+         * @return T* The new object, nullptr if the pool is full.
+         */
+        template<typename... Args>
+        T* create(Args&&... args)
+        {
+            void* slot{ allocate() };
+            return slot != nullptr ? ::new (slot) T(std::forward<Args>(args)...) : nullptr;
+        }
+
+        /**
+         * @brief Destroy an object created by this pool and free its slot. nullptr is ignored.
+         */
+        void destroy(T* object)
+        {
+            if (object == nullptr) { return; }
+            object->~T();
+            deallocate(object);
+        }
+
+        /**
+         * @brief Check whether a pointer designates a slot of this pool.
+         */
+        bool owns(const void* pointer) const
+        {
+            const auto* slot{ static_cast<const Slot*>(pointer) };
+            return slot >= slots.data() && slot < slots.data() + N;
+        }
+    };
+};
+
+#endif // __OBJECTPOOL_H__
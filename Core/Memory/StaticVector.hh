@@ -0,0 +1,63 @@
+#ifndef __STATICVECTOR_H__
+#define __STATICVECTOR_H__
+
+/**
+ * @file StaticVector.hh
+ * @brief Vector with a compile-time capacity and inline storage.
+ *
+ * A drop-in for the std::vector subset used by registries (push_back, iteration,
+ * size) that never allocates. push_back() reports a full vector instead of growing.
+ */
+
+//<------------------------------INCLUDES------------------------------>//
+#include <array>
+#include <cstddef>
+#include <type_traits>
+//<-------------------------------------------------------------------->//
+
+namespace Memory
+{
+    /**
+     * @brief Up to N elements of a trivially copyable type T stored inline.
+     */
+    template<typename T, std::size_t N>
+    requires (std::is_trivially_copyable_v<T> && N > 0)
+    class StaticVector
+    {
+    private:
+        std::array<T, N> elements{};
+        std::size_t count{ 0 };
+
+    public:
+        constexpr StaticVector() = default;
+
+        static constexpr std::size_t capacity() { return N; }
+        constexpr std::size_t size() const { return count; }
+        constexpr bool empty() const { return count == 0; }
+        constexpr bool full() const { return count == N; }
+
+        /**
+         * @brief Append an element.
+         * @return true If it was added, false if the vector is full.
+         */
+        constexpr bool push_back(const T& value)
+        {
+            if (full()) { return false; }
+            elements[count++] = value;
+            return true;
+        }
+
+        constexpr void pop_back() { if (count != 0) { --count; } }
+        constexpr void clear() { count = 0; }
+
+        constexpr T& operator[](const std::size_t index) { return elements[index]; }
+        constexpr const T& operator[](const std::size_t index) const { return elements[index]; }
+
+        constexpr T* begin() { return elements.data(); }
+        constexpr T* end() { return elements.data() + count; }
+        constexpr const T* begin() const { return elements.data(); }
+        constexpr const T* end() const { return elements.data() + count; }
+    };
+};
+
+#endif // __STATICVECTOR_H__
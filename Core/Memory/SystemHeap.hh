@@ -0,0 +1,160 @@
+#ifndef __SYSTEMHEAP_H__
+#define __SYSTEMHEAP_H__
+
+/**
+ * @file SystemHeap.hh
+ * @brief The two TLSF heaps of a core, behind malloc/free and operator new.
+ *
+ * - fast: the DTCM (CM7) or D2 SRAM (CM4) between _end and the reserved MSP stack,
+ *   the range newlib's _sbrk used to hand out.
+ * - bulk: the part of the core's AXI SRAM left after .axi_bss (__axi_heap_start/end).
+ *
+ * MallocHooks.cpp replaces the newlib allocator with these functions, so malloc(),
+ * new and the standard containers allocate in constant time. Allocations go to the
+ * preferred heap first and fall back to the other one. Every call masks interrupts
+ * for its (bounded) duration, so the heaps may be used from ISRs.
+ *
+ * Usage example:
+ * ```
+ * auto* frame = static_cast<std::uint8_t*>(Memory::SystemHeap::allocate(64 * 1024, Memory::HeapRegion::bulk));
+ * Memory::SystemHeap::deallocate(frame);
+ * auto stats = Memory::SystemHeap::getStatistics(Memory::HeapRegion::fast);
+ * ```
+ */
+
+//<------------------------------INCLUDES------------------------------>//
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <CriticalSection.hh>
+#include <TlsfHeap.hh>
+//<-------------------------------------------------------------------->//
+
+#if defined(__arm__)
+extern "C" {
+    extern std::uint8_t _end;
+    extern std::uint8_t _estack;
+    extern std::uint8_t _Min_Stack_Size;
+    extern std::uint8_t __axi_heap_start;
+    extern std::uint8_t __axi_heap_end;
+}
+#endif
+
+namespace Memory
+{
+    /**
+     * @brief Heaps of a core.
+     */
+    enum class HeapRegion : std::uint8_t {
+        fast,   ///< Core coupled RAM, lowest latency, small.
+        bulk    ///< AXI SRAM, large buffers.
+    };
+
+    namespace SystemHeap
+    {
+        // Constant initialized, usable before the static constructors run
+        inline TlsfHeap fastHeap;
+        inline TlsfHeap bulkHeap;
+        inline bool initialized{ false };
+
+        inline TlsfHeap& get(const HeapRegion region) { return region == HeapRegion::fast ? fastHeap : bulkHeap; }
+
+        /**
+         * @brief Hand the linker script ranges to the heaps. Called on the first allocation.
+         */
+        inline void initialize()
+        {
+            if (initialized) { return; }
+            initialized = true;
+            #if defined(__arm__)
+                const std::uintptr_t fastEnd{ reinterpret_cast<std::uintptr_t>(&_estack) - reinterpret_cast<std::uintptr_t>(&_Min_Stack_Size) };
+                fastHeap.addRegion(&_end, fastEnd - reinterpret_cast<std::uintptr_t>(&_end));
+                bulkHeap.addRegion(&__axi_heap_start, static_cast<std::size_t>(&__axi_heap_end - &__axi_heap_start));
+            #endif
+        }
+
+        /**
+         * @brief Add memory to one of the heaps, e.g. a statically allocated pool.
+         * @return true If the region was added.
+         */
+        inline bool addRegion(const HeapRegion region, void* memory, const std::size_t size)
+        {
+            CriticalSection guard;
+            initialize();
+            return get(region).addRegion(memory, size);
+        }
+
+        /**
+         * @brief Allocate from the preferred heap, falling back to the other one.
+         * @return void* nullptr if neither heap has a large enough block.
+         */
+        inline void* allocate(const std::size_t size, const HeapRegion preferred = HeapRegion::fast)
+        {
+            CriticalSection guard;
+            initialize();
+            const HeapRegion other{ preferred == HeapRegion::fast ? HeapRegion::bulk : HeapRegion::fast };
+            void* pointer{ get(preferred).allocate(size) };
+            return pointer != nullptr ? pointer : get(other).allocate(size);
+        }
+
+        /**
+         * @brief Allocate with a power of two alignment, falling back to the other heap.
+         */
+        inline void* allocateAligned(const std::size_t size, const std::size_t align, const HeapRegion preferred = HeapRegion::fast)
+        {
+            CriticalSection guard;
+            initialize();
+            const HeapRegion other{ preferred == HeapRegion::fast ? HeapRegion::bulk : HeapRegion::fast };
+            void* pointer{ get(preferred).allocateAligned(size, align) };
+            return pointer != nullptr ? pointer : get(other).allocateAligned(size, align);
+        }
+
+        /**
+         * @brief Return a block to the heap owning it. nullptr and foreign pointers are ignored.
+         */
+        inline void deallocate(void* pointer)
+        {
+            CriticalSection guard;
+            if (fastHeap.owns(pointer)) {
+                fastHeap.deallocate(pointer);
+            } else if (bulkHeap.owns(pointer)) {
+                bulkHeap.deallocate(pointer);
+            }
+        }
+
+        /**
+         * @brief Resize a block in its own heap, moving it to the other heap if needed.
+         */
+        inline void* reallocate(void* pointer, const std::size_t size)
+        {
+            if (pointer == nullptr) { return allocate(size); }
+            const HeapRegion region{ fastHeap.owns(pointer) ? HeapRegion::fast : HeapRegion::bulk };
+            void* resized{ nullptr };
+            {
+                CriticalSection guard;
+                if (!get(region).owns(pointer)) { return nullptr; }
+                resized = get(region).reallocate(pointer, size);
+            }
+            if (resized != nullptr || size == 0) { return resized; }
+
+            resized = allocate(size, region == HeapRegion::fast ? HeapRegion::bulk : HeapRegion::fast);
+            if (resized != nullptr) {
+                const std::size_t current{ TlsfHeap::usableSize(pointer) };
+                std::memcpy(resized, pointer, current < size ? current : size);
+                deallocate(pointer);
+            }
+            return resized;
+        }
+
+        /**
+         * @brief Statistics of one heap.
+         */
+        inline TlsfHeap::Statistics getStatistics(const HeapRegion region)
+        {
+            CriticalSection guard;
+            return get(region).getStatistics();
+        }
+    };
+};
+
+#endif // __SYSTEMHEAP_H__
@@ -0,0 +1,457 @@
+#ifndef __TLSFHEAP_H__
+#define __TLSFHEAP_H__
+
+/**
+ * @file TlsfHeap.hh
+ * @brief Two-Level Segregated Fit allocator with constant time allocation and release.
+ *
+ * Free blocks are kept in size-segregated lists indexed by a first level (power of two)
+ * and a second level (16 linear subdivisions of that power of two). Two bitmaps record
+ * which lists are non empty, so finding a fitting block is a couple of bit scans and
+ * never a list walk. Neighbouring free blocks are merged immediately on release.
+ *
+ * A heap can span up to maxRegions disjoint memory regions and keeps running statistics
+ * (usage, peak, free block count, largest free block, fragmentation). It does no locking:
+ * callers shared with interrupts wrap it in a CriticalSection, see SystemHeap.hh.
+ *
+ * Usage example:
+ * ```
+ * static std::uint8_t pool[16 * 1024];
+ * Memory::TlsfHeap heap;
+ * heap.addRegion(pool, sizeof(pool));
+ * void* p = heap.allocate(100);
+ * heap.deallocate(p);
+ * ```
+ */
+
+//<------------------------------INCLUDES------------------------------>//
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+//<-------------------------------------------------------------------->//
+
+namespace Memory
+{
+    class TlsfHeap
+    {
+    public:
+        /// Alignment of every returned pointer: 8 bytes on the Cortex-M, 16 on 64-bit hosts.
+        static constexpr std::size_t alignment{ 2 * sizeof(void*) };
+
+        /// Number of disjoint regions a heap can manage.
+        static constexpr std::size_t maxRegions{ 4 };
+
+        /**
+         * @brief Usage and fragmentation figures of a heap.
+         */
+        struct Statistics {
+            std::size_t totalBytes{ 0 };            ///< Usable bytes of all regions, headers excluded.
+            std::size_t usedBytes{ 0 };             ///< Bytes currently allocated, rounding included.
+            std::size_t peakUsedBytes{ 0 };         ///< Highest usedBytes seen.
+            std::size_t freeBytes{ 0 };             ///< Bytes in free blocks.
+            std::size_t freeBlocks{ 0 };            ///< Number of free blocks.
+            std::size_t largestFreeBlock{ 0 };      ///< Largest single allocation that can succeed.
+            std::size_t allocations{ 0 };           ///< Successful allocations since start.
+            std::size_t failedAllocations{ 0 };     ///< Allocations that returned nullptr.
+
+            /// Share of the free memory unusable for one allocation of all free bytes, 0 to 100.
+            constexpr std::size_t fragmentationPercent() const
+            {
+                return freeBytes == 0 ? 0 : 100 - (largestFreeBlock * 100) / freeBytes;
+            }
+        };
+
+    private:
+        static constexpr std::size_t alignmentLog2{ static_cast<std::size_t>(std::countr_zero(alignment)) };
+        static constexpr std::size_t slLog2{ 4 };
+        static constexpr std::size_t slCount{ std::size_t{ 1 } << slLog2 };
+        static constexpr std::size_t flShift{ slLog2 + alignmentLog2 };
+        static constexpr std::size_t flMax{ 28 };
+        static constexpr std::size_t flCount{ flMax - flShift + 1 };
+        static constexpr std::size_t smallBlockSize{ std::size_t{ 1 } << flShift };
+
+        static constexpr std::size_t freeFlag{ 0x1 };
+        static constexpr std::size_t prevFreeFlag{ 0x2 };
+        static constexpr std::size_t flagsMask{ freeFlag | prevFreeFlag };
+
+        /**
+         * @brief Header in front of every block. nextFree/prevFree overlap the payload
+         * and are only meaningful while the block is free.
+         */
+        struct Block {
+            Block* prevPhysical;
+            std::size_t sizeAndFlags;
+            Block* nextFree;
+            Block* prevFree;
+
+            std::size_t size() const { return sizeAndFlags & ~flagsMask; }
+            void setSize(const std::size_t size) { sizeAndFlags = size | (sizeAndFlags & flagsMask); }
+            bool isFree() const { return (sizeAndFlags & freeFlag) != 0; }
+            void setFree(const bool free) { sizeAndFlags = free ? (sizeAndFlags | freeFlag) : (sizeAndFlags & ~freeFlag); }
+            bool isPrevFree() const { return (sizeAndFlags & prevFreeFlag) != 0; }
+            void setPrevFree(const bool free) { sizeAndFlags = free ? (sizeAndFlags | prevFreeFlag) : (sizeAndFlags & ~prevFreeFlag); }
+        };
+
+        static constexpr std::size_t headerSize{ 2 * sizeof(void*) };
+        static constexpr std::size_t minBlockSize{ sizeof(Block) - headerSize };
+        static constexpr std::size_t maxBlockSize{ (std::size_t{ 1 } << flMax) - alignment };
+
+        static_assert(headerSize % alignment == 0, "Block headers must keep payloads aligned");
+        static_assert(flCount < 32 && slCount <= 32, "Bitmaps are 32 bits wide");
+
+        struct RegionBounds {
+            std::uintptr_t start{ 0 };
+            std::uintptr_t end{ 0 };
+        };
+
+        std::uint32_t flBitmap{ 0 };
+        std::array<std::uint32_t, flCount> slBitmap{};
+        std::array<std::array<Block*, slCount>, flCount> freeLists{};
+        std::array<RegionBounds, maxRegions> regions{};
+        std::size_t regionCount{ 0 };
+        Statistics statistics{};
+
+        static constexpr std::size_t alignUp(const std::size_t value, const std::size_t align) { return (value + align - 1) & ~(align - 1); }
+
+        static constexpr std::size_t adjustSize(const std::size_t size)
+        {
+            const std::size_t aligned{ alignUp(size, alignment) };
+            return aligned < minBlockSize ? minBlockSize : aligned;
+        }
+
+        static constexpr void mapping(const std::size_t size, std::size_t& fl, std::size_t& sl)
+        {
+            if (size < smallBlockSize) {
+                fl = 0;
+                sl = size / (smallBlockSize / slCount);
+            } else {
+                const std::size_t msb{ static_cast<std::size_t>(std::bit_width(size)) - 1 };
+                sl = (size >> (msb - slLog2)) ^ slCount;
+                fl = msb - flShift + 1;
+            }
+        }
+
+        // Round up so that every block of the list found for size is large enough
+        static constexpr std::size_t searchSize(const std::size_t size)
+        {
+            if (size < smallBlockSize) { return size; }
+            const std::size_t msb{ static_cast<std::size_t>(std::bit_width(size)) - 1 };
+            return size + (std::size_t{ 1 } << (msb - slLog2)) - 1;
+        }
+
+        static Block* fromPayload(void* payload) { return reinterpret_cast<Block*>(static_cast<std::uint8_t*>(payload) - headerSize); }
+        static void* toPayload(Block* block) { return reinterpret_cast<std::uint8_t*>(block) + headerSize; }
+        static Block* nextPhysical(Block* block) { return reinterpret_cast<Block*>(reinterpret_cast<std::uint8_t*>(block) + headerSize + block->size()); }
+
+        void insertFree(Block* block)
+        {
+            std::size_t fl{ 0 };
+            std::size_t sl{ 0 };
+            mapping(block->size(), fl, sl);
+            Block* head{ freeLists[fl][sl] };
+            block->nextFree = head;
+            block->prevFree = nullptr;
+            if (head != nullptr) { head->prevFree = block; }
+            freeLists[fl][sl] = block;
+            flBitmap |= 1U << fl;
+            slBitmap[fl] |= 1U << sl;
+            ++statistics.freeBlocks;
+            statistics.freeBytes += block->size();
+        }
+
+        void removeFree(Block* block)
+        {
+            std::size_t fl{ 0 };
+            std::size_t sl{ 0 };
+            mapping(block->size(), fl, sl);
+            if (block->prevFree != nullptr) {
+                block->prevFree->nextFree = block->nextFree;
+            } else {
+                freeLists[fl][sl] = block->nextFree;
+            }
+            if (block->nextFree != nullptr) { block->nextFree->prevFree = block->prevFree; }
+            if (freeLists[fl][sl] == nullptr) {
+                slBitmap[fl] &= ~(1U << sl);
+                if (slBitmap[fl] == 0) { flBitmap &= ~(1U << fl); }
+            }
+            --statistics.freeBlocks;
+            statistics.freeBytes -= block->size();
+        }
+
+        Block* findSuitable(const std::size_t size) const
+        {
+            std::size_t fl{ 0 };
+            std::size_t sl{ 0 };
+            mapping(searchSize(size), fl, sl);
+            if (fl >= flCount) { return nullptr; }
+            std::uint32_t slMap{ slBitmap[fl] & (~0U << sl) };
+            if (slMap == 0) {
+                const std::uint32_t flMap{ flBitmap & (~0U << (fl + 1)) };
+                if (flMap == 0) { return nullptr; }
+                fl = static_cast<std::size_t>(std::countr_zero(flMap));
+                slMap = slBitmap[fl];
+            }
+            sl = static_cast<std::size_t>(std::countr_zero(slMap));
+            return freeLists[fl][sl];
+        }
+
+        // Mark a block taken out of the free lists as used
+        void markUsed(Block* block)
+        {
+            block->setFree(false);
+            nextPhysical(block)->setPrevFree(false);
+            statistics.usedBytes += block->size();
+        }
+
+        // Give the tail of a used block beyond size back to the free lists
+        void trimUsed(Block* block, const std::size_t size)
+        {
+            if (block->size() < size + headerSize + minBlockSize) { return; }
+            Block* remainder{ reinterpret_cast<Block*>(reinterpret_cast<std::uint8_t*>(block) + headerSize + size) };
+            remainder->prevPhysical = block;
+            remainder->sizeAndFlags = (block->size() - size - headerSize) | freeFlag;
+            block->setSize(size);
+            statistics.usedBytes -= remainder->size() + headerSize;
+
+            Block* next{ nextPhysical(remainder) };
+            if (next->isFree()) {
+                removeFree(next);
+                remainder->setSize(remainder->size() + headerSize + next->size());
+                next = nextPhysical(remainder);
+            }
+            next->prevPhysical = remainder;
+            next->setPrevFree(true);
+            insertFree(remainder);
+        }
+
+        void* finishAllocation(Block* block, const std::size_t size)
+        {
+            markUsed(block);
+            trimUsed(block, size);
+            ++statistics.allocations;
+            if (statistics.usedBytes > statistics.peakUsedBytes) { statistics.peakUsedBytes = statistics.usedBytes; }
+            return toPayload(block);
+        }
+
+        void* fail()
+        {
+            ++statistics.failedAllocations;
+            return nullptr;
+        }
+
+    public:
+        constexpr TlsfHeap() = default;
+        TlsfHeap(const TlsfHeap&) = delete;
+        TlsfHeap& operator=(const TlsfHeap&) = delete;
+
+        /**
+         * @brief Hand a memory region to the heap.
+         * @param memory Start of the region, any alignment.
+         * @param size Size of the region in bytes. Regions above 256 MB are truncated.
+         * @return true If the region was added, false if it is too small or maxRegions is reached.
+         */
+        bool addRegion(void* memory, const std::size_t size)
+        {
+            const std::uintptr_t start{ alignUp(reinterpret_cast<std::uintptr_t>(memory), alignment) };
+            const std::uintptr_t end{ (reinterpret_cast<std::uintptr_t>(memory) + size) & ~(alignment - 1) };
+            if (regionCount == maxRegions || end <= start || end - start < 2 * headerSize + minBlockSize) { return false; }
+
+            std::size_t payloadSize{ end - start - 2 * headerSize };
+            if (payloadSize > maxBlockSize) { payloadSize = maxBlockSize; }
+
+            Block* block{ reinterpret_cast<Block*>(start) };
+            block->prevPhysical = nullptr;
+            block->sizeAndFlags = payloadSize | freeFlag;
+
+            // Zero sized used block closing the region, so every block has a physical successor
+            Block* sentinel{ nextPhysical(block) };
+            sentinel->prevPhysical = block;
+            sentinel->sizeAndFlags = prevFreeFlag;
+
+            insertFree(block);
+            regions[regionCount++] = RegionBounds{ start, reinterpret_cast<std::uintptr_t>(sentinel) + headerSize };
+            statistics.totalBytes += payloadSize;
+            return true;
+        }
+
+        /**
+         * @brief Allocate size bytes aligned to TlsfHeap::alignment, in constant time.
+         * @return void* nullptr if no free block is large enough.
+         */
+        void* allocate(const std::size_t size)
+        {
+            if (size > maxBlockSize) { return fail(); }
+            const std::size_t adjusted{ adjustSize(size) };
+            Block* block{ findSuitable(adjusted) };
+            if (block == nullptr) { return fail(); }
+            removeFree(block);
+            return finishAllocation(block, adjusted);
+        }
+
+        /**
+         * @brief Allocate size bytes aligned to align, in constant time.
+         * @param align Power of two alignment.
+         * @return void* nullptr if no free block is large enough.
+         */
+        void* allocateAligned(const std::size_t size, const std::size_t align)
+        {
+            if (align <= alignment) { return allocate(size); }
+            if (size > maxBlockSize || align > maxBlockSize || (align & (align - 1)) != 0) { return fail(); }
+            const std::size_t adjusted{ adjustSize(size) };
+            const std::size_t gapMinimum{ headerSize + minBlockSize };
+            Block* block{ findSuitable(adjusted + align + gapMinimum) };
+            if (block == nullptr) { return fail(); }
+            removeFree(block);
+
+            const std::uintptr_t payload{ reinterpret_cast<std::uintptr_t>(toPayload(block)) };
+            std::uintptr_t aligned{ alignUp(payload, align) };
+            if (aligned != payload) {
+                if (aligned - payload < gapMinimum) { aligned = alignUp(payload + gapMinimum, align); }
+                // Leading gap becomes a free block of its own
+                const std::size_t gap{ aligned - payload };
+                Block* alignedBlock{ reinterpret_cast<Block*>(aligned - headerSize) };
+                alignedBlock->prevPhysical = block;
+                alignedBlock->sizeAndFlags = (block->size() - gap) | freeFlag | prevFreeFlag;
+                nextPhysical(alignedBlock)->prevPhysical = alignedBlock;
+                block->setSize(gap - headerSize);
+                insertFree(block);
+                block = alignedBlock;
+            }
+            return finishAllocation(block, adjusted);
+        }
+
+        /**
+         * @brief Release a block, merging it with its free neighbours, in constant time.
+         * @param pointer Value returned by allocate(), allocateAligned() or reallocate(). nullptr is ignored.
+         */
+        void deallocate(void* pointer)
+        {
+            if (pointer == nullptr) { return; }
+            Block* block{ fromPayload(pointer) };
+            statistics.usedBytes -= block->size();
+            block->setFree(true);
+
+            if (block->isPrevFree()) {
+                Block* previous{ block->prevPhysical };
+                removeFree(previous);
+                previous->setSize(previous->size() + headerSize + block->size());
+                block = previous;
+            }
+            Block* next{ nextPhysical(block) };
+            if (next->isFree()) {
+                removeFree(next);
+                block->setSize(block->size() + headerSize + next->size());
+                next = nextPhysical(block);
+            }
+            next->prevPhysical = block;
+            next->setPrevFree(true);
+            insertFree(block);
+        }
+
+        /**
+         * @brief Resize a block, in place when it or its free successor is large enough.
+         * @return void* The new block, nullptr if it could not be resized (the old block is kept).
+         */
+        void* reallocate(void* pointer, const std::size_t size)
+        {
+            if (pointer == nullptr) { return allocate(size); }
+            if (size == 0) {
+                deallocate(pointer);
+                return nullptr;
+            }
+            if (size > maxBlockSize) { return fail(); }
+            Block* block{ fromPayload(pointer) };
+            const std::size_t adjusted{ adjustSize(size) };
+            const std::size_t current{ block->size() };
+
+            Block* next{ nextPhysical(block) };
+            if (adjusted > current && next->isFree() && current + headerSize + next->size() >= adjusted) {
+                removeFree(next);
+                block->setSize(current + headerSize + next->size());
+                nextPhysical(block)->prevPhysical = block;
+                nextPhysical(block)->setPrevFree(false);
+                statistics.usedBytes += block->size() - current;
+            }
+            if (adjusted <= block->size()) {
+                trimUsed(block, adjusted);
+                if (statistics.usedBytes > statistics.peakUsedBytes) { statistics.peakUsedBytes = statistics.usedBytes; }
+                return pointer;
+            }
+
+            void* moved{ allocate(size) };
+            if (moved != nullptr) {
+                std::memcpy(moved, pointer, current);
+                deallocate(pointer);
+            }
+            return moved;
+        }
+
+        /**
+         * @brief Usable size of an allocated block, at least the requested size.
+         */
+        static std::size_t usableSize(void* pointer) { return pointer == nullptr ? 0 : fromPayload(pointer)->size(); }
+
+        /**
+         * @brief Check whether a pointer lies in one of the regions of this heap.
+         */
+        bool owns(const void* pointer) const
+        {
+            const std::uintptr_t address{ reinterpret_cast<std::uintptr_t>(pointer) };
+            for (std::size_t index = 0; index < regionCount; ++index) {
+                if (address >= regions[index].start && address < regions[index].end) { return true; }
+            }
+            return false;
+        }
+
+        /**
+         * @brief Current statistics. Only largestFreeBlock needs work: a walk of the highest non-empty list.
+         */
+        Statistics getStatistics() const
+        {
+            Statistics result{ statistics };
+            result.largestFreeBlock = 0;
+            if (flBitmap != 0) {
+                const std::size_t fl{ static_cast<std::size_t>(std::bit_width(flBitmap)) - 1 };
+                const std::size_t sl{ static_cast<std::size_t>(std::bit_width(slBitmap[fl])) - 1 };
+                for (const Block* block = freeLists[fl][sl]; block != nullptr; block = block->nextFree) {
+                    if (block->size() > result.largestFreeBlock) { result.largestFreeBlock = block->size(); }
+                }
+            }
+            return result;
+        }
+
+        /**
+         * @brief Walk every block of every region and check the heap invariants.
+         *
+         * Linear in the number of blocks, meant for tests and debug builds.
+         * @return true If physical links, flags, coalescing and the free lists are consistent.
+         */
+        bool check() const
+        {
+            std::size_t freeBlocks{ 0 };
+            std::size_t freeBytes{ 0 };
+            for (std::size_t index = 0; index < regionCount; ++index) {
+                Block* previous{ nullptr };
+                Block* block{ reinterpret_cast<Block*>(regions[index].start) };
+                while (true) {
+                    if (block->prevPhysical != previous) { return false; }
+                    if (previous != nullptr && block->isPrevFree() != previous->isFree()) { return false; }
+                    if (block->size() == 0) { break; }
+                    if (block->isFree()) {
+                        if (block->isPrevFree()) { return false; }
+                        ++freeBlocks;
+                        freeBytes += block->size();
+                    }
+                    previous = block;
+                    block = nextPhysical(block);
+                }
+                if (reinterpret_cast<std::uintptr_t>(block) + headerSize != regions[index].end) { return false; }
+            }
+            return freeBlocks == statistics.freeBlocks && freeBytes == statistics.freeBytes;
+        }
+    };
+};
+
+#endif // __TLSFHEAP_H__
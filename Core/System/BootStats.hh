@@ -0,0 +1,46 @@
+#ifndef __BOOTSTATS_H__
+#define __BOOTSTATS_H__
+
+/**
+ * @file BootStats.hh
+ * @brief Access to the boot time measured by Reset_Handler.
+ *
+ * Reset_Handler enables the DWT cycle counter as its first action and stores its
+ * value into __boot_cycles right before calling main(). The figure covers
+ * SystemInit(), the copy/zero tables and the static constructors.
+ */
+
+//<------------------------------INCLUDES------------------------------>//
+#include <cstdint>
+//<-------------------------------------------------------------------->//
+
+extern "C" {
+    /// Defined in startup_stm32h755xx.s
+    extern std::uint32_t __boot_cycles;
+}
+
+namespace BootStats
+{
+    /**
+     * @brief Get the number of core cycles spent between reset and main().
+     * @return std::uint32_t Cycles counted at the clock frequency(ies) active during boot.
+     */
+    inline std::uint32_t getBootCycles() { return __boot_cycles; }
+
+    /**
+     * @brief Convert the boot cycles into microseconds.
+     *
+     * There is no default clock: the CM7 leaves HSI (64 MHz) for the PLL inside SystemInit(),
+     * so the figure depends on the boot configuration, ClockTree::bootConfig.sysclkHz on the
+     * CM7 and its hclkHz on the CM4. The few cycles run on HSI before the switch are converted
+     * at the same clock, which slightly underestimates the boot time.
+     * @param coreClockHz Core clock after SystemInit().
+     * @return std::uint32_t Boot time in microseconds.
+     */
+    inline std::uint32_t getBootMicroseconds(const std::uint32_t coreClockHz)
+    {
+        return static_cast<std::uint32_t>((static_cast<std::uint64_t>(__boot_cycles) * 1000000U) / coreClockHz);
+    }
+};
+
+#endif // __BOOTSTATS_H__
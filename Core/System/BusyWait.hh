@@ -0,0 +1,28 @@
+#ifndef __BUSYWAIT_H__
+#define __BUSYWAIT_H__
+
+/**
+ * @file BusyWait.hh
+ * @brief Step of a polling loop: nothing on the target, a thread yield on the host.
+ *
+ * Host tests run the producer of what a loop waits for on another thread, or on the
+ * same CPU: yielding keeps the loop from starving it.
+ */
+
+//<------------------------------INCLUDES------------------------------>//
+#if !defined(CORE_CM7) && !defined(CORE_CM4)
+#include <thread>
+#endif
+//<-------------------------------------------------------------------->//
+
+namespace BusyWait
+{
+    inline void relax()
+    {
+        #if !defined(CORE_CM7) && !defined(CORE_CM4)
+            std::this_thread::yield();
+        #endif
+    }
+};
+
+#endif // __BUSYWAIT_H__
@@ -0,0 +1,209 @@
+#ifndef __CACHE_H__
+#define __CACHE_H__
+
+/**
+ * @file Cache.hh
+ * @brief L1 cache enablement and range based cache maintenance for DMA buffers.
+ *
+ * On the CM7 the I- and D-caches are enabled at boot and the maintenance functions
+ * wrap the CMSIS SCB_*DCache_by_Addr functions of core_cm7.h. The CM4 has no L1 cache:
+ * enable() turns on the ART accelerator for its flash bank instead, and the maintenance
+ * functions compile to nothing. The same holds for host builds, where no core is defined.
+ *
+ * Rules for DMA buffers living in cacheable memory:
+ *  - clean() before a DMA reads memory written by the CPU (TX).
+ *  - invalidate() after a DMA wrote memory the CPU is going to read (RX).
+ *
+ * Usage example:
+ * ```
+ * DMA_BUFFER CacheAlignedBuffer<uint8_t, 100> rxBuffer; // 128 bytes, 4 whole lines
+ * // ... DMA transfer complete ...
+ * rxBuffer.invalidate();
+ * ```
+ */
+
+//<------------------------------INCLUDES------------------------------>//
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#if defined(CORE_CM7) || defined(CORE_CM4)
+#include <stm32h755xx.h>
+#endif
+//<-------------------------------------------------------------------->//
+
+namespace Cache
+{
+    /// Cortex-M7 L1 data cache line size in bytes.
+    inline constexpr std::size_t lineSize{ 32 };
+
+    /// Base address of the flash bank cached by the CM4 ART accelerator.
+    inline constexpr std::uint32_t cm4FlashBase{ 0x08100000 };
+
+    /**
+     * @brief Round an address down to the start of its cache line.
+     * @param address Address to align.
+     * @return std::uintptr_t Start of the line containing address.
+     */
+    constexpr std::uintptr_t alignDown(const std::uintptr_t address) { return address & ~(lineSize - 1); }
+
+    /**
+     * @brief Round an address up to the next cache line boundary.
+     * @param address Address to align.
+     * @return std::uintptr_t address if already aligned, otherwise the start of the next line.
+     */
+    constexpr std::uintptr_t alignUp(const std::uintptr_t address) { return (address + lineSize - 1) & ~(lineSize - 1); }
+
+    /**
+     * @brief Round a size up to a whole number of cache lines.
+     * @param size Size in bytes.
+     * @return std::size_t Size in bytes, multiple of lineSize.
+     */
+    constexpr std::size_t roundUpToLines(const std::size_t size) { return (size + lineSize - 1) & ~(lineSize - 1); }
+
+    /**
+     * @brief Enable the caches of the running core.
+     *
+     * CM7: invalidate and enable the I- and D-cache. CM4: enable the ART accelerator
+     * on flash bank 2. Safe to call from SystemInit(), it does not use any RAM data.
+     */
+    inline void enable()
+    {
+        #if defined(CORE_CM7)
+            SCB_EnableICache();
+            SCB_EnableDCache();
+        #elif defined(CORE_CM4)
+            RCC->AHB1ENR = RCC->AHB1ENR | RCC_AHB1ENR_ARTEN;
+            ART->CTR = (ART->CTR & ~ART_CTR_PCACHEADDR) | ((cm4FlashBase >> 12U) & ART_CTR_PCACHEADDR);
+            ART->CTR = ART->CTR | ART_CTR_EN;
+        #endif
+    }
+
+    /**
+     * @brief Clean (write back) and disable the caches of the running core.
+     */
+    inline void disable()
+    {
+        #if defined(CORE_CM7)
+            SCB_DisableDCache();
+            SCB_DisableICache();
+        #elif defined(CORE_CM4)
+            ART->CTR = ART->CTR & ~ART_CTR_EN;
+        #endif
+    }
+
+    /**
+     * @brief Write back the lines covering [address, address + size) to memory.
+     *
+     * Cleaning never loses data, so the range is simply widened to whole lines.
+     * @param address First byte of the range.
+     * @param size Size of the range in bytes.
+     */
+    inline void clean([[maybe_unused]] const void* address, [[maybe_unused]] const std::size_t size)
+    {
+        #if defined(CORE_CM7)
+            if (size == 0) { return; }
+            const std::uintptr_t start{ alignDown(reinterpret_cast<std::uintptr_t>(address)) };
+            const std::uintptr_t end{ alignUp(reinterpret_cast<std::uintptr_t>(address) + size) };
+            SCB_CleanDCache_by_Addr(reinterpret_cast<uint32_t*>(start), static_cast<int32_t>(end - start));
+        #endif
+    }
+
+    /**
+     * @brief Write back then discard the lines covering [address, address + size).
+     * @param address First byte of the range.
+     * @param size Size of the range in bytes.
+     */
+    inline void cleanInvalidate([[maybe_unused]] const void* address, [[maybe_unused]] const std::size_t size)
+    {
+        #if defined(CORE_CM7)
+            if (size == 0) { return; }
+            const std::uintptr_t start{ alignDown(reinterpret_cast<std::uintptr_t>(address)) };
+            const std::uintptr_t end{ alignUp(reinterpret_cast<std::uintptr_t>(address) + size) };
+            SCB_CleanInvalidateDCache_by_Addr(reinterpret_cast<uint32_t*>(start), static_cast<int32_t>(end - start));
+        #endif
+    }
+
+    /**
+     * @brief Discard the cached copy of [address, address + size) so the next read comes from memory.
+     *
+     * Only whole lines inside the range are invalidated. A partial line at either end
+     * is shared with a neighbouring object, so it is cleaned and invalidated instead:
+     * its bytes outside the range are written back rather than silently dropped.
+     * @param address First byte of the range.
+     * @param size Size of the range in bytes.
+     */
+    inline void invalidate([[maybe_unused]] const void* address, [[maybe_unused]] const std::size_t size)
+    {
+        #if defined(CORE_CM7)
+            if (size == 0) { return; }
+            std::uintptr_t start{ reinterpret_cast<std::uintptr_t>(address) };
+            std::uintptr_t end{ start + size };
+            if (start != alignDown(start)) {
+                SCB_CleanInvalidateDCache_by_Addr(reinterpret_cast<uint32_t*>(alignDown(start)), static_cast<int32_t>(lineSize));
+                start = alignUp(start);
+            }
+            if (end != alignDown(end) && alignDown(end) >= start) {
+                SCB_CleanInvalidateDCache_by_Addr(reinterpret_cast<uint32_t*>(alignDown(end)), static_cast<int32_t>(lineSize));
+                end = alignDown(end);
+            }
+            if (end > start) {
+                SCB_InvalidateDCache_by_Addr(reinterpret_cast<void*>(start), static_cast<int32_t>(end - start));
+            }
+        #endif
+    }
+};
+
+/**
+ * @brief Array of N elements of type T that owns whole cache lines.
+ *
+ * The buffer starts on a line boundary and its size is padded up to a multiple of
+ * the line size, so cache maintenance on it never touches another object and can use
+ * plain invalidation on RX paths.
+ *
+ * @tparam T Element type, must be trivially copyable since a DMA writes it.
+ * @tparam N Number of elements.
+ */
+template<typename T, std::size_t N>
+requires (std::is_trivially_copyable_v<T> && N > 0)
+class alignas(Cache::lineSize) CacheAlignedBuffer
+{
+private:
+    T elements[N];
+
+public:
+    using ValueType = T;
+
+    /// Number of usable elements.
+    static constexpr std::size_t size() { return N; }
+
+    /// Number of usable bytes, excluding the padding.
+    static constexpr std::size_t sizeBytes() { return N * sizeof(T); }
+
+    /// Number of bytes owned, padding included. Always a multiple of the line size.
+    static constexpr std::size_t capacityBytes() { return Cache::roundUpToLines(sizeBytes()); }
+
+    constexpr T* data() { return elements; }
+    constexpr const T* data() const { return elements; }
+
+    constexpr T& operator[](const std::size_t index) { return elements[index]; }
+    constexpr const T& operator[](const std::size_t index) const { return elements[index]; }
+
+    constexpr T* begin() { return elements; }
+    constexpr T* end() { return elements + N; }
+    constexpr const T* begin() const { return elements; }
+    constexpr const T* end() const { return elements + N; }
+
+    /// Write the buffer back to memory before a DMA reads it.
+    void clean() const { Cache::clean(this, capacityBytes()); }
+
+    /// Drop the cached copy after a DMA wrote the buffer. Only the buffer's own lines are affected.
+    void invalidate() const { Cache::invalidate(this, capacityBytes()); }
+
+    /// Write back then drop the cached copy.
+    void cleanInvalidate() const { Cache::cleanInvalidate(this, capacityBytes()); }
+};
+
+static_assert(sizeof(CacheAlignedBuffer<std::uint8_t, 100>) == 128, "CacheAlignedBuffer must be padded to whole cache lines");
+static_assert(alignof(CacheAlignedBuffer<std::uint32_t, 1>) == Cache::lineSize, "CacheAlignedBuffer must start on a cache line");
+
+#endif // __CACHE_H__
@@ -0,0 +1,493 @@
+#ifndef __CLOCKTREE_H__
+#define __CLOCKTREE_H__
+
+/**
+ * @file ClockTree.hh
+ * @brief Compile-time solver for the STM32H755 clock tree and the routine applying its result.
+ *
+ * ClockTree::solve() takes a ClockRequest (PLL source, SYSCLK, HCLK, APB and the PLL
+ * outputs used as peripheral kernel clocks) and searches the DIVM/DIVN/DIVP/DIVQ/DIVR
+ * dividers of PLL1, PLL2 and PLL3 for exact matches. It then picks the lowest voltage
+ * scale able to run the requested frequencies, the bus prescalers and the flash wait
+ * states. Every limit comes from RM0399 (rev V devices) and is listed below, so the
+ * solver runs unchanged on the host for unit testing.
+ *
+ * Usage example:
+ * ```
+ * constexpr ClockTree::ClockConfig config{ ClockTree::solve(ClockTree::ClockRequest{ .sysclkHz = 400000000 }) };
+ * static_assert(config.isValid());
+ * ClockTree::apply(config);
+ * ```
+ */
+
+//<------------------------------INCLUDES------------------------------>//
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#if defined(CORE_CM7) || defined(CORE_CM4)
+#include <stm32h755xx.h>
+#endif
+//<-------------------------------------------------------------------->//
+
+namespace ClockTree
+{
+    enum class PllSource : std::uint8_t { hsi, csi, hse };
+    enum class PowerSupply : std::uint8_t { ldo, smpsDirect };
+    enum class VoltageScale : std::uint8_t { vos0, vos1, vos2, vos3 };
+    enum class PllOutput : std::uint8_t { p, q, r };
+
+    /**
+     * @brief Reason a request could not be solved.
+     */
+    enum class SolveError : std::uint8_t {
+        none,
+        invalidSource,          ///< Source frequency missing or out of range.
+        sysclkTooHigh,          ///< No voltage scale allowed by the supply runs SYSCLK.
+        noPll1Solution,         ///< No divider set of PLL1 produces SYSCLK and its Q/R outputs exactly.
+        noPll2Solution,         ///< No divider set of PLL2 produces the requested outputs exactly.
+        noPll3Solution,         ///< No divider set of PLL3 produces the requested outputs exactly.
+        invalidHclk,            ///< HCLK is not SYSCLK divided by 1, 2, 4, 8, 16, 64, 128, 256 or 512.
+        hclkTooHigh,            ///< HCLK above the limit of the selected voltage scale.
+        invalidApb              ///< No APB prescaler brings the APB clocks below the limit.
+    };
+
+    // Oscillators
+    inline constexpr std::uint32_t hsiHz{ 64000000 };
+    inline constexpr std::uint32_t csiHz{ 4000000 };
+    inline constexpr std::uint32_t hseMinHz{ 4000000 };
+    inline constexpr std::uint32_t hseMaxHz{ 50000000 };
+
+    // PLL limits, RM0399 section 8.5.6 and the datasheet PLL characteristics
+    inline constexpr std::uint32_t divmMax{ 63 };
+    inline constexpr std::uint32_t divnMin{ 4 };
+    inline constexpr std::uint32_t divnMax{ 512 };
+    inline constexpr std::uint32_t divOutMax{ 128 };
+    inline constexpr std::uint32_t refMinHz{ 1000000 };
+    inline constexpr std::uint32_t refMaxHz{ 16000000 };
+    inline constexpr std::uint32_t wideVcoRefMinHz{ 2000000 };
+    inline constexpr std::uint32_t wideVcoMinHz{ 192000000 };
+    inline constexpr std::uint32_t wideVcoMaxHz{ 960000000 };
+    inline constexpr std::uint32_t mediumVcoMinHz{ 150000000 };
+    inline constexpr std::uint32_t mediumVcoMaxHz{ 420000000 };
+
+    /**
+     * @brief Frequency limits of one voltage scale.
+     */
+    struct ScaleLimits {
+        VoltageScale scale;
+        std::uint32_t sysclkMaxHz;
+        std::uint32_t hclkMaxHz;
+        std::uint32_t apbMaxHz;
+    };
+
+    /// Limits ordered from the lowest to the highest power scale.
+    inline constexpr std::array<ScaleLimits, 4> scaleLimits{ {
+        { VoltageScale::vos3, 200000000, 100000000,  50000000 },
+        { VoltageScale::vos2, 300000000, 150000000,  75000000 },
+        { VoltageScale::vos1, 400000000, 200000000, 100000000 },
+        { VoltageScale::vos0, 480000000, 240000000, 120000000 },
+    } };
+
+    /**
+     * @brief One row of the flash access table: wait states and programming delay up to an AXI clock.
+     */
+    struct FlashTiming {
+        std::uint32_t latency;                  ///< FLASH_ACR LATENCY, wait states.
+        std::uint32_t programmingDelay;         ///< FLASH_ACR WRHIGHFREQ.
+        std::array<std::uint32_t, 4> maxHz;     ///< Highest AXI clock per VoltageScale (vos0..vos3), 0 when the row does not apply.
+    };
+
+    /// RM0399 table 15, rows ordered by increasing AXI clock. Each row starts above the previous applicable one.
+    inline constexpr std::array<FlashTiming, 6> flashTimings{ {
+        //  LATENCY, WRHIGHFREQ,       VOS0,      VOS1,      VOS2,      VOS3
+        { 0, 0, {  70000000,  70000000,  55000000,  45000000 } },
+        { 1, 1, { 140000000, 140000000, 110000000,  90000000 } },
+        { 2, 1, { 185000000, 185000000, 165000000, 135000000 } },
+        { 2, 2, { 210000000, 210000000,         0,         0 } },
+        { 3, 2, { 225000000, 225000000, 225000000, 180000000 } },
+        { 4, 2, { 240000000,         0,         0, 225000000 } },
+    } };
+
+    /**
+     * @brief Flash access timing for an AXI clock in a voltage scale.
+     * @return const FlashTiming* Row of flashTimings, nullptr if the clock is above the table.
+     */
+    constexpr const FlashTiming* flashTiming(const VoltageScale scale, const std::uint32_t hclkHz)
+    {
+        for (const FlashTiming& timing : flashTimings) {
+            const std::uint32_t maxHz{ timing.maxHz[static_cast<std::size_t>(scale)] };
+            if (maxHz != 0 && hclkHz <= maxHz) { return &timing; }
+        }
+        return nullptr;
+    }
+
+    /// Dividers available for D1CPRE and HPRE.
+    inline constexpr std::array<std::uint32_t, 9> ahbDividers{ 1, 2, 4, 8, 16, 64, 128, 256, 512 };
+
+    /// Dividers available for D1PPRE, D2PPRE1, D2PPRE2 and D3PPRE.
+    inline constexpr std::array<std::uint32_t, 5> apbDividers{ 1, 2, 4, 8, 16 };
+
+    /**
+     * @brief Requested clock tree. Frequencies in Hz, 0 means "output not used".
+     */
+    struct ClockRequest {
+        PllSource source{ PllSource::hsi };
+        std::uint32_t hseHz{ 0 };                                   ///< Only used with PllSource::hse.
+        PowerSupply supply{ PowerSupply::ldo };
+        std::uint32_t sysclkHz{ 0 };                                ///< PLL1 P output, the CM7 clock.
+        std::uint32_t hclkHz{ 0 };                                  ///< AXI/AHB clock, also the CM4 clock. 0 selects the highest allowed.
+        std::uint32_t apbHz{ 0 };                                   ///< Upper bound for all APB clocks. 0 selects the highest allowed.
+        std::array<std::uint32_t, 3> pll1{ 0, 0, 0 };               ///< P (ignored, SYSCLK), Q, R.
+        std::array<std::uint32_t, 3> pll2{ 0, 0, 0 };               ///< P, Q, R.
+        std::array<std::uint32_t, 3> pll3{ 0, 0, 0 };               ///< P, Q, R.
+    };
+
+    /**
+     * @brief Dividers of one PLL.
+     */
+    struct PllConfig {
+        bool enabled{ false };
+        std::uint32_t m{ 0 };
+        std::uint32_t n{ 0 };
+        std::array<std::uint32_t, 3> div{ 0, 0, 0 };               ///< P, Q, R, 0 when the output is disabled.
+        std::uint32_t refHz{ 0 };
+        std::uint32_t vcoHz{ 0 };
+        bool wideVco{ true };
+
+        /// Frequency of one output, 0 when disabled.
+        constexpr std::uint32_t outputHz(const PllOutput output) const
+        {
+            const std::uint32_t divider{ div[static_cast<std::size_t>(output)] };
+            return (enabled && divider != 0) ? vcoHz / divider : 0;
+        }
+
+        /// RCC_PLLCFGR PLLxRGE encoding of the reference frequency.
+        constexpr std::uint32_t inputRange() const
+        {
+            if (refHz < 2000000) { return 0; }
+            if (refHz < 4000000) { return 1; }
+            if (refHz < 8000000) { return 2; }
+            return 3;
+        }
+    };
+
+    /**
+     * @brief Result of the solver, every value needed to program the clock tree.
+     */
+    struct ClockConfig {
+        SolveError error{ SolveError::none };
+        PllSource source{ PllSource::hsi };
+        std::uint32_t sourceHz{ 0 };
+        PowerSupply supply{ PowerSupply::ldo };
+        VoltageScale scale{ VoltageScale::vos3 };
+        std::array<PllConfig, 3> pll{};
+        std::uint32_t sysclkHz{ 0 };
+        std::uint32_t hclkHz{ 0 };
+        std::uint32_t apbHz{ 0 };
+        std::uint32_t hpre{ 1 };
+        std::uint32_t ppre{ 1 };                                    ///< Same divider for D1PPRE, D2PPRE1, D2PPRE2 and D3PPRE.
+        std::uint32_t flashLatency{ 0 };
+        std::uint32_t flashProgrammingDelay{ 0 };
+
+        constexpr bool isValid() const { return error == SolveError::none; }
+    };
+
+    /**
+     * @brief Frequency of a PLL source.
+     * @return std::uint32_t Frequency in Hz, 0 if the source is not usable.
+     */
+    constexpr std::uint32_t sourceFrequency(const PllSource source, const std::uint32_t hseHz)
+    {
+        switch (source) {
+            case PllSource::hsi: return hsiHz;
+            case PllSource::csi: return csiHz;
+            case PllSource::hse: return (hseHz >= hseMinHz && hseHz <= hseMaxHz) ? hseHz : 0;
+        }
+        return 0;
+    }
+
+    /**
+     * @brief Check the divider producing one output is allowed.
+     * @param isPll1P DIVP1 only accepts even values.
+     */
+    constexpr bool isOutputDividerValid(const std::uint32_t divider, const bool isPll1P)
+    {
+        if (divider < 1 || divider > divOutMax) { return false; }
+        return !isPll1P || (divider % 2) == 0;
+    }
+
+    /**
+     * @brief Search the dividers of one PLL producing all requested outputs exactly.
+     *
+     * The search prefers the highest reference frequency (lowest DIVM, less jitter)
+     * then the lowest VCO frequency (less power).
+     * @param sourceHz PLL source frequency.
+     * @param targets Requested P, Q, R frequencies, 0 for unused outputs.
+     * @param isPll1 Apply the DIVP1 even divider rule.
+     * @return PllConfig enabled == false if no solution exists or no output is requested.
+     */
+    constexpr PllConfig solvePll(const std::uint32_t sourceHz, const std::array<std::uint32_t, 3>& targets, const bool isPll1)
+    {
+        PllConfig result{};
+        if (targets[0] == 0 && targets[1] == 0 && targets[2] == 0) { return result; }
+
+        for (std::uint32_t m = 1; m <= divmMax; ++m) {
+            if (sourceHz % m != 0) { continue; }
+            const std::uint32_t refHz{ sourceHz / m };
+            if (refHz < refMinHz || refHz > refMaxHz) { continue; }
+            const bool wideVco{ refHz >= wideVcoRefMinHz };
+            const std::uint64_t vcoMin{ wideVco ? wideVcoMinHz : mediumVcoMinHz };
+            const std::uint64_t vcoMax{ wideVco ? wideVcoMaxHz : mediumVcoMaxHz };
+
+            for (std::uint32_t n = divnMin; n <= divnMax; ++n) {
+                const std::uint64_t vcoHz{ std::uint64_t{ refHz } * n };
+                if (vcoHz < vcoMin) { continue; }
+                if (vcoHz > vcoMax) { break; }
+
+                std::array<std::uint32_t, 3> div{ 0, 0, 0 };
+                bool matches{ true };
+                for (std::size_t output = 0; output < targets.size() && matches; ++output) {
+                    if (targets[output] == 0) { continue; }
+                    const std::uint64_t divider{ vcoHz / targets[output] };
+                    matches = (vcoHz % targets[output] == 0) &&
+                              isOutputDividerValid(static_cast<std::uint32_t>(divider), isPll1 && output == 0);
+                    div[output] = static_cast<std::uint32_t>(divider);
+                }
+                if (matches) {
+                    result.enabled = true;
+                    result.m = m;
+                    result.n = n;
+                    result.div = div;
+                    result.refHz = refHz;
+                    result.vcoHz = static_cast<std::uint32_t>(vcoHz);
+                    result.wideVco = wideVco;
+                    return result;
+                }
+            }
+        }
+        return result;
+    }
+
+    /**
+     * @brief Solve a whole clock tree request.
+     * @param request Requested frequencies.
+     * @return ClockConfig error != SolveError::none if the request cannot be met.
+     */
+    constexpr ClockConfig solve(const ClockRequest& request)
+    {
+        ClockConfig config{};
+        config.source = request.source;
+        config.supply = request.supply;
+        config.sourceHz = sourceFrequency(request.source, request.hseHz);
+        if (config.sourceHz == 0 || request.sysclkHz == 0) {
+            config.error = SolveError::invalidSource;
+            return config;
+        }
+
+        // Lowest power voltage scale running SYSCLK. VOS0 needs the LDO to supply VCORE.
+        const ScaleLimits* limits{ nullptr };
+        for (const ScaleLimits& candidate : scaleLimits) {
+            if (candidate.scale == VoltageScale::vos0 && request.supply != PowerSupply::ldo) { continue; }
+            if (request.sysclkHz <= candidate.sysclkMaxHz) { limits = &candidate; break; }
+        }
+        if (limits == nullptr) {
+            config.error = SolveError::sysclkTooHigh;
+            return config;
+        }
+
+        config.pll[0] = solvePll(config.sourceHz, { request.sysclkHz, request.pll1[1], request.pll1[2] }, true);
+        if (!config.pll[0].enabled) {
+            config.error = SolveError::noPll1Solution;
+            return config;
+        }
+        config.pll[1] = solvePll(config.sourceHz, request.pll2, false);
+        if (!config.pll[1].enabled && (request.pll2[0] | request.pll2[1] | request.pll2[2]) != 0) {
+            config.error = SolveError::noPll2Solution;
+            return config;
+        }
+        config.pll[2] = solvePll(config.sourceHz, request.pll3, false);
+        if (!config.pll[2].enabled && (request.pll3[0] | request.pll3[1] | request.pll3[2]) != 0) {
+            config.error = SolveError::noPll3Solution;
+            return config;
+        }
+        config.sysclkHz = config.pll[0].outputHz(PllOutput::p);
+
+        // HCLK: the requested value, or the fastest one allowed by the scale.
+        config.hpre = 0;
+        for (const std::uint32_t divider : ahbDividers) {
+            const std::uint32_t hclkHz{ config.sysclkHz / divider };
+            if (config.sysclkHz % divider != 0) { continue; }
+            if (request.hclkHz != 0 ? hclkHz == request.hclkHz : hclkHz <= limits->hclkMaxHz) {
+                config.hpre = divider;
+                config.hclkHz = hclkHz;
+                break;
+            }
+        }
+        if (config.hpre == 0) {
+            config.error = SolveError::invalidHclk;
+            return config;
+        }
+
+        // Raise the scale if HCLK needs it, never above what the supply allows.
+        while (config.hclkHz > limits->hclkMaxHz) {
+            if (limits == &scaleLimits.back() ||
+                ((limits + 1)->scale == VoltageScale::vos0 && request.supply != PowerSupply::ldo)) {
+                config.error = SolveError::hclkTooHigh;
+                return config;
+            }
+            ++limits;
+        }
+        config.scale = limits->scale;
+
+        // APB: the fastest clock below both the scale limit and the request.
+        const std::uint32_t apbMaxHz{ (request.apbHz != 0 && request.apbHz < limits->apbMaxHz) ? request.apbHz : limits->apbMaxHz };
+        config.ppre = 0;
+        for (const std::uint32_t divider : apbDividers) {
+            if (config.hclkHz / divider <= apbMaxHz) {
+                config.ppre = divider;
+                config.apbHz = config.hclkHz / divider;
+                break;
+            }
+        }
+        if (config.ppre == 0) {
+            config.error = SolveError::invalidApb;
+            return config;
+        }
+
+        // Flash wait states and programming delay. hclkMaxHz of every scale is inside the table.
+        const FlashTiming* const timing{ flashTiming(config.scale, config.hclkHz) };
+        config.flashLatency = timing->latency;
+        config.flashProgrammingDelay = timing->programmingDelay;
+        return config;
+    }
+
+    /// Highest performance configuration: CM7 at 480 MHz, AXI/AHB and CM4 at 240 MHz, APB at 120 MHz, from HSI.
+    inline constexpr ClockRequest bootRequest{
+        .source = PllSource::hsi,
+        .supply = PowerSupply::ldo,
+        .sysclkHz = 480000000,
+        .hclkHz = 240000000,
+        .apbHz = 120000000,
+        .pll1 = { 0, 240000000, 0 },
+    };
+
+    /// Solution of bootRequest, applied by the CM7 from SystemInit().
+    inline constexpr ClockConfig bootConfig{ solve(bootRequest) };
+    static_assert(bootConfig.isValid(), "The boot clock request has no solution");
+
+    /**
+     * @brief RCC encoding of D1CPRE/HPRE dividers.
+     */
+    constexpr std::uint32_t ahbPrescalerBits(const std::uint32_t divider)
+    {
+        switch (divider) {
+            case 2:   return 0b1000;
+            case 4:   return 0b1001;
+            case 8:   return 0b1010;
+            case 16:  return 0b1011;
+            case 64:  return 0b1100;
+            case 128: return 0b1101;
+            case 256: return 0b1110;
+            case 512: return 0b1111;
+            default:  return 0b0000;
+        }
+    }
+
+    /**
+     * @brief RCC encoding of the APB prescaler dividers.
+     */
+    constexpr std::uint32_t apbPrescalerBits(const std::uint32_t divider)
+    {
+        switch (divider) {
+            case 2:  return 0b100;
+            case 4:  return 0b101;
+            case 8:  return 0b110;
+            case 16: return 0b111;
+            default: return 0b000;
+        }
+    }
+
+    /**
+     * @brief Program the supply, voltage scale, PLLs, prescalers and flash latency, then switch SYSCLK to PLL1.
+     *
+     * Must run on the CM7 right after reset, with SYSCLK still on HSI. Does not use RAM data,
+     * so it can be called from SystemInit(). Compiles to nothing on the host.
+     * @param config Valid solver result.
+     */
+    inline void apply([[maybe_unused]] const ClockConfig& config)
+    {
+        #if defined(CORE_CM7)
+            // Supply configuration, PWR_CR3 can only be written once after power on
+            const std::uint32_t supply{ static_cast<std::uint32_t>(config.supply == PowerSupply::ldo ? PWR_CR3_LDOEN : PWR_CR3_SMPSEN) };
+            PWR->CR3 = (PWR->CR3 & ~(PWR_CR3_SMPSEN | PWR_CR3_LDOEN | PWR_CR3_BYPASS)) | supply;
+            while ((PWR->CSR1 & PWR_CSR1_ACTVOSRDY) == 0) { }
+
+            // Voltage scale, VOS0 is VOS1 plus the SYSCFG overdrive
+            constexpr std::array<std::uint32_t, 4> vosBits{ 0b11, 0b11, 0b10, 0b01 };
+            PWR->D3CR = (PWR->D3CR & ~PWR_D3CR_VOS_Msk) | (vosBits[static_cast<std::size_t>(config.scale)] << PWR_D3CR_VOS_Pos);
+            while ((PWR->D3CR & PWR_D3CR_VOSRDY) == 0) { }
+            if (config.scale == VoltageScale::vos0) {
+                RCC->APB4ENR = RCC->APB4ENR | RCC_APB4ENR_SYSCFGEN;
+                SYSCFG->PWRCR = SYSCFG->PWRCR | SYSCFG_PWRCR_ODEN;
+                while ((PWR->D3CR & PWR_D3CR_VOSRDY) == 0) { }
+            }
+
+            // PLL source
+            std::uint32_t pllSource{ 0 };
+            if (config.source == PllSource::csi) {
+                RCC->CR = RCC->CR | RCC_CR_CSION;
+                while ((RCC->CR & RCC_CR_CSIRDY) == 0) { }
+                pllSource = 1;
+            } else if (config.source == PllSource::hse) {
+                RCC->CR = RCC->CR | RCC_CR_HSEON;
+                while ((RCC->CR & RCC_CR_HSERDY) == 0) { }
+                pllSource = 2;
+            }
+            RCC->PLLCKSELR = (pllSource << RCC_PLLCKSELR_PLLSRC_Pos) |
+                             (config.pll[0].m << RCC_PLLCKSELR_DIVM1_Pos) |
+                             (config.pll[1].m << RCC_PLLCKSELR_DIVM2_Pos) |
+                             (config.pll[2].m << RCC_PLLCKSELR_DIVM3_Pos);
+
+            // Dividers, ranges and output enables of the three PLLs
+            volatile uint32_t* const divRegisters[3]{ &RCC->PLL1DIVR, &RCC->PLL2DIVR, &RCC->PLL3DIVR };
+            constexpr std::array<std::uint32_t, 3> pllOn{ RCC_CR_PLL1ON, RCC_CR_PLL2ON, RCC_CR_PLL3ON };
+            constexpr std::array<std::uint32_t, 3> pllReady{ RCC_CR_PLL1RDY, RCC_CR_PLL2RDY, RCC_CR_PLL3RDY };
+            std::uint32_t pllcfgr{ 0 };
+            for (std::size_t index = 0; index < config.pll.size(); ++index) {
+                const PllConfig& pll{ config.pll[index] };
+                if (!pll.enabled) { continue; }
+                *divRegisters[index] = ((pll.n - 1) << RCC_PLL1DIVR_N1_Pos) |
+                                       ((pll.div[0] == 0 ? 1 : pll.div[0] - 1) << RCC_PLL1DIVR_P1_Pos) |
+                                       ((pll.div[1] == 0 ? 1 : pll.div[1] - 1) << RCC_PLL1DIVR_Q1_Pos) |
+                                       ((pll.div[2] == 0 ? 1 : pll.div[2] - 1) << RCC_PLL1DIVR_R1_Pos);
+                pllcfgr |= (pll.inputRange() << (RCC_PLLCFGR_PLL1RGE_Pos + 4 * index)) |
+                           ((pll.wideVco ? 0U : 1U) << (RCC_PLLCFGR_PLL1VCOSEL_Pos + 4 * index));
+                for (std::size_t output = 0; output < pll.div.size(); ++output) {
+                    if (pll.div[output] != 0) { pllcfgr |= 1U << (RCC_PLLCFGR_DIVP1EN_Pos + 3 * index + output); }
+                }
+            }
+            RCC->PLLCFGR = pllcfgr;
+            for (std::size_t index = 0; index < config.pll.size(); ++index) {
+                if (!config.pll[index].enabled) { continue; }
+                RCC->CR = RCC->CR | pllOn[index];
+                while ((RCC->CR & pllReady[index]) == 0) { }
+            }
+
+            // Flash wait states before raising the clock
+            FLASH->ACR = (config.flashLatency << FLASH_ACR_LATENCY_Pos) | (config.flashProgrammingDelay << FLASH_ACR_WRHIGHFREQ_Pos);
+            while (((FLASH->ACR & FLASH_ACR_LATENCY_Msk) >> FLASH_ACR_LATENCY_Pos) != config.flashLatency) { }
+
+            // Bus prescalers, D1CPRE stays at 1 so the CM7 runs at SYSCLK
+            const std::uint32_t ppre{ apbPrescalerBits(config.ppre) };
+            RCC->D1CFGR = (ahbPrescalerBits(config.hpre) << RCC_D1CFGR_HPRE_Pos) | (ppre << RCC_D1CFGR_D1PPRE_Pos);
+            RCC->D2CFGR = (ppre << RCC_D2CFGR_D2PPRE1_Pos) | (ppre << RCC_D2CFGR_D2PPRE2_Pos);
+            RCC->D3CFGR = (ppre << RCC_D3CFGR_D3PPRE_Pos);
+
+            // Switch SYSCLK to PLL1 P
+            RCC->CFGR = (RCC->CFGR & ~RCC_CFGR_SW_Msk) | (0b011 << RCC_CFGR_SW_Pos);
+            while (((RCC->CFGR & RCC_CFGR_SWS_Msk) >> RCC_CFGR_SWS_Pos) != 0b011) { }
+        #endif
+    }
+};
+
+#endif // __CLOCKTREE_H__
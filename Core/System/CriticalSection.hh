@@ -0,0 +1,52 @@
+#ifndef __CRITICALSECTION_H__
+#define __CRITICALSECTION_H__
+
+/**
+ * @file CriticalSection.hh
+ * @brief Scoped interrupt masking for short sections shared with ISRs.
+ *
+ * The previous PRIMASK value is restored on exit, so critical sections nest. Host
+ * builds have no interrupts and the guard does nothing.
+ *
+ * Usage example:
+ * ```
+ * {
+ *     CriticalSection guard;
+ *     // ... code that must not be interrupted ...
+ * }
+ * ```
+ */
+
+//<------------------------------INCLUDES------------------------------>//
+#include <cstdint>
+#if defined(__arm__)
+#include <cmsis_compiler.h>
+#endif
+//<-------------------------------------------------------------------->//
+
+class CriticalSection
+{
+private:
+    std::uint32_t primask{ 0 };
+
+public:
+    CriticalSection()
+    {
+        #if defined(__arm__)
+            primask = __get_PRIMASK();
+            __disable_irq();
+        #endif
+    }
+
+    ~CriticalSection()
+    {
+        #if defined(__arm__)
+            __set_PRIMASK(primask);
+        #endif
+    }
+
+    CriticalSection(const CriticalSection&) = delete;
+    CriticalSection& operator=(const CriticalSection&) = delete;
+};
+
+#endif // __CRITICALSECTION_H__
@@ -0,0 +1,36 @@
+#ifndef __CYCLECOUNTER_H__
+#define __CYCLECOUNTER_H__
+
+/**
+ * @file CycleCounter.hh
+ * @brief Free-running 32-bit timestamp of the calling core.
+ *
+ * On the target it reads the DWT cycle counter, started by Reset_Handler, so it counts
+ * core clock cycles: a CM7 stamp and a CM4 stamp are not comparable. On the host it
+ * counts nanoseconds, which lets code measuring durations run unchanged in tests.
+ * Differences of two stamps are valid across a wrap of the counter.
+ */
+
+//<------------------------------INCLUDES------------------------------>//
+#include <cstdint>
+#if defined(CORE_CM7) || defined(CORE_CM4)
+#include <stm32h755xx.h>
+#else
+#include <chrono>
+#endif
+//<-------------------------------------------------------------------->//
+
+namespace CycleCounter
+{
+    inline std::uint32_t now()
+    {
+        #if defined(CORE_CM7) || defined(CORE_CM4)
+            return DWT->CYCCNT;
+        #else
+            return static_cast<std::uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+        #endif
+    }
+};
+
+#endif // __CYCLECOUNTER_H__
@@ -0,0 +1,318 @@
+#ifndef __DUALCOREBOOT_H__
+#define __DUALCOREBOOT_H__
+
+/**
+ * @file DualCoreBoot.hh
+ * @brief Boot protocol keeping the CM4 parked while the CM7 brings the system up.
+ *
+ * Both cores leave reset together. Without coordination the CM4 runs its startup on
+ * the reset clocks while the CM7 reprograms the supply, the PLLs and the bus
+ * prescalers under it, and both fight for the AXI bus. The protocol is:
+ *
+ *  1. CM4 SystemInit(): parkCm4() enables the release notification of HSEM
+ *     releaseSemaphoreId and puts the D2 domain in Stop, waiting for an event.
+ *  2. CM7 SystemInit(): bootCm7() waits for the D2 domain clock to stop (CM4 parked),
+ *     applies the clock tree, the MPU plan and the caches, clears the boot record,
+ *     locks releasedSemaphoreId for good, then takes and releases releaseSemaphoreId,
+ *     which wakes the CM4 up.
+ *
+ * releasedSemaphoreId tells a CM4 that reaches parkCm4() after the release not to sleep:
+ * one held by BCM4 and started later, one the CM7 gave up waiting for, or one reset
+ * alone while the CM7 runs. Only a system reset, which resets the HSEM, frees it.
+ *  3. Both cores run their copy/zero tables and constructors in parallel.
+ *  4. CM4 main(): signalCm4Ready(). CM7 main(): waitForCm4Ready(), which stamps the
+ *     moment both cores are ready.
+ *
+ * The CM7 timestamps every step with its DWT cycle counter into the boot record, in
+ * SRAM4 at the same address for both cores. Everything before main() runs without
+ * .data and .bss, so this code only touches registers and the record, and the HSEM is
+ * driven at register level rather than through HsemHandler objects.
+ *
+ * Usage example:
+ * ```
+ * // CM7                                         // CM4
+ * void SystemInit() {                            void SystemInit() { DualCoreBoot::parkCm4(); }
+ *     DualCoreBoot::bootCm7(ClockTree::bootConfig);  int main() {
+ * }                                                  DualCoreBoot::signalCm4Ready();
+ * int main() {                                       // ...
+ *     DualCoreBoot::waitForCm4Ready();           }
+ *     const std::uint32_t us{ DualCoreBoot::timeline().microseconds(DualCoreBoot::Stage::bothReady) };
+ * }
+ * ```
+ */
+
+//<------------------------------INCLUDES------------------------------>//
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <BootStats.hh>
+#include <ClockTree.hh>
+#include <CycleCounter.hh>
+#include <Hsem.hh>
+#include <MemorySections.hh>
+#if defined(CORE_CM7) || defined(CORE_CM4)
+#include <stm32h755xx.h>
+#include <Cache.hh>
+#include <Mpu.hh>
+#endif
+//<-------------------------------------------------------------------->//
+
+namespace DualCoreBoot
+{
+    /// Semaphore whose release wakes the CM4 up, not to be used for anything else.
+    inline constexpr std::uint32_t releaseSemaphoreId{ 0 };
+
+    /// Semaphore the CM7 keeps locked once it released the CM4, not to be used for anything else.
+    inline constexpr std::uint32_t releasedSemaphoreId{ 1 };
+
+    /// Polling iterations before giving up on the D2 domain clock, roughly 1 ms at 64 MHz.
+    inline constexpr std::uint32_t timeoutLoops{ 0xFFFF };
+
+    /// Polling iterations before giving up on the CM4 startup, in the order of 100 ms at 480 MHz.
+    inline constexpr std::uint32_t readyTimeoutLoops{ 0x00FFFFFF };
+
+    /**
+     * @brief Boot steps, in order. Each one is stamped when it completes.
+     */
+    enum class Stage : std::uint8_t {
+        cm4Parked,          ///< The D2 domain clock stopped; unstamped if the wait timed out.
+        clocksReady,        ///< Clock tree applied, the CM7 runs at SYSCLK from here on.
+        memoryReady,        ///< MPU plan applied and caches enabled.
+        cm4Released,        ///< Release semaphore freed and the D2 domain running again; unstamped if the CM4 did not park.
+        cm7Ready,           ///< The CM7 reached main().
+        bothReady           ///< The CM7 saw the CM4 ready.
+    };
+    inline constexpr std::size_t stageCount{ static_cast<std::size_t>(Stage::bothReady) + 1 };
+
+    /**
+     * @brief Cycle stamps of the CM7 during the boot.
+     *
+     * The cycle counter runs at the reset clock (HSI) up to clocksReady and at SYSCLK
+     * after, conversions to time account for both. A stage left at 0 cycles was never
+     * stamped, e.g. bothReady after waitForCm4Ready() timed out: its times read 0.
+     */
+    struct Timeline {
+        std::array<std::uint32_t, stageCount> cycles;
+        std::uint32_t resetClockHz;
+        std::uint32_t runClockHz;
+
+        constexpr std::uint32_t cyclesAt(const Stage stage) const { return cycles[static_cast<std::size_t>(stage)]; }
+
+        /// Whether the stage completed, and every stage its time depends on.
+        constexpr bool isStamped(const Stage stage) const
+        {
+            if (cyclesAt(stage) == 0) { return false; }
+            return stage <= Stage::clocksReady || (cyclesAt(Stage::clocksReady) != 0 && cyclesAt(stage) >= cyclesAt(Stage::clocksReady));
+        }
+
+        /**
+         * @brief Time from reset to the end of a stage.
+         * @return std::uint32_t Microseconds, 0 if the stage was not stamped.
+         */
+        constexpr std::uint32_t microseconds(const Stage stage) const
+        {
+            if (!isStamped(stage)) { return 0; }
+            const std::uint64_t switchCycles{ cyclesAt(Stage::clocksReady) };
+            const std::uint64_t stageCycles{ cyclesAt(stage) };
+            if (stage <= Stage::clocksReady) { return static_cast<std::uint32_t>(stageCycles * 1000000U / resetClockHz); }
+            return static_cast<std::uint32_t>(switchCycles * 1000000U / resetClockHz + (stageCycles - switchCycles) * 1000000U / runClockHz);
+        }
+
+        /**
+         * @brief Duration of one step, from the end of the previous stage (or reset) to its end.
+         * @return std::uint32_t Microseconds, 0 if either end was not stamped.
+         */
+        constexpr std::uint32_t stepMicroseconds(const Stage stage) const
+        {
+            if (stage == Stage::cm4Parked) { return microseconds(stage); }
+            const Stage previous{ static_cast<Stage>(static_cast<std::uint8_t>(stage) - 1) };
+            if (!isStamped(stage) || !isStamped(previous) || cyclesAt(stage) < cyclesAt(previous)) { return 0; }
+            return microseconds(stage) - microseconds(previous);
+        }
+    };
+
+    /**
+     * @brief Record shared by the cores, rewritten by the CM7 at every boot.
+     */
+    struct BootRecord {
+        static constexpr std::uint32_t releasedState{ 0xB0070001 };
+        static constexpr std::uint32_t cm4ReadyState{ 0xB0070002 };
+
+        std::atomic<std::uint32_t> state;
+        Timeline timeline;
+
+        /// Start a new boot, SRAM4 keeps the previous one across a reset.
+        void reset(const std::uint32_t resetClockHz, const std::uint32_t runClockHz)
+        {
+            timeline.cycles.fill(0);
+            timeline.resetClockHz = resetClockHz;
+            timeline.runClockHz = runClockHz;
+            state.store(releasedState, std::memory_order_release);
+        }
+
+        void stamp(const Stage stage, const std::uint32_t cycles) { timeline.cycles[static_cast<std::size_t>(stage)] = cycles; }
+
+        void markCm4Ready() { state.store(cm4ReadyState, std::memory_order_release); }
+
+        bool isCm4Ready() const { return state.load(std::memory_order_acquire) == cm4ReadyState; }
+
+        /**
+         * @brief Poll for the CM4, stamping bothReady with now() once it is ready.
+         * @return bool false after maxLoops polls, bothReady is then left unstamped.
+         */
+        template<typename Clock>
+        bool awaitCm4Ready(const std::uint32_t maxLoops, Clock&& now)
+        {
+            for (std::uint32_t loop = 0; loop < maxLoops; ++loop) {
+                if (isCm4Ready()) {
+                    stamp(Stage::bothReady, now());
+                    return true;
+                }
+            }
+            return false;
+        }
+    };
+
+    inline SRAM4_BOOT BootRecord bootRecord;
+
+    /// Timestamps of the last boot, complete once waitForCm4Ready() returned.
+    inline const Timeline& timeline() { return bootRecord.timeline; }
+
+    #if defined(CORE_CM7) || defined(CORE_CM4)
+        /// Enable the HSEM clock of the calling core, from any point of the boot.
+        inline void enableHsemClock()
+        {
+            RCC->AHB4ENR = RCC->AHB4ENR | RCC_AHB4ENR_HSEMEN;
+            static_cast<void>(RCC->AHB4ENR);
+        }
+    #endif
+
+    #if defined(CORE_CM4)
+        /**
+         * @brief Park the CM4 in D2 Stop until the CM7 releases the release semaphore.
+         *
+         * Call first thing from the CM4 SystemInit(). SEVONPEND turns the pending HSEM2
+         * interrupt into a wake-up event without enabling it in the NVIC; a wake-up that
+         * is not the release (debugger, stray event) goes back to sleep. Returns at once
+         * if the CM7 already released the CM4, see releasedSemaphoreId.
+         */
+        inline void parkCm4()
+        {
+            constexpr std::uint32_t mask{ 1U << releaseSemaphoreId };
+            enableHsemClock();
+            // The notification is on before the check: a release from here on stays latched in ISR
+            HSEM_COMMON->IER = HSEM_COMMON->IER | mask;
+            if ((HSEM->R[releasedSemaphoreId] & Hsem::lockBit) != 0) {
+                HSEM_COMMON->ICR = mask;
+                HSEM_COMMON->IER = HSEM_COMMON->IER & ~mask;
+                return;
+            }
+
+            SCB->SCR = SCB->SCR | SCB_SCR_SEVONPEND_Msk | SCB_SCR_SLEEPDEEP_Msk;
+            PWR->CPU2CR = PWR->CPU2CR & ~PWR_CPU2CR_PDDS_D2;    // Stop, not Standby
+            // Clear the event register so the first WFE really sleeps
+            __SEV();
+            __WFE();
+            while ((HSEM_COMMON->MISR & mask) == 0) { __WFE(); }
+            SCB->SCR = SCB->SCR & ~(SCB_SCR_SEVONPEND_Msk | SCB_SCR_SLEEPDEEP_Msk);
+
+            HSEM_COMMON->ICR = mask;
+            HSEM_COMMON->IER = HSEM_COMMON->IER & ~mask;
+            NVIC_ClearPendingIRQ(HSEM2_IRQn);
+        }
+
+        /**
+         * @brief Tell the CM7 the CM4 finished its startup, from the CM4 main().
+         */
+        inline void signalCm4Ready()
+        {
+            bootRecord.markCm4Ready();
+            __DSB();
+        }
+    #endif
+
+    #if defined(CORE_CM7)
+        /**
+         * @brief Wait until the CM4 parked: the D2 domain clock stops when it enters Stop.
+         * @return bool false if it did not within timeoutLoops, e.g. the CM4 is held by BCM4.
+         */
+        inline bool waitForCm4Parked()
+        {
+            for (std::uint32_t loop = 0; loop < timeoutLoops; ++loop) {
+                if ((RCC->CR & RCC_CR_D2CKRDY) == 0) { return true; }
+            }
+            return false;
+        }
+
+        /// Lock releasedSemaphoreId: a CM4 reaching parkCm4() from now on does not sleep.
+        inline void markCm4Released()
+        {
+            enableHsemClock();
+            static_cast<void>(HSEM->RLR[releasedSemaphoreId]);
+        }
+
+        /**
+         * @brief Wake a parked CM4 up: markCm4Released(), then a 1-step lock and a release of the release semaphore.
+         * @return bool false if the D2 domain clock did not restart within timeoutLoops.
+         */
+        inline bool releaseCm4()
+        {
+            markCm4Released();
+            static_cast<void>(HSEM->RLR[releaseSemaphoreId]);
+            HSEM->R[releaseSemaphoreId] = Hsem::cm7CoreId << Hsem::coreIdPos;
+            for (std::uint32_t loop = 0; loop < timeoutLoops; ++loop) {
+                if ((RCC->CR & RCC_CR_D2CKRDY) != 0) { return true; }
+            }
+            return false;
+        }
+
+        /**
+         * @brief CM7 side of the boot, call from its SystemInit() in place of the individual steps.
+         *
+         * Assumes the cycle counter was started by Reset_Handler and SYSCLK is still on HSI.
+         * A CM4 that did not park is not woken up, only marked released.
+         * @param config Clock configuration to apply.
+         * @return bool false if the CM4 did not park or did not wake up.
+         */
+        inline bool bootCm7(const ClockTree::ClockConfig& config)
+        {
+            const bool parked{ waitForCm4Parked() };
+            const std::uint32_t parkedCycles{ CycleCounter::now() };
+            ClockTree::apply(config);
+            const std::uint32_t clocks{ CycleCounter::now() };
+            Mpu::BootPlan::apply();
+            Cache::enable();
+            const std::uint32_t memory{ CycleCounter::now() };
+
+            // SRAM4 is non-cacheable from here on, the record can be written for the CM4
+            bootRecord.reset(ClockTree::hsiHz, config.sysclkHz);
+            if (parked) { bootRecord.stamp(Stage::cm4Parked, parkedCycles); }
+            bootRecord.stamp(Stage::clocksReady, clocks);
+            bootRecord.stamp(Stage::memoryReady, memory);
+            __DSB();
+            if (!parked) {
+                markCm4Released();
+                return false;
+            }
+            const bool released{ releaseCm4() };
+            if (released) { bootRecord.stamp(Stage::cm4Released, CycleCounter::now()); }
+            return released;
+        }
+
+        /**
+         * @brief Wait until the CM4 signals it is ready, from the CM7 main().
+         *
+         * Polls rather than sleeping in WFE, so a CM4 that never starts cannot hang the CM7.
+         * @param maxLoops Polling iterations before giving up.
+         * @return bool false on timeout, bothReady is then left unstamped.
+         */
+        inline bool waitForCm4Ready(const std::uint32_t maxLoops = readyTimeoutLoops)
+        {
+            bootRecord.stamp(Stage::cm7Ready, BootStats::getBootCycles());
+            return bootRecord.awaitCm4Ready(maxLoops, [] { return CycleCounter::now(); });
+        }
+    #endif
+};
+
+#endif // __DUALCOREBOOT_H__
@@ -0,0 +1,124 @@
+#ifndef __MEMORYSECTIONS_H__
+#define __MEMORYSECTIONS_H__
+
+/**
+ * @file MemorySections.hh
+ * @brief Placement macros for the named RAM sections of the linker scripts.
+ *
+ * The linker scripts in Startup/ describe every SRAM region of the STM32H755 and
+ * expose one output section per purpose. These macros are the only supported way
+ * to put an object into one of them, so the section names live in a single place.
+ *
+ * Usage example:
+ * ```
+ * DMA_BUFFER uint8_t rxBuffer[256];
+ * AXI_BSS uint32_t frameBuffer[320 * 240];
+ * SRAM4_SHARED volatile uint32_t mailbox;
+ * ```
+ *
+ * AXI_BSS objects are zeroed by the startup zero table like regular .bss. DMA_BUFFER
+ * and SRAM4_SHARED objects are NOLOAD and left untouched by the startup code, so
+ * they must be written before being read. ITCM_TEXT functions are copied from flash
+ * by the startup copy table.
+ */
+
+//<------------------------------INCLUDES------------------------------>//
+#include <cstddef>
+#include <cstdint>
+//<-------------------------------------------------------------------->//
+
+namespace MemorySections
+{
+    /**
+     * @brief Alignment of every named section, equal to the Cortex-M7 cache line size.
+     *
+     * Keeping objects on line boundaries lets cache maintenance on one buffer never
+     * touch a neighbour.
+     */
+    inline constexpr std::size_t sectionAlignment{ 32 };
+
+    // Tightly coupled memories, unreachable by DMA1/DMA2/BDMA
+    inline constexpr std::uintptr_t itcmStart{ 0x00000000 };
+    inline constexpr std::uintptr_t itcmEnd{ 0x00010000 };
+    inline constexpr std::uintptr_t dtcmStart{ 0x20000000 };
+    inline constexpr std::uintptr_t dtcmEnd{ 0x20020000 };
+
+    // Regions reachable by the bus masters
+    inline constexpr std::uintptr_t axiSramStart{ 0x24000000 };
+    inline constexpr std::uintptr_t axiSramEnd{ 0x24080000 };
+    inline constexpr std::uintptr_t d2SramStart{ 0x30000000 };
+    inline constexpr std::uintptr_t d2SramEnd{ 0x30048000 };
+    inline constexpr std::uintptr_t sram4Start{ 0x38000000 };
+    inline constexpr std::uintptr_t sram4End{ 0x38010000 };
+
+    /**
+     * @brief Check whether an address range lies in one of the TCMs.
+     * @param address First byte of the range.
+     * @param size Size of the range in bytes.
+     * @return true If any byte of the range is in ITCM or DTCM.
+     */
+    constexpr bool isInTcm(const std::uintptr_t address, const std::size_t size)
+    {
+        const std::uintptr_t end{ address + size };
+        return (address < itcmEnd && end > itcmStart) || (address < dtcmEnd && end > dtcmStart);
+    }
+
+    /**
+     * @brief Check whether an address range can be used by DMA1/DMA2.
+     * @param address First byte of the range.
+     * @param size Size of the range in bytes.
+     * @return true If the whole range is in AXI SRAM, D2 SRAM or SRAM4.
+     */
+    constexpr bool isDmaReachable(const std::uintptr_t address, const std::size_t size)
+    {
+        const std::uintptr_t end{ address + size };
+        return (address >= axiSramStart && end <= axiSramEnd) ||
+               (address >= d2SramStart && end <= d2SramEnd) ||
+               (address >= sram4Start && end <= sram4End);
+    }
+
+    /**
+     * @brief Check whether an address range can be used by BDMA, which only sees SRAM4.
+     * @param address First byte of the range.
+     * @param size Size of the range in bytes.
+     * @return true If the whole range is in SRAM4.
+     */
+    constexpr bool isBdmaReachable(const std::uintptr_t address, const std::size_t size)
+    {
+        return address >= sram4Start && (address + size) <= sram4End;
+    }
+};
+
+/// Place an object in the DMA1/DMA2 reachable buffer section (never in TCM).
+#define DMA_BUFFER __attribute__((section(".dma_buffers"), aligned(32)))
+
+/// Place an object in the core's share of AXI SRAM.
+#define AXI_BSS __attribute__((section(".axi_bss"), aligned(32)))
+
+/**
+ * Place an object in SRAM4, shared by both cores.
+ *
+ * The linker scripts fix the start of the section, the objects inside follow the link
+ * order of each image: define every shared object in both images, in one translation
+ * unit or header built into both, so they come in the same order. The top-level
+ * "make build" checks the result with Tools/shared_layout_check.py and fails when an
+ * object has two addresses or overlaps another one of the other image.
+ *
+ * The section is NOLOAD: the startup code neither copies nor zeroes it, so shared objects
+ * (rings, pools, RPC channels) start with whatever SRAM4 holds.
+ * Exactly one core calls their reset(), usually the CM7 in main(), before the other core
+ * uses them.
+ */
+#define SRAM4_SHARED __attribute__((section(".sram4_shared"), aligned(32)))
+
+/// Reserved for the dual-core boot record (DualCoreBoot.hh), first in SRAM4 in both images.
+#define SRAM4_BOOT __attribute__((section(".sram4_boot"), aligned(32)))
+
+/// Run a function from ITCM on the CM7, long_call so it can be reached from flash.
+#if defined(CORE_CM7) && defined(__arm__)
+    #define ITCM_TEXT __attribute__((section(".itcm_text"), long_call, noinline))
+#else
+    #define ITCM_TEXT
+#endif
+
+#endif // __MEMORYSECTIONS_H__
@@ -0,0 +1,253 @@
+#ifndef __MPU_H__
+#define __MPU_H__
+
+/**
+ * @file Mpu.hh
+ * @brief Compile-time MPU region planner on top of the CMSIS mpu_armv7.h functions.
+ *
+ * Regions are described with Mpu::Region descriptors and grouped in an Mpu::Plan.
+ * The plan checks the ARMv7-M rules (power of two size >= 32 bytes, base aligned to
+ * the size, sub-regions only for regions >= 256 bytes, number of regions) with
+ * static_assert and computes the RBAR/RASR values at compile time. apply() then
+ * programs every region in a single pass.
+ *
+ * Usage example:
+ * ```
+ * using Plan = Mpu::Plan<
+ *     Mpu::Region{ .base = 0x38000000, .size = 64 * 1024, .policy = Mpu::CachePolicy::normalNonCacheable,
+ *                  .access = Mpu::Access::fullAccess, .executeNever = true, .shareable = true }
+ * >;
+ * Plan::apply();
+ * ```
+ */
+
+//<------------------------------INCLUDES------------------------------>//
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#if defined(CORE_CM7) || defined(CORE_CM4)
+#include <stm32h755xx.h>
+#endif
+//<-------------------------------------------------------------------->//
+
+namespace Mpu
+{
+    /// Number of MPU regions: 16 on the H7 Cortex-M7, 8 on the Cortex-M4.
+    #if defined(CORE_CM4)
+        inline constexpr std::size_t regionCount{ 8 };
+    #else
+        inline constexpr std::size_t regionCount{ 16 };
+    #endif
+
+    /**
+     * @brief Memory type and cache policy of a region, mapped to the TEX/C/B attributes.
+     */
+    enum class CachePolicy : std::uint8_t {
+        stronglyOrdered,            ///< TEX=000 C=0 B=0
+        device,                     ///< TEX=000 C=0 B=1
+        normalNonCacheable,         ///< TEX=001 C=0 B=0
+        writeThrough,               ///< TEX=000 C=1 B=0, no write allocate
+        writeBackNoWriteAllocate,   ///< TEX=000 C=1 B=1
+        writeBackWriteAllocate      ///< TEX=001 C=1 B=1
+    };
+
+    /**
+     * @brief Access permissions of a region, values of the RASR AP field.
+     */
+    enum class Access : std::uint8_t {
+        noAccess = 0,                 ///< ARM_MPU_AP_NONE
+        privilegedOnly = 1,           ///< ARM_MPU_AP_PRIV
+        unprivilegedReadOnly = 2,     ///< ARM_MPU_AP_URO
+        fullAccess = 3,               ///< ARM_MPU_AP_FULL
+        privilegedReadOnly = 5,       ///< ARM_MPU_AP_PRO
+        readOnly = 6                  ///< ARM_MPU_AP_RO
+    };
+
+    /**
+     * @brief Description of one MPU region.
+     *
+     * A structural type so it can be passed as a template argument to Mpu::Plan.
+     */
+    struct Region {
+        std::uint32_t base{ 0 };                                ///< Start address, aligned to size.
+        std::uint64_t size{ 0 };                                ///< Size in bytes, power of two from 32 B to 4 GB.
+        CachePolicy policy{ CachePolicy::stronglyOrdered };     ///< Memory type and cacheability.
+        Access access{ Access::noAccess };                      ///< Access permissions.
+        bool executeNever{ true };                              ///< Forbid instruction fetches.
+        bool shareable{ false };                                ///< Shareable between bus masters.
+        std::uint8_t subRegionDisable{ 0 };                     ///< One bit per disabled eighth of the region.
+    };
+
+    /**
+     * @brief Values of the two registers programming one region.
+     */
+    struct RegionRegisters {
+        std::uint32_t rbar{ 0 };
+        std::uint32_t rasr{ 0 };
+    };
+
+    // RBAR/RASR field layout, identical to the MPU_RBAR_* / MPU_RASR_* definitions of core_cm7.h
+    inline constexpr std::uint32_t rbarValid{ 1U << 4 };
+    inline constexpr std::uint32_t rbarAddressMask{ 0xFFFFFFE0U };
+    inline constexpr std::uint32_t rasrEnable{ 1U << 0 };
+    inline constexpr std::uint32_t rasrSizePos{ 1 };
+    inline constexpr std::uint32_t rasrSrdPos{ 8 };
+    inline constexpr std::uint32_t rasrBufferable{ 1U << 16 };
+    inline constexpr std::uint32_t rasrCacheable{ 1U << 17 };
+    inline constexpr std::uint32_t rasrShareable{ 1U << 18 };
+    inline constexpr std::uint32_t rasrTexPos{ 19 };
+    inline constexpr std::uint32_t rasrApPos{ 24 };
+    inline constexpr std::uint32_t rasrExecuteNever{ 1U << 28 };
+
+    /**
+     * @brief Check the region size is a power of two between 32 bytes and 4 GB.
+     */
+    constexpr bool isSizeValid(const Region& region)
+    {
+        return region.size >= 32 && region.size <= (std::uint64_t{ 1 } << 32) && (region.size & (region.size - 1)) == 0;
+    }
+
+    /**
+     * @brief Check the region base is aligned to its size.
+     */
+    constexpr bool isBaseAligned(const Region& region)
+    {
+        return isSizeValid(region) && (region.base % region.size) == 0;
+    }
+
+    /**
+     * @brief Check sub-regions are only disabled on regions of 256 bytes or more.
+     */
+    constexpr bool isSubRegionValid(const Region& region)
+    {
+        return region.subRegionDisable == 0 || region.size >= 256;
+    }
+
+    /**
+     * @brief Encode the RASR SIZE field, log2(size) - 1.
+     */
+    constexpr std::uint32_t sizeField(const std::uint64_t size)
+    {
+        std::uint32_t log2{ 0 };
+        while ((std::uint64_t{ 1 } << (log2 + 1)) <= size) { ++log2; }
+        return log2 - 1;
+    }
+
+    /**
+     * @brief Encode the TEX, C and B attributes of a cache policy.
+     */
+    constexpr std::uint32_t attributes(const CachePolicy policy)
+    {
+        switch (policy) {
+            case CachePolicy::stronglyOrdered:          return 0;
+            case CachePolicy::device:                   return rasrBufferable;
+            case CachePolicy::normalNonCacheable:       return 1U << rasrTexPos;
+            case CachePolicy::writeThrough:             return rasrCacheable;
+            case CachePolicy::writeBackNoWriteAllocate: return rasrCacheable | rasrBufferable;
+            case CachePolicy::writeBackWriteAllocate:   return (1U << rasrTexPos) | rasrCacheable | rasrBufferable;
+        }
+        return 0;
+    }
+
+    /**
+     * @brief Compute RBAR and RASR of a region.
+     * @param region Region descriptor.
+     * @param number MPU region number, higher numbers take priority where regions overlap.
+     * @return RegionRegisters Values to program.
+     */
+    constexpr RegionRegisters encode(const Region& region, const std::uint32_t number)
+    {
+        return RegionRegisters{
+            .rbar = (region.base & rbarAddressMask) | rbarValid | (number & 0xFU),
+            .rasr = (region.executeNever ? rasrExecuteNever : 0U) |
+                    (static_cast<std::uint32_t>(region.access) << rasrApPos) |
+                    attributes(region.policy) |
+                    (region.shareable ? rasrShareable : 0U) |
+                    (static_cast<std::uint32_t>(region.subRegionDisable) << rasrSrdPos) |
+                    (sizeField(region.size) << rasrSizePos) |
+                    rasrEnable
+        };
+    }
+
+    /**
+     * @brief A validated set of MPU regions, numbered in declaration order.
+     *
+     * Later regions override earlier ones where they overlap, so list background
+     * regions first and specific ones last.
+     * @tparam Regions Region descriptors.
+     */
+    template<Region... Regions>
+    class Plan
+    {
+        static_assert(sizeof...(Regions) > 0, "An MPU plan needs at least one region");
+        static_assert(sizeof...(Regions) <= regionCount, "Too many MPU regions for this core");
+        static_assert((isSizeValid(Regions) && ...), "MPU region size must be a power of two between 32 bytes and 4 GB");
+        static_assert((isBaseAligned(Regions) && ...), "MPU region base address must be aligned to the region size");
+        static_assert((isSubRegionValid(Regions) && ...), "MPU sub-regions can only be disabled on regions of 256 bytes or more");
+
+    private:
+        static constexpr std::array<Region, sizeof...(Regions)> regions{ Regions... };
+
+        static constexpr std::array<RegionRegisters, sizeof...(Regions)> computeRegisters()
+        {
+            std::array<RegionRegisters, sizeof...(Regions)> result{};
+            for (std::size_t i = 0; i < regions.size(); ++i) {
+                result[i] = encode(regions[i], static_cast<std::uint32_t>(i));
+            }
+            return result;
+        }
+
+    public:
+        /// Register values of every region, computed at compile time.
+        static constexpr std::array<RegionRegisters, sizeof...(Regions)> registers{ computeRegisters() };
+
+        /// Number of regions used by the plan.
+        static constexpr std::size_t size() { return sizeof...(Regions); }
+
+        /**
+         * @brief Program the MPU: disable it, write every planned region, clear the
+         * unused ones and enable it again with the default map as privileged background.
+         */
+        static void apply()
+        {
+            #if defined(CORE_CM7) || defined(CORE_CM4)
+                ARM_MPU_Disable();
+                for (const RegionRegisters& region : registers) {
+                    ARM_MPU_SetRegion(region.rbar, region.rasr);
+                }
+                const std::uint32_t hardwareRegions{ static_cast<std::uint32_t>((MPU->TYPE & MPU_TYPE_DREGION_Msk) >> MPU_TYPE_DREGION_Pos) };
+                for (std::uint32_t number = sizeof...(Regions); number < hardwareRegions; ++number) {
+                    ARM_MPU_ClrRegion(number);
+                }
+                ARM_MPU_Enable(MPU_CTRL_PRIVDEFENA_Msk);
+            #endif
+        }
+    };
+
+    /**
+     * @brief MPU plan applied by the CM7 at boot.
+     *
+     * - Flash (both banks): cached write-through, executable, and writable for in-application
+     *   programming; invalidate the D-cache lines of an erased or programmed range afterwards.
+     * - AXI SRAM: write-back write-allocate.
+     * - D2 SRAM3 (.dma_buffers of the CM7): non-cacheable, so DMA buffers need no maintenance.
+     * - SRAM4 (.sram4_shared): non-cacheable and shareable, so both cores see the same data.
+     */
+    using BootPlan = Plan<
+        Region{ .base = 0x08000000, .size = 2 * 1024 * 1024, .policy = CachePolicy::writeThrough,
+                .access = Access::fullAccess, .executeNever = false, .shareable = false },
+        Region{ .base = 0x24000000, .size = 512 * 1024, .policy = CachePolicy::writeBackWriteAllocate,
+                .access = Access::fullAccess, .executeNever = false, .shareable = false },
+        Region{ .base = 0x30040000, .size = 32 * 1024, .policy = CachePolicy::normalNonCacheable,
+                .access = Access::fullAccess, .executeNever = true, .shareable = true },
+        Region{ .base = 0x38000000, .size = 64 * 1024, .policy = CachePolicy::normalNonCacheable,
+                .access = Access::fullAccess, .executeNever = true, .shareable = true }
+    >;
+
+    static_assert(sizeField(32) == 4 && sizeField(std::uint64_t{ 1 } << 32) == 31, "RASR SIZE encoding");
+    static_assert(BootPlan::registers[3].rbar == 0x38000013U, "RBAR encoding");
+    static_assert(BootPlan::registers[3].rasr == 0x130C001FU, "RASR encoding");
+    static_assert(((BootPlan::registers[0].rasr >> 24) & 7U) == static_cast<std::uint32_t>(Access::fullAccess), "Flash programming needs write access");
+};
+
+#endif // __MPU_H__
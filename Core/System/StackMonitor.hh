@@ -0,0 +1,276 @@
+#ifndef __STACKMONITOR_H__
+#define __STACKMONITOR_H__
+
+/**
+ * @file StackMonitor.hh
+ * @brief Runtime high-water mark of the MSP stack and optional per-ISR stack sampling.
+ *
+ * Reset_Handler paints the MSP stack reserve [_estack - _Min_Stack_Size, _estack) with
+ * paintPattern before anything runs. The deepest point ever reached is then the lowest
+ * word that no longer holds the pattern: highWaterMark() finds it by scanning up from
+ * the bottom of the reserve, so it costs one read per free word and nothing otherwise.
+ * This complements Tools/stack_analysis.py, which cannot follow recursion or function
+ * pointers.
+ *
+ * Per-ISR sampling is opt-in with -DSTACK_MONITOR_ISR_SAMPLING. Put STACK_MONITOR_ISR()
+ * at the top of a handler: it records the depth on entry, per exception number in
+ * getIsrStats(). Only the outermost sampled handler touches the stack: on entry it
+ * repaints the words used since the last repaint, on exit it scans for the deepest word
+ * it and the handlers nesting on top of it touched. A nested handler only counts itself
+ * and is given the peak of the outermost one, so nesting never hides a peak. Without the
+ * define the macro expands to nothing.
+ *
+ * Usage example:
+ * ```
+ * extern "C" void USART1_IRQHandler(void)
+ * {
+ *     STACK_MONITOR_ISR();
+ *     // ...
+ * }
+ * std::size_t used = StackMonitor::highWaterMark();
+ * bool tooSmall = StackMonitor::overflowed();
+ * ```
+ */
+
+//<------------------------------INCLUDES------------------------------>//
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#if defined(__arm__)
+#include <cmsis_compiler.h>
+#endif
+//<-------------------------------------------------------------------->//
+
+#if defined(__arm__)
+extern "C" {
+    extern std::uint8_t _estack;
+    extern std::uint8_t _Min_Stack_Size;
+}
+#endif
+
+namespace StackMonitor
+{
+    /// Value painted into every free stack word, STACK_PAINT in startup_stm32h755xx.s.
+    inline constexpr std::uint32_t paintPattern{ 0xC5C5C5C5U };
+
+    /// System exceptions and the 150 interrupts of the H755.
+    inline constexpr std::size_t exceptionCount{ 16 + 150 };
+
+    /**
+     * @brief A stack, bottom inclusive and top exclusive, both word aligned.
+     */
+    struct Region {
+        std::uintptr_t bottom{ 0 };
+        std::uintptr_t top{ 0 };
+
+        constexpr std::size_t size() const { return top - bottom; }
+    };
+
+    /**
+     * @brief Stack figures of one exception.
+     */
+    struct IsrStats {
+        std::uint32_t samples{ 0 };         ///< Number of times the handler ran.
+        std::uint16_t maxEntryDepth{ 0 };   ///< Deepest stack depth found on entry, preempted code included.
+        std::uint16_t maxPeakDepth{ 0 };    ///< Deepest point reached while the handler ran.
+    };
+
+    /**
+     * @brief The MSP stack reserve defined by the linker script. Empty on the host.
+     */
+    inline Region mainStack()
+    {
+        #if defined(__arm__)
+            const std::uintptr_t top{ reinterpret_cast<std::uintptr_t>(&_estack) };
+            return Region{ top - reinterpret_cast<std::uintptr_t>(&_Min_Stack_Size), top };
+        #else
+            return Region{};
+        #endif
+    }
+
+    /**
+     * @brief Current main stack pointer, 0 on the host.
+     */
+    inline std::uintptr_t stackPointer()
+    {
+        #if defined(__arm__)
+            return __get_MSP();
+        #else
+            return 0;
+        #endif
+    }
+
+    /**
+     * @brief Fill [bottom, limit) of a stack with paintPattern.
+     *
+     * The range is clipped to the stack pointer of the running function, so a live stack
+     * can be repainted: everything below the stack pointer is free.
+     * @param limit Exclusive end of the range.
+     */
+    inline void paint(const Region& region, const std::uintptr_t limit)
+    {
+        const std::uintptr_t pointer{ stackPointer() };
+        const std::uintptr_t end{ (pointer != 0 && pointer < limit) ? pointer : limit };
+        for (auto* word = reinterpret_cast<volatile std::uint32_t*>(region.bottom); reinterpret_cast<std::uintptr_t>(word) < end; ++word) {
+            *word = paintPattern;
+        }
+    }
+
+    /**
+     * @brief Lowest address below limit that no longer holds the pattern.
+     * @return std::uintptr_t limit if the whole range is still painted.
+     */
+    inline std::uintptr_t lowestUsed(const Region& region, const std::uintptr_t limit)
+    {
+        auto* word{ reinterpret_cast<const volatile std::uint32_t*>(region.bottom) };
+        while (reinterpret_cast<std::uintptr_t>(word) < limit && *word == paintPattern) { ++word; }
+        return reinterpret_cast<std::uintptr_t>(word);
+    }
+
+    /**
+     * @brief Deepest stack use since the stack was painted, in bytes.
+     */
+    inline std::size_t highWaterMark(const Region& region) { return region.top - lowestUsed(region, region.top); }
+
+    /**
+     * @brief Check whether the bottom word of the stack was overwritten: the stack is at
+     * least full and has likely overflowed into the memory below it.
+     */
+    inline bool overflowed(const Region& region)
+    {
+        return region.size() != 0 && *reinterpret_cast<const volatile std::uint32_t*>(region.bottom) != paintPattern;
+    }
+
+    /// Deepest use erased by the repaint of a sampled handler, see IsrScope.
+    inline std::size_t& erasedMark()
+    {
+        static std::size_t mark{ 0 };
+        return mark;
+    }
+
+    /// Deepest use of the MSP stack since boot, in bytes.
+    inline std::size_t highWaterMark()
+    {
+        const std::size_t mark{ highWaterMark(mainStack()) };
+        return erasedMark() > mark ? erasedMark() : mark;
+    }
+
+    /// Bytes of the MSP stack in use right now.
+    inline std::size_t currentDepth() { return stackPointer() == 0 ? 0 : mainStack().top - stackPointer(); }
+
+    /// Check whether the MSP stack reserve was exhausted.
+    inline bool overflowed() { return overflowed(mainStack()); }
+
+    /// Per exception statistics, indexed by exception number (IRQn + 16).
+    inline std::array<IsrStats, exceptionCount>& getIsrStats()
+    {
+        static std::array<IsrStats, exceptionCount> stats{};
+        return stats;
+    }
+
+    /**
+     * @brief Nesting of the sampled handlers, written from the handlers.
+     */
+    struct Nesting {
+        volatile std::size_t depth{ 0 };                        ///< Outermost handler past its repaint plus the nested ones.
+        volatile std::size_t nestedEntries{ 0 };                ///< Nested handler entries since boot.
+        std::array<bool, exceptionCount> nested{};              ///< Exceptions that ran nested, given the outermost peak.
+    };
+
+    inline Nesting& nesting()
+    {
+        static Nesting state{};
+        return state;
+    }
+
+    /**
+     * @brief Samples the stack of one handler invocation, see STACK_MONITOR_ISR().
+     *
+     * Repainting the free stack on entry erases deeper marks left earlier by the code the
+     * handler preempted, so they are saved in erasedMark() first. The words below that mark
+     * still hold the pattern and are not written again. The peak includes the few bytes used
+     * by the sampling itself, so it errs on the safe side.
+     *
+     * Handlers preempting each other unwind in order, so the nesting needs no lock. The
+     * outermost scope only counts itself once its repaint is done and until its scan is:
+     * a handler preempting the repaint samples on its own, one preempting the scan makes
+     * the scan run again.
+     */
+    class IsrScope
+    {
+    private:
+        Region region;
+        std::uintptr_t entryPointer{ 0 };
+        std::size_t exception{ 0 };
+        std::size_t entriesBefore{ 0 };
+        bool outermost{ false };
+
+        static void raisePeak(IsrStats& stats, const std::size_t peak)
+        {
+            if (peak > stats.maxPeakDepth) { stats.maxPeakDepth = static_cast<std::uint16_t>(peak); }
+        }
+
+    public:
+        IsrScope(const Region& stack, const std::uintptr_t pointer, const std::size_t exceptionNumber)
+            : region{ stack }, entryPointer{ pointer }, exception{ exceptionNumber }
+        {
+            if (region.size() == 0 || exception >= exceptionCount) { return; }
+            IsrStats& stats{ getIsrStats()[exception] };
+            const std::size_t depth{ region.top - entryPointer };
+            ++stats.samples;
+            if (depth > stats.maxEntryDepth) { stats.maxEntryDepth = static_cast<std::uint16_t>(depth); }
+
+            Nesting& state{ nesting() };
+            outermost = state.depth == 0;
+            if (outermost) {
+                const std::uintptr_t lowest{ lowestUsed(region, entryPointer) };
+                if (region.top - lowest > erasedMark()) { erasedMark() = region.top - lowest; }
+                paint(Region{ lowest, region.top }, entryPointer);
+                entriesBefore = state.nestedEntries;
+            } else {
+                state.nested[exception] = true;
+                state.nestedEntries = state.nestedEntries + 1;
+            }
+            state.depth = state.depth + 1;
+        }
+
+        ~IsrScope()
+        {
+            if (region.size() == 0 || exception >= exceptionCount) { return; }
+            Nesting& state{ nesting() };
+            if (!outermost) {
+                state.depth = state.depth - 1;
+                return;
+            }
+
+            std::size_t peak{ 0 };
+            std::size_t entries{ 0 };
+            do {
+                entries = state.nestedEntries;
+                peak = region.top - lowestUsed(region, entryPointer);
+            } while (entries != state.nestedEntries);
+            std::array<IsrStats, exceptionCount>& stats{ getIsrStats() };
+            raisePeak(stats[exception], peak);
+            if (peak > erasedMark()) { erasedMark() = peak; }
+            if (entries != entriesBefore) {
+                for (std::size_t index = 0; index < exceptionCount; ++index) {
+                    if (!state.nested[index]) { continue; }
+                    state.nested[index] = false;
+                    raisePeak(stats[index], peak);
+                }
+            }
+            state.depth = state.depth - 1;
+        }
+
+        IsrScope(const IsrScope&) = delete;
+        IsrScope& operator=(const IsrScope&) = delete;
+    };
+};
+
+#if defined(STACK_MONITOR_ISR_SAMPLING) && defined(__arm__)
+    #define STACK_MONITOR_ISR() StackMonitor::IsrScope stackMonitorScope{ StackMonitor::mainStack(), __get_MSP(), __get_IPSR() }
+#else
+    #define STACK_MONITOR_ISR() do {} while (0)
+#endif
+
+#endif // __STACKMONITOR_H__
@@ -0,0 +1,279 @@
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+/**
+ * @file Trace.hh
+ * @brief Dual-core binary trace log: per-core flight recorders on a common time base.
+ *
+ * Each core writes 16-byte records (cycle stamp, event ID, kind, two arguments) into its
+ * own Log, a ring of Records entries overwriting the oldest. Writing a record is a DWT
+ * read, an atomic increment of the core's own write index (LDREX/STREX, safe against the
+ * ISRs of the same core) and four word stores: a few dozen cycles, so tracing can stay
+ * enabled in production builds. Nothing reads the logs on the target: the debugger
+ * dumps them and Tools/trace_merge.py rebuilds one timeline in the trace-viewer format.
+ *
+ * Time base: the stamps are the cycle counters of each core. Both core clocks come from
+ * PLL1 (the CM4 clock is the CM7 clock divided by HPRE), so the ratio of the counters is
+ * an integer and constant, and only their offset is unknown. synchronize() (CM7) and
+ * respondToSync() (CM4) measure it with a ping-pong through the shared SyncCell: the
+ * best round (shortest round trip) is kept in the CM7 log header, and the merge tool
+ * moves the CM4 stamps into the CM7 time base with it. The error is bounded by half the
+ * round trip, a few tens of nanoseconds.
+ *
+ * The stamps are 32-bit: a core should write at least one record every 2^31 CM7 cycles
+ * (4.4 s at 480 MHz) for the merge tool to count every counter wrap.
+ *
+ * Usage example:
+ * ```
+ * SRAM4_SHARED Trace::Area<512> traceArea;
+ * // Both cores, once
+ * traceArea.local().reset(SystemCoreClock);
+ * // CM7 main()                                   // CM4 main()
+ * traceArea.synchronize();                        traceArea.respondToSync();
+ * // Anywhere
+ * Trace::Scope scope{ traceArea.local(), adcBlockEvent };
+ * traceArea.local().instant(frameEvent, frameNumber);
+ * ```
+ */
+
+//<------------------------------INCLUDES------------------------------>//
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <BusyWait.hh>
+#include <CycleCounter.hh>
+#include <Hsem.hh>
+//<-------------------------------------------------------------------->//
+
+namespace Trace
+{
+    /// "TRCE" in the dump, what the merge tool looks for.
+    inline constexpr std::uint32_t magic{ 0x45435254 };
+    inline constexpr std::uint16_t formatVersion{ 1 };
+
+    /// Ping-pong rounds of synchronize(), the shortest is kept.
+    inline constexpr std::uint32_t syncRounds{ 16 };
+
+    /// Polling iterations before a sync round is given up.
+    inline constexpr std::uint32_t syncTimeoutLoops{ 0x000FFFFF };
+
+    enum class Kind : std::uint8_t {
+        instant,            ///< Point event.
+        begin,              ///< Start of a duration, closed by the next end of the same event.
+        end,
+        counter,            ///< Value of a counter in arg0.
+        sync                ///< Sync round: arg0 and arg1 are the stamps of the other side.
+    };
+
+    /**
+     * @brief One event as stored in the log. The layout is part of the dump format.
+     */
+    struct Record {
+        std::uint32_t cycles;
+        std::uint16_t event;
+        Kind kind;
+        std::uint8_t reserved;
+        std::uint32_t arg0;
+        std::uint32_t arg1;
+    };
+    static_assert(sizeof(Record) == 16, "Trace records are 16 bytes in the dump format");
+
+    /**
+     * @brief Best sync round seen by the CM7, stamps of the two counters.
+     */
+    struct SyncPoint {
+        std::uint32_t sequence;         ///< 0 if never synchronized.
+        std::uint32_t masterSend;       ///< CM7, ping written.
+        std::uint32_t peerReceive;      ///< CM4, ping seen.
+        std::uint32_t peerSend;         ///< CM4, pong written.
+        std::uint32_t masterReceive;    ///< CM7, pong seen.
+
+        constexpr std::uint32_t roundTrip() const { return masterReceive - masterSend; }
+    };
+
+    /**
+     * @brief Log header, the layout is part of the dump format.
+     */
+    struct alignas(32) LogHeader {
+        std::uint32_t magic;
+        std::uint16_t version;
+        std::uint8_t core;                  ///< HSEM core ID: 3 for the CM7, 1 for the CM4.
+        std::uint8_t recordSize;
+        std::uint32_t capacity;             ///< Records in the ring.
+        std::uint32_t clockHz;              ///< Rate of the cycle stamps.
+        std::atomic<std::uint32_t> head;    ///< Records written since reset(), the ring keeps the last capacity.
+        SyncPoint sync;
+    };
+    static_assert(sizeof(LogHeader) == 64, "The trace log header is 64 bytes in the dump format");
+
+    /**
+     * @brief Flight recorder of one core.
+     * @tparam Records Ring size, a power of two.
+     */
+    template<std::size_t Records>
+    class Log
+    {
+        static_assert(Records >= 16 && (Records & (Records - 1)) == 0, "The trace ring size must be a power of two");
+        static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "Trace logs need lock-free 32-bit atomics");
+
+    private:
+        LogHeader header;
+        Record records[Records];
+
+    public:
+        /**
+         * @brief Empty the log, from the core writing it.
+         * @param clockHz Rate of the cycle counter of the calling core.
+         * @param core HSEM core ID recorded for the merge tool, to be set on the host only.
+         */
+        void reset(const std::uint32_t clockHz, const std::uint32_t core = Hsem::currentCoreId())
+        {
+            header.version = formatVersion;
+            header.core = static_cast<std::uint8_t>(core);
+            header.recordSize = sizeof(Record);
+            header.capacity = Records;
+            header.clockHz = clockHz;
+            header.head.store(0, std::memory_order_relaxed);
+            header.sync = SyncPoint{};
+            // Written last: a dump of a half-reset log is not recognized
+            std::atomic_thread_fence(std::memory_order_release);
+            header.magic = magic;
+        }
+
+        /// Append a record, overwriting the oldest one if the ring is full.
+        void write(const Kind kind, const std::uint16_t event, const std::uint32_t arg0 = 0, const std::uint32_t arg1 = 0)
+        {
+            const std::uint32_t cycles{ CycleCounter::now() };
+            const std::uint32_t index{ header.head.fetch_add(1, std::memory_order_relaxed) };
+            records[index & (Records - 1)] = Record{ cycles, event, kind, 0, arg0, arg1 };
+        }
+
+        void instant(const std::uint16_t event, const std::uint32_t arg0 = 0, const std::uint32_t arg1 = 0) { write(Kind::instant, event, arg0, arg1); }
+        void begin(const std::uint16_t event, const std::uint32_t arg0 = 0) { write(Kind::begin, event, arg0); }
+        void end(const std::uint16_t event, const std::uint32_t arg0 = 0) { write(Kind::end, event, arg0); }
+        void counter(const std::uint16_t event, const std::uint32_t value) { write(Kind::counter, event, value); }
+
+        /// Records written since reset(), including the overwritten ones.
+        std::uint32_t written() const { return header.head.load(std::memory_order_relaxed); }
+
+        /// Records still in the ring.
+        std::uint32_t size() const { return written() < Records ? written() : static_cast<std::uint32_t>(Records); }
+
+        /// index-th oldest record still in the ring, 0 to size() - 1.
+        const Record& at(const std::uint32_t index) const { return records[(written() - size() + index) & (Records - 1)]; }
+
+        const SyncPoint& syncPoint() const { return header.sync; }
+
+        /// Keep a sync round in the header, where the merge tool finds it.
+        void setSyncPoint(const SyncPoint& point) { header.sync = point; }
+
+        static constexpr std::size_t capacity() { return Records; }
+    };
+
+    /**
+     * @brief Ping-pong cell of the sync protocol, plain loads and stores on both sides.
+     *
+     * The CM4 answers a ping whenever it differs from the last pong, and the CM7 always
+     * pings with the last pong + 1: whatever the cell held at power-up, the protocol
+     * resynchronizes after at most one round.
+     */
+    struct SyncCell {
+        std::atomic<std::uint32_t> ping;
+        std::atomic<std::uint32_t> peerReceive;
+        std::atomic<std::uint32_t> peerSend;
+        std::atomic<std::uint32_t> pong;
+    };
+
+    /**
+     * @brief Both logs and the sync cell, one object in shared memory so one dump covers all.
+     */
+    template<std::size_t Records>
+    class Area
+    {
+    public:
+        Log<Records> cm7;
+        Log<Records> cm4;
+        alignas(32) SyncCell cell;
+
+        /// Log of the calling core, the CM7 one on the host.
+        Log<Records>& local()
+        {
+            #if defined(CORE_CM4)
+                return cm4;
+            #else
+                return cm7;
+            #endif
+        }
+
+        /**
+         * @brief CM7 side of the offset measurement, with respondToSync() running on the CM4.
+         *
+         * The best round goes to the CM7 log header, every round to the CM7 log as a
+         * Kind::sync record.
+         * @param rounds Ping-pong rounds.
+         * @return bool false if no round completed within syncTimeoutLoops.
+         */
+        bool synchronize(const std::uint32_t rounds = syncRounds)
+        {
+            SyncPoint best{};
+            for (std::uint32_t round = 0; round < rounds; ++round) {
+                const std::uint32_t sequence{ cell.pong.load(std::memory_order_acquire) + 1 };
+                const std::uint32_t send{ CycleCounter::now() };
+                cell.ping.store(sequence, std::memory_order_release);
+                std::uint32_t loops{ 0 };
+                while (cell.pong.load(std::memory_order_acquire) != sequence && ++loops < syncTimeoutLoops) { BusyWait::relax(); }
+                const std::uint32_t receive{ CycleCounter::now() };
+                if (loops >= syncTimeoutLoops) { break; }
+
+                const SyncPoint point{ sequence, send, cell.peerReceive.load(std::memory_order_relaxed),
+                                       cell.peerSend.load(std::memory_order_relaxed), receive };
+                cm7.write(Kind::sync, static_cast<std::uint16_t>(sequence), point.peerReceive, point.peerSend);
+                if (best.sequence == 0 || point.roundTrip() < best.roundTrip()) { best = point; }
+            }
+            if (best.sequence == 0) { return false; }
+            cm7.setSyncPoint(best);
+            return true;
+        }
+
+        /**
+         * @brief CM4 side of the offset measurement: answer pings until rounds were answered.
+         * @return bool false if the CM7 stopped pinging for syncTimeoutLoops.
+         */
+        bool respondToSync(const std::uint32_t rounds = syncRounds)
+        {
+            for (std::uint32_t round = 0; round < rounds; ++round) {
+                std::uint32_t loops{ 0 };
+                std::uint32_t sequence{ cell.ping.load(std::memory_order_acquire) };
+                while (sequence == cell.pong.load(std::memory_order_relaxed)) {
+                    if (++loops >= syncTimeoutLoops) { return false; }
+                    BusyWait::relax();
+                    sequence = cell.ping.load(std::memory_order_acquire);
+                }
+                cell.peerReceive.store(CycleCounter::now(), std::memory_order_relaxed);
+                cell.peerSend.store(CycleCounter::now(), std::memory_order_relaxed);
+                cell.pong.store(sequence, std::memory_order_release);
+            }
+            return true;
+        }
+    };
+
+    /**
+     * @brief Begin record on construction, end record on destruction.
+     */
+    template<std::size_t Records>
+    class Scope
+    {
+    private:
+        Log<Records>& log;
+        std::uint16_t event;
+
+    public:
+        Scope(Log<Records>& log, const std::uint16_t event, const std::uint32_t arg0 = 0) : log(log), event(event) { log.begin(event, arg0); }
+        ~Scope() { log.end(event); }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+};
+
+#endif // __TRACE_H__
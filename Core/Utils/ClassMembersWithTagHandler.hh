@@ -54,6 +54,13 @@ class classMembersWithTags {
             constexpr std::size_t index = Utils::indexOfEnumValue<EnumValue, Pairs...>::value;
             return std::get<index>(members);
         }
+
+        template <auto EnumValue>
+        requires Utils::EnumInPairs<EnumValue, Pairs...> 
+        constexpr const auto& get() const {
+            constexpr std::size_t index = Utils::indexOfEnumValue<EnumValue, Pairs...>::value;
+            return std::get<index>(members);
+        }
 };
 
 template<typename T>
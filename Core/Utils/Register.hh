@@ -7,6 +7,8 @@
 #include <vector>       //For std::vector
 #include <memory>       //For std::shared_ptr
 #include <algorithm>    //For this for std::find_if
+#include <utility>      //For std::move
+#include <AllocationPolicy.hh> //For Memory::DefaultAllocation
 //<-------------------------------------------------------------------->//
 
 /**
@@ -258,13 +260,19 @@ class Register : public IRegister<UnsignedIntegralPtr>{
         //template <Utils::UnsignedIntegralPointerConcept>
         //friend class SRegister;
 
-        template <Utils::UnsignedIntegralPointerConcept>
+        template <Utils::UnsignedIntegralPointerConcept, typename>
         friend class UniquePtrRegister;
 };
 
 
 
-template <Utils::UnsignedIntegralPointerConcept UnsignedIntegralPtr>
+/**
+ * @brief Register owning its Register instance.
+ * @tparam UnsignedIntegralPtr The type of pointer to a unsigned integral type.
+ * @tparam AllocationPolicy Where the Register instance is allocated, see AllocationPolicy.hh.
+ * Only create() builds one, and never around a missing Register, so every access can dereference it.
+ */
+template <Utils::UnsignedIntegralPointerConcept UnsignedIntegralPtr, typename AllocationPolicy = Memory::DefaultAllocation>
 class UniquePtrRegister : public IRegister<UnsignedIntegralPtr> {
 public:
 
@@ -313,51 +321,83 @@ public:
 
 private:
 
-    constexpr explicit UniquePtrRegister(UnsignedIntegralPtr address)
-            : registerPtr(std::make_unique<Register<UnsignedIntegralPtr>>(address)) {}
+    using Owner = std::unique_ptr<Register<UnsignedIntegralPtr>, Memory::PolicyDeleter<AllocationPolicy>>;
+
+    /**
+     * @brief Take ownership of an allocated Register.
+     * @param registerPtr Must not be null.
+     */
+    constexpr explicit UniquePtrRegister(Owner registerPtr) : registerPtr(std::move(registerPtr)) {}
+
+    /**
+     * @brief Allocate the Register and its owner.
+     * @return UniquePtrRegister* nullptr if either allocation fails, nothing stays allocated then.
+     */
+    constexpr static UniquePtrRegister* create(UnsignedIntegralPtr address)
+    {
+        Owner owned{ AllocationPolicy::template create<Register<UnsignedIntegralPtr>>(address) };
+        if (!owned) {
+            return nullptr;
+        }
+        // The policy only moves from owned once it has a slot, otherwise owned releases the Register
+        return AllocationPolicy::template create<UniquePtrRegister>(std::move(owned));
+    }
 
-    std::unique_ptr<Register<UnsignedIntegralPtr>> registerPtr;
+    Owner registerPtr;
 
-    template <Utils::UnsignedIntegralPointerConcept>
+    template <Utils::UnsignedIntegralPointerConcept, typename>
     friend class SRegister;
 
+    friend AllocationPolicy;
+
 };
 
 
-template <Utils::UnsignedIntegralPointerConcept UnsignedIntegralPtr>
-class SRegister : public UniquePtrRegister<UnsignedIntegralPtr> {
+/**
+ * @brief One shared UniquePtrRegister per register address.
+ * @tparam UnsignedIntegralPtr The type of pointer to a unsigned integral type.
+ * @tparam AllocationPolicy Where the instances and their registry live, see AllocationPolicy.hh.
+ * With the default pool policy getInstance() returns nullptr once the pool is exhausted.
+ */
+template <Utils::UnsignedIntegralPointerConcept UnsignedIntegralPtr, typename AllocationPolicy = Memory::DefaultAllocation>
+class SRegister : public UniquePtrRegister<UnsignedIntegralPtr, AllocationPolicy> {
 //
     private:
 
-        constexpr explicit SRegister(UnsignedIntegralPtr n) : UniquePtrRegister<UnsignedIntegralPtr>(n) {}
+        using Instance = UniquePtrRegister<UnsignedIntegralPtr, AllocationPolicy>;
+
+        constexpr explicit SRegister(typename Instance::Owner registerPtr) : Instance(std::move(registerPtr)) {}
 
-        // Function to access the instances vector
-        static std::vector<UniquePtrRegister<UnsignedIntegralPtr>*>& getInstances() {
+        // Function to access the instances registry
+        static typename AllocationPolicy::template Registry<Instance*>& getInstances() {
             // Local static variable
             //Construct On First Use Idiom
-            static std::vector<UniquePtrRegister<UnsignedIntegralPtr>*> instances;
+            static typename AllocationPolicy::template Registry<Instance*> instances;
             return instances;
         }
 
-        constexpr static UniquePtrRegister<UnsignedIntegralPtr>* createInstance(UnsignedIntegralPtr n) 
+        constexpr static Instance* createInstance(UnsignedIntegralPtr n) 
         {
             #ifdef DEBUG_PRINT
                 std::cout << "Created instance to register: " << std::hex << reinterpret_cast<std::uintptr_t>(n) << std::dec << std::endl;
             #endif
-            UniquePtrRegister<UnsignedIntegralPtr>* newInstance = new UniquePtrRegister<UnsignedIntegralPtr>(n);
+            Instance* newInstance = Instance::create(n);
+            if (newInstance == nullptr) {
+                return nullptr;
+            }
             auto& instances = SRegister::getInstances();
             instances.push_back(newInstance);
             return newInstance;
         }
-        constexpr static UniquePtrRegister<UnsignedIntegralPtr>* findInstance(UnsignedIntegralPtr const n){
+        constexpr static Instance* findInstance(UnsignedIntegralPtr const n){
             #ifdef DEBUG_PRINT
                 std::cout << "Searching for register: " << std::hex << reinterpret_cast<std::uintptr_t>(n) << std::dec << std::endl;
             #endif
-            auto instances = SRegister::getInstances();
+            auto& instances = SRegister::getInstances();
             auto it = std::find_if(
                 instances.begin(), 
                 instances.end(), 
-                [&n](UniquePtrRegister<UnsignedIntegralPtr>* const instance) -> bool {
+                [&n](Instance* const instance) -> bool {
                     return instance->getAddress() == n ;
                 }
             );
@@ -377,7 +417,7 @@ class SRegister : public UniquePtrRegister<UnsignedIntegralPtr> {
         SRegister(const SRegister&) = delete;
         SRegister& operator=(const SRegister&) = delete;
         constexpr ~SRegister() override = default;
-        constexpr static UniquePtrRegister<UnsignedIntegralPtr>* getInstance(UnsignedIntegralPtr n) 
+        constexpr static Instance* getInstance(UnsignedIntegralPtr n) 
         {
             auto it = SRegister::findInstance(n);
             if (it != nullptr) {
@@ -388,11 +428,11 @@ class SRegister : public UniquePtrRegister<UnsignedIntegralPtr> {
 };
 
 
-template<typename T>
+template<typename T, typename AllocationPolicy = Memory::DefaultAllocation>
 requires ((Utils::UnsignedIntegralPointerConcept<T>))
 IRegister<T>* getRegisterInstance(T i)
 {
-    return SRegister<T>::getInstance(i);
+    return SRegister<T, AllocationPolicy>::getInstance(i);
 }
 
 
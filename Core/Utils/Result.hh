@@ -0,0 +1,124 @@
+#ifndef __RESULT_H__
+#define __RESULT_H__
+
+/**
+ * @file Result.hh
+ * @brief Value-or-error return type for code built without exceptions.
+ *
+ * Result<T, E> holds either a T or an error E, Result<void, E> only the error. Failure
+ * is returned explicitly with Utils::fail(error) and checked by the caller, so every
+ * error path is ordinary code with a bounded cost: no unwinder, no .ARM.extab tables.
+ * Values and errors must be trivially copyable, which keeps a Result in registers.
+ *
+ * Usage example:
+ * ```
+ * Utils::Result<std::uint32_t, DriverError> readFifo()
+ * {
+ *     if (!isEnabled()) { return Utils::fail(DriverError::notInitialized); }
+ *     return fifo->DR;
+ * }
+ * DriverStatus init()
+ * {
+ *     RESULT_TRY(configure());        // Returns the error of configure() to the caller
+ *     return {};
+ * }
+ * ```
+ */
+
+//<------------------------------INCLUDES------------------------------>//
+#include <type_traits>
+#include <utility>
+//<-------------------------------------------------------------------->//
+
+namespace Utils
+{
+    /**
+     * @brief Error wrapper converting to any Result with the same error type.
+     */
+    template<typename E>
+    struct Failure {
+        E error;
+    };
+
+    template<typename E>
+    constexpr Failure<E> fail(const E error) { return Failure<E>{ error }; }
+
+    /**
+     * @brief A T on success, an E on failure.
+     *
+     * value() is unchecked, like std::optional::operator*: test the result first or use valueOr().
+     */
+    template<typename T, typename E>
+    class [[nodiscard]] Result
+    {
+        static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_copyable_v<E>, "Result holds trivially copyable types only");
+
+    private:
+        union {
+            T storedValue;
+            E storedError;
+        };
+        bool success;
+
+    public:
+        constexpr Result(const T& value) : storedValue{ value }, success{ true } {}
+        constexpr Result(const Failure<E> failure) : storedError{ failure.error }, success{ false } {}
+
+        constexpr bool hasValue() const { return success; }
+        constexpr explicit operator bool() const { return success; }
+
+        constexpr T& value() { return storedValue; }
+        constexpr const T& value() const { return storedValue; }
+        constexpr E error() const { return storedError; }
+
+        constexpr T valueOr(const T& fallback) const { return success ? storedValue : fallback; }
+
+        /**
+         * @brief Chain a step returning a Result with the same error type.
+         * @return The result of function(value()), or this error unchanged.
+         */
+        template<typename Function>
+        constexpr auto andThen(Function&& function) const -> std::invoke_result_t<Function, const T&>
+        {
+            if (!success) { return fail(storedError); }
+            return std::forward<Function>(function)(storedValue);
+        }
+    };
+
+    /**
+     * @brief Success or an error. Default constructed means success.
+     */
+    template<typename E>
+    class [[nodiscard]] Result<void, E>
+    {
+        static_assert(std::is_trivially_copyable_v<E>, "Result holds trivially copyable types only");
+
+    private:
+        E storedError{};
+        bool success{ true };
+
+    public:
+        constexpr Result() = default;
+        constexpr Result(const Failure<E> failure) : storedError{ failure.error }, success{ false } {}
+
+        constexpr bool hasValue() const { return success; }
+        constexpr explicit operator bool() const { return success; }
+        constexpr E error() const { return storedError; }
+
+        template<typename Function>
+        constexpr auto andThen(Function&& function) const -> std::invoke_result_t<Function>
+        {
+            if (!success) { return fail(storedError); }
+            return std::forward<Function>(function)();
+        }
+    };
+};
+
+/// Evaluate a Result and return its error from the enclosing function on failure.
+#define RESULT_TRY(expression)                                              \
+    do {                                                                    \
+        const auto resultTryValue{ (expression) };                          \
+        if (!resultTryValue) { return Utils::fail(resultTryValue.error()); } \
+    } while (0)
+
+#endif // __RESULT_H__
@@ -1,5 +1,7 @@
 #define CORE_CM4
 #include <stm32h755xx.h>
+#include <Cache.hh>
+#include <DualCoreBoot.hh>
 
 extern "C"{
 
@@ -8,6 +10,11 @@ extern "C"{
 
 int main(void)
 {
+    DualCoreBoot::signalCm4Ready();
+    while (1)
+    {
+        __WFI();
+    }
 
     return 0;
 }
@@ -15,6 +22,7 @@ int main(void)
 
 void SystemInit(void)
 {
-    
+    // Sleeps until the CM7 configured clocks and memories, see DualCoreBoot.hh
+    DualCoreBoot::parkCm4();
+    Cache::enable();
 }
-    
\ No newline at end of file
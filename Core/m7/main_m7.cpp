@@ -1,5 +1,9 @@
 #define CORE_CM7
 #include <stm32h755xx.h>
+#include <Cache.hh>
+#include <Mpu.hh>
+#include <ClockTree.hh>
+#include <DualCoreBoot.hh>
 #include <InputPin.hh>
 #include <Register.hh>
 
@@ -14,6 +18,7 @@ InputPinHandler A{a};
 
 int main(void)
 {
+    static_cast<void>(DualCoreBoot::waitForCm4Ready());
     //A.setParam<InputPinProperties::pinState>(true);
     A.getParam<InputPinProperties::pinState>();
     while (1)
@@ -27,6 +32,7 @@ int main(void)
 
 void SystemInit(void)
 {
-    
+    // Clocks, MPU and caches, then releases the parked CM4
+    static_cast<void>(DualCoreBoot::bootCm7(ClockTree::bootConfig));
 }
     
\ No newline at end of file
@@ -32,19 +32,34 @@
 .global  g_pfnVectors
 .global  Default_Handler
 
-/* start address for the initialization values of the .data section.
-defined in linker script */
-.word  _sidata
-/* start address for the .data section. defined in linker script */
-.word  _sdata
-/* end address for the .data section. defined in linker script */
-.word  _edata
-/* start address for the .bss section. defined in linker script */
-.word  _sbss
-/* end address for the .bss section. defined in linker script */
-.word  _ebss
+/* start address of the (load, run, size) copy table. defined in linker script */
+.word  __copy_table_start
+/* end address of the copy table. defined in linker script */
+.word  __copy_table_end
+/* start address of the (run, size) zero table. defined in linker script */
+.word  __zero_table_start
+/* end address of the zero table. defined in linker script */
+.word  __zero_table_end
 /* stack used for SystemInit_ExtMemCtl; always internal RAM used */
 
+/* DWT registers used to measure the boot time */
+.equ  DEMCR,      0xE000EDFC
+.equ  DWT_CTRL,   0xE0001000
+.equ  DWT_CYCCNT, 0xE0001004
+.equ  DWT_LAR,    0xE0001FB0
+
+/* Fill value of the MSP stack reserve, must match StackMonitor::paintPattern */
+.equ  STACK_PAINT, 0xC5C5C5C5
+
+/* Cycles elapsed between reset and the call to main(), read by BootStats.hh */
+  .section  .bss.__boot_cycles,"aw",%nobits
+  .align 2
+  .global  __boot_cycles
+  .type  __boot_cycles, %object
+__boot_cycles:
+  .space 4
+  .size  __boot_cycles, .-__boot_cycles
+
 /**
  * @brief  This is the code that gets called when the processor first
  *          starts execution following a reset event. Only the absolutely
@@ -60,46 +75,145 @@ defined in linker script */
 Reset_Handler:
   ldr   sp, =_estack      /* set stack pointer */
 
+/* Start the cycle counter so the time spent up to main() can be measured */
+  ldr r0, =DEMCR
+  ldr r1, [r0]
+  orr r1, r1, #0x01000000 /* TRCENA */
+  str r1, [r0]
+  ldr r0, =DWT_LAR
+  ldr r1, =0xC5ACCE55     /* unlock the DWT, required on the CM7 */
+  str r1, [r0]
+  ldr r0, =DWT_CYCCNT
+  movs r1, #0
+  str r1, [r0]
+  ldr r0, =DWT_CTRL
+  ldr r1, [r0]
+  orr r1, r1, #1          /* CYCCNTENA */
+  str r1, [r0]
+
+/* Paint the MSP stack reserve [_estack - _Min_Stack_Size, _estack) for StackMonitor.
+   Nothing is on the stack yet, so the whole reserve can be written */
+  ldr r0, =_estack
+  ldr r1, =_Min_Stack_Size
+  subs r1, r0, r1
+  ldr r2, =STACK_PAINT
+
+LoopPaintStack:
+  str r2, [r1], #4
+  cmp r1, r0
+  bcc LoopPaintStack
+
 /* Call the clock system initialization function.*/
   bl  SystemInit
 
-/* Copy the data segment initializers from flash to SRAM */
-  ldr r0, =_sdata
-  ldr r1, =_edata
-  ldr r2, =_sidata
-  movs r3, #0
-  b LoopCopyDataInit
-
-CopyDataInit:
-  ldr r4, [r2, r3]
-  str r4, [r0, r3]
-  adds r3, r3, #4
-
-LoopCopyDataInit:
-  adds r4, r0, r3
-  cmp r4, r1
-  bcc CopyDataInit
-/* Zero fill the bss segment. */
-  ldr r2, =_sbss
-  ldr r4, =_ebss
-  movs r3, #0
-  b LoopFillZerobss
+/* Copy every (load, run, size) entry of the copy table: .data, .itcm_text */
+  ldr r4, =__copy_table_start
+  ldr r5, =__copy_table_end
+  b LoopCopyTable
 
-FillZerobss:
-  str  r3, [r2]
-  adds r2, r2, #4
+CopyTableEntry:
+  ldmia r4!, {r0, r1, r2}
+  bl BurstCopy
 
-LoopFillZerobss:
-  cmp r2, r4
-  bcc FillZerobss
+LoopCopyTable:
+  cmp r4, r5
+  bcc CopyTableEntry
+
+/* Zero every (run, size) entry of the zero table: .bss, .axi_bss */
+  ldr r4, =__zero_table_start
+  ldr r5, =__zero_table_end
+  b LoopZeroTable
+
+ZeroTableEntry:
+  ldmia r4!, {r0, r1}
+  bl BurstZero
+
+LoopZeroTable:
+  cmp r4, r5
+  bcc ZeroTableEntry
 
 /* Call static constructors */
     bl __libc_init_array
+
+/* Record the boot time */
+  ldr r0, =DWT_CYCCNT
+  ldr r1, [r0]
+  ldr r0, =__boot_cycles
+  str r1, [r0]
+
 /* Call the application's entry point.*/
   bl  main
   bx  lr
 .size  Reset_Handler, .-Reset_Handler
 
+/**
+ * @brief  Copy a region 16 bytes per iteration, then the remaining words.
+ * @param  r0: source address, r1: destination address, r2: size in bytes
+ *         (multiple of 4). Clobbers r0-r3, r6-r8.
+ * @retval None
+*/
+    .section  .text.BurstCopy,"ax",%progbits
+  .type  BurstCopy, %function
+BurstCopy:
+  subs r2, r2, #16
+  bcc BurstCopyTail
+
+BurstCopyBlock:
+  ldmia r0!, {r3, r6, r7, r8}
+  stmia r1!, {r3, r6, r7, r8}
+  subs r2, r2, #16
+  bcs BurstCopyBlock
+
+BurstCopyTail:
+  adds r2, r2, #16
+  b LoopBurstCopyWord
+
+BurstCopyWord:
+  ldr r3, [r0], #4
+  str r3, [r1], #4
+  subs r2, r2, #4
+
+LoopBurstCopyWord:
+  cmp r2, #0
+  bgt BurstCopyWord
+  bx  lr
+  .size  BurstCopy, .-BurstCopy
+
+/**
+ * @brief  Zero a region 16 bytes per iteration, then the remaining words.
+ * @param  r0: destination address, r1: size in bytes (multiple of 4).
+ *         Clobbers r0-r3, r6, r7.
+ * @retval None
+*/
+    .section  .text.BurstZero,"ax",%progbits
+  .type  BurstZero, %function
+BurstZero:
+  movs r2, #0
+  movs r3, #0
+  movs r6, #0
+  movs r7, #0
+  subs r1, r1, #16
+  bcc BurstZeroTail
+
+BurstZeroBlock:
+  stmia r0!, {r2, r3, r6, r7}
+  subs r1, r1, #16
+  bcs BurstZeroBlock
+
+BurstZeroTail:
+  adds r1, r1, #16
+  b LoopBurstZeroWord
+
+BurstZeroWord:
+  str r2, [r0], #4
+  subs r1, r1, #4
+
+LoopBurstZeroWord:
+  cmp r1, #0
+  bgt BurstZeroWord
+  bx  lr
+  .size  BurstZero, .-BurstZero
+
 /**
  * @brief  This is the code that gets called when the processor receives an
  *         unexpected interrupt.  This simply enters an infinite loop, preserving
@@ -0,0 +1,228 @@
+#include "UnitTest.hh"
+#include "MdmaModel.hh"
+#include "ModelSupport.hh"
+#include <AsyncMemory.hh>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+    // The copier at the start of AXI SRAM, data after it, in SRAM1 and in DTCM
+    constexpr std::uint32_t copierBase{ TestBus::axiSram };
+    constexpr std::uint32_t axiBase{ TestBus::axiSram + 0x10000 };
+    constexpr std::uint32_t unmapped{ TestBus::axiSram + 0x70000 };
+    constexpr std::size_t bufferSize{ 150000 };
+
+    /// Bus addresses of the host memory the model maps; anything else is unmapped.
+    struct TestAddress {
+        struct Entry {
+            const std::uint8_t* host;
+            std::size_t size;
+            std::uint32_t address;
+        };
+
+        static inline std::vector<Entry> entries;
+
+        static std::uint32_t of(const void* pointer)
+        {
+            const auto* byte{ static_cast<const std::uint8_t*>(pointer) };
+            for (const Entry& entry : entries) {
+                if (byte >= entry.host && byte < entry.host + entry.size) { return entry.address + static_cast<std::uint32_t>(byte - entry.host); }
+            }
+            return unmapped;
+        }
+    };
+
+    /// Registers an object before the members after it are built.
+    struct Registration {
+        Registration(const void* host, const std::size_t size, const std::uint32_t address)
+        {
+            TestAddress::entries.push_back(TestAddress::Entry{ static_cast<const std::uint8_t*>(host), size, address });
+        }
+
+        ~Registration() { TestAddress::entries.clear(); }
+    };
+
+    template<std::size_t Pending, std::size_t Nodes>
+    struct Bus {
+        using Copier = AsyncMemory::AsyncCopier<Pending, Nodes, TestAddress>;
+
+        Registration self;
+        MdmaModel model;
+        std::vector<std::uint8_t> axi;
+        std::vector<std::uint8_t> sram1;
+        std::vector<std::uint8_t> dtcm;
+        Copier copier;
+
+        explicit Bus(const AsyncMemory::Thresholds& thresholds = AsyncMemory::defaultThresholds)
+            : self(this, sizeof(Bus), copierBase), axi(bufferSize), sram1(bufferSize), dtcm(4096), copier(model.handler(1), thresholds)
+        {
+            for (std::size_t index = 0; index < bufferSize; ++index) { axi[index] = static_cast<std::uint8_t>(index * 7 + 1); }
+            model.map(copierBase, this, sizeof(Bus));
+            mapData(axiBase, axi);
+            mapData(TestBus::sram1, sram1);
+            mapData(TestBus::dtcm, dtcm);
+        }
+
+        void mapData(const std::uint32_t address, std::vector<std::uint8_t>& buffer)
+        {
+            TestAddress::entries.push_back(TestAddress::Entry{ buffer.data(), buffer.size(), address });
+            model.map(address, buffer.data(), buffer.size());
+        }
+
+        bool copied(const std::size_t destination, const std::size_t source, const std::size_t bytes) const
+        {
+            return std::equal(axi.begin() + static_cast<std::ptrdiff_t>(source), axi.begin() + static_cast<std::ptrdiff_t>(source + bytes),
+                              sram1.begin() + static_cast<std::ptrdiff_t>(destination));
+        }
+    };
+
+    void testRegionsAndCrossover()
+    {
+        using AsyncMemory::Region;
+        TEST_CHECK(AsyncMemory::regionOf(0x00000400) == Region::itcm && AsyncMemory::regionOf(0x2001FFFF) == Region::dtcm);
+        TEST_CHECK(AsyncMemory::regionOf(0x24000000) == Region::axiSram && AsyncMemory::regionOf(0x30040000) == Region::d2Sram);
+        TEST_CHECK(AsyncMemory::regionOf(0x38000000) == Region::sram4 && AsyncMemory::regionOf(0xC0000000) == Region::other);
+        TEST_CHECK(!AsyncMemory::isCached(Region::dtcm) && AsyncMemory::isCached(Region::d2Sram));
+
+        // Fixed cost 500 against one cycle per byte: the MDMA wins from 512 bytes
+        const auto cpu = [](const std::uint32_t bytes) { return 2.0 * bytes; };
+        const auto dma = [](const std::uint32_t bytes) { return 500.0 + bytes; };
+        TEST_CHECK(AsyncMemory::findCrossover(cpu, dma) == 512);
+        TEST_CHECK(AsyncMemory::findCrossover(cpu, dma, 256) == AsyncMemory::never);
+        TEST_CHECK(AsyncMemory::findCrossover(dma, cpu) == AsyncMemory::never);
+
+        // A win at one size only does not count
+        const auto bump = [](const std::uint32_t bytes) { return bytes == 64 ? 0.0 : 4.0 * bytes; };
+        TEST_CHECK(AsyncMemory::findCrossover(cpu, bump) == AsyncMemory::never);
+    }
+
+    void testCpuFunctions()
+    {
+        std::vector<std::uint8_t> source(300);
+        std::vector<std::uint8_t> destination(304, 0);
+        for (std::size_t index = 0; index < source.size(); ++index) { source[index] = static_cast<std::uint8_t>(index); }
+        AsyncMemory::cpuCopy(destination.data() + 1, source.data() + 2, 290);
+        TEST_CHECK(destination[0] == 0 && std::equal(source.begin() + 2, source.begin() + 292, destination.begin() + 1) && destination[291] == 0);
+        AsyncMemory::cpuFill(destination.data() + 3, 0x5C, 101);
+        TEST_CHECK(destination[2] == 3 && destination[3] == 0x5C && destination[103] == 0x5C && destination[104] == 105);
+    }
+
+    void testDispatch()
+    {
+        Bus<4, 2> bus;
+
+        // AXI SRAM to SRAM1 below the threshold: on the CPU, complete on return
+        const auto small{ bus.copier.copyAsync(bus.sram1.data(), bus.axi.data(), 512) };
+        TEST_CHECK(small.hasValue() && bus.copier.isComplete(small.value()) && bus.copier.pending() == 0 && bus.copied(0, 0, 512));
+        TEST_CHECK(bus.model.nodesLoaded(1) == 0 && !bus.model.interruptPending(1));
+
+        // Above it: on the MDMA, complete once the channel reported
+        const auto large{ bus.copier.copyAsync(bus.sram1.data() + 1000, bus.axi.data() + 3, 8000) };
+        TEST_CHECK(large.hasValue() && !bus.copier.isComplete(large.value()) && bus.copier.pending() == 1);
+        TEST_CHECK(bus.copier.wait(large.value()).hasValue() && bus.copier.isComplete(large.value()) && bus.copied(1000, 3, 8000));
+        TEST_CHECK(bus.copier.pending() == 0);
+
+        // Forced either way
+        const auto forced{ bus.copier.copyAsync(bus.sram1.data(), bus.axi.data() + 64, 64, AsyncMemory::Dispatch::dma) };
+        TEST_CHECK(forced.hasValue() && !bus.copier.isComplete(forced.value()) && bus.copier.wait(forced.value()).hasValue() && bus.copied(0, 64, 64));
+        const auto cpu{ bus.copier.copyAsync(bus.sram1.data(), bus.axi.data() + 128, 20000, AsyncMemory::Dispatch::cpu) };
+        TEST_CHECK(cpu.hasValue() && bus.copier.isComplete(cpu.value()) && bus.copied(0, 128, 20000));
+
+        // TCM to TCM never leaves the CPU
+        const auto tcm{ bus.copier.copyAsync(bus.dtcm.data(), bus.dtcm.data() + 2048, 2048) };
+        TEST_CHECK(tcm.hasValue() && bus.copier.isComplete(tcm.value()));
+
+        // A new table moves the crossover
+        AsyncMemory::Thresholds table{ AsyncMemory::defaultThresholds };
+        table.copy[static_cast<std::size_t>(AsyncMemory::Region::axiSram)][static_cast<std::size_t>(AsyncMemory::Region::d2Sram)] = AsyncMemory::never;
+        bus.copier.setThresholds(table);
+        const auto kept{ bus.copier.copyAsync(bus.sram1.data(), bus.axi.data(), 60000) };
+        TEST_CHECK(kept.hasValue() && bus.copier.isComplete(kept.value()) && bus.copied(0, 0, 60000));
+        TEST_CHECK(bus.copier.thresholdTable().copyFrom(AsyncMemory::Region::axiSram, AsyncMemory::Region::d2Sram) == AsyncMemory::never);
+    }
+
+    void testFill()
+    {
+        Bus<4, 2> bus;
+        const auto token{ bus.copier.fillAsync(bus.sram1.data() + 3, 0xA5, 20000) };
+        TEST_CHECK(token.hasValue() && !bus.copier.isComplete(token.value()) && bus.copier.wait(token.value()).hasValue());
+        TEST_CHECK(bus.sram1[2] == 0 && bus.sram1[20003] == 0);
+        TEST_CHECK(std::all_of(bus.sram1.begin() + 3, bus.sram1.begin() + 20003, [](const std::uint8_t value) { return value == 0xA5; }));
+
+        // A second fill reuses the pattern with another value
+        const auto second{ bus.copier.fillAsync(bus.sram1.data() + 8, 0x3C, 70000) };
+        TEST_CHECK(second.hasValue() && bus.copier.wait(second.value()).hasValue() && bus.sram1[7] == 0xA5 && bus.sram1[70008] == 0);
+        TEST_CHECK(std::all_of(bus.sram1.begin() + 8, bus.sram1.begin() + 70008, [](const std::uint8_t value) { return value == 0x3C; }));
+
+        // The node the copier builds
+        MdmaChain<2> chain{ axiBase };
+        TEST_CHECK(chain.fill(TestBus::sram1 + 1, axiBase + 4, 16).error() == DriverError::invalidParameter);
+        TEST_CHECK(chain.fill(TestBus::sram1 + 1, axiBase, 70000).hasValue() && chain.size() == 2 && chain.validate().hasValue());
+        TEST_CHECK(chain.node(0).source == axiBase && chain.node(1).source == axiBase && chain.node(1).destination == TestBus::sram1 + 1 + 65536);
+    }
+
+    void testOrdering()
+    {
+        Bus<4, 2> bus;
+
+        // A small copy behind MDMA work waits its turn
+        const auto large{ bus.copier.copyAsync(bus.sram1.data(), bus.axi.data(), 16384) };
+        const auto small{ bus.copier.copyAsync(bus.sram1.data() + 100, bus.axi.data() + 50000, 64) };
+        TEST_CHECK(large.hasValue() && small.hasValue() && bus.copier.pending() == 2 && !bus.copier.isComplete(small.value()));
+        TEST_CHECK(bus.copier.copyAsync(bus.sram1.data(), bus.axi.data(), 64, AsyncMemory::Dispatch::cpu).error() == DriverError::busy);
+        TEST_CHECK(bus.copier.wait(small.value()).hasValue() && bus.copier.isComplete(large.value()));
+        TEST_CHECK(bus.copied(0, 0, 100) && bus.copied(100, 50000, 64) && bus.copied(164, 164, 16384 - 164));
+
+        // Queue full
+        for (std::size_t index = 0; index < 4; ++index) {
+            TEST_CHECK(bus.copier.copyAsync(bus.sram1.data() + index * 4096, bus.axi.data(), 4096).hasValue());
+        }
+        TEST_CHECK(bus.copier.copyAsync(bus.sram1.data(), bus.axi.data(), 4096).error() == DriverError::outOfResources);
+        TEST_CHECK(bus.copier.fillAsync(bus.sram1.data(), 0, 4096).error() == DriverError::outOfResources);
+        const auto last{ bus.copier.copyAsync(bus.sram1.data() + 20000, bus.axi.data(), 16, AsyncMemory::Dispatch::automatic) };
+        TEST_CHECK(last.error() == DriverError::outOfResources);
+        bus.copier.poll();
+        TEST_CHECK(bus.copier.pending() == 3);
+    }
+
+    void testSegments()
+    {
+        // One node per chain: 150000 bytes take three chains
+        Bus<2, 1> bus;
+        const auto token{ bus.copier.copyAsync(bus.sram1.data(), bus.axi.data(), bufferSize) };
+        TEST_CHECK(token.hasValue());
+        bus.copier.poll();
+        TEST_CHECK(!bus.copier.isComplete(token.value()) && bus.copier.pending() == 1);
+        TEST_CHECK(bus.copier.wait(token.value()).hasValue() && bus.sram1 == bus.axi);
+    }
+
+    void testErrors()
+    {
+        Bus<4, 2> bus;
+        TEST_CHECK(bus.copier.copyAsync(bus.axi.data() + 100, bus.axi.data(), 200).error() == DriverError::invalidParameter);
+        TEST_CHECK(bus.copier.copyAsync(bus.axi.data(), bus.axi.data() + 100, 200).error() == DriverError::invalidParameter);
+        TEST_CHECK(bus.copier.copyAsync(bus.sram1.data(), bus.axi.data(), 0).error() == DriverError::invalidParameter);
+        TEST_CHECK(bus.copier.fillAsync(bus.sram1.data(), 0, 0).error() == DriverError::invalidParameter);
+
+        // Destination the model does not map: bus error, the next operation still runs
+        std::vector<std::uint8_t> outside(4096);
+        const auto failed{ bus.copier.copyAsync(outside.data(), bus.axi.data(), outside.size(), AsyncMemory::Dispatch::dma) };
+        const auto next{ bus.copier.copyAsync(bus.sram1.data(), bus.axi.data(), 4096, AsyncMemory::Dispatch::dma) };
+        TEST_CHECK(failed.hasValue() && next.hasValue());
+        TEST_CHECK(bus.copier.wait(failed.value()).error() == DriverError::hardwareFault);
+        TEST_CHECK(bus.copier.wait(next.value()).hasValue() && bus.copied(0, 0, 4096) && bus.copier.pending() == 0);
+    }
+};
+
+void runAsyncMemoryTests()
+{
+    testRegionsAndCrossover();
+    testCpuFunctions();
+    testDispatch();
+    testFill();
+    testOrdering();
+    testSegments();
+    testErrors();
+}
@@ -0,0 +1,71 @@
+#ifndef __BDMAMODEL_H__
+#define __BDMAMODEL_H__
+
+/**
+ * @file BdmaModel.hh
+ * @brief Behavioral model of the BDMA channels and DMAMUX2 for host tests.
+ *
+ * The channel model of DmaChannelModel.hh with the BDMA specifics: ISR and IFCR hold
+ * all 8 channels, and the global flag of a channel rises with each of its flags and
+ * clears them all.
+ */
+
+//<------------------------------INCLUDES------------------------------>//
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <Bdma.hh>
+#include "DmaChannelModel.hh"
+#include "ModelSupport.hh"
+//<-------------------------------------------------------------------->//
+
+class BdmaModel : public DmaChannelModel<Bdma::ChannelLayout, Bdma::channelCount, Bdma::channelCount, Bdma::globalFlag>
+{
+    public:
+        using ModelRegister = HostRegister<BdmaModel, std::uint32_t, BdmaChannelRegisters>;
+        friend ModelRegister;
+
+        /// Registers of one channel, in the order BdmaChannelHandler takes them.
+        struct View {
+            ModelRegister control, count, peripheralAddress, memory0Address, memory1Address, interruptStatus, interruptClear, muxControl;
+
+            View(BdmaModel& model, const std::uint32_t channel)
+                : control(model, channel, BdmaChannelRegisters::control), count(model, channel, BdmaChannelRegisters::count),
+                  peripheralAddress(model, channel, BdmaChannelRegisters::peripheralAddress),
+                  memory0Address(model, channel, BdmaChannelRegisters::memory0Address), memory1Address(model, channel, BdmaChannelRegisters::memory1Address),
+                  interruptStatus(model, channel, BdmaChannelRegisters::interruptStatus), interruptClear(model, channel, BdmaChannelRegisters::interruptClear),
+                  muxControl(model, channel, BdmaChannelRegisters::muxControl) {}
+        };
+
+        /**
+         * @brief Handler of a channel, running on the model.
+         */
+        BdmaChannelHandler& handler(const std::uint8_t channel)
+        {
+            views.push_back(std::make_unique<View>(*this, channel));
+            View& view{ *views.back() };
+            auto handle = [](ModelRegister& reg) -> IRegister<volatile std::uint32_t*>* { return &reg; };
+            handlers.push_back(std::make_unique<BdmaChannelHandler>(channel, registerHandles, handle(view.control), handle(view.count),
+                handle(view.peripheralAddress), handle(view.memory0Address), handle(view.memory1Address),
+                handle(view.interruptStatus), handle(view.interruptClear), handle(view.muxControl)));
+            return *handlers.back();
+        }
+
+        /**
+         * @brief Serve items requests of a channel: move items data items of the peripheral size.
+         * @return std::uint32_t Items moved, fewer if the channel stopped.
+         */
+        std::uint32_t transfer(const std::uint8_t channel, const std::uint32_t items) { return serve(channel, items); }
+
+        /// Whether an enabled interrupt of the channel is pending, the NVIC line.
+        bool interruptPending(const std::uint8_t channel) { return (channels[channel].flags & enabledFlags(channels[channel])) != 0; }
+
+        /// DMAMUX2 request routed to a channel.
+        std::uint32_t request(const std::uint8_t channel) { return channels[channel].mux; }
+
+    private:
+        std::vector<std::unique_ptr<View>> views;
+        std::vector<std::unique_ptr<BdmaChannelHandler>> handlers;
+};
+
+#endif // __BDMAMODEL_H__
@@ -0,0 +1,187 @@
+#include "UnitTest.hh"
+#include "BdmaModel.hh"
+#include "ModelSupport.hh"
+#include <Bdma.hh>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+    // Data register of a D3 peripheral
+    constexpr std::uint32_t dataRegister{ 0x58026040 };
+
+    using Events = EventLog<BdmaEvent, std::uint8_t>;
+
+    /// Peripheral producing a counter, one item per request; counts the interrupts served.
+    struct Peripheral {
+        BdmaModel& model;
+        BdmaChannelHandler& channel;
+        std::uint8_t number;
+        std::uint32_t data{ 0 };
+        std::uint32_t next{ 0 };
+        std::uint32_t interrupts{ 0 };
+
+        Peripheral(BdmaModel& model, BdmaChannelHandler& channel, const std::uint8_t number) : model(model), channel(channel), number(number)
+        {
+            model.map(dataRegister, &data, sizeof(data));
+        }
+
+        void produce(const std::uint32_t items)
+        {
+            for (std::uint32_t item = 0; item < items; ++item) {
+                data = next++;
+                model.transfer(number, 1);
+                if (model.interruptPending(number)) {
+                    channel.handleInterrupt();
+                    ++interrupts;
+                }
+            }
+        }
+    };
+
+    void testEncoding()
+    {
+        constexpr BdmaConfig config{ .direction = BdmaDirection::memoryToPeripheral, .peripheralSize = DmaDataSize::halfWord,
+                                     .memorySize = DmaDataSize::word, .mode = DmaMode::doubleBuffer, .priority = DmaPriority::high };
+        static_assert(Bdma::controlValue(config) == ((1U << 4) | (1U << 5) | (1U << 7) | (1U << 8) | (2U << 10) | (2U << 12) | (1U << 15)));
+        static_assert(Bdma::controlValue(BdmaConfig{ .mode = DmaMode::circular }) == ((1U << 5) | (1U << 7)));
+        static_assert(Bdma::flagShift(0) == 0 && Bdma::flagShift(7) == 28);
+        static_assert(static_cast<std::uint8_t>(Bdma::Request::lpuart1Rx) == 9 && static_cast<std::uint8_t>(Bdma::Request::adc3) == 17);
+        TEST_CHECK(Dma::bytesOf(DmaDataSize::word) == 4);
+    }
+
+    void testChecks()
+    {
+        BdmaModel model;
+        BdmaChannelHandler& channel{ model.handler(2) };
+        TEST_CHECK(channel.start(dataRegister, TestBus::sram4, 16).error() == DriverError::notInitialized);
+        TEST_CHECK(channel.configure(BdmaConfig{ .request = Bdma::Request::spi6Rx, .peripheralSize = DmaDataSize::halfWord,
+                                                 .memorySize = DmaDataSize::halfWord }).hasValue());
+        TEST_CHECK(model.request(2) == 11);
+
+        // SRAM4 only, whole items
+        TEST_CHECK(channel.start(dataRegister, TestBus::axiSram, 16).error() == DriverError::invalidParameter);
+        TEST_CHECK(channel.start(dataRegister, TestBus::sram4 + 0xFFF0, 16).error() == DriverError::invalidParameter);
+        TEST_CHECK(channel.start(dataRegister, TestBus::sram4 + 1, 16).error() == DriverError::invalidParameter);
+        TEST_CHECK(channel.start(dataRegister, TestBus::sram4, 0).error() == DriverError::invalidParameter);
+        TEST_CHECK(channel.startDoubleBuffer(dataRegister, TestBus::sram4, TestBus::sram4 + 64, 16).error() == DriverError::invalidParameter);
+
+        std::array<std::uint16_t, 16> buffer{};
+        model.map(TestBus::sram4, buffer.data(), sizeof(buffer));
+        TEST_CHECK(channel.start(dataRegister, TestBus::sram4, 16).hasValue() && channel.isEnabled());
+        TEST_CHECK(channel.start(dataRegister, TestBus::sram4, 16).error() == DriverError::busy);
+        TEST_CHECK(channel.configure(BdmaConfig{}).error() == DriverError::busy);
+        TEST_CHECK(channel.stop().hasValue() && !channel.isEnabled());
+    }
+
+    void testCircular()
+    {
+        BdmaModel model;
+        BdmaChannelHandler& channel{ model.handler(3) };
+        Peripheral adc{ model, channel, 3 };
+        std::array<std::uint8_t, 8> buffer{};
+        model.map(TestBus::sram4, buffer.data(), buffer.size());
+        Events log;
+        TEST_CHECK(channel.configure(BdmaConfig{ .request = Bdma::Request::adc3, .mode = DmaMode::circular, .halfTransferInterrupt = true }, &Events::record, &log).hasValue());
+        TEST_CHECK(channel.start(dataRegister, TestBus::sram4, 8).hasValue());
+
+        adc.produce(3);
+        TEST_CHECK(log.events.empty() && channel.remaining() == 5);
+        adc.produce(13);
+        TEST_CHECK(log.events == (std::vector<BdmaEvent>{ BdmaEvent::halfTransfer, BdmaEvent::transferComplete, BdmaEvent::halfTransfer, BdmaEvent::transferComplete }));
+        TEST_CHECK(buffer[0] == 8 && buffer[7] == 15 && channel.isEnabled() && channel.remaining() == 8);
+
+        // Without the callback the flags stay for polling
+        TEST_CHECK(channel.stop().hasValue());
+        TEST_CHECK(channel.configure(BdmaConfig{ .mode = DmaMode::normal }).hasValue() && channel.start(dataRegister, TestBus::sram4, 4).hasValue());
+        adc.produce(4);
+        TEST_CHECK(!channel.isEnabled() && (channel.flags() & Bdma::transferCompleteFlag) != 0 && channel.handleInterrupt() == 0);
+        channel.clearFlags(Bdma::allFlags);
+        TEST_CHECK(channel.flags() == 0);
+    }
+
+    void testDoubleBuffer()
+    {
+        BdmaModel model;
+        BdmaChannelHandler& channel{ model.handler(5) };
+        Peripheral uart{ model, channel, 5 };
+        std::array<std::uint8_t, 8> buffers{};
+        model.map(TestBus::sram4, buffers.data(), buffers.size());
+        Events log;
+        TEST_CHECK(channel.configure(BdmaConfig{ .request = Bdma::Request::lpuart1Rx, .mode = DmaMode::doubleBuffer }, &Events::record, &log).hasValue());
+        TEST_CHECK(channel.start(dataRegister, TestBus::sram4, 4).error() == DriverError::invalidParameter);
+        TEST_CHECK(channel.startDoubleBuffer(dataRegister, TestBus::sram4, TestBus::sram4 + 4, 4).hasValue());
+
+        uart.produce(12);
+        TEST_CHECK(log.arguments == (std::vector<std::uint8_t>{ 0, 1, 0 }) && channel.currentBuffer() == 1);
+        TEST_CHECK(buffers[0] == 8 && buffers[3] == 11 && buffers[4] == 4 && buffers[7] == 7);
+        TEST_CHECK(uart.interrupts == 3);
+    }
+
+    void testCapture()
+    {
+        BdmaModel model;
+        BdmaChannelHandler& channel{ model.handler(0) };
+        Peripheral adc{ model, channel, 0 };
+        BdmaCapture<std::uint16_t, 8> capture;
+        model.map(TestBus::sram4, &capture, sizeof(capture));
+
+        // The object must be in SRAM4
+        TEST_CHECK(capture.start(channel, Bdma::Request::adc3, dataRegister, DmaPriority::medium, TestBus::axiSram).error() == DriverError::invalidParameter);
+        TEST_CHECK(capture.start(channel, Bdma::Request::adc3, dataRegister, DmaPriority::medium, TestBus::sram4).hasValue() && capture.isRunning());
+        TEST_CHECK(!capture.front().isValid() && capture.pop());
+
+        // One interrupt per full block, none for the items
+        adc.produce(7);
+        TEST_CHECK(!capture.front().isValid() && adc.interrupts == 0);
+        adc.produce(1);
+        BdmaCapture<std::uint16_t, 8>::Block block{ capture.front() };
+        TEST_CHECK(block.isValid() && block.items == 8 && block.sequence == 0 && block.data[0] == 0 && block.data[7] == 7 && adc.interrupts == 1);
+        adc.produce(4);
+        TEST_CHECK(capture.pop() && !capture.front().isValid());
+        adc.produce(4);
+        block = capture.front();
+        TEST_CHECK(block.isValid() && block.sequence == 1 && block.data[0] == 8 && block.data[7] == 15 && capture.pop());
+
+        // Three blocks without a pop: the channel overwrote the first and writes over the second
+        adc.produce(24);
+        block = capture.front();
+        TEST_CHECK(block.isValid() && block.sequence == 4 && block.data[0] == 32 && capture.statistics().overruns == 2);
+
+        // Held too long: the channel got back to the block before pop()
+        adc.produce(8);
+        TEST_CHECK(!capture.pop() && capture.statistics().overruns == 3);
+        block = capture.front();
+        TEST_CHECK(block.isValid() && block.sequence == 5 && block.data[0] == 40 && capture.pop());
+
+        const auto statistics{ capture.statistics() };
+        TEST_CHECK(statistics.blocks == 6 && adc.interrupts == 6 && statistics.errors == 0);
+        TEST_CHECK(capture.stop().hasValue() && !capture.isRunning());
+    }
+
+    void testCaptureError()
+    {
+        BdmaModel model;
+        BdmaChannelHandler& channel{ model.handler(1) };
+        BdmaCapture<std::uint32_t, 4> capture;
+        TEST_CHECK(capture.stop().error() == DriverError::notInitialized);
+        model.map(TestBus::sram4, &capture, sizeof(capture));
+
+        // Nothing at the peripheral address: bus error, the channel stops
+        TEST_CHECK(capture.start(channel, Bdma::Request::spi6Rx, dataRegister, DmaPriority::high, TestBus::sram4).hasValue());
+        model.transfer(1, 1);
+        TEST_CHECK(model.interruptPending(1) && channel.handleInterrupt() == Bdma::transferErrorFlag);
+        TEST_CHECK(!capture.isRunning() && capture.statistics().errors == 1 && !capture.front().isValid());
+    }
+};
+
+void runBdmaTests()
+{
+    testEncoding();
+    testChecks();
+    testCircular();
+    testDoubleBuffer();
+    testCapture();
+    testCaptureError();
+}
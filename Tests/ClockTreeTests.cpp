@@ -0,0 +1,182 @@
+#include "UnitTest.hh"
+#include <ClockTree.hh>
+
+using namespace ClockTree;
+
+namespace
+{
+    const ScaleLimits& limitsOf(const VoltageScale scale)
+    {
+        for (const ScaleLimits& limits : scaleLimits) {
+            if (limits.scale == scale) { return limits; }
+        }
+        return scaleLimits.back();
+    }
+
+    // Every constraint of RM0399 a valid configuration must respect.
+    void checkConstraints(const ClockConfig& config)
+    {
+        const ScaleLimits& limits{ limitsOf(config.scale) };
+        for (std::size_t index = 0; index < config.pll.size(); ++index) {
+            const PllConfig& pll{ config.pll[index] };
+            if (!pll.enabled) { continue; }
+            TEST_CHECK(pll.m >= 1 && pll.m <= divmMax);
+            TEST_CHECK(pll.n >= divnMin && pll.n <= divnMax);
+            TEST_CHECK(pll.refHz >= refMinHz && pll.refHz <= refMaxHz);
+            TEST_CHECK(pll.refHz * pll.m == config.sourceHz);
+            if (pll.wideVco) {
+                TEST_CHECK(pll.refHz >= wideVcoRefMinHz);
+                TEST_CHECK(pll.vcoHz >= wideVcoMinHz && pll.vcoHz <= wideVcoMaxHz);
+            } else {
+                TEST_CHECK(pll.vcoHz >= mediumVcoMinHz && pll.vcoHz <= mediumVcoMaxHz);
+            }
+            for (const std::uint32_t divider : pll.div) {
+                TEST_CHECK(divider <= divOutMax);
+            }
+        }
+        TEST_CHECK(config.pll[0].div[0] % 2 == 0);
+        TEST_CHECK(config.sysclkHz <= limits.sysclkMaxHz);
+        TEST_CHECK(config.hclkHz <= limits.hclkMaxHz);
+        TEST_CHECK(config.apbHz <= limits.apbMaxHz);
+        TEST_CHECK(config.hclkHz * config.hpre == config.sysclkHz);
+        TEST_CHECK(config.apbHz * config.ppre == config.hclkHz);
+        const FlashTiming* const timing{ flashTiming(config.scale, config.hclkHz) };
+        TEST_CHECK(timing != nullptr && timing->latency == config.flashLatency && timing->programmingDelay == config.flashProgrammingDelay);
+        TEST_CHECK(config.scale != VoltageScale::vos0 || config.supply == PowerSupply::ldo);
+    }
+
+    void testBootConfig()
+    {
+        TEST_CHECK(bootConfig.isValid());
+        TEST_CHECK(bootConfig.sysclkHz == 480000000);
+        TEST_CHECK(bootConfig.hclkHz == 240000000);
+        TEST_CHECK(bootConfig.apbHz == 120000000);
+        TEST_CHECK(bootConfig.scale == VoltageScale::vos0);
+        TEST_CHECK(bootConfig.flashLatency == 4);
+        TEST_CHECK(bootConfig.flashProgrammingDelay == 2);
+        TEST_CHECK(bootConfig.pll[0].m == 4 && bootConfig.pll[0].n == 60);
+        TEST_CHECK(bootConfig.pll[0].div[0] == 2 && bootConfig.pll[0].div[1] == 4);
+        TEST_CHECK(bootConfig.pll[0].outputHz(PllOutput::q) == 240000000);
+        TEST_CHECK(!bootConfig.pll[1].enabled && !bootConfig.pll[2].enabled);
+        checkConstraints(bootConfig);
+    }
+
+    void testSupplyLimitsVoltageScale()
+    {
+        const ClockConfig smps480{ solve(ClockRequest{ .supply = PowerSupply::smpsDirect, .sysclkHz = 480000000 }) };
+        TEST_CHECK(smps480.error == SolveError::sysclkTooHigh);
+
+        const ClockConfig smps400{ solve(ClockRequest{ .supply = PowerSupply::smpsDirect, .sysclkHz = 400000000 }) };
+        TEST_CHECK(smps400.isValid());
+        TEST_CHECK(smps400.scale == VoltageScale::vos1);
+        TEST_CHECK(smps400.hclkHz == 200000000);
+        TEST_CHECK(smps400.flashLatency == 2 && smps400.flashProgrammingDelay == 2);
+        checkConstraints(smps400);
+
+        const ClockConfig low{ solve(ClockRequest{ .sysclkHz = 128000000 }) };
+        TEST_CHECK(low.isValid());
+        TEST_CHECK(low.scale == VoltageScale::vos3);
+        checkConstraints(low);
+    }
+
+    void testHclkRaisesVoltageScale()
+    {
+        // 200 MHz SYSCLK fits VOS3 but an undivided 200 MHz HCLK needs VOS1
+        const ClockConfig config{ solve(ClockRequest{ .sysclkHz = 200000000, .hclkHz = 200000000 }) };
+        TEST_CHECK(config.isValid());
+        TEST_CHECK(config.scale == VoltageScale::vos1);
+        TEST_CHECK(config.flashLatency == 2 && config.flashProgrammingDelay == 2);
+        checkConstraints(config);
+    }
+
+    void testFlashTimingBands()
+    {
+        struct Band {
+            VoltageScale scale;
+            std::uint32_t hclkHz;
+            std::uint32_t latency;
+            std::uint32_t programmingDelay;
+        };
+        // Both sides of every edge of RM0399 table 15
+        constexpr std::array<Band, 34> bands{ {
+            { VoltageScale::vos3,  45000000, 0, 0 }, { VoltageScale::vos3,  45000001, 1, 1 },
+            { VoltageScale::vos3,  90000000, 1, 1 }, { VoltageScale::vos3,  90000001, 2, 1 },
+            { VoltageScale::vos3, 135000000, 2, 1 }, { VoltageScale::vos3, 135000001, 3, 2 },
+            { VoltageScale::vos3, 180000000, 3, 2 }, { VoltageScale::vos3, 180000001, 4, 2 },
+            { VoltageScale::vos2,  55000000, 0, 0 }, { VoltageScale::vos2,  55000001, 1, 1 },
+            { VoltageScale::vos2, 110000000, 1, 1 }, { VoltageScale::vos2, 110000001, 2, 1 },
+            { VoltageScale::vos2, 165000000, 2, 1 }, { VoltageScale::vos2, 165000001, 3, 2 },
+            { VoltageScale::vos1,  70000000, 0, 0 }, { VoltageScale::vos1,  70000001, 1, 1 },
+            { VoltageScale::vos1, 140000000, 1, 1 }, { VoltageScale::vos1, 140000001, 2, 1 },
+            { VoltageScale::vos1, 185000000, 2, 1 }, { VoltageScale::vos1, 185000001, 2, 2 },
+            { VoltageScale::vos1, 210000000, 2, 2 }, { VoltageScale::vos1, 210000001, 3, 2 },
+            { VoltageScale::vos0,  70000000, 0, 0 }, { VoltageScale::vos0,  70000001, 1, 1 },
+            { VoltageScale::vos0, 140000000, 1, 1 }, { VoltageScale::vos0, 140000001, 2, 1 },
+            { VoltageScale::vos0, 185000000, 2, 1 }, { VoltageScale::vos0, 185000001, 2, 2 },
+            { VoltageScale::vos0, 210000000, 2, 2 }, { VoltageScale::vos0, 210000001, 3, 2 },
+            { VoltageScale::vos0, 225000000, 3, 2 }, { VoltageScale::vos0, 225000001, 4, 2 },
+            { VoltageScale::vos0, 240000000, 4, 2 }, { VoltageScale::vos1, 200000000, 2, 2 },
+        } };
+        for (const Band& band : bands) {
+            const FlashTiming* const timing{ flashTiming(band.scale, band.hclkHz) };
+            TEST_CHECK(timing != nullptr && timing->latency == band.latency && timing->programmingDelay == band.programmingDelay);
+        }
+
+        // Above the last row of each scale
+        TEST_CHECK(flashTiming(VoltageScale::vos3, 225000001) == nullptr);
+        TEST_CHECK(flashTiming(VoltageScale::vos2, 225000001) == nullptr);
+        TEST_CHECK(flashTiming(VoltageScale::vos1, 225000001) == nullptr);
+        TEST_CHECK(flashTiming(VoltageScale::vos0, 240000001) == nullptr);
+
+        // The highest HCLK of every scale has a row
+        for (const ScaleLimits& limits : scaleLimits) {
+            TEST_CHECK(flashTiming(limits.scale, limits.hclkMaxHz) != nullptr);
+        }
+    }
+
+    void testKernelClocks()
+    {
+        const ClockConfig config{ solve(ClockRequest{
+            .source = PllSource::hse, .hseHz = 25000000, .sysclkHz = 400000000,
+            .pll2 = { 0, 0, 200000000 }, .pll3 = { 0, 48000000, 0 } }) };
+        TEST_CHECK(config.isValid());
+        TEST_CHECK(config.pll[1].outputHz(PllOutput::r) == 200000000);
+        TEST_CHECK(config.pll[2].outputHz(PllOutput::q) == 48000000);
+        TEST_CHECK(config.pll[2].outputHz(PllOutput::p) == 0);
+        checkConstraints(config);
+    }
+
+    void testErrors()
+    {
+        TEST_CHECK(solve(ClockRequest{ .source = PllSource::hse, .hseHz = 1000000, .sysclkHz = 400000000 }).error == SolveError::invalidSource);
+        TEST_CHECK(solve(ClockRequest{ .sysclkHz = 400000001 }).error == SolveError::noPll1Solution);
+        TEST_CHECK(solve(ClockRequest{ .sysclkHz = 400000000, .pll2 = { 7, 0, 0 } }).error == SolveError::noPll2Solution);
+        TEST_CHECK(solve(ClockRequest{ .sysclkHz = 400000000, .pll3 = { 0, 0, 1000000000 } }).error == SolveError::noPll3Solution);
+        TEST_CHECK(solve(ClockRequest{ .sysclkHz = 400000000, .hclkHz = 300000000 }).error == SolveError::invalidHclk);
+        TEST_CHECK(solve(ClockRequest{ .supply = PowerSupply::smpsDirect, .sysclkHz = 240000000, .hclkHz = 240000000 }).error == SolveError::hclkTooHigh);
+    }
+
+    void testSweepRespectsConstraints()
+    {
+        for (const std::uint32_t hseHz : { 8000000U, 12000000U, 16000000U, 25000000U }) {
+            for (std::uint32_t sysclkHz = 48000000; sysclkHz <= 480000000; sysclkHz += 8000000) {
+                const ClockConfig config{ solve(ClockRequest{ .source = PllSource::hse, .hseHz = hseHz, .sysclkHz = sysclkHz }) };
+                if (config.isValid()) {
+                    TEST_CHECK(config.sysclkHz == sysclkHz);
+                    checkConstraints(config);
+                }
+            }
+        }
+    }
+};
+
+void runClockTreeTests()
+{
+    testBootConfig();
+    testSupplyLimitsVoltageScale();
+    testHclkRaisesVoltageScale();
+    testFlashTimingBands();
+    testKernelClocks();
+    testErrors();
+    testSweepRespectsConstraints();
+}
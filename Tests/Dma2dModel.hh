@@ -0,0 +1,174 @@
+#ifndef __DMA2DMODEL_H__
+#define __DMA2DMODEL_H__
+
+/**
+ * @file Dma2dModel.hh
+ * @brief Behavioral model of the DMA2D for host tests.
+ *
+ * Models what the driver relies on: the registers, START set by software and cleared by
+ * the hardware, ABORT, the flags of ISR cleared through IFCR, and the configuration error
+ * of a color mode the output or the layers cannot use. Writing START only latches the
+ * operation; complete() runs it with Dma2d::render() on the bus given with map(), the way
+ * the hardware would finish it later. An access to an unmapped address is a transfer error.
+ */
+
+//<------------------------------INCLUDES------------------------------>//
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <Dma2d.hh>
+#include "ModelSupport.hh"
+//<-------------------------------------------------------------------->//
+
+class Dma2dModel : public BusMap
+{
+    public:
+        using ModelRegister = HostRegister<Dma2dModel, Dma2dRegisters>;
+        friend ModelRegister;
+
+        static constexpr std::size_t registerCount{ 16 };
+
+        Dma2dModel()
+        {
+            for (std::size_t index = 0; index < registerCount; ++index) {
+                views.push_back(std::make_unique<ModelRegister>(*this, static_cast<Dma2dRegisters>(index)));
+            }
+        }
+
+        /**
+         * @brief Handler of the DMA2D, running on the model.
+         */
+        Dma2dHandler& handler()
+        {
+            if (!instance) {
+                auto handle = [this](const std::size_t index) -> IRegister<volatile std::uint32_t*>* { return views[index].get(); };
+                instance = std::make_unique<Dma2dHandler>(Dma2d::abortTimeoutLoops, registerHandles, handle(0), handle(1), handle(2), handle(3), handle(4), handle(5),
+                                                          handle(6), handle(7), handle(8), handle(9), handle(10), handle(11), handle(12), handle(13), handle(14), handle(15));
+            }
+            return *instance;
+        }
+
+        /// Whether an operation is latched and not finished.
+        bool isRunning() const { return (values[index(Dma2dRegisters::control)] & (1U << Dma2d::startPos)) != 0; }
+
+        /**
+         * @brief Finish the latched operation.
+         * @return bool false if nothing was running.
+         */
+        bool complete()
+        {
+            if (!isRunning()) { return false; }
+            const bool success{ Dma2d::render(latched, [this](const std::uint32_t address, const std::uint32_t bytes) { return translate(address, bytes); }) };
+            flags |= success ? Dma2d::transferCompleteFlag : Dma2d::transferErrorFlag;
+            values[index(Dma2dRegisters::control)] &= ~(1U << Dma2d::startPos);
+            ++operations;
+            return true;
+        }
+
+        /// End the latched operation without running it, raising flags together.
+        void stop(const std::uint32_t raised)
+        {
+            flags |= raised;
+            values[index(Dma2dRegisters::control)] &= ~(1U << Dma2d::startPos);
+            ++operations;
+        }
+
+        /// Whether an enabled interrupt is pending, the NVIC line.
+        bool interruptPending() const
+        {
+            const std::uint32_t control{ values[index(Dma2dRegisters::control)] };
+            std::uint32_t enabledFlags{ 0 };
+            if ((control & (1U << Dma2d::transferCompleteInterruptPos)) != 0) { enabledFlags |= Dma2d::transferCompleteFlag; }
+            if ((control & (1U << Dma2d::transferErrorInterruptPos)) != 0) { enabledFlags |= Dma2d::transferErrorFlag; }
+            if ((control & (1U << Dma2d::configurationErrorInterruptPos)) != 0) { enabledFlags |= Dma2d::configurationErrorFlag; }
+            return (flags & enabledFlags) != 0;
+        }
+
+        /// Operation latched by the last START.
+        const Dma2dOperation& operation() const { return latched; }
+
+        /// Operations finished, failed ones included.
+        std::uint32_t completed() const { return operations; }
+
+    private:
+        std::array<std::uint32_t, registerCount> values{};
+        std::uint32_t flags{ 0 };
+        std::uint32_t operations{ 0 };
+        Dma2dOperation latched{};
+        std::vector<std::unique_ptr<ModelRegister>> views;
+        std::unique_ptr<Dma2dHandler> instance;
+
+        static constexpr std::size_t index(const Dma2dRegisters kind) { return static_cast<std::size_t>(kind); }
+
+        bool decodeLayer(Dma2dLayer& layer, const Dma2dRegisters address, const Dma2dRegisters offset, const Dma2dRegisters control, const Dma2dRegisters color)
+        {
+            const std::uint32_t value{ values[index(control)] };
+            const std::uint32_t alphaMode{ (value >> Dma2d::alphaModePos) & 3U };
+            if (!Dma2d::formatOf((value >> Dma2d::colorModePos) & 0xFU, layer.format) || alphaMode == 3U) { return false; }
+            layer.address = values[index(address)];
+            layer.offset = static_cast<std::uint16_t>(values[index(offset)] & Dma2d::maxOffset);
+            layer.options = Dma2dLayerOptions{ static_cast<Dma2dAlphaMode>(alphaMode), static_cast<std::uint8_t>(value >> Dma2d::alphaPos),
+                                               values[index(color)] & 0xFFFFFFU };
+            return true;
+        }
+
+        /// Latch the operation the registers describe, false on a configuration error.
+        bool latch()
+        {
+            const std::uint32_t control{ values[index(Dma2dRegisters::control)] };
+            const std::uint32_t lines{ values[index(Dma2dRegisters::lineCount)] };
+            latched = Dma2dOperation{};
+            latched.mode = static_cast<Dma2dMode>((control >> Dma2d::modePos) & 7U);
+            latched.output = values[index(Dma2dRegisters::outputAddress)];
+            latched.outputOffset = static_cast<std::uint16_t>(values[index(Dma2dRegisters::outputOffset)] & Dma2d::maxOffset);
+            latched.color = values[index(Dma2dRegisters::outputColor)];
+            latched.width = static_cast<std::uint16_t>((lines >> Dma2d::pixelsPerLinePos) & Dma2d::maxWidth);
+            latched.height = static_cast<std::uint16_t>(lines & Dma2d::maxHeight);
+            if (!Dma2d::formatOf(values[index(Dma2dRegisters::outputControl)] & 7U, latched.outputFormat) || latched.mode > Dma2dMode::fill) { return false; }
+            if (latched.mode != Dma2dMode::fill &&
+                !decodeLayer(latched.foreground, Dma2dRegisters::foregroundAddress, Dma2dRegisters::foregroundOffset,
+                             Dma2dRegisters::foregroundControl, Dma2dRegisters::foregroundColor)) { return false; }
+            if (latched.mode == Dma2dMode::blend &&
+                !decodeLayer(latched.background, Dma2dRegisters::backgroundAddress, Dma2dRegisters::backgroundOffset,
+                             Dma2dRegisters::backgroundControl, Dma2dRegisters::backgroundColor)) { return false; }
+            // Copy does not convert: the input format is the output one
+            if (latched.mode == Dma2dMode::copy) { latched.foreground.format = latched.outputFormat; }
+            return latched.width != 0 && latched.height != 0 && Dma2d::isOutputFormat(latched.outputFormat) &&
+                   Dma2d::isAligned(latched.output, latched.outputFormat);
+        }
+
+        std::uint32_t read(const Dma2dRegisters kind) const
+        {
+            switch (kind) {
+                case Dma2dRegisters::interruptStatus: return flags;
+                case Dma2dRegisters::interruptClear: return 0;
+                default: return values[index(kind)];
+            }
+        }
+
+        void write(const Dma2dRegisters kind, const std::uint32_t value)
+        {
+            switch (kind) {
+                case Dma2dRegisters::interruptStatus: break;
+                case Dma2dRegisters::interruptClear: flags &= ~(value & Dma2d::allFlags); break;
+                case Dma2dRegisters::control:
+                    if (isRunning()) {
+                        // Only ABORT is honored while running
+                        if ((value & (1U << Dma2d::abortPos)) != 0) { values[index(kind)] &= ~(1U << Dma2d::startPos); }
+                        break;
+                    }
+                    values[index(kind)] = value & ~(1U << Dma2d::abortPos);
+                    if ((value & (1U << Dma2d::startPos)) != 0 && !latch()) {
+                        flags |= Dma2d::configurationErrorFlag;
+                        values[index(kind)] &= ~(1U << Dma2d::startPos);
+                    }
+                    break;
+                default:
+                    if (!isRunning()) { values[index(kind)] = value; }
+                    break;
+            }
+        }
+};
+
+#endif // __DMA2DMODEL_H__
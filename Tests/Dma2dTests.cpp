@@ -0,0 +1,212 @@
+#include "UnitTest.hh"
+#include "Dma2dModel.hh"
+#include "ModelSupport.hh"
+#include <Dma2d.hh>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+    // A frame and a glyph in AXI SRAM, an image in SRAM1
+    constexpr std::uint32_t frameBase{ TestBus::axiSram };
+    constexpr std::uint32_t glyphBase{ TestBus::axiSram + 0x10000 };
+    constexpr std::uint32_t imageBase{ TestBus::sram1 };
+    constexpr std::uint32_t unmapped{ TestBus::axiSram + 0x70000 };
+
+    constexpr Dma2dSurface frameSurface{ frameBase, 8, Dma2dFormat::rgb565 };
+    constexpr Dma2dSurface glyphSurface{ glyphBase, 4, Dma2dFormat::a8 };
+    constexpr Dma2dSurface imageSurface{ imageBase, 4, Dma2dFormat::argb8888 };
+
+    struct Bus {
+        Dma2dModel model;
+        std::array<std::uint16_t, 64> frame{};
+        std::array<std::uint8_t, 8> glyph{ 0, 255, 128, 64, 0, 255, 128, 64 };
+        std::array<std::uint32_t, 16> image{};
+
+        Bus()
+        {
+            model.map(frameBase, frame.data(), sizeof(frame));
+            model.map(glyphBase, glyph.data(), sizeof(glyph));
+            model.map(imageBase, image.data(), sizeof(image));
+        }
+
+        /// Let the hardware finish everything, serving the interrupts.
+        void run()
+        {
+            while (model.complete()) {
+                if (model.interruptPending()) { model.handler().handleInterrupt(); }
+            }
+        }
+    };
+
+    using Events = EventLog<Dma2dEvent>;
+
+    void testPixels()
+    {
+        static_assert(Dma2d::unpack(0xF800, Dma2dFormat::rgb565) == 0xFFFF0000 && Dma2d::unpack(0x07E0, Dma2dFormat::rgb565) == 0xFF00FF00);
+        static_assert(Dma2d::unpack(0xF00F, Dma2dFormat::argb4444) == 0xFF0000FF && Dma2d::unpack(0x7C00, Dma2dFormat::argb1555) == 0x00FF0000);
+        static_assert(Dma2d::unpack(0x40, Dma2dFormat::a8, 0x123456) == 0x40123456 && Dma2d::unpack(0xABCDEF, Dma2dFormat::rgb888) == 0xFFABCDEF);
+        static_assert(Dma2d::pack(0xFF808080, Dma2dFormat::rgb565) == 0x8410 && Dma2d::pack(0x80FF0000, Dma2dFormat::argb1555) == 0xFC00);
+        static_assert(Dma2d::pack(0xF0A0B0C0, Dma2dFormat::argb4444) == 0xFABC);
+
+        // White at half alpha over opaque black, and the transparent corner cases
+        static_assert(Dma2d::blendPixel(0x80FFFFFF, 0xFF000000) == 0xFF808080);
+        static_assert(Dma2d::blendPixel(0xFF123456, 0xFF000000) == 0xFF123456 && Dma2d::blendPixel(0x00FFFFFF, 0x80204060) == 0x80204060);
+        static_assert(Dma2d::blendPixel(0, 0) == 0);
+
+        static_assert(Dma2d::applyAlpha(0x80FFFFFF, Dma2dLayerOptions{ Dma2dAlphaMode::multiply, 128 }) == 0x40FFFFFF);
+        static_assert(Dma2d::applyAlpha(0x80FFFFFF, Dma2dLayerOptions{ Dma2dAlphaMode::replace, 7 }) == 0x07FFFFFF);
+        static_assert(Dma2d::colorMode(Dma2dFormat::a8) == 9 && Dma2d::layerControl(Dma2dLayer{ 0, 0, Dma2dFormat::rgb565,
+                      Dma2dLayerOptions{ Dma2dAlphaMode::replace, 0x80 } }) == (2U | (1U << 16) | (0x80U << 24)));
+        TEST_CHECK(Dma2d::bytesPerPixel(Dma2dFormat::rgb888) == 3);
+    }
+
+    void testBuilders()
+    {
+        const auto fill{ Dma2d::fill(frameSurface, { 2, 1, 4, 3 }, 0xFFFF0000) };
+        TEST_CHECK(fill.hasValue() && fill.value().mode == Dma2dMode::fill && fill.value().color == 0xF800);
+        TEST_CHECK(fill.value().output == frameBase + (8 + 2) * 2 && fill.value().outputOffset == 4 && fill.value().height == 3);
+
+        // Same format: copy, otherwise or with an alpha change: conversion
+        TEST_CHECK(Dma2d::copy(frameSurface, 0, 0, frameSurface, { 0, 4, 8, 4 }).value().mode == Dma2dMode::copy);
+        TEST_CHECK(Dma2d::copy(frameSurface, 0, 0, frameSurface, { 0, 4, 8, 4 }, { Dma2dAlphaMode::replace, 0x80 }).value().mode == Dma2dMode::convert);
+        const auto convert{ Dma2d::copy(frameSurface, 4, 4, imageSurface, { 1, 1, 3, 2 }) };
+        TEST_CHECK(convert.value().mode == Dma2dMode::convert && convert.value().foreground.address == imageBase + 5 * 4 && convert.value().foreground.offset == 1);
+
+        const auto blend{ Dma2d::blend(frameSurface, 1, 2, glyphSurface, { 0, 0, 4, 2 }) };
+        TEST_CHECK(blend.value().mode == Dma2dMode::blend && blend.value().background.address == blend.value().output);
+
+        // Refused: empty, wider than the surface, A8 output, TCM, misaligned
+        TEST_CHECK(Dma2d::fill(frameSurface, { 0, 0, 0, 4 }, 0).error() == DriverError::invalidParameter);
+        TEST_CHECK(Dma2d::fill(frameSurface, { 6, 0, 3, 4 }, 0).error() == DriverError::invalidParameter);
+        TEST_CHECK(Dma2d::fill(glyphSurface, { 0, 0, 4, 2 }, 0).error() == DriverError::invalidParameter);
+        TEST_CHECK(Dma2d::fill(Dma2dSurface{ TestBus::dtcm, 8, Dma2dFormat::rgb565 }, { 0, 0, 8, 8 }, 0).error() == DriverError::invalidParameter);
+        TEST_CHECK(Dma2d::copy(frameSurface, 0, 0, Dma2dSurface{ TestBus::dtcm, 8, Dma2dFormat::rgb565 }, { 0, 0, 8, 8 }).error() == DriverError::invalidParameter);
+        TEST_CHECK(Dma2d::fill(Dma2dSurface{ frameBase + 1, 8, Dma2dFormat::rgb565 }, { 0, 0, 8, 8 }, 0).error() == DriverError::invalidParameter);
+        TEST_CHECK(Dma2d::fill(Dma2dSurface{ frameBase + 1, 8, Dma2dFormat::rgb888 }, { 0, 0, 8, 8 }, 0).hasValue());
+    }
+
+    void testReference()
+    {
+        std::array<std::uint16_t, 16> frame{};
+        std::array<std::uint8_t, 4> glyph{ 0, 255, 128, 64 };
+        std::array<std::uint32_t, 4> image{ 0xFFFF0000, 0x80FFFFFF, 0x00000000, 0xFF00FF00 };
+        BusMap bus;
+        bus.map(frameBase, frame.data(), sizeof(frame));
+        bus.map(glyphBase, glyph.data(), sizeof(glyph));
+        bus.map(imageBase, image.data(), sizeof(image));
+        const auto translate = [&bus](const std::uint32_t address, const std::uint32_t bytes) { return bus.translate(address, bytes); };
+        constexpr Dma2dSurface frameSurface{ frameBase, 4, Dma2dFormat::rgb565 };
+
+        // Conversion drops the alpha and the low bits
+        TEST_CHECK(Dma2d::render(Dma2d::copy(frameSurface, 0, 0, Dma2dSurface{ imageBase, 4, Dma2dFormat::argb8888 }, { 0, 0, 4, 1 }).value(), translate));
+        TEST_CHECK(frame[0] == 0xF800 && frame[1] == 0xFFFF && frame[2] == 0x0000 && frame[3] == 0x07E0);
+
+        // White text on black: 0, full, half and quarter coverage
+        TEST_CHECK(Dma2d::render(Dma2d::blend(frameSurface, 0, 1, Dma2dSurface{ glyphBase, 4, Dma2dFormat::a8 }, { 0, 0, 4, 1 },
+                                              { Dma2dAlphaMode::keep, 0xFF, 0xFFFFFF }).value(), translate));
+        TEST_CHECK(frame[4] == 0x0000 && frame[5] == 0xFFFF && frame[6] == 0x8410 && frame[7] == 0x4208);
+
+        // Layer alpha multiplied in: half coverage at half alpha is a quarter
+        TEST_CHECK(Dma2d::render(Dma2d::blend(frameSurface, 0, 2, Dma2dSurface{ glyphBase, 4, Dma2dFormat::a8 }, { 2, 0, 1, 1 },
+                                              { Dma2dAlphaMode::multiply, 128, 0xFFFFFF }).value(), translate));
+        TEST_CHECK(frame[8] == 0x4208);
+
+        // An unmapped line stops the operation
+        TEST_CHECK(!Dma2d::render(Dma2d::fill(Dma2dSurface{ unmapped, 4, Dma2dFormat::rgb565 }, { 0, 0, 4, 1 }, 0).value(), translate));
+    }
+
+    void testHandler()
+    {
+        Bus bus;
+        Dma2dHandler& dma2d{ bus.model.handler() };
+        Events log;
+        TEST_CHECK(dma2d.configure(&Events::record, &log).hasValue());
+
+        TEST_CHECK(dma2d.start(Dma2d::fill(frameSurface, { 0, 0, 8, 8 }, 0xFF0000FF).value()).hasValue() && dma2d.isBusy());
+        TEST_CHECK(bus.model.operation().mode == Dma2dMode::fill && bus.model.operation().width == 8 && bus.model.operation().color == 0x001F);
+        TEST_CHECK(dma2d.start(Dma2d::fill(frameSurface, { 0, 0, 8, 8 }, 0).value()).error() == DriverError::busy);
+        TEST_CHECK(dma2d.configure(nullptr).error() == DriverError::busy);
+        bus.run();
+        TEST_CHECK(!dma2d.isBusy() && bus.frame[0] == 0x001F && bus.frame[63] == 0x001F && dma2d.flags() == 0);
+        TEST_CHECK(log.events == (std::vector<Dma2dEvent>{ Dma2dEvent::transferComplete }));
+
+        // The registers describe the operation the builder made
+        const Dma2dOperation blend{ Dma2d::blend(frameSurface, 2, 3, glyphSurface, { 0, 0, 4, 2 }, { Dma2dAlphaMode::keep, 0xFF, 0xFFFFFF }).value() };
+        TEST_CHECK(dma2d.start(blend).hasValue());
+        const Dma2dOperation& latched{ bus.model.operation() };
+        TEST_CHECK(latched.foreground.format == Dma2dFormat::a8 && latched.foreground.options.color == 0xFFFFFF && latched.background.offset == 4);
+        bus.run();
+        TEST_CHECK(bus.frame[3 * 8 + 2] == 0x001F && bus.frame[3 * 8 + 3] == 0xFFFF && bus.frame[4 * 8 + 5] == 0x421F);
+
+        // Invalid operations never reach the hardware
+        Dma2dOperation invalid{ blend };
+        invalid.outputFormat = Dma2dFormat::a8;
+        TEST_CHECK(dma2d.start(invalid).error() == DriverError::invalidParameter && !dma2d.isBusy());
+
+        // Abort leaves the output as it was
+        TEST_CHECK(dma2d.start(Dma2d::fill(frameSurface, { 0, 0, 8, 8 }, 0).value()).hasValue());
+        TEST_CHECK(dma2d.abort().hasValue() && !dma2d.isBusy() && !bus.model.complete() && bus.frame[0] == 0x001F);
+
+        // Bus error
+        log.events.clear();
+        TEST_CHECK(dma2d.start(Dma2d::fill(Dma2dSurface{ unmapped, 8, Dma2dFormat::rgb565 }, { 0, 0, 8, 1 }, 0).value()).hasValue());
+        bus.run();
+        TEST_CHECK(log.events == (std::vector<Dma2dEvent>{ Dma2dEvent::transferError }));
+
+        // Without the callback the flags stay for polling
+        TEST_CHECK(dma2d.configure(nullptr).hasValue());
+        TEST_CHECK(dma2d.start(Dma2d::fill(frameSurface, { 0, 0, 1, 1 }, 0).value()).hasValue() && bus.model.complete());
+        TEST_CHECK(!bus.model.interruptPending() && dma2d.flags() == Dma2d::transferCompleteFlag && dma2d.handleInterrupt() == 0);
+    }
+
+    void testQueue()
+    {
+        Bus bus;
+        Dma2dQueue<4> queue{ bus.model.handler() };
+        const auto submit = [&](const Utils::Result<Dma2dOperation, DriverError>& operation) {
+            return operation.andThen([&](const Dma2dOperation& built) { return queue.submit(built); });
+        };
+
+        // Back to back: each operation starts from the interrupt of the previous one
+        const auto first{ submit(Dma2d::fill(frameSurface, { 0, 0, 8, 8 }, 0xFF000000)) };
+        const auto second{ submit(Dma2d::blend(frameSurface, 0, 0, glyphSurface, { 0, 0, 4, 2 }, { Dma2dAlphaMode::keep, 0xFF, 0xFFFFFF })) };
+        const auto third{ submit(Dma2d::copy(frameSurface, 4, 0, frameSurface, { 0, 0, 4, 2 })) };
+        const auto fourth{ submit(Dma2d::fill(frameSurface, { 0, 7, 8, 1 }, 0xFFFFFFFF)) };
+        TEST_CHECK(first && second && third && fourth && queue.pending() == 4 && bus.model.operation().mode == Dma2dMode::fill);
+        TEST_CHECK(submit(Dma2d::fill(frameSurface, { 0, 0, 8, 8 }, 0)).error() == DriverError::outOfResources);
+        TEST_CHECK(submit(Dma2d::fill(frameSurface, { 0, 0, 9, 8 }, 0)).error() == DriverError::invalidParameter);
+        TEST_CHECK(!queue.isComplete(first.value()));
+
+        bus.run();
+        TEST_CHECK(bus.model.completed() == 4 && queue.pending() == 0 && queue.isComplete(fourth.value()));
+        TEST_CHECK(queue.wait(first.value()).hasValue() && queue.wait(fourth.value()).hasValue());
+        TEST_CHECK(bus.frame[1] == 0xFFFF && bus.frame[2] == 0x8410 && bus.frame[5] == 0xFFFF && bus.frame[6] == 0x8410 && bus.frame[9] == 0xFFFF);
+        TEST_CHECK(bus.frame[16] == 0x0000 && bus.frame[56] == 0xFFFF && bus.frame[63] == 0xFFFF);
+
+        // A failed operation is reported by its token, the next ones still run
+        const auto failing{ submit(Dma2d::fill(Dma2dSurface{ unmapped, 8, Dma2dFormat::rgb565 }, { 0, 0, 8, 1 }, 0)) };
+        const auto after{ submit(Dma2d::fill(frameSurface, { 0, 0, 1, 1 }, 0xFF00FF00)) };
+        bus.run();
+        TEST_CHECK(queue.wait(failing.value()).error() == DriverError::hardwareFault && queue.wait(after.value()).hasValue() && bus.frame[0] == 0x07E0);
+
+        // An error raised with the transfer complete flag ends one operation, not the next one too
+        const auto stopped{ submit(Dma2d::fill(frameSurface, { 0, 0, 1, 1 }, 0xFF0000FF)) };
+        const auto next{ submit(Dma2d::fill(frameSurface, { 0, 0, 1, 1 }, 0xFFFFFFFF)) };
+        bus.model.stop(Dma2d::transferErrorFlag | Dma2d::transferCompleteFlag);
+        bus.model.handler().handleInterrupt();
+        TEST_CHECK(queue.isComplete(stopped.value()) && !queue.isComplete(next.value()) && bus.model.isRunning());
+        bus.run();
+        TEST_CHECK(queue.wait(stopped.value()).error() == DriverError::hardwareFault && queue.wait(next.value()).hasValue() && bus.frame[0] == 0xFFFF);
+    }
+};
+
+void runDma2dTests()
+{
+    testPixels();
+    testBuilders();
+    testReference();
+    testHandler();
+    testQueue();
+}
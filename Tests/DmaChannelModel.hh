@@ -0,0 +1,194 @@
+#ifndef __DMACHANNELMODEL_H__
+#define __DMACHANNELMODEL_H__
+
+/**
+ * @file DmaChannelModel.hh
+ * @brief The channel model DmaModel and BdmaModel share, on the register model of DmaChannel.hh.
+ *
+ * Models what DmaChannelBase relies on: control, count and address writes ignored while
+ * the channel is enabled (except clearing EN), the raw flags read through the status
+ * register of a group of channels and cleared through its clear register, the count
+ * going down with the half transfer and transfer complete flags, the reload of circular
+ * mode, the current target toggle of double-buffer mode, and the transfer error raised
+ * by a write to the memory address register in use. The bus is the map of 32-bit
+ * addresses to host buffers given with map(); serve() moves data items the way the
+ * requests of the peripheral would, and an access to an unmapped address is a transfer
+ * error that disables the channel.
+ *
+ * @tparam Layout The layout of the driver, see DmaChannel.hh.
+ * @tparam GroupSize Channels sharing a status and clear register pair.
+ * @tparam SummaryFlag Flag raised with every other one and clearing them all, 0 for none.
+ */
+
+//<------------------------------INCLUDES------------------------------>//
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <DmaChannel.hh>
+#include "ModelSupport.hh"
+//<-------------------------------------------------------------------->//
+
+template<typename Layout, std::size_t Channels, std::size_t GroupSize, std::uint32_t SummaryFlag = 0>
+class DmaChannelModel : public BusMap
+{
+    protected:
+        using Registers = typename Layout::Registers;
+
+        struct Channel {
+            std::uint32_t control{ 0 };
+            std::uint32_t count{ 0 };
+            std::uint32_t reload{ 0 };
+            std::uint32_t peripheral{ 0 };
+            std::uint32_t memory0{ 0 };
+            std::uint32_t memory1{ 0 };
+            std::uint32_t flags{ 0 };
+            std::uint32_t mux{ 0 };
+            std::uint32_t peripheralOffset{ 0 };
+            std::uint32_t memoryOffset{ 0 };
+        };
+
+        std::array<Channel, Channels> channels{};
+
+        static bool enabled(const Channel& state) { return isSet(state, Layout::enablePos); }
+        static bool isSet(const Channel& state, const std::uint32_t position) { return (state.control & (1U << position)) != 0; }
+        static std::uint32_t field(const Channel& state, const std::uint32_t position) { return (state.control >> position) & 3U; }
+
+        static void raise(Channel& state, const std::uint32_t flag) { state.flags |= flag | SummaryFlag; }
+        static void disable(Channel& state) { state.control &= ~(1U << Layout::enablePos); }
+
+        /**
+         * @brief Serve items requests of a channel: move items data items of the peripheral size.
+         * @return std::uint32_t Items moved, fewer if the channel stopped.
+         */
+        std::uint32_t serve(const std::uint32_t channel, const std::uint32_t items)
+        {
+            Channel& state{ channels[channel] };
+            std::uint32_t moved{ 0 };
+            while (moved < items && enabled(state)) {
+                if (!moveItem(state)) {
+                    raise(state, Layout::transferErrorFlag);
+                    disable(state);
+                    break;
+                }
+                ++moved;
+                --state.count;
+                if (state.count == state.reload / 2) { raise(state, Layout::halfTransferFlag); }
+                if (state.count == 0) { complete(state); }
+            }
+            return moved;
+        }
+
+        /// Flags whose interrupt is enabled in the control register.
+        static std::uint32_t enabledFlags(const Channel& state)
+        {
+            std::uint32_t flags{ 0 };
+            if (isSet(state, Layout::transferCompleteInterruptPos)) { flags |= Layout::transferCompleteFlag; }
+            if (isSet(state, Layout::halfTransferInterruptPos)) { flags |= Layout::halfTransferFlag; }
+            if (isSet(state, Layout::transferErrorInterruptPos)) { flags |= Layout::transferErrorFlag; }
+            return flags;
+        }
+
+        std::uint32_t read(const std::uint32_t channel, const Registers kind)
+        {
+            switch (kind) {
+                case Registers::control: return channels[channel].control;
+                case Registers::count: return channels[channel].count;
+                case Registers::peripheralAddress: return channels[channel].peripheral;
+                case Registers::memory0Address: return channels[channel].memory0;
+                case Registers::memory1Address: return channels[channel].memory1;
+                case Registers::muxControl: return channels[channel].mux;
+                case Registers::interruptStatus: {
+                    const std::uint32_t first{ static_cast<std::uint32_t>(channel - channel % GroupSize) };
+                    std::uint32_t value{ 0 };
+                    for (std::uint8_t index = 0; index < GroupSize; ++index) { value |= channels[first + index].flags << Layout::flagShift(index); }
+                    return value;
+                }
+                default: return 0;
+            }
+        }
+
+        void write(const std::uint32_t channel, const Registers kind, const std::uint32_t value)
+        {
+            Channel& state{ channels[channel] };
+            const bool running{ enabled(state) };
+            switch (kind) {
+                case Registers::control:
+                    if (running) {
+                        // Only EN is writable
+                        if ((value & (1U << Layout::enablePos)) == 0) { disable(state); }
+                        break;
+                    }
+                    state.control = value;
+                    if (enabled(state)) {
+                        state.reload = state.count;
+                        state.peripheralOffset = 0;
+                        state.memoryOffset = 0;
+                    }
+                    break;
+                case Registers::count: if (!running) { state.count = value & Dma::maxItems; } break;
+                case Registers::peripheralAddress: if (!running) { state.peripheral = value; } break;
+                case Registers::memory0Address:
+                case Registers::memory1Address: {
+                    const bool target1{ kind == Registers::memory1Address };
+                    const bool doubleBuffer{ isSet(state, Layout::doubleBufferPos) };
+                    if (running && (!doubleBuffer || isSet(state, Layout::currentTargetPos) == target1)) {
+                        // Memory address in use: transfer error, the channel stops
+                        if (doubleBuffer) {
+                            raise(state, Layout::transferErrorFlag);
+                            disable(state);
+                        }
+                        break;
+                    }
+                    (target1 ? state.memory1 : state.memory0) = value;
+                    break;
+                }
+                case Registers::muxControl: state.mux = value; break;
+                case Registers::interruptClear: {
+                    const std::uint32_t first{ static_cast<std::uint32_t>(channel - channel % GroupSize) };
+                    for (std::uint8_t index = 0; index < GroupSize; ++index) {
+                        std::uint32_t clear{ (value >> Layout::flagShift(index)) & Layout::allFlags };
+                        if ((clear & SummaryFlag) != 0) { clear = Layout::allFlags; }
+                        channels[first + index].flags &= ~clear;
+                    }
+                    break;
+                }
+                default: break;
+            }
+        }
+
+    private:
+        bool moveItem(Channel& state)
+        {
+            const std::uint32_t bytes{ 1U << field(state, Layout::peripheralSizePos) };
+            const std::uint32_t memory{ isSet(state, Layout::currentTargetPos) ? state.memory1 : state.memory0 };
+            std::uint8_t* peripheral{ translate(state.peripheral + state.peripheralOffset, bytes) };
+            std::uint8_t* buffer{ translate(memory + state.memoryOffset, bytes) };
+            if (peripheral == nullptr || buffer == nullptr) { return false; }
+            // Peripheral-to-memory is 0, memory-to-peripheral 1, memory-to-memory copies the peripheral address to memory 0
+            if (field(state, Layout::directionPos) == 1U) {
+                std::memcpy(peripheral, buffer, bytes);
+            } else {
+                std::memcpy(buffer, peripheral, bytes);
+            }
+            if (isSet(state, Layout::peripheralIncrementPos)) { state.peripheralOffset += bytes; }
+            if (isSet(state, Layout::memoryIncrementPos)) { state.memoryOffset += bytes; }
+            return true;
+        }
+
+        void complete(Channel& state)
+        {
+            raise(state, Layout::transferCompleteFlag);
+            if (isSet(state, Layout::doubleBufferPos)) {
+                state.control ^= 1U << Layout::currentTargetPos;
+            } else if (!isSet(state, Layout::circularPos)) {
+                disable(state);
+                return;
+            }
+            state.count = state.reload;
+            state.peripheralOffset = 0;
+            state.memoryOffset = 0;
+        }
+};
+
+#endif // __DMACHANNELMODEL_H__
@@ -0,0 +1,107 @@
+#ifndef __DMAMODEL_H__
+#define __DMAMODEL_H__
+
+/**
+ * @file DmaModel.hh
+ * @brief Behavioral model of the DMA1/DMA2 streams and DMAMUX1 for host tests.
+ *
+ * The channel model of DmaChannelModel.hh with the stream specifics: FCR, ignored while
+ * the stream is enabled, its FIFO error interrupt, the direct mode error interrupt, and
+ * disabling by software setting TCIF. LISR/HISR and LIFCR/HIFCR hold four streams each.
+ */
+
+//<------------------------------INCLUDES------------------------------>//
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <Dma.hh>
+#include "DmaChannelModel.hh"
+#include "ModelSupport.hh"
+//<-------------------------------------------------------------------->//
+
+class DmaModel : public DmaChannelModel<Dma::StreamLayout, Dma::controllerCount * Dma::streamsPerController, 4>
+{
+    public:
+        using ModelRegister = HostRegister<DmaModel, std::uint32_t, DmaStreamRegisters>;
+        friend ModelRegister;
+
+        /// Registers of one stream, in the order DmaStreamHandler takes them.
+        struct View {
+            ModelRegister control, count, peripheralAddress, memory0Address, memory1Address, fifoControl, interruptStatus, interruptClear, muxControl;
+
+            View(DmaModel& model, const std::uint32_t channel)
+                : control(model, channel, DmaStreamRegisters::control), count(model, channel, DmaStreamRegisters::count),
+                  peripheralAddress(model, channel, DmaStreamRegisters::peripheralAddress),
+                  memory0Address(model, channel, DmaStreamRegisters::memory0Address), memory1Address(model, channel, DmaStreamRegisters::memory1Address),
+                  fifoControl(model, channel, DmaStreamRegisters::fifoControl), interruptStatus(model, channel, DmaStreamRegisters::interruptStatus),
+                  interruptClear(model, channel, DmaStreamRegisters::interruptClear), muxControl(model, channel, DmaStreamRegisters::muxControl) {}
+        };
+
+        DmaModel() { fifoControls.fill(0x21); }
+
+        /**
+         * @brief Handler of a stream, running on the model.
+         */
+        DmaStreamHandler& handler(const std::uint8_t controller, const std::uint8_t stream)
+        {
+            views.push_back(std::make_unique<View>(*this, Dma::muxChannel(controller, stream)));
+            View& view{ *views.back() };
+            auto handle = [](ModelRegister& reg) -> IRegister<volatile std::uint32_t*>* { return &reg; };
+            handlers.push_back(std::make_unique<DmaStreamHandler>(controller, stream, registerHandles, handle(view.control), handle(view.count),
+                handle(view.peripheralAddress), handle(view.memory0Address), handle(view.memory1Address), handle(view.fifoControl),
+                handle(view.interruptStatus), handle(view.interruptClear), handle(view.muxControl)));
+            return *handlers.back();
+        }
+
+        /**
+         * @brief Serve items requests of a stream: move items data items of the peripheral size.
+         * @return std::uint32_t Items moved, fewer if the stream stopped.
+         */
+        std::uint32_t transfer(const std::uint8_t controller, const std::uint8_t stream, const std::uint32_t items)
+        {
+            return serve(Dma::muxChannel(controller, stream), items);
+        }
+
+        /// Whether an enabled interrupt of the stream is pending, the NVIC line.
+        bool interruptPending(const std::uint8_t controller, const std::uint8_t stream)
+        {
+            const std::uint8_t channel{ Dma::muxChannel(controller, stream) };
+            const Channel& state{ channels[channel] };
+            std::uint32_t flags{ enabledFlags(state) };
+            if (isSet(state, Dma::directModeErrorInterruptPos)) { flags |= Dma::directModeErrorFlag; }
+            if ((fifoControls[channel] & (1U << Dma::fifoErrorInterruptPos)) != 0) { flags |= Dma::fifoErrorFlag; }
+            return (state.flags & flags) != 0;
+        }
+
+        /// DMAMUX1 request routed to a stream.
+        std::uint32_t request(const std::uint8_t controller, const std::uint8_t stream) { return channels[Dma::muxChannel(controller, stream)].mux; }
+
+    private:
+        using classParent = DmaChannelModel<Dma::StreamLayout, Dma::controllerCount * Dma::streamsPerController, 4>;
+
+        std::array<std::uint32_t, Dma::controllerCount * Dma::streamsPerController> fifoControls{};
+        std::vector<std::unique_ptr<View>> views;
+        std::vector<std::unique_ptr<DmaStreamHandler>> handlers;
+
+        std::uint32_t read(const std::uint32_t channel, const DmaStreamRegisters kind)
+        {
+            if (kind == DmaStreamRegisters::fifoControl) { return fifoControls[channel]; }
+            return classParent::read(channel, kind);
+        }
+
+        void write(const std::uint32_t channel, const DmaStreamRegisters kind, const std::uint32_t value)
+        {
+            Channel& state{ channels[channel] };
+            const bool running{ enabled(state) };
+            if (kind == DmaStreamRegisters::fifoControl) {
+                if (!running) { fifoControls[channel] = value; }
+                return;
+            }
+            classParent::write(channel, kind, value);
+            // Disabling completes the stream
+            if (kind == DmaStreamRegisters::control && running && !enabled(state)) { raise(state, Dma::transferCompleteFlag); }
+        }
+};
+
+#endif // __DMAMODEL_H__
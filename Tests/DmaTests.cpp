@@ -0,0 +1,235 @@
+#include "UnitTest.hh"
+#include "DmaModel.hh"
+#include "ModelSupport.hh"
+#include <Dma.hh>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+    // A peripheral data register and two buffers in AXI SRAM
+    constexpr std::uint32_t dataRegister{ 0x40011024 };
+    constexpr std::uint32_t buffer0{ TestBus::axiSram };
+    constexpr std::uint32_t buffer1{ TestBus::axiSram + 0x100 };
+
+    using Events = EventLog<DmaEvent, std::uint8_t>;
+
+    void serve(DmaModel& model, DmaStreamHandler& stream, const std::uint8_t controller, const std::uint8_t number, const std::uint32_t items)
+    {
+        for (std::uint32_t item = 0; item < items; ++item) {
+            model.transfer(controller, number, 1);
+            if (model.interruptPending(controller, number)) { stream.handleInterrupt(); }
+        }
+    }
+
+    void testValidation()
+    {
+        // Bursts need the FIFO
+        TEST_CHECK(Dma::isValid(DmaConfig{}));
+        TEST_CHECK(!Dma::isValid(DmaConfig{ .memoryBurst = DmaBurst::incr4 }));
+        TEST_CHECK(!Dma::isValid(DmaConfig{ .peripheralSize = DmaDataSize::byte, .memorySize = DmaDataSize::word }));
+        // A memory burst divides the threshold: 4 words fill the FIFO, 4 half-words half of it
+        TEST_CHECK(Dma::isValid(DmaConfig{ .memorySize = DmaDataSize::word, .fifo = DmaFifo::full, .memoryBurst = DmaBurst::incr4 }));
+        TEST_CHECK(!Dma::isValid(DmaConfig{ .memorySize = DmaDataSize::word, .fifo = DmaFifo::half, .memoryBurst = DmaBurst::incr4 }));
+        TEST_CHECK(Dma::isValid(DmaConfig{ .memorySize = DmaDataSize::halfWord, .fifo = DmaFifo::half, .memoryBurst = DmaBurst::incr4 }));
+        TEST_CHECK(!Dma::isValid(DmaConfig{ .memorySize = DmaDataSize::halfWord, .fifo = DmaFifo::threeQuarters, .memoryBurst = DmaBurst::incr4 }));
+        TEST_CHECK(Dma::isValid(DmaConfig{ .memorySize = DmaDataSize::byte, .fifo = DmaFifo::full, .memoryBurst = DmaBurst::incr16 }));
+        // A peripheral burst fits in the FIFO
+        TEST_CHECK(!Dma::isValid(DmaConfig{ .peripheralSize = DmaDataSize::word, .fifo = DmaFifo::full, .peripheralBurst = DmaBurst::incr8 }));
+        // Memory-to-memory uses the FIFO, once
+        TEST_CHECK(!Dma::isValid(DmaConfig{ .direction = DmaDirection::memoryToMemory }));
+        TEST_CHECK(Dma::isValid(DmaConfig{ .direction = DmaDirection::memoryToMemory, .fifo = DmaFifo::full }));
+        TEST_CHECK(!Dma::isValid(DmaConfig{ .direction = DmaDirection::memoryToMemory, .mode = DmaMode::circular, .fifo = DmaFifo::full }));
+
+        // Register encodings
+        constexpr DmaConfig config{ .direction = DmaDirection::memoryToPeripheral, .peripheralSize = DmaDataSize::halfWord,
+                                    .memorySize = DmaDataSize::word, .mode = DmaMode::doubleBuffer, .priority = DmaPriority::high,
+                                    .fifo = DmaFifo::full, .memoryBurst = DmaBurst::incr4, .bufferable = true };
+        static_assert(Dma::controlValue(config) == ((1U << 6) | (1U << 8) | (1U << 10) | (1U << 11) | (2U << 13) | (2U << 16) |
+                                                    (1U << 18) | (1U << 20) | (1U << 23)));
+        static_assert(Dma::fifoValue(config) == ((1U << 2) | 3U));
+        static_assert(Dma::fifoValue(DmaConfig{}) == 0);
+        static_assert(Dma::beatsOf(DmaBurst::incr16) == 16 && Dma::beatsOf(DmaBurst::single) == 1);
+    }
+
+    void testFlagLayout()
+    {
+        // LISR: streams 0-3 at 0, 6, 16, 22; HISR: the same for streams 4-7
+        TEST_CHECK(Dma::flagShift(0) == 0 && Dma::flagShift(1) == 6 && Dma::flagShift(2) == 16 && Dma::flagShift(3) == 22);
+        TEST_CHECK(Dma::flagShift(5) == 6 && Dma::flagShift(7) == 22);
+        TEST_CHECK(Dma::muxChannel(1, 0) == 0 && Dma::muxChannel(1, 7) == 7 && Dma::muxChannel(2, 0) == 8 && Dma::muxChannel(2, 7) == 15);
+
+        // Flags of neighbour streams stay apart
+        DmaModel model;
+        DmaStreamHandler& first{ model.handler(1, 5) };
+        DmaStreamHandler& second{ model.handler(1, 6) };
+        std::array<std::uint8_t, 4> source{ 1, 2, 3, 4 };
+        std::array<std::uint8_t, 4> destination{};
+        model.map(dataRegister, source.data(), source.size());
+        model.map(buffer0, destination.data(), destination.size());
+        TEST_CHECK(first.configure(DmaConfig{ .peripheralIncrement = true }).hasValue());
+        TEST_CHECK(second.configure(DmaConfig{}).hasValue());
+        TEST_CHECK(first.start(dataRegister, buffer0, 4).hasValue());
+        TEST_CHECK(model.transfer(1, 5, 4) == 4 && destination == source);
+        TEST_CHECK(first.flags() == (Dma::transferCompleteFlag | Dma::halfTransferFlag) && second.flags() == 0);
+        first.clearFlags(Dma::allFlags);
+        TEST_CHECK(first.flags() == 0 && !first.isEnabled());
+    }
+
+    void testConfigure()
+    {
+        DmaModel model;
+        DmaStreamHandler& stream{ model.handler(2, 3) };
+        TEST_CHECK(stream.status().hasValue());
+        TEST_CHECK(stream.start(dataRegister, buffer0, 16).error() == DriverError::notInitialized);
+        TEST_CHECK(stream.configure(DmaConfig{ .memoryBurst = DmaBurst::incr4 }).error() == DriverError::invalidParameter);
+
+        Events log;
+        TEST_CHECK(stream.configure(DmaConfig{ .request = Dma::Request::usart1Rx, .halfTransferInterrupt = true }, &Events::record, &log).hasValue());
+        TEST_CHECK(model.request(2, 3) == 41);
+        TEST_CHECK(stream.configuration().request == Dma::Request::usart1Rx);
+
+        // Buffers the stream cannot reach or count it cannot hold
+        TEST_CHECK(stream.start(dataRegister, TestBus::dtcm, 16).error() == DriverError::invalidParameter);
+        TEST_CHECK(stream.start(dataRegister, buffer0, 0).error() == DriverError::invalidParameter);
+        TEST_CHECK(stream.start(dataRegister, buffer0, 0x10000).error() == DriverError::invalidParameter);
+        TEST_CHECK(stream.startDoubleBuffer(dataRegister, buffer0, buffer1, 16).error() == DriverError::invalidParameter);
+
+        std::array<std::uint8_t, 16> memory{};
+        std::uint8_t data{ 0x5A };
+        model.map(dataRegister, &data, 1);
+        model.map(buffer0, memory.data(), memory.size());
+        TEST_CHECK(stream.start(dataRegister, buffer0, 16).hasValue());
+        TEST_CHECK(stream.isEnabled() && stream.remaining() == 16);
+        // Running: no reconfiguration, no second start
+        TEST_CHECK(stream.configure(DmaConfig{}).error() == DriverError::busy);
+        TEST_CHECK(stream.start(dataRegister, buffer0, 16).error() == DriverError::busy);
+
+        serve(model, stream, 2, 3, 10);
+        TEST_CHECK(stream.remaining() == 6 && memory[9] == 0x5A && memory[10] == 0);
+        TEST_CHECK(log.events.size() == 1 && log.events[0] == DmaEvent::halfTransfer);
+        // Stopping sets TCIF on the hardware, stop() acknowledges it
+        TEST_CHECK(stream.stop().hasValue());
+        TEST_CHECK(!stream.isEnabled() && stream.flags() == 0 && !model.interruptPending(2, 3));
+    }
+
+    void testWordPacking()
+    {
+        // Bytes from the peripheral, words to memory through the FIFO
+        DmaModel model;
+        DmaStreamHandler& stream{ model.handler(1, 2) };
+        const DmaConfig config{ .peripheralSize = DmaDataSize::byte, .memorySize = DmaDataSize::word, .mode = DmaMode::circular,
+                                .fifo = DmaFifo::full, .memoryBurst = DmaBurst::incr4 };
+        TEST_CHECK(stream.configure(config).hasValue());
+        // Circular with bursts: whole bursts only, 16 bytes here
+        TEST_CHECK(stream.start(dataRegister, buffer0, 24).error() == DriverError::invalidParameter);
+        TEST_CHECK(stream.start(dataRegister, buffer0, 6).error() == DriverError::invalidParameter);
+        TEST_CHECK(stream.start(dataRegister, buffer0 + 2, 32).error() == DriverError::invalidParameter);
+        TEST_CHECK(stream.start(dataRegister, buffer0, 32).hasValue());
+    }
+
+    void testCircular()
+    {
+        DmaModel model;
+        DmaStreamHandler& stream{ model.handler(1, 4) };
+        std::array<std::uint8_t, 8> memory{};
+        std::uint8_t data{ 0 };
+        model.map(dataRegister, &data, 1);
+        model.map(buffer0, memory.data(), memory.size());
+
+        Events log;
+        TEST_CHECK(stream.configure(DmaConfig{ .mode = DmaMode::circular, .halfTransferInterrupt = true }, &Events::record, &log).hasValue());
+        TEST_CHECK(stream.start(dataRegister, buffer0, 8).hasValue());
+        for (std::uint8_t item = 1; item <= 20; ++item) {
+            data = item;
+            serve(model, stream, 1, 4, 1);
+        }
+        // 2.5 rounds: HT, TC, HT, TC, HT; the stream wrapped to the start of the buffer
+        TEST_CHECK(log.events.size() == 5 && log.events[1] == DmaEvent::transferComplete && log.events[4] == DmaEvent::halfTransfer);
+        TEST_CHECK(stream.isEnabled() && stream.remaining() == 4);
+        TEST_CHECK(memory[0] == 17 && memory[3] == 20 && memory[4] == 13 && memory[7] == 16);
+        TEST_CHECK(stream.stop().hasValue());
+    }
+
+    void testDoubleBuffer()
+    {
+        DmaModel model;
+        DmaStreamHandler& stream{ model.handler(2, 7) };
+        std::array<std::uint16_t, 4> ping{};
+        std::array<std::uint16_t, 4> pong{};
+        std::array<std::uint16_t, 4> spare{};
+        std::uint16_t data{ 0 };
+        model.map(dataRegister, &data, sizeof(data));
+        model.map(buffer0, ping.data(), sizeof(ping));
+        model.map(buffer1, pong.data(), sizeof(pong));
+        model.map(buffer1 + 0x100, spare.data(), sizeof(spare));
+
+        Events log;
+        const DmaConfig config{ .peripheralSize = DmaDataSize::halfWord, .memorySize = DmaDataSize::halfWord, .mode = DmaMode::doubleBuffer };
+        TEST_CHECK(stream.configure(config, &Events::record, &log).hasValue());
+        TEST_CHECK(stream.start(dataRegister, buffer0, 4).error() == DriverError::invalidParameter);
+        TEST_CHECK(stream.startDoubleBuffer(dataRegister, buffer0, buffer1, 4).hasValue());
+        TEST_CHECK(stream.currentBuffer() == 0);
+
+        // The buffer in use cannot move, the idle one can
+        TEST_CHECK(stream.setMemory(0, buffer1 + 0x100).error() == DriverError::busy);
+        TEST_CHECK(stream.isEnabled());
+
+        for (std::uint16_t item = 1; item <= 4; ++item) {
+            data = item;
+            serve(model, stream, 2, 7, 1);
+        }
+        // Buffer 0 is ready, the stream works on buffer 1: move buffer 0 while it fills
+        TEST_CHECK(log.events.size() == 1 && log.events[0] == DmaEvent::transferComplete && log.arguments[0] == 0);
+        TEST_CHECK(stream.currentBuffer() == 1 && ping[3] == 4);
+        TEST_CHECK(stream.setMemory(0, buffer1 + 0x100).hasValue());
+        for (std::uint16_t item = 5; item <= 12; ++item) {
+            data = item;
+            serve(model, stream, 2, 7, 1);
+        }
+        TEST_CHECK(log.events.size() == 3 && log.arguments[1] == 1 && log.arguments[2] == 0);
+        TEST_CHECK(pong[0] == 5 && pong[3] == 8 && spare[0] == 9 && spare[3] == 12 && ping[0] == 1);
+        TEST_CHECK(stream.stop().hasValue());
+    }
+
+    void testTransferError()
+    {
+        DmaModel model;
+        DmaStreamHandler& stream{ model.handler(1, 1) };
+        Events log;
+        std::uint8_t data{ 0 };
+        model.map(dataRegister, &data, 1);
+        TEST_CHECK(stream.configure(DmaConfig{}, &Events::record, &log).hasValue());
+        // Nothing mapped at the buffer: bus error, the stream stops
+        TEST_CHECK(stream.start(dataRegister, buffer0, 4).hasValue());
+        serve(model, stream, 1, 1, 1);
+        TEST_CHECK(!stream.isEnabled() && log.events.size() == 1 && log.events[0] == DmaEvent::transferError);
+    }
+
+    void testAllocation()
+    {
+        enum class User { uartRx, uartTx, spi };
+        using Streams = Dma::StreamAllocation<pair<User::uartRx, Dma::StreamId<1, 0>>, pair<User::uartTx, Dma::StreamId<1, 1>>,
+                                              pair<User::spi, Dma::StreamId<2, 0>>>;
+        static_assert(Streams::Stream<User::uartTx>::controller == 1 && Streams::Stream<User::uartTx>::stream == 1);
+        static_assert(Streams::Stream<User::spi>::channel == 8);
+        // A stream or a user given twice is refused at compile time by StreamAllocation
+        static_assert(!Dma::isValidAllocation<pair<User::uartRx, Dma::StreamId<1, 3>>, pair<User::spi, Dma::StreamId<1, 3>>>());
+        static_assert(!Dma::isValidAllocation<pair<User::spi, Dma::StreamId<1, 3>>, pair<User::spi, Dma::StreamId<1, 4>>>());
+        static_assert(Dma::isValidAllocation<pair<User::uartRx, Dma::StreamId<1, 3>>, pair<User::spi, Dma::StreamId<2, 3>>>());
+        TEST_CHECK(true);
+    }
+};
+
+void runDmaTests()
+{
+    testValidation();
+    testFlagLayout();
+    testConfigure();
+    testWordPacking();
+    testCircular();
+    testDoubleBuffer();
+    testTransferError();
+    testAllocation();
+}
@@ -0,0 +1,71 @@
+#include "UnitTest.hh"
+#include <DualCoreBoot.hh>
+#include <thread>
+
+using namespace DualCoreBoot;
+
+namespace
+{
+    void testTimeline()
+    {
+        // 640 cycles at 64 MHz before the switch, then 480 MHz
+        constexpr Timeline timeline{ { 64, 640, 640 + 4800, 640 + 9600, 640 + 48000, 640 + 96000 }, 64000000, 480000000 };
+        static_assert(timeline.microseconds(Stage::cm4Parked) == 1);
+        TEST_CHECK(timeline.microseconds(Stage::clocksReady) == 10);
+        TEST_CHECK(timeline.microseconds(Stage::memoryReady) == 20);
+        TEST_CHECK(timeline.stepMicroseconds(Stage::clocksReady) == 9);
+        TEST_CHECK(timeline.stepMicroseconds(Stage::cm4Released) == 10);
+        TEST_CHECK(timeline.microseconds(Stage::bothReady) == 210);
+        TEST_CHECK(timeline.stepMicroseconds(Stage::bothReady) == 100);
+    }
+
+    void testRecordHandshake()
+    {
+        BootRecord& record{ bootRecord };
+        // A stale ready state from the previous boot is cleared by the CM7
+        record.markCm4Ready();
+        record.reset(ClockTree::hsiHz, ClockTree::bootConfig.sysclkHz);
+        TEST_CHECK(!record.isCm4Ready() && timeline().cyclesAt(Stage::bothReady) == 0);
+        TEST_CHECK(timeline().runClockHz == 480000000);
+
+        std::thread cm4([&] { record.markCm4Ready(); });
+        while (!record.isCm4Ready()) { std::this_thread::yield(); }
+        cm4.join();
+        record.stamp(Stage::bothReady, 1234);
+        TEST_CHECK(timeline().cyclesAt(Stage::bothReady) == 1234);
+    }
+
+    void testReadyTimeout()
+    {
+        BootRecord& record{ bootRecord };
+        record.reset(ClockTree::hsiHz, ClockTree::bootConfig.sysclkHz);
+        record.stamp(Stage::cm4Parked, 64);
+        record.stamp(Stage::clocksReady, 640);
+        record.stamp(Stage::memoryReady, 640 + 4800);
+        record.stamp(Stage::cm4Released, 640 + 9600);
+        record.stamp(Stage::cm7Ready, 640 + 48000);
+
+        // The CM4 never signals: bothReady stays unstamped and reads 0, not a wrapped duration
+        std::uint32_t clockReads{ 0 };
+        TEST_CHECK(!record.awaitCm4Ready(100, [&] { return ++clockReads; }));
+        TEST_CHECK(clockReads == 0 && !timeline().isStamped(Stage::bothReady));
+        TEST_CHECK(timeline().microseconds(Stage::bothReady) == 0 && timeline().stepMicroseconds(Stage::bothReady) == 0);
+        TEST_CHECK(timeline().isStamped(Stage::cm7Ready) && timeline().microseconds(Stage::cm7Ready) == 110);
+
+        // A stage stamped before the clock switch was recorded cannot yield a negative step
+        constexpr Timeline partial{ { 64, 0, 640 + 4800, 0, 0, 0 }, 64000000, 480000000 };
+        static_assert(partial.microseconds(Stage::memoryReady) == 0 && partial.stepMicroseconds(Stage::memoryReady) == 0);
+        static_assert(partial.stepMicroseconds(Stage::cm4Parked) == 1);
+
+        record.markCm4Ready();
+        TEST_CHECK(record.awaitCm4Ready(1, [] { return 640U + 96000U; }));
+        TEST_CHECK(timeline().microseconds(Stage::bothReady) == 210 && timeline().stepMicroseconds(Stage::bothReady) == 100);
+    }
+};
+
+void runDualCoreBootTests()
+{
+    testTimeline();
+    testRecordHandshake();
+    testReadyTimeout();
+}
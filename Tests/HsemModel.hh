@@ -0,0 +1,134 @@
+#ifndef __HSEMMODEL_H__
+#define __HSEMMODEL_H__
+
+/**
+ * @file HsemModel.hh
+ * @brief Behavioral model of the HSEM lock semantics for host tests.
+ *
+ * Models the 32 semaphores with the two core interfaces (CM7 and CM4): 2-step lock
+ * writes that only take effect on a free semaphore, 1-step lock reads, releases that
+ * must match the owner, CR clear-all guarded by KEYR, and the per-core interrupt status
+ * raised when a semaphore is freed. The registers are IRegister handles passed to
+ * HsemHandler with registerHandles, so the driver code runs unchanged. Accesses are
+ * serialized by a mutex, as the bus does, so the cores may be modeled with threads.
+ */
+
+//<------------------------------INCLUDES------------------------------>//
+#include <cstdint>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <Hsem.hh>
+#include "ModelSupport.hh"
+//<-------------------------------------------------------------------->//
+
+class HsemModel
+{
+    public:
+        enum class Kind { semaphore, readLock, interruptEnable, interruptClear, interruptStatus, clear, clearKey };
+
+        using ModelRegister = HostRegister<HsemModel, std::uint32_t, std::uint32_t, Kind>;
+        friend ModelRegister;
+
+        /// Registers of one semaphore seen from one core, in the order HsemHandler takes them.
+        struct View {
+            ModelRegister semaphore, readLock, interruptEnable, interruptClear, interruptStatus, clear, clearKey;
+
+            View(HsemModel& model, const std::uint32_t core, const std::uint32_t id)
+                : semaphore(model, core, id, Kind::semaphore), readLock(model, core, id, Kind::readLock),
+                  interruptEnable(model, core, id, Kind::interruptEnable), interruptClear(model, core, id, Kind::interruptClear),
+                  interruptStatus(model, core, id, Kind::interruptStatus), clear(model, core, id, Kind::clear),
+                  clearKey(model, core, id, Kind::clearKey) {}
+        };
+
+        /**
+         * @brief Handler of semaphore id for a core, running on the model.
+         */
+        HsemHandler& handler(const std::uint32_t core, const std::uint32_t id)
+        {
+            views.push_back(std::make_unique<View>(*this, core, id));
+            View& view{ *views.back() };
+            // The handles are stored as the interface type
+            auto handle = [](ModelRegister& reg) -> IRegister<volatile std::uint32_t*>* { return &reg; };
+            handlers.push_back(std::make_unique<HsemHandler>(id, core, registerHandles, handle(view.semaphore), handle(view.readLock),
+                handle(view.interruptEnable), handle(view.interruptClear), handle(view.interruptStatus), handle(view.clear),
+                handle(view.clearKey)));
+            return *handlers.back();
+        }
+
+        /// Interrupt status (ISR) of a core's interface, before masking.
+        std::uint32_t rawStatus(const std::uint32_t core)
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            return interface(core).status;
+        }
+
+    private:
+        struct Interface {
+            std::uint32_t enable{ 0 };
+            std::uint32_t status{ 0 };
+        };
+
+        std::mutex mutex;
+        std::array<std::uint32_t, Hsem::semaphoreCount> semaphores{};
+        std::uint32_t key{ 0 };
+        Interface cm7Interface;
+        Interface cm4Interface;
+        std::vector<std::unique_ptr<View>> views;
+        std::vector<std::unique_ptr<HsemHandler>> handlers;
+
+        Interface& interface(const std::uint32_t core) { return core == Hsem::cm4CoreId ? cm4Interface : cm7Interface; }
+
+        void free(const std::uint32_t id)
+        {
+            semaphores[id] = 0;
+            cm7Interface.status |= 1U << id;
+            cm4Interface.status |= 1U << id;
+        }
+
+        std::uint32_t read(const std::uint32_t core, const std::uint32_t id, const Kind kind)
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            switch (kind) {
+                case Kind::semaphore: return semaphores[id];
+                case Kind::readLock:
+                    // 1-step lock: a read locks a free semaphore with process ID 0
+                    if ((semaphores[id] & Hsem::lockBit) == 0) { semaphores[id] = Hsem::lockValue(core, 0); }
+                    return semaphores[id];
+                case Kind::interruptEnable: return interface(core).enable;
+                case Kind::interruptStatus: return interface(core).status & interface(core).enable;
+                case Kind::clearKey: return key << Hsem::keyPos;
+                default: return 0;
+            }
+        }
+
+        void write(const std::uint32_t core, const std::uint32_t id, const Kind kind, const std::uint32_t value)
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            const std::uint32_t valueCore{ (value & Hsem::coreIdMask) >> Hsem::coreIdPos };
+            switch (kind) {
+                case Kind::semaphore:
+                    // The core ID is the one of the bus master, whatever the written value
+                    if (valueCore != core) { break; }
+                    if ((value & Hsem::lockBit) != 0) {
+                        if ((semaphores[id] & Hsem::lockBit) == 0) { semaphores[id] = value & (Hsem::lockBit | Hsem::coreIdMask | Hsem::procIdMask); }
+                    } else if (semaphores[id] == (Hsem::lockBit | value)) {
+                        free(id);
+                    }
+                    break;
+                case Kind::interruptEnable: interface(core).enable = value; break;
+                case Kind::interruptClear: interface(core).status &= ~value; break;
+                case Kind::clear:
+                    if (valueCore != core || (value >> Hsem::keyPos) != key) { break; }
+                    for (std::uint32_t index = 0; index < Hsem::semaphoreCount; ++index) {
+                        if ((semaphores[index] & Hsem::lockBit) != 0 && ((semaphores[index] & Hsem::coreIdMask) >> Hsem::coreIdPos) == core) { free(index); }
+                    }
+                    break;
+                case Kind::clearKey: key = value >> Hsem::keyPos; break;
+                default: break;
+            }
+        }
+};
+
+#endif // __HSEMMODEL_H__
@@ -0,0 +1,111 @@
+#include "UnitTest.hh"
+#include "HsemModel.hh"
+#include <Hsem.hh>
+#include <atomic>
+#include <thread>
+
+namespace
+{
+    void testTwoStepLock()
+    {
+        HsemModel model;
+        HsemHandler& cm7{ model.handler(Hsem::cm7CoreId, 3) };
+        HsemHandler& cm4{ model.handler(Hsem::cm4CoreId, 3) };
+
+        TEST_CHECK(cm7.status().hasValue() && !cm7.isLocked());
+        TEST_CHECK(cm7.lock(5).hasValue());
+        TEST_CHECK(cm7.isLocked() && cm7.ownerCore() == Hsem::cm7CoreId && cm7.ownerProcess() == 5);
+        // Held by another core, then by another process of the same core
+        TEST_CHECK(!cm4.lock(5) && cm4.lock(5).error() == DriverError::busy);
+        TEST_CHECK(!cm7.lock(6));
+        // Only the owning process can release
+        cm7.release(6);
+        TEST_CHECK(cm7.isLocked());
+        cm4.release(5);
+        TEST_CHECK(cm7.isLocked());
+        cm7.release(5);
+        TEST_CHECK(!cm7.isLocked() && cm4.lock(1).hasValue() && cm4.ownerCore() == Hsem::cm4CoreId);
+    }
+
+    void testOneStepLock()
+    {
+        HsemModel model;
+        HsemHandler& cm7{ model.handler(Hsem::cm7CoreId, 0) };
+        HsemHandler& cm4{ model.handler(Hsem::cm4CoreId, 0) };
+
+        TEST_CHECK(cm4.fastLock().hasValue());
+        TEST_CHECK(cm4.ownerProcess() == 0 && !cm7.fastLock());
+        // A 1-step lock is a 2-step lock with process ID 0
+        TEST_CHECK(!cm4.lock(1));
+        cm4.release();
+        TEST_CHECK(cm7.fastLock().hasValue() && cm7.ownerCore() == Hsem::cm7CoreId);
+    }
+
+    void testReleaseAll()
+    {
+        HsemModel model;
+        HsemHandler& first{ model.handler(Hsem::cm7CoreId, 1) };
+        HsemHandler& second{ model.handler(Hsem::cm7CoreId, 2) };
+        HsemHandler& other{ model.handler(Hsem::cm4CoreId, 4) };
+
+        first.setClearKey(0x1234);
+        TEST_CHECK(first.lock(1).hasValue() && second.fastLock().hasValue() && other.lock(1).hasValue());
+        first.releaseAll(0x4321);
+        TEST_CHECK(first.isLocked() && second.isLocked());
+        first.releaseAll(0x1234);
+        // Only the semaphores of the calling core are freed
+        TEST_CHECK(!first.isLocked() && !second.isLocked() && other.isLocked());
+    }
+
+    void testNotification()
+    {
+        HsemModel model;
+        HsemHandler& cm7{ model.handler(Hsem::cm7CoreId, 9) };
+        HsemHandler& cm4{ model.handler(Hsem::cm4CoreId, 9) };
+
+        TEST_CHECK(cm4.lock(2).hasValue());
+        cm7.enableNotification();
+        TEST_CHECK(!cm7.takeNotification());
+        cm4.release(2);
+        // Raised on every interface, only the enabled one reaches the core
+        TEST_CHECK((model.rawStatus(Hsem::cm4CoreId) & (1U << 9)) != 0);
+        TEST_CHECK(cm7.takeNotification() && !cm7.takeNotification());
+        cm7.disableNotification();
+        TEST_CHECK(cm4.lock(2).hasValue());
+        cm4.release(2);
+        TEST_CHECK(!cm7.takeNotification());
+    }
+
+    void testLockWaiting()
+    {
+        HsemModel model;
+        HsemHandler& cm7{ model.handler(Hsem::cm7CoreId, 12) };
+        HsemHandler& cm4{ model.handler(Hsem::cm4CoreId, 12) };
+
+        TEST_CHECK(cm4.lock(1).hasValue());
+        TEST_CHECK(cm7.lockWaiting(1, 3).error() == DriverError::timeout);
+
+        // The other core releases after a while, the waiter gets the lock
+        std::atomic<bool> waiting{ false };
+        std::thread owner([&] {
+            while (!waiting.load()) { std::this_thread::yield(); }
+            for (int index = 0; index < 100; ++index) { std::this_thread::yield(); }
+            cm4.release(1);
+        });
+        waiting.store(true);
+        const DriverStatus result{ cm7.lockWaiting(1) };
+        owner.join();
+        TEST_CHECK(result.hasValue() && cm7.ownerCore() == Hsem::cm7CoreId && cm7.ownerProcess() == 1);
+        cm7.release(1);
+        TEST_CHECK(!cm7.isLocked());
+    }
+};
+
+void runHsemTests()
+{
+    testTwoStepLock();
+    testOneStepLock();
+    testReleaseAll();
+    testNotification();
+    testLockWaiting();
+}
@@ -0,0 +1,254 @@
+#ifndef __MDMAMODEL_H__
+#define __MDMAMODEL_H__
+
+/**
+ * @file MdmaModel.hh
+ * @brief Behavioral model of the MDMA channels for host tests.
+ *
+ * Models the channel registers (locked while the channel is enabled), requests served
+ * according to the trigger mode of the current node (a buffer, a block, all blocks of the
+ * node, or the node and the software nodes linked after it), block repeats with the CxBRUR
+ * address updates, the mask write after each request, node loading from the CxLAR address,
+ * and the end of the chain disabling the channel. The bus is the map of 32-bit addresses
+ * to host buffers given with map(): chains are built with MdmaChain(busAddress) on a mapped
+ * range, and an access outside the map is a transfer error (CxESR.TELD for a node load).
+ */
+
+//<------------------------------INCLUDES------------------------------>//
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <Mdma.hh>
+#include "ModelSupport.hh"
+//<-------------------------------------------------------------------->//
+
+class MdmaModel : public BusMap
+{
+    public:
+        enum class Kind { status, clear, errorStatus, control, transferConfig, blockCount, source, destination, repeatUpdate, link, triggerBus, maskAddress, maskData };
+
+        /// CxESR.TELD: error while loading a node.
+        static constexpr std::uint32_t linkErrorBit{ 1U << 8 };
+
+        using ModelRegister = HostRegister<MdmaModel, std::uint32_t, Kind>;
+        friend ModelRegister;
+
+        /// Registers of one channel, in the order MdmaChannelHandler takes them.
+        struct View {
+            std::array<ModelRegister, 13> registers;
+
+            View(MdmaModel& model, const std::uint32_t channel)
+                : registers{ ModelRegister(model, channel, Kind::status), ModelRegister(model, channel, Kind::clear),
+                             ModelRegister(model, channel, Kind::errorStatus), ModelRegister(model, channel, Kind::control),
+                             ModelRegister(model, channel, Kind::transferConfig), ModelRegister(model, channel, Kind::blockCount),
+                             ModelRegister(model, channel, Kind::source), ModelRegister(model, channel, Kind::destination),
+                             ModelRegister(model, channel, Kind::repeatUpdate), ModelRegister(model, channel, Kind::link),
+                             ModelRegister(model, channel, Kind::triggerBus), ModelRegister(model, channel, Kind::maskAddress),
+                             ModelRegister(model, channel, Kind::maskData) } {}
+        };
+
+        /**
+         * @brief Handler of a channel, running on the model.
+         */
+        MdmaChannelHandler& handler(const std::uint8_t channel)
+        {
+            views.push_back(std::make_unique<View>(*this, channel));
+            auto& r{ views.back()->registers };
+            auto handle = [](ModelRegister& reg) -> IRegister<volatile std::uint32_t*>* { return &reg; };
+            handlers.push_back(std::make_unique<MdmaChannelHandler>(channel, registerHandles, handle(r[0]), handle(r[1]), handle(r[2]), handle(r[3]),
+                handle(r[4]), handle(r[5]), handle(r[6]), handle(r[7]), handle(r[8]), handle(r[9]), handle(r[10]), handle(r[11]), handle(r[12])));
+            return *handlers.back();
+        }
+
+        /// Hardware trigger of a channel, served if its current node waits for it.
+        void trigger(const std::uint8_t channel)
+        {
+            Channel& state{ channels[channel] };
+            if (enabled(state) && !software(state)) { serve(state); }
+        }
+
+        /// Whether an enabled interrupt of the channel is pending, its bit in GISR0.
+        bool interruptPending(const std::uint8_t channel)
+        {
+            const Channel& state{ channels[channel] };
+            std::uint32_t enabledFlags{ 0 };
+            if ((state.control & (1U << Mdma::transferErrorInterruptPos)) != 0) { enabledFlags |= Mdma::transferErrorFlag; }
+            if ((state.control & (1U << Mdma::channelCompleteInterruptPos)) != 0) { enabledFlags |= Mdma::channelCompleteFlag; }
+            return (state.flags & enabledFlags) != 0;
+        }
+
+        /// Nodes loaded from memory by a channel since the model was created.
+        std::uint32_t nodesLoaded(const std::uint8_t channel) { return channels[channel].loads; }
+
+    private:
+        struct Channel {
+            std::uint32_t control{ 0 };
+            std::uint32_t flags{ 0 };
+            std::uint32_t error{ 0 };
+            MdmaDescriptor node{};
+            std::uint32_t blockBytes{ 0 };  ///< BNDT of the node, the register counts down.
+            std::uint32_t repeats{ 0 };     ///< BRC of the node, the register counts down.
+            std::uint32_t offset{ 0 };      ///< Bytes done in the current block.
+            std::uint32_t loads{ 0 };
+        };
+
+        std::array<Channel, Mdma::channelCount> channels{};
+        std::vector<std::unique_ptr<View>> views;
+        std::vector<std::unique_ptr<MdmaChannelHandler>> handlers;
+
+        static bool enabled(const Channel& state) { return (state.control & (1U << Mdma::enablePos)) != 0; }
+        static bool software(const Channel& state) { return ((state.node.transferConfig >> Mdma::softwareModePos) & 1U) != 0; }
+        static std::uint32_t field(const Channel& state, const std::uint32_t position, const std::uint32_t mask) { return (state.node.transferConfig >> position) & mask; }
+
+        void fail(Channel& state, const std::uint32_t error)
+        {
+            state.flags |= Mdma::transferErrorFlag;
+            state.error = error;
+            state.control &= ~(1U << Mdma::enablePos);
+        }
+
+        /// Start a node: the counters come from its CxBNDTR.
+        void begin(Channel& state)
+        {
+            state.blockBytes = state.node.blockCount & Mdma::blockBytesMask;
+            state.repeats = state.node.blockCount >> Mdma::blockRepeatPos;
+            state.offset = 0;
+        }
+
+        /// Move bytes of the current block, false on a bus error.
+        bool move(Channel& state, const std::uint32_t bytes)
+        {
+            const bool sourceIncrement{ field(state, Mdma::sourceIncrementPos, 3) != 0 };
+            const bool destinationIncrement{ field(state, Mdma::destinationIncrementPos, 3) != 0 };
+            const std::uint32_t sourceSize{ 1U << field(state, Mdma::sourceSizePos, 3) };
+            const std::uint32_t destinationSize{ 1U << field(state, Mdma::destinationSizePos, 3) };
+            for (std::uint32_t index = 0; index < bytes; ++index) {
+                const std::uint32_t position{ state.offset + index };
+                std::uint8_t* from{ translate(state.node.source + (sourceIncrement ? position : position % sourceSize), 1) };
+                std::uint8_t* to{ translate(state.node.destination + (destinationIncrement ? position : position % destinationSize), 1) };
+                if (from == nullptr || to == nullptr) { return false; }
+                *to = *from;
+            }
+            state.offset += bytes;
+            return true;
+        }
+
+        /// Next block of the node, false when the node is done.
+        bool nextBlock(Channel& state)
+        {
+            state.flags |= Mdma::blockCompleteFlag;
+            if (state.repeats == 0) {
+                state.flags |= Mdma::blockRepeatCompleteFlag;
+                return false;
+            }
+            --state.repeats;
+            const bool sourceIncrement{ field(state, Mdma::sourceIncrementPos, 3) != 0 };
+            const bool destinationIncrement{ field(state, Mdma::destinationIncrementPos, 3) != 0 };
+            state.node.source += (sourceIncrement ? state.blockBytes : 0U) + (state.node.repeatUpdate & 0xFFFFU);
+            state.node.destination += (destinationIncrement ? state.blockBytes : 0U) + (state.node.repeatUpdate >> Mdma::destinationUpdatePos);
+            state.offset = 0;
+            return true;
+        }
+
+        /// Load the next node, or end the chain. false if the channel stopped.
+        bool nextNode(Channel& state)
+        {
+            if (state.node.link == 0) {
+                state.flags |= Mdma::channelCompleteFlag;
+                state.control &= ~(1U << Mdma::enablePos);
+                return false;
+            }
+            const std::uint8_t* node{ translate(state.node.link, sizeof(MdmaDescriptor)) };
+            if (node == nullptr || (state.node.link & 7U) != 0) {
+                fail(state, linkErrorBit);
+                return false;
+            }
+            std::memcpy(&state.node, node, sizeof(MdmaDescriptor));
+            ++state.loads;
+            begin(state);
+            return true;
+        }
+
+        /// One request: the amount of data the trigger mode of the current node says.
+        void serve(Channel& state)
+        {
+            while (enabled(state)) {
+                const auto mode{ static_cast<MdmaTriggerMode>(field(state, Mdma::triggerModePos, 3)) };
+                const std::uint32_t buffer{ field(state, Mdma::bufferLengthPos, 0x7F) + 1U };
+                const std::uint32_t left{ state.blockBytes - state.offset };
+                const std::uint32_t bytes{ mode == MdmaTriggerMode::buffer && buffer < left ? buffer : left };
+                if (!move(state, bytes)) {
+                    fail(state, 0);
+                    return;
+                }
+                state.flags |= Mdma::bufferCompleteFlag;
+                if (state.node.maskAddress != 0) {
+                    std::uint8_t* mask{ translate(state.node.maskAddress, 4) };
+                    if (mask != nullptr) { std::memcpy(mask, &state.node.maskData, 4); }
+                }
+                if (state.offset < state.blockBytes) { return; }
+                const bool wholeNode{ mode == MdmaTriggerMode::repeatedBlock || mode == MdmaTriggerMode::linkedList };
+                if (nextBlock(state)) {
+                    if (wholeNode) { continue; }
+                    return;
+                }
+                if (!nextNode(state)) { return; }
+                // Software nodes follow each other, a triggered node waits
+                if (mode != MdmaTriggerMode::linkedList || !software(state)) { return; }
+            }
+        }
+
+        std::uint32_t read(const std::uint32_t channel, const Kind kind)
+        {
+            const Channel& state{ channels[channel] };
+            switch (kind) {
+                case Kind::status: return state.flags;
+                case Kind::errorStatus: return state.error;
+                case Kind::control: return state.control;
+                case Kind::transferConfig: return state.node.transferConfig;
+                case Kind::blockCount: return (state.blockBytes - state.offset) | (state.repeats << Mdma::blockRepeatPos);
+                case Kind::source: return state.node.source;
+                case Kind::destination: return state.node.destination;
+                case Kind::repeatUpdate: return state.node.repeatUpdate;
+                case Kind::link: return state.node.link;
+                case Kind::triggerBus: return state.node.triggerBus;
+                case Kind::maskAddress: return state.node.maskAddress;
+                case Kind::maskData: return state.node.maskData;
+                default: return 0;
+            }
+        }
+
+        void write(const std::uint32_t channel, const Kind kind, const std::uint32_t value)
+        {
+            Channel& state{ channels[channel] };
+            if (kind == Kind::clear) {
+                state.flags &= ~value;
+                if ((value & Mdma::transferErrorFlag) != 0) { state.error = 0; }
+                return;
+            }
+            if (kind == Kind::control) {
+                const bool wasEnabled{ enabled(state) };
+                state.control = value & ~(1U << Mdma::softwareRequestPos);
+                if (!wasEnabled && enabled(state)) { begin(state); }
+                if (enabled(state) && software(state) && (value & (1U << Mdma::softwareRequestPos)) != 0) { serve(state); }
+                return;
+            }
+            if (enabled(state)) { return; }
+            switch (kind) {
+                case Kind::transferConfig: state.node.transferConfig = value; break;
+                case Kind::blockCount: state.node.blockCount = value; break;
+                case Kind::source: state.node.source = value; break;
+                case Kind::destination: state.node.destination = value; break;
+                case Kind::repeatUpdate: state.node.repeatUpdate = value; break;
+                case Kind::link: state.node.link = value; break;
+                case Kind::triggerBus: state.node.triggerBus = value; break;
+                case Kind::maskAddress: state.node.maskAddress = value; break;
+                case Kind::maskData: state.node.maskData = value; break;
+                default: break;
+            }
+        }
+};
+
+#endif // __MDMAMODEL_H__
@@ -0,0 +1,257 @@
+#include "UnitTest.hh"
+#include "MdmaModel.hh"
+#include "ModelSupport.hh"
+#include <Mdma.hh>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+    // The chains at the end of AXI SRAM, two peripheral registers
+    constexpr std::uint32_t chainBase{ TestBus::axiSram + 0x70000 };
+    constexpr std::uint32_t dataRegister{ 0x40013000 };
+    constexpr std::uint32_t clearRegister{ 0x40013004 };
+
+    struct Bus {
+        MdmaModel model;
+        std::vector<std::uint8_t> axi;
+        std::vector<std::uint8_t> sram1;
+        std::array<std::uint8_t, 256> dtcm{};
+        std::array<std::uint32_t, 2> registers{};
+
+        explicit Bus(const std::size_t size) : axi(size), sram1(size)
+        {
+            for (std::size_t index = 0; index < size; ++index) { axi[index] = static_cast<std::uint8_t>(index * 7 + 1); }
+            model.map(TestBus::axiSram, axi.data(), axi.size());
+            model.map(TestBus::sram1, sram1.data(), sram1.size());
+            model.map(TestBus::dtcm, dtcm.data(), dtcm.size());
+            model.map(dataRegister, registers.data(), sizeof(registers));
+        }
+
+        template<std::size_t Nodes>
+        void mapChain(MdmaChain<Nodes>& chain, const std::size_t nodes = Nodes)
+        {
+            model.map(chainBase, const_cast<MdmaDescriptor*>(chain.data()), nodes * sizeof(MdmaDescriptor));
+        }
+    };
+
+    using Events = EventLog<MdmaEvent, std::uint32_t>;
+
+    void serveInterrupt(Bus& bus, MdmaChannelHandler& channel, const std::uint8_t number)
+    {
+        if (bus.model.interruptPending(number)) { channel.handleInterrupt(); }
+    }
+
+    void testValidation()
+    {
+        TEST_CHECK(Mdma::widestSize(TestBus::axiSram, TestBus::sram1, 4096) == MdmaDataSize::doubleWord);
+        TEST_CHECK(Mdma::widestSize(TestBus::axiSram + 4, TestBus::sram1, 4096) == MdmaDataSize::word);
+        TEST_CHECK(Mdma::widestSize(TestBus::axiSram, TestBus::sram1, 98) == MdmaDataSize::halfWord);
+        TEST_CHECK(Mdma::widestSize(TestBus::axiSram + 3, TestBus::sram1, 4096) == MdmaDataSize::byte);
+        TEST_CHECK(Mdma::busOf(TestBus::dtcm) == 1 && Mdma::busOf(0x00001000) == 1 && Mdma::busOf(TestBus::axiSram) == 0);
+
+        // Bursts of 16 double words fill a 128-byte buffer, fixed addresses read single beats
+        constexpr std::uint32_t config{ Mdma::transferConfig(MdmaDataSize::doubleWord, true, false, 128, MdmaTriggerMode::linkedList, true) };
+        static_assert(((config >> Mdma::sourceBurstPos) & 7U) == 4 && ((config >> Mdma::destinationBurstPos) & 7U) == 0);
+        static_assert(((config >> Mdma::bufferLengthPos) & 0x7FU) == 127 && (config >> Mdma::triggerModePos) == 3 + 4);
+        static_assert(((Mdma::transferConfig(MdmaDataSize::word, true, true, 8, MdmaTriggerMode::buffer, false) >> Mdma::sourceBurstPos) & 7U) == 1);
+
+        MdmaChain<4> chain{ chainBase };
+        TEST_CHECK(chain.copy(TestBus::sram1, TestBus::axiSram, 1000).hasValue());
+        const MdmaDescriptor good{ chain.node(0) };
+        TEST_CHECK(Mdma::isValid(good));
+
+        MdmaDescriptor bad{ good };
+        bad.source += 2;                                    // not aligned on the data size
+        TEST_CHECK(!Mdma::isValid(bad));
+        bad = good;
+        bad.blockCount = 0;
+        TEST_CHECK(!Mdma::isValid(bad));
+        bad = good;
+        bad.blockCount = 1001;                              // not whole data items
+        TEST_CHECK(!Mdma::isValid(bad));
+        bad = good;
+        bad.transferConfig = (good.transferConfig & ~(0x7FU << Mdma::bufferLengthPos)) | (15U << Mdma::bufferLengthPos);
+        TEST_CHECK(!Mdma::isValid(bad));                    // a 16-beat burst longer than the buffer
+        bad = good;
+        bad.link = chainBase + 4;
+        TEST_CHECK(!Mdma::isValid(bad));
+        bad = good;
+        bad.destination = TestBus::dtcm;                         // TCM through AXI
+        TEST_CHECK(!Mdma::isValid(bad));
+        bad.triggerBus |= 1U << Mdma::destinationBusPos;
+        TEST_CHECK(Mdma::isValid(bad));
+
+        // Builder arguments
+        TEST_CHECK(chain.copy(TestBus::sram1, TestBus::axiSram, 0).error() == DriverError::invalidParameter);
+        TEST_CHECK(chain.copy2d(TestBus::sram1, 8, TestBus::axiSram, 4, 8, 2).error() == DriverError::invalidParameter);
+        TEST_CHECK(chain.copy2d(TestBus::sram1, 8, TestBus::axiSram, 8, 8, 4097).error() == DriverError::invalidParameter);
+        TEST_CHECK(chain.triggered(MdmaTriggeredTransfer{ .peripheral = dataRegister, .memory = TestBus::axiSram, .bytes = 16, .bytesPerTrigger = 6 }).error() ==
+                   DriverError::invalidParameter);
+        TEST_CHECK(chain.size() == 1 && chain.validate().hasValue());
+    }
+
+    void testScatterGather()
+    {
+        Bus bus{ 4096 };
+        MdmaChain<4> chain{ chainBase };
+        bus.mapChain(chain);
+        MdmaChannelHandler& channel{ bus.model.handler(3) };
+        Events log;
+        TEST_CHECK(channel.configure(MdmaPriority::high, &Events::record, &log).hasValue());
+
+        // Gather three pieces of any alignment into one contiguous buffer
+        TEST_CHECK(chain.copy(TestBus::sram1, TestBus::axiSram + 1000, 256).hasValue());
+        TEST_CHECK(chain.copy(TestBus::sram1 + 256, TestBus::axiSram + 3, 101).hasValue());
+        TEST_CHECK(chain.copy(TestBus::sram1 + 357, TestBus::axiSram + 2048, 40).hasValue());
+        TEST_CHECK(chain.node(0).link == chainBase + 40 && chain.node(1).link == chainBase + 80 && chain.node(2).link == 0);
+        TEST_CHECK(((chain.node(1).transferConfig >> Mdma::sourceSizePos) & 3U) == 0);
+
+        TEST_CHECK(channel.start(chain).hasValue());
+        serveInterrupt(bus, channel, 3);
+        TEST_CHECK(log.events.size() == 1 && log.events[0] == MdmaEvent::channelComplete);
+        TEST_CHECK(!channel.isBusy() && bus.model.nodesLoaded(3) == 2);
+        bool same{ true };
+        for (std::size_t index = 0; index < 256; ++index) { same = same && bus.sram1[index] == bus.axi[1000 + index]; }
+        for (std::size_t index = 0; index < 101; ++index) { same = same && bus.sram1[256 + index] == bus.axi[3 + index]; }
+        for (std::size_t index = 0; index < 40; ++index) { same = same && bus.sram1[357 + index] == bus.axi[2048 + index]; }
+        TEST_CHECK(same && bus.sram1[397] == 0);
+
+        // Chains are rebuilt in place and run again
+        chain.reset();
+        TEST_CHECK(chain.copy(TestBus::sram1 + 1024, TestBus::axiSram, 64).hasValue());
+        TEST_CHECK(channel.start(chain).hasValue());
+        TEST_CHECK(bus.sram1[1024 + 63] == bus.axi[63] && !channel.isBusy());
+    }
+
+    void testLargeCopy()
+    {
+        Bus bus{ 150000 };
+        MdmaChain<3> chain{ chainBase };
+        bus.mapChain(chain);
+        MdmaChannelHandler& channel{ bus.model.handler(0) };
+
+        // 64 KiB blocks: three nodes for 150000 bytes
+        MdmaChain<2> small{ chainBase };
+        TEST_CHECK(small.copy(TestBus::sram1, TestBus::axiSram, 150000).error() == DriverError::outOfResources && small.size() == 0);
+        TEST_CHECK(chain.copy(TestBus::sram1, TestBus::axiSram, 150000).hasValue() && chain.size() == 3);
+        TEST_CHECK((chain.node(2).blockCount & Mdma::blockBytesMask) == 150000 - 2 * 65536);
+        TEST_CHECK(channel.start(chain).hasValue());
+        TEST_CHECK(bus.sram1 == bus.axi && channel.flags() == (Mdma::channelCompleteFlag | Mdma::blockCompleteFlag |
+                                                                Mdma::blockRepeatCompleteFlag | Mdma::bufferCompleteFlag));
+    }
+
+    void testCopy2d()
+    {
+        Bus bus{ 4096 };
+        MdmaChain<2> chain{ chainBase };
+        bus.mapChain(chain);
+        MdmaChannelHandler& channel{ bus.model.handler(1) };
+
+        // 16 x 8 tile at (8, 2) of a 64-byte-stride image, into a packed tile in DTCM
+        TEST_CHECK(chain.copy2d(TestBus::dtcm, 16, TestBus::axiSram + 2 * 64 + 8, 64, 16, 8).hasValue());
+        const MdmaDescriptor& node{ chain.node(0) };
+        TEST_CHECK((node.blockCount >> Mdma::blockRepeatPos) == 7 && node.repeatUpdate == (48U | (0U << 16)));
+        TEST_CHECK((node.triggerBus >> Mdma::destinationBusPos) == 1 && ((node.triggerBus >> Mdma::sourceBusPos) & 1U) == 0);
+        TEST_CHECK(channel.start(chain).hasValue());
+        bool same{ true };
+        for (std::size_t row = 0; row < 8; ++row) {
+            for (std::size_t column = 0; column < 16; ++column) { same = same && bus.dtcm[row * 16 + column] == bus.axi[(row + 2) * 64 + 8 + column]; }
+        }
+        TEST_CHECK(same && bus.dtcm[128] == 0 && !channel.isBusy());
+    }
+
+    void testWriteRegister()
+    {
+        Bus bus{ 1024 };
+        MdmaChain<2> chain{ chainBase };
+        bus.mapChain(chain);
+        MdmaChannelHandler& channel{ bus.model.handler(2) };
+
+        // Data first, then the register write that would start the peripheral
+        TEST_CHECK(chain.copy(TestBus::sram1, TestBus::axiSram, 512).hasValue());
+        TEST_CHECK(chain.writeRegister(dataRegister, 0xA5A50001).hasValue());
+        TEST_CHECK(chain.node(1).source == chainBase + 40 + 28);
+        TEST_CHECK(chain.writeRegister(dataRegister, 0).error() == DriverError::outOfResources);
+        TEST_CHECK(channel.start(chain).hasValue());
+        TEST_CHECK(bus.registers[0] == 0xA5A50001 && bus.sram1[511] == bus.axi[511]);
+    }
+
+    void testTriggered()
+    {
+        Bus bus{ 1024 };
+        MdmaChain<1> chain{ chainBase };
+        bus.mapChain(chain);
+        MdmaChannelHandler& channel{ bus.model.handler(5) };
+        Events log;
+        TEST_CHECK(channel.configure(MdmaPriority::medium, &Events::record, &log).hasValue());
+
+        // Four words from the data register, one per trigger, each acknowledged by a mask write
+        TEST_CHECK(chain.triggered(MdmaTriggeredTransfer{ .trigger = Mdma::Trigger::quadspiFifoThreshold, .peripheral = dataRegister, .memory = TestBus::sram1,
+                                                          .bytes = 16, .bytesPerTrigger = 4, .maskAddress = clearRegister, .maskData = 0x8 }).hasValue());
+        TEST_CHECK((chain.node(0).triggerBus & Mdma::triggerMask) == 22);
+        TEST_CHECK(channel.start(chain).hasValue());
+        TEST_CHECK(channel.isBusy() && channel.remaining() == 16);
+        TEST_CHECK(channel.start(chain).error() == DriverError::busy);
+
+        std::array<std::uint32_t, 4> received{};
+        for (std::uint32_t word = 0; word < 4; ++word) {
+            bus.registers[0] = 0x100 + word;
+            bus.registers[1] = 0;
+            bus.model.trigger(5);
+            TEST_CHECK(bus.registers[1] == 0x8);
+            serveInterrupt(bus, channel, 5);
+        }
+        std::memcpy(received.data(), bus.sram1.data(), sizeof(received));
+        TEST_CHECK(received[0] == 0x100 && received[3] == 0x103);
+        TEST_CHECK(log.events.size() == 1 && log.events[0] == MdmaEvent::channelComplete && !channel.isBusy());
+
+        // Stopped halfway
+        TEST_CHECK(channel.start(chain).hasValue());
+        bus.model.trigger(5);
+        TEST_CHECK(channel.remaining() == 12 && channel.stop().hasValue() && !channel.isBusy());
+    }
+
+    void testErrors()
+    {
+        Bus bus{ 1024 };
+        MdmaChannelHandler& channel{ bus.model.handler(7) };
+        Events log;
+        TEST_CHECK(channel.configure(MdmaPriority::low, &Events::record, &log).hasValue());
+
+        // Chains the channel cannot fetch
+        MdmaChain<2> empty{ chainBase };
+        TEST_CHECK(channel.start(empty).error() == DriverError::invalidParameter);
+        MdmaChain<2> inTcm{ TestBus::dtcm };
+        TEST_CHECK(inTcm.copy(TestBus::sram1, TestBus::axiSram, 16).hasValue() && channel.start(inTcm).error() == DriverError::invalidParameter);
+
+        // Unmapped destination: bus error
+        MdmaChain<2> chain{ chainBase };
+        bus.mapChain(chain);
+        TEST_CHECK(chain.copy(0x24060000, TestBus::axiSram, 16).hasValue());
+        TEST_CHECK(channel.start(chain).hasValue());
+        serveInterrupt(bus, channel, 7);
+        TEST_CHECK(log.events.size() == 1 && log.events[0] == MdmaEvent::transferError && !channel.isBusy());
+
+        // Second node outside the memory the channel reads: load error
+        MdmaChain<2> cut{ chainBase + 0x100 };
+        bus.model.map(chainBase + 0x100, const_cast<MdmaDescriptor*>(cut.data()), sizeof(MdmaDescriptor));
+        TEST_CHECK(cut.copy(TestBus::sram1, TestBus::axiSram, 16).hasValue() && cut.copy(TestBus::sram1 + 16, TestBus::axiSram, 16).hasValue());
+        TEST_CHECK(channel.start(cut).hasValue());
+        serveInterrupt(bus, channel, 7);
+        TEST_CHECK(log.events.size() == 2 && log.events[1] == MdmaEvent::transferError && log.arguments.back() == MdmaModel::linkErrorBit);
+        TEST_CHECK((channel.flags() & Mdma::transferErrorFlag) == 0);
+    }
+};
+
+void runMdmaTests()
+{
+    testValidation();
+    testScatterGather();
+    testLargeCopy();
+    testCopy2d();
+    testWriteRegister();
+    testTriggered();
+    testErrors();
+}
@@ -0,0 +1,131 @@
+#ifndef __MODELSUPPORT_H__
+#define __MODELSUPPORT_H__
+
+/**
+ * @file ModelSupport.hh
+ * @brief Pieces shared by the peripheral models and their tests: model registers, the bus map and the event log.
+ *
+ * The models hand their drivers HostRegister handles with registerHandles, so the driver
+ * code runs unchanged. The DMA models see memory through a BusMap: the tests place host
+ * buffers at the TestBus addresses, which fall in the regions the drivers check (TCM,
+ * SRAM4), and anything not mapped is a bus error. An EventLog records what a driver
+ * reported to its callback.
+ */
+
+//<------------------------------INCLUDES------------------------------>//
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+#include <Register.hh>
+//<-------------------------------------------------------------------->//
+
+/**
+ * @brief Bus addresses the tests place their buffers at.
+ */
+namespace TestBus
+{
+    inline constexpr std::uint32_t dtcm{ 0x20000000 };
+    inline constexpr std::uint32_t axiSram{ 0x24000000 };
+    inline constexpr std::uint32_t sram1{ 0x30000000 };
+    inline constexpr std::uint32_t sram4{ 0x38000000 };
+};
+
+/**
+ * @brief One register of a model, with the side effects of the hardware.
+ * @tparam Keys What the model needs to find the register, e.g. the channel and the kind.
+ *
+ * get() and set() are Model::read(keys...) and Model::write(keys..., value), the bit
+ * operations are read-modify-write sequences through them. The models declare the
+ * template a friend and keep read() and write() private.
+ */
+template<Utils::UnsignedIntegralPointerConcept Pointer, typename Model, typename... Keys>
+class BasicHostRegister : public IRegister<Pointer>
+{
+    private:
+        using ValueType = typename IRegister<Pointer>::ValueType;
+
+        Model& model;
+        std::tuple<Keys...> keys;
+
+    public:
+        explicit BasicHostRegister(Model& model, const Keys... keys) : model(model), keys(keys...) {}
+
+        ValueType const get() const override
+        {
+            return std::apply([this](const Keys... values) -> ValueType { return model.read(values...); }, keys);
+        }
+        void set(ValueType value) override { std::apply([this, value](const Keys... values) { model.write(values..., value); }, keys); }
+        void clear() override { set(0); }
+        bool checkBit(const std::size_t position) const override { return (get() >> position) & 1U; }
+        bool checkBits(ValueType bitsMask, const std::size_t position = 0) const override
+        {
+            return (get() & (bitsMask << position)) == (bitsMask << position);
+        }
+        void setBit(const std::size_t position) override { set(get() | (1U << position)); }
+        void clearBit(const std::size_t position) override { set(get() & ~(1U << position)); }
+        void setBits(ValueType bitsMask, const std::size_t position = 0) override { set(get() | (bitsMask << position)); }
+        std::size_t const getLowestIndex() const override { return static_cast<std::size_t>(__builtin_ctz(get() | 0x80000000U)); }
+        std::size_t const getHighestIndex() const override { return 31U - static_cast<std::size_t>(__builtin_clz(get() | 1U)); }
+        Pointer const getAddress() const override { return nullptr; }
+};
+
+template<typename Model, typename... Keys>
+using HostRegister = BasicHostRegister<volatile std::uint32_t*, Model, Keys...>;
+
+/**
+ * @brief 32-bit bus addresses mapped to host buffers.
+ */
+class BusMap
+{
+    public:
+        /// Make size bytes at host visible at address.
+        void map(const std::uint32_t address, void* host, const std::size_t size) { regions.push_back(Region{ address, static_cast<std::uint8_t*>(host), size }); }
+
+        /**
+         * @brief Host bytes behind [address, address + bytes).
+         * @return std::uint8_t* nullptr unless one mapped buffer holds them all.
+         */
+        std::uint8_t* translate(const std::uint32_t address, const std::uint32_t bytes) const
+        {
+            for (const Region& region : regions) {
+                if (address >= region.address && address + bytes <= region.address + region.size) { return region.host + (address - region.address); }
+            }
+            return nullptr;
+        }
+
+    private:
+        struct Region {
+            std::uint32_t address;
+            std::uint8_t* host;
+            std::size_t size;
+        };
+
+        std::vector<Region> regions;
+};
+
+/**
+ * @brief Events a driver reported, in order: pass &EventLog::record as the callback and the log as its context.
+ * @tparam Argument What the callback passes with each event, e.g. the buffer; void for nothing.
+ */
+template<typename Event, typename Argument = void>
+struct EventLog {
+    std::vector<Event> events;
+    std::vector<Argument> arguments;
+
+    static void record(void* context, const Event event, const Argument argument)
+    {
+        EventLog& log{ *static_cast<EventLog*>(context) };
+        log.events.push_back(event);
+        log.arguments.push_back(argument);
+    }
+};
+
+template<typename Event>
+struct EventLog<Event, void> {
+    std::vector<Event> events;
+
+    static void record(void* context, const Event event) { static_cast<EventLog*>(context)->events.push_back(event); }
+};
+
+#endif // __MODELSUPPORT_H__
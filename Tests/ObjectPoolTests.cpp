@@ -0,0 +1,118 @@
+#include "UnitTest.hh"
+#include <Utils.hh>
+#include <ObjectPool.hh>
+#include <StaticVector.hh>
+#include <AllocationPolicy.hh>
+#include <Register.hh>
+#include <IPeripheralRegisters.hh>
+#include <cstdint>
+
+namespace
+{
+    struct Tracked {
+        static inline int alive{ 0 };
+        int value;
+        explicit Tracked(const int value) : value{ value } { ++alive; }
+        ~Tracked() { --alive; }
+    };
+
+    void testObjectPool()
+    {
+        Memory::ObjectPool<Tracked, 3> pool;
+        TEST_CHECK(pool.capacity() == 3 && pool.available() == 3);
+
+        Tracked* a{ pool.create(1) };
+        Tracked* b{ pool.create(2) };
+        Tracked* c{ pool.create(3) };
+        TEST_CHECK(a != nullptr && b != nullptr && c != nullptr);
+        TEST_CHECK(a->value == 1 && b->value == 2 && c->value == 3);
+        TEST_CHECK(Tracked::alive == 3);
+        TEST_CHECK(pool.create(4) == nullptr);
+        TEST_CHECK(pool.owns(b));
+
+        pool.destroy(b);
+        TEST_CHECK(Tracked::alive == 2 && pool.size() == 2);
+        // The released slot is reused first
+        Tracked* d{ pool.create(5) };
+        TEST_CHECK(d == b && d->value == 5);
+
+        // Foreign pointers and double releases are ignored
+        Tracked outside{ 6 };
+        pool.deallocate(&outside);
+        pool.destroy(a);
+        pool.deallocate(a);
+        TEST_CHECK(pool.size() == 2);
+        pool.destroy(c);
+        pool.destroy(d);
+        TEST_CHECK(pool.size() == 0 && Tracked::alive == 1);
+    }
+
+    void testStaticVector()
+    {
+        Memory::StaticVector<int, 2> vector;
+        TEST_CHECK(vector.empty());
+        TEST_CHECK(vector.push_back(1) && vector.push_back(2));
+        TEST_CHECK(!vector.push_back(3));
+        int sum{ 0 };
+        for (const int value : vector) { sum += value; }
+        TEST_CHECK(sum == 3 && vector.size() == 2 && vector.full());
+    }
+
+    volatile std::uint16_t poolRegisters[4]{};
+    volatile std::uint16_t heapRegisters[2]{};
+
+    void testRegisterPolicies()
+    {
+        using Policy = Memory::PoolAllocation<3>;
+        using Pointer = volatile std::uint16_t*;
+        IRegister<Pointer>* first{ getRegisterInstance<Pointer, Policy>(&poolRegisters[0]) };
+        IRegister<Pointer>* again{ getRegisterInstance<Pointer, Policy>(&poolRegisters[0]) };
+        TEST_CHECK(first != nullptr && first == again);
+        TEST_CHECK((Policy::pool<UniquePtrRegister<Pointer, Policy>>().size() == 1));
+        TEST_CHECK((Policy::pool<Register<Pointer>>().size() == 1));
+
+        first->setBit(3);
+        TEST_CHECK(poolRegisters[0] == 0x8);
+
+        // The pools are sized at compile time: the fourth register does not fit
+        TEST_CHECK((getRegisterInstance<Pointer, Policy>(&poolRegisters[1]) != nullptr));
+        TEST_CHECK((getRegisterInstance<Pointer, Policy>(&poolRegisters[2]) != nullptr));
+        TEST_CHECK((getRegisterInstance<Pointer, Policy>(&poolRegisters[3]) == nullptr));
+
+        // No Register left for the owner: no owner either, the handle is null rather than empty
+        using Starved = Memory::PoolAllocation<1>;
+        Register<Pointer>* taken{ Starved::create<Register<Pointer>>(&poolRegisters[3]) };
+        TEST_CHECK((getRegisterInstance<Pointer, Starved>(&poolRegisters[0]) == nullptr));
+        TEST_CHECK((Starved::pool<UniquePtrRegister<Pointer, Starved>>().size() == 0));
+        Starved::destroy(taken);
+        IRegister<Pointer>* fed{ getRegisterInstance<Pointer, Starved>(&poolRegisters[0]) };
+        TEST_CHECK(fed != nullptr && fed->get() == 0x8);
+
+        IRegister<Pointer>* heapRegister{ getRegisterInstance<Pointer, Memory::HeapAllocation>(&heapRegisters[0]) };
+        TEST_CHECK(heapRegister != nullptr && heapRegister != first);
+        heapRegister->set(0x1234);
+        TEST_CHECK(heapRegisters[0] == 0x1234);
+    }
+
+    enum class TestRegisters { control, status };
+    volatile std::uint32_t controlRegister{ 0 };
+    volatile std::uint32_t statusRegister{ 0 };
+
+    void testPeripheralRegisters()
+    {
+        using Pairs = Utils::TypeList<pair<TestRegisters::control, volatile std::uint32_t*>, pair<TestRegisters::status, volatile std::uint32_t*>>;
+        IPeripheralRegisters<Pairs> registers{ &controlRegister, &statusRegister };
+        registers.set<TestRegisters::control>(0xA5U);
+        registers.setBit<TestRegisters::status>(1);
+        TEST_CHECK(controlRegister == 0xA5U && statusRegister == 0x2U);
+        TEST_CHECK((Memory::DefaultAllocation::pool<UniquePtrRegister<volatile std::uint32_t*>>().size() >= 2));
+    }
+};
+
+void runObjectPoolTests()
+{
+    testObjectPool();
+    testStaticVector();
+    testRegisterPolicies();
+    testPeripheralRegisters();
+}
@@ -0,0 +1,186 @@
+#include "UnitTest.hh"
+#include <Offload.hh>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+
+namespace
+{
+    enum : std::uint16_t { heavyJob, lightJob, unboundJob, functionCount };
+
+    using Queue = Ipc::OffloadQueue<4096>;
+    using Client = Ipc::OffloadClient<Queue, functionCount>;
+    using Worker = Ipc::OffloadWorker<Queue, functionCount>;
+    Queue queue;
+
+    std::uint32_t sumWords(const std::byte* args, const std::size_t size)
+    {
+        std::uint32_t sum{ 0 };
+        for (std::size_t offset = 0; offset + sizeof(std::uint32_t) <= size; offset += sizeof(std::uint32_t)) {
+            std::uint32_t word;
+            std::memcpy(&word, args + offset, sizeof(word));
+            sum += word;
+        }
+        return sum;
+    }
+
+    void testEwma()
+    {
+        Ipc::Ewma average;
+        TEST_CHECK(!average.isValid());
+        average.add(800);
+        average.add(0);
+        TEST_CHECK(average.isValid() && average.value == 700);
+        average.add(1500);
+        TEST_CHECK(average.value == 800);
+    }
+
+    void testPolicy()
+    {
+        Ipc::OffloadStats<functionCount> stats;
+
+        // Exploration: first run local, then one offload, then local until it completes
+        TEST_CHECK(!stats.shouldOffload(heavyJob));
+        stats.recordLocal(heavyJob, 10000);
+        TEST_CHECK(stats.shouldOffload(heavyJob));
+        const std::uint32_t first{ stats.recordSubmit(heavyJob) };
+        TEST_CHECK(first == 10000 && stats.depth() == 1 && stats.backlogCycles() == 10000);
+        TEST_CHECK(!stats.shouldOffload(heavyJob));
+        // 3000 CM4 cycles are 6000 CM7 cycles
+        stats.recordCompletion(heavyJob, 3000, 6500, first);
+        TEST_CHECK(stats.function(heavyJob).remote.value == 6000 && stats.depth() == 0 && stats.backlogCycles() == 0);
+        TEST_CHECK(stats.expectedRemoteLatency(heavyJob) == 6400 && stats.shouldOffload(heavyJob));
+
+        // A job cheaper than the trip through the rings stays local
+        stats.recordLocal(lightJob, 100);
+        TEST_CHECK(stats.shouldOffload(lightJob));
+        stats.recordCompletion(lightJob, 50, 600, stats.recordSubmit(lightJob));
+        TEST_CHECK(!stats.shouldOffload(lightJob));
+
+        // The backlog grows until waiting for the CM4 costs more than the slack allows
+        std::uint32_t queued{ 0 };
+        while (stats.shouldOffload(heavyJob)) {
+            static_cast<void>(stats.recordSubmit(heavyJob));
+            ++queued;
+        }
+        // 400 + 6000 * queued + 6000 <= 4 * 10000
+        TEST_CHECK(queued == 6 && stats.backlogCycles() == 36000 && stats.maxDepthSeen() == 6);
+        for (std::uint32_t index = 0; index < queued; ++index) { stats.recordCompletion(heavyJob, 3000, 8000, 6000); }
+        TEST_CHECK(stats.backlogCycles() == 0 && stats.shouldOffload(heavyJob));
+
+        // The depth limit applies whatever the estimates
+        Ipc::OffloadStats<functionCount> shallow{ Ipc::OffloadPolicy{ 1, 1000, 0, 1, 1 } };
+        shallow.recordLocal(heavyJob, 1000);
+        static_cast<void>(shallow.recordSubmit(heavyJob));
+        TEST_CHECK(!shallow.shouldOffload(heavyJob));
+
+        // Utilization over a window of 100000 cycles
+        stats.resetWindow(50000);
+        stats.recordLocal(lightJob, 20000);
+        stats.recordCompletion(heavyJob, 15000, 20000, stats.recordSubmit(heavyJob));
+        TEST_CHECK(stats.localUtilization(150000) == 20 && stats.remoteUtilization(150000) == 30);
+    }
+
+    struct Collected {
+        std::uint32_t completions{ 0 };
+        std::uint32_t offloaded{ 0 };
+        std::uint32_t failed{ 0 };
+        std::uint64_t sum{ 0 };
+    };
+
+    void collect(void* context, const Ipc::OffloadResult& result)
+    {
+        Collected& collected{ *static_cast<Collected*>(context) };
+        ++collected.completions;
+        collected.offloaded += result.offloaded ? 1 : 0;
+        collected.failed += result.ok ? 0 : 1;
+        if (result.ok) { collected.sum += result.result; }
+    }
+
+    void testQueue()
+    {
+        queue.reset();
+        Collected collected;
+        Client client{ queue, &collect, &collected };
+        Worker worker{ queue };
+        worker.bind(heavyJob, &sumWords);
+
+        const std::uint32_t args[4]{ 1, 2, 3, 4 };
+        const auto id{ client.submit(heavyJob, args, sizeof(args)) };
+        TEST_CHECK(id.hasValue() && client.statistics().depth() == 1);
+        TEST_CHECK(client.submit(functionCount, args, sizeof(args)).error() == Ipc::OffloadError::unknownFunction);
+        TEST_CHECK(client.submit(heavyJob, args, Queue::maxArgsSize + 1).error() == Ipc::OffloadError::argsTooLarge);
+        TEST_CHECK(client.submit(unboundJob, args, 0).hasValue());
+
+        TEST_CHECK(worker.poll() == 2 && worker.executedCount() == 2);
+        TEST_CHECK(client.poll() == 2 && client.statistics().depth() == 0);
+        TEST_CHECK(collected.completions == 2 && collected.offloaded == 2 && collected.failed == 1 && collected.sum == 10);
+        TEST_CHECK(client.statistics().function(heavyJob).remote.isValid());
+        // The failed job took no sample
+        TEST_CHECK(!client.statistics().function(unboundJob).remote.isValid() && !client.statistics().function(unboundJob).latency.isValid());
+
+        // A completion naming no function is dropped, its job leaves the queue
+        TEST_CHECK(client.submit(heavyJob, args, sizeof(args)).hasValue());
+        const Ipc::OffloadCompletion forged{ 99, 0, 0, 0, 0, functionCount, 0, 0 };
+        queue.jobs.pop();
+        TEST_CHECK(queue.completions.push(&forged, sizeof(forged)));
+        TEST_CHECK(client.poll() == 1 && collected.completions == 2 && client.statistics().droppedCount() == 1 && client.statistics().depth() == 0);
+
+        // A local run completes before returning
+        const auto local{ client.run(lightJob, args, sizeof(args), &sumWords) };
+        TEST_CHECK(local.hasValue() && collected.completions == 3 && collected.offloaded == 2 && collected.sum == 20);
+        TEST_CHECK(client.statistics().function(lightJob).localRuns == 1);
+
+        // Past maxDepth the queue refuses jobs
+        Client shallow{ queue, &collect, &collected, Ipc::OffloadPolicy{ 2, 400, 400, 1, 1 } };
+        TEST_CHECK(shallow.submit(heavyJob, args, sizeof(args)).hasValue());
+        TEST_CHECK(shallow.submit(heavyJob, args, sizeof(args)).hasValue());
+        TEST_CHECK(shallow.submit(heavyJob, args, sizeof(args)).error() == Ipc::OffloadError::queueFull);
+        TEST_CHECK(shallow.statistics().refusedCount() == 1);
+        worker.poll();
+        TEST_CHECK(shallow.poll() == 2);
+    }
+
+    void testTwoThreads()
+    {
+        queue.reset();
+        constexpr std::uint32_t jobs{ 5000 };
+        std::atomic<bool> stop{ false };
+        Worker worker{ queue };
+        worker.bind(heavyJob, &sumWords);
+        std::thread workerThread([&] {
+            while (!stop.load(std::memory_order_acquire)) {
+                if (worker.poll() == 0) { std::this_thread::yield(); }
+            }
+        });
+
+        // Wherever the jobs run, each one completes exactly once with its result
+        Collected collected;
+        Client client{ queue, &collect, &collected };
+        std::uint32_t args[64];
+        std::uint64_t expected{ 0 };
+        for (std::uint32_t index = 0; index < jobs; ++index) {
+            for (std::uint32_t word = 0; word < 64; ++word) { args[word] = index + word; }
+            expected += 64 * index + 63 * 64 / 2;
+            TEST_CHECK(client.run(heavyJob, args, sizeof(args), &sumWords).hasValue());
+            client.poll();
+        }
+        client.drain();
+        stop.store(true, std::memory_order_release);
+        workerThread.join();
+
+        const auto& stats{ client.statistics().function(heavyJob) };
+        TEST_CHECK(collected.completions == jobs && collected.failed == 0 && collected.sum == expected);
+        TEST_CHECK(stats.localRuns + stats.offloaded == jobs && collected.offloaded == stats.offloaded);
+        TEST_CHECK(stats.offloaded >= 1 && worker.executedCount() == stats.offloaded);
+    }
+};
+
+void runOffloadTests()
+{
+    testEwma();
+    testPolicy();
+    testQueue();
+    testTwoThreads();
+}
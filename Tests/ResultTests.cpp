@@ -0,0 +1,83 @@
+#include "UnitTest.hh"
+#include <Result.hh>
+#include <DriverError.hh>
+#include <AllocationPolicy.hh>
+#include <IPeripheralRegisters.hh>
+#include <InputPin.hh>
+#include <cstdint>
+
+namespace
+{
+    constexpr DriverResult<std::uint32_t> divide(const std::uint32_t value, const std::uint32_t divisor)
+    {
+        if (divisor == 0) { return Utils::fail(DriverError::invalidParameter); }
+        return value / divisor;
+    }
+
+    DriverStatus divideTwice(const std::uint32_t value, const std::uint32_t first, const std::uint32_t second, std::uint32_t& out)
+    {
+        const auto half{ divide(value, first) };
+        RESULT_TRY(half);
+        const auto quarter{ divide(half.value(), second) };
+        RESULT_TRY(quarter);
+        out = quarter.value();
+        return {};
+    }
+
+    void testResult()
+    {
+        const auto ok{ divide(12, 4) };
+        TEST_CHECK(ok.hasValue() && ok.value() == 3);
+        const auto failed{ divide(12, 0) };
+        TEST_CHECK(!failed && failed.error() == DriverError::invalidParameter);
+        TEST_CHECK(failed.valueOr(7) == 7 && ok.valueOr(7) == 3);
+
+        const auto chained{ ok.andThen([](const std::uint32_t value) { return divide(value, 3); }) };
+        TEST_CHECK(chained && chained.value() == 1);
+        const auto stopped{ failed.andThen([](const std::uint32_t value) { return divide(value, 3); }) };
+        TEST_CHECK(!stopped && stopped.error() == DriverError::invalidParameter);
+
+        std::uint32_t out{ 0 };
+        TEST_CHECK(divideTwice(100, 5, 2, out) && out == 10);
+        const DriverStatus status{ divideTwice(100, 5, 0, out) };
+        TEST_CHECK(!status && status.error() == DriverError::invalidParameter && out == 10);
+
+        static_assert(divide(9, 3).value() == 3);
+        static_assert(sizeof(DriverStatus) <= 2);
+    }
+
+    enum class FakeRegisters { first, second };
+    volatile std::uint32_t firstRegister{ 0 };
+    volatile std::uint32_t secondRegister{ 0 };
+
+    void testRegisterExhaustion()
+    {
+        // Pools of one handle: the second register of the peripheral cannot be allocated
+        using Pairs = Utils::TypeList<pair<FakeRegisters::first, volatile std::uint32_t*>, pair<FakeRegisters::second, volatile std::uint32_t*>>;
+        IPeripheralRegisters<Pairs, Memory::PoolAllocation<1>> registers{ &firstRegister, &secondRegister };
+        TEST_CHECK(!registers.isValid());
+    }
+
+    volatile std::uint32_t modeRegister{ 0 };
+    volatile std::uint32_t inputRegister{ 0 };
+
+    void testPinStatus()
+    {
+        InputPin<3> pin{ &modeRegister, &inputRegister };
+        TEST_CHECK(pin.init().hasValue());
+        TEST_CHECK(pin.reset().hasValue());
+
+        InputPinHandler handler{ &modeRegister, &inputRegister };
+        TEST_CHECK(handler.status().hasValue());
+        handler.setParam<IPinHandlerProperties::pinNumber>(pinsPerPort);
+        const DriverStatus status{ handler.setMode() };
+        TEST_CHECK(!status && status.error() == DriverError::invalidParameter);
+    }
+};
+
+void runResultTests()
+{
+    testResult();
+    testRegisterExhaustion();
+    testPinStatus();
+}
@@ -0,0 +1,215 @@
+#include "UnitTest.hh"
+#include <Rpc.hh>
+#include <cstdint>
+#include <thread>
+
+namespace
+{
+    enum class Math : std::uint8_t { add, scale, unbound };
+
+    struct AddRequest { std::int32_t a; std::int32_t b; };
+    struct AddResponse { std::int32_t sum; };
+    struct ScaleRequest { float factor; float values[64]; };
+    struct ScaleResponse { float values[64]; };
+    struct Empty {};
+
+    using Requests = Utils::TypeList<pair<Math::add, AddRequest>, pair<Math::scale, ScaleRequest>, pair<Math::unbound, Empty>>;
+    using Responses = Utils::TypeList<pair<Math::add, AddResponse>, pair<Math::scale, ScaleResponse>, pair<Math::unbound, Empty>>;
+    using Schema = Ipc::RpcSchema<Requests, Responses>;
+    using Channel = Ipc::RpcChannel<Schema, 4>;
+
+    static_assert(std::is_same_v<Schema::Request<Math::scale>, ScaleRequest>);
+    static_assert(std::is_same_v<Schema::Response<Math::add>, AddResponse>);
+    static_assert(Schema::requestSize == sizeof(ScaleRequest) && Schema::responseSize == sizeof(ScaleResponse));
+
+    void add(const AddRequest& request, AddResponse& response) { response.sum = request.a + request.b; }
+
+    void scale(const ScaleRequest& request, ScaleResponse& response)
+    {
+        for (std::size_t index = 0; index < 64; ++index) { response.values[index] = request.values[index] * request.factor; }
+    }
+
+    Channel channel;
+
+    void testSynchronousCall()
+    {
+        channel.reset();
+        Ipc::RpcClient<Channel> client{ channel };
+        Ipc::RpcServer<Channel> server{ channel };
+        server.bind<Math::add, &add>();
+        server.bind<Math::scale, &scale>();
+
+        // Zero-copy: the request is built in the shared slot
+        const auto call{ client.prepare<Math::scale>() };
+        TEST_CHECK(call.hasValue());
+        ScaleRequest& request{ client.request(call.value()) };
+        request.factor = 2.0F;
+        for (std::size_t index = 0; index < 64; ++index) { request.values[index] = static_cast<float>(index); }
+        TEST_CHECK(client.send(call.value()).hasValue());
+        TEST_CHECK(client.response(call.value()).error() == Ipc::RpcError::notReady);
+
+        TEST_CHECK(server.poll() == 1 && client.poll() == 1);
+        const auto response{ client.response(call.value()) };
+        TEST_CHECK(response.hasValue() && response.value()->values[63] == 126.0F);
+        // Payload handed over in place: the response lives in the channel
+        TEST_CHECK(reinterpret_cast<const std::byte*>(response.value()) == channel.slots[call.value().slot].response);
+        client.release(call.value());
+        TEST_CHECK(client.freeSlotCount() == 4);
+
+        // By-value convenience call
+        const auto sum{ client.call<Math::add>(AddRequest{ 40, 2 }) };
+        server.poll();
+        TEST_CHECK(client.wait(sum.value(), 0).value()->sum == 42);
+        client.release(sum.value());
+    }
+
+    void testSlotsAndErrors()
+    {
+        channel.reset();
+        Ipc::RpcClient<Channel> client{ channel };
+        Ipc::RpcServer<Channel> server{ channel };
+        server.bind<Math::add, &add>();
+
+        Ipc::RpcClient<Channel>::Call<Math::add> calls[4];
+        for (std::int32_t index = 0; index < 4; ++index) {
+            calls[index] = client.call<Math::add>(AddRequest{ index, 100 }).value();
+        }
+        TEST_CHECK(client.prepare<Math::add>().error() == Ipc::RpcError::noSlot);
+        TEST_CHECK(client.wait(calls[0], 2).error() == Ipc::RpcError::timeout);
+
+        // Responses are matched by slot and correlation ID, whatever the order of release
+        server.poll();
+        client.poll();
+        client.release(calls[2]);
+        TEST_CHECK(client.response(calls[3]).value()->sum == 103);
+        TEST_CHECK(client.response(calls[1]).value()->sum == 101);
+        const auto reused{ client.call<Math::add>(AddRequest{ 1, 1 }).value() };
+        TEST_CHECK(reused.slot == calls[2].slot && reused.correlation != calls[2].correlation);
+        // A handle of the previous call of the slot no longer matches
+        TEST_CHECK(!client.isDone(calls[2]));
+        server.poll();
+        client.poll();
+        TEST_CHECK(client.response(reused).value()->sum == 2);
+        for (const auto& call : { calls[0], calls[1], calls[3], reused }) { client.release(call); }
+        TEST_CHECK(client.freeSlotCount() == Channel::slotCount);
+
+        const auto unbound{ client.call<Math::unbound>(Empty{}).value() };
+        server.poll();
+        client.poll();
+        TEST_CHECK(client.response(unbound).error() == Ipc::RpcError::unknownMethod);
+        TEST_CHECK(client.staleCount() == 0);
+        client.release(unbound);
+        TEST_CHECK(client.wait(unbound, 0).error() == Ipc::RpcError::notWaitable);
+
+        // A corrupted request envelope cannot make the server index past the slots
+        using Envelope = Channel::Envelope;
+        const Envelope corrupted{ 7, static_cast<std::uint16_t>(Channel::slotCount), 0, 0 };
+        TEST_CHECK(channel.requests.push(&corrupted, sizeof(corrupted)));
+        const auto valid{ client.call<Math::add>(AddRequest{ 2, 3 }).value() };
+        const std::uint32_t served{ server.servedCount() };
+        TEST_CHECK(server.poll() == 1 && server.rejectedCount() == 1 && server.servedCount() == served + 1);
+        TEST_CHECK(client.wait(valid, 0).value()->sum == 5 && client.staleCount() == 0);
+        client.release(valid);
+    }
+
+    void ignore(void*, const Ipc::RpcClient<Channel>::Outcome<Math::add>) {}
+
+    void testWaitWithCallback()
+    {
+        channel.reset();
+        Ipc::RpcClient<Channel> client{ channel };
+        Ipc::RpcServer<Channel> server{ channel };
+        server.bind<Math::add, &add>();
+
+        // The callback owns the completion: poll() frees the slot, wait() could never see it done
+        const auto call{ client.call<Math::add>(AddRequest{ 1, 2 }, &ignore, nullptr).value() };
+        TEST_CHECK(client.wait(call, 0).error() == Ipc::RpcError::notWaitable);
+        server.poll();
+        TEST_CHECK(client.poll() == 1 && client.freeSlotCount() == Channel::slotCount);
+        TEST_CHECK(client.wait(call, 0).error() == Ipc::RpcError::notWaitable);
+    }
+
+    struct Totals {
+        std::int32_t sum{ 0 };
+        std::uint32_t completions{ 0 };
+    };
+
+    void accumulate(void* context, const Ipc::RpcClient<Channel>::Outcome<Math::add> outcome)
+    {
+        Totals& totals{ *static_cast<Totals*>(context) };
+        if (outcome) { totals.sum += outcome.value()->sum; }
+        ++totals.completions;
+    }
+
+    void testReleaseInFlight()
+    {
+        channel.reset();
+        Ipc::RpcClient<Channel> client{ channel };
+        Ipc::RpcServer<Channel> server{ channel };
+        server.bind<Math::add, &add>();
+
+        // Released after a timeout: the server has yet to read the request, the slot stays taken
+        const auto late{ client.call<Math::add>(AddRequest{ 1, 1 }).value() };
+        TEST_CHECK(client.wait(late, 0).error() == Ipc::RpcError::timeout);
+        client.release(late);
+        TEST_CHECK(client.freeSlotCount() == Channel::slotCount - 1 && client.wait(late, 0).error() == Ipc::RpcError::notWaitable);
+        const auto next{ client.call<Math::add>(AddRequest{ 20, 22 }).value() };
+        TEST_CHECK(next.slot != late.slot);
+
+        // Its response frees the slot and is dropped
+        TEST_CHECK(server.poll() == 2 && client.poll() == 1 && client.staleCount() == 1);
+        TEST_CHECK(client.response(next).value()->sum == 42 && client.freeSlotCount() == Channel::slotCount - 1);
+        client.release(next);
+        const auto reused{ client.call<Math::add>(AddRequest{ 3, 4 }).value() };
+        TEST_CHECK(reused.slot == late.slot);
+        server.poll();
+        TEST_CHECK(client.wait(reused, 0).value()->sum == 7);
+        client.release(reused);
+
+        // A call with a callback still completes through it
+        Totals totals;
+        const auto async{ client.call<Math::add>(AddRequest{ 5, 5 }, &accumulate, &totals).value() };
+        client.release(async);
+        server.poll();
+        TEST_CHECK(client.poll() == 1 && totals.completions == 1 && totals.sum == 10 && client.freeSlotCount() == Channel::slotCount);
+    }
+
+    void testAsyncTwoThreads()
+    {
+        channel.reset();
+        constexpr std::uint32_t calls{ 20000 };
+        Ipc::RpcServer<Channel> server{ channel };
+        server.bind<Math::add, &add>();
+        std::thread serverThread([&] {
+            while (server.servedCount() < calls) {
+                channel.requests.waitForData();
+                server.poll();
+            }
+        });
+
+        // Completions delivered by callback, the slots are recycled automatically
+        Ipc::RpcClient<Channel> client{ channel };
+        Totals totals;
+        std::int64_t expected{ 0 };
+        for (std::uint32_t index = 0; index < calls; ++index) {
+            const AddRequest request{ static_cast<std::int32_t>(index % 1000), 1 };
+            while (!client.call<Math::add>(request, &accumulate, &totals)) { client.poll(); }
+            expected += request.a + request.b;
+        }
+        while (totals.completions < calls) {
+            channel.responses.waitForData();
+            client.poll();
+        }
+        serverThread.join();
+        TEST_CHECK(totals.sum == expected && client.freeSlotCount() == Channel::slotCount);
+    }
+};
+
+void runRpcTests()
+{
+    testSynchronousCall();
+    testSlotsAndErrors();
+    testWaitWithCallback();
+    testReleaseInFlight();
+    testAsyncTwoThreads();
+}
@@ -0,0 +1,146 @@
+#include "UnitTest.hh"
+#include <SharedBufferPool.hh>
+#include <SpscRing.hh>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+
+namespace
+{
+    using Pool = Ipc::SharedBufferPool<100, 8, Ipc::HsemSpinLock<6>>;
+    Pool pool;
+
+    static_assert(Pool::blockSize == 128, "Blocks are whole cache lines");
+
+    void testReferences()
+    {
+        pool.reset();
+        const Ipc::BufferHandle first{ pool.allocate().value() };
+        TEST_CHECK(pool.useCount(first) == 1);
+        TEST_CHECK(reinterpret_cast<std::uintptr_t>(pool.data(first)) % Cache::lineSize == 0);
+
+        // Shared: the block survives until the last reference goes
+        TEST_CHECK(pool.retain(first).hasValue() && pool.useCount(first) == 2);
+        TEST_CHECK(!pool.release(first).value() && pool.useCount(first) == 1);
+        TEST_CHECK(pool.release(first).value() && pool.useCount(first) == 0);
+
+        // A freed block has no reference left to drop or share
+        TEST_CHECK(pool.release(first).error() == Ipc::BufferPoolError::invalidHandle);
+        TEST_CHECK(pool.retain(first).error() == Ipc::BufferPoolError::invalidHandle);
+        TEST_CHECK(pool.release(Ipc::BufferHandle{ 8 }).error() == Ipc::BufferPoolError::invalidHandle);
+
+        Ipc::BufferHandle handles[8];
+        for (Ipc::BufferHandle& handle : handles) { handle = pool.allocate().value(); }
+        TEST_CHECK(pool.allocate().error() == Ipc::BufferPoolError::exhausted);
+        TEST_CHECK(pool.handleOf(pool.data(handles[3]) + 127).value() == handles[3]);
+        TEST_CHECK(pool.handleOf(&pool).error() == Ipc::BufferPoolError::invalidHandle);
+        // The block freed last is handed out first
+        static_cast<void>(pool.release(handles[5]));
+        TEST_CHECK(pool.allocate().value() == handles[5]);
+        for (const Ipc::BufferHandle handle : handles) { static_cast<void>(pool.release(handle)); }
+
+        const Pool::Counters counters{ pool.counters() };
+        TEST_CHECK(counters.allocations == 10 && counters.frees == 10 && counters.inUse == 0 && counters.peakInUse == 8);
+        TEST_CHECK(counters.exhausted == 1 && counters.invalidReleases == 2);
+    }
+
+    // Both threads allocate, share and free blocks of a pool too small for them: a block
+    // handed to both at once would see its pattern overwritten
+    void testContention()
+    {
+        pool.reset();
+        constexpr std::uint32_t rounds{ 20000 };
+        std::atomic<std::uint32_t> corrupted{ 0 };
+        const auto worker = [&](const std::uint8_t pattern) {
+            for (std::uint32_t round = 0; round < rounds; ++round) {
+                const auto allocated{ pool.allocate() };
+                if (!allocated) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                const Ipc::BufferHandle handle{ allocated.value() };
+                std::memset(pool.data(handle), pattern, Pool::blockSize);
+                static_cast<void>(pool.retain(handle));
+                if (round % 64 == 0) { std::this_thread::yield(); }
+                for (std::size_t index = 0; index < Pool::blockSize; ++index) {
+                    if (pool.data(handle)[index] != pattern) {
+                        ++corrupted;
+                        break;
+                    }
+                }
+                static_cast<void>(pool.release(handle));
+                static_cast<void>(pool.release(handle));
+            }
+        };
+        std::thread other(worker, 0x55);
+        worker(0xAA);
+        other.join();
+
+        const Pool::Counters counters{ pool.counters() };
+        TEST_CHECK(corrupted == 0 && counters.invalidReleases == 0);
+        TEST_CHECK(counters.inUse == 0 && counters.allocations == counters.frees);
+        TEST_CHECK(counters.allocations + counters.exhausted == 2 * rounds);
+    }
+
+    // Handles cross a ring, some blocks kept by the producer until the consumer is done
+    void testTransfer()
+    {
+        pool.reset();
+        Ipc::SpscRing<256> ring;
+        ring.reset();
+        constexpr std::uint32_t frames{ 20000 };
+        std::uint32_t received{ 0 };
+        std::uint32_t mismatches{ 0 };
+        std::thread consumer([&] {
+            while (received < frames) {
+                Ipc::BufferHandle handle;
+                if (ring.pop(&handle, sizeof(handle)) != sizeof(handle)) {
+                    ring.waitForData();
+                    continue;
+                }
+                pool.receive(handle);
+                std::uint32_t sequence;
+                std::memcpy(&sequence, pool.data(handle), sizeof(sequence));
+                mismatches += sequence == received ? 0 : 1;
+                static_cast<void>(pool.release(handle));
+                ++received;
+            }
+        });
+
+        Ipc::BufferHandle kept[4];
+        std::size_t keptCount{ 0 };
+        for (std::uint32_t sequence = 0; sequence < frames; ++sequence) {
+            auto allocated{ pool.allocate() };
+            while (!allocated) {
+                std::this_thread::yield();
+                allocated = pool.allocate();
+            }
+            const Ipc::BufferHandle handle{ allocated.value() };
+            std::memcpy(pool.data(handle), &sequence, sizeof(sequence));
+            pool.publish(handle, sizeof(sequence));
+            if (sequence % 3 == 0 && keptCount < 4) {
+                static_cast<void>(pool.retain(handle));
+                kept[keptCount++] = handle;
+            }
+            while (!ring.push(&handle, sizeof(handle))) { std::this_thread::yield(); }
+            if (keptCount == 4) {
+                for (const Ipc::BufferHandle handle : kept) { static_cast<void>(pool.release(handle)); }
+                keptCount = 0;
+            }
+        }
+        consumer.join();
+        for (std::size_t index = 0; index < keptCount; ++index) { static_cast<void>(pool.release(kept[index])); }
+
+        const Pool::Counters counters{ pool.counters() };
+        TEST_CHECK(received == frames && mismatches == 0);
+        TEST_CHECK(counters.allocations == frames && counters.frees == frames && counters.inUse == 0);
+    }
+};
+
+void runSharedBufferPoolTests()
+{
+    testReferences();
+    testContention();
+    testTransfer();
+}
@@ -0,0 +1,194 @@
+#include "UnitTest.hh"
+#include <SpscRing.hh>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <utility>
+
+namespace
+{
+    using SmallRing = Ipc::SpscRing<256>;
+    SmallRing smallRing;
+
+    void testSingleThread()
+    {
+        smallRing.reset();
+        TEST_CHECK(smallRing.empty() && !smallRing.front().isValid());
+        TEST_CHECK(SmallRing::maxMessageSize() == 124);
+
+        const char text[]{ "hello" };
+        TEST_CHECK(smallRing.push(text, sizeof(text)));
+        TEST_CHECK(smallRing.usedBytes() == 4 + 8);
+        const SmallRing::Message message{ smallRing.front() };
+        TEST_CHECK(message.isValid() && message.size == sizeof(text));
+        TEST_CHECK(std::memcmp(message.data, text, sizeof(text)) == 0);
+        smallRing.pop();
+        TEST_CHECK(smallRing.empty() && smallRing.poppedCount() == 1);
+
+        // Too large messages are refused, whatever the free space
+        std::uint8_t buffer[200]{};
+        TEST_CHECK(!smallRing.push(buffer, SmallRing::maxMessageSize() + 1));
+    }
+
+    void testWrapAndFull()
+    {
+        smallRing.reset();
+        std::uint8_t block[100];
+        std::uint8_t out[128];
+        // 104 B records: two fit, the third does not
+        for (std::uint8_t index = 0; index < 2; ++index) {
+            std::memset(block, index, sizeof(block));
+            TEST_CHECK(smallRing.push(block, sizeof(block)));
+        }
+        TEST_CHECK(!smallRing.push(block, sizeof(block)) && smallRing.fullCount() == 1);
+        TEST_CHECK(smallRing.pop(out, sizeof(out)) == 100 && out[0] == 0);
+
+        // Offset 208: the next record wraps to offset 0 and needs the 48 B gap plus 104 B
+        std::memset(block, 7, sizeof(block));
+        TEST_CHECK(smallRing.push(block, sizeof(block)));
+        TEST_CHECK(smallRing.usedBytes() == 104 + 48 + 104);
+        TEST_CHECK(smallRing.pop(out, sizeof(out)) == 100 && out[99] == 1);
+        TEST_CHECK(smallRing.pop(out, sizeof(out)) == 100 && out[0] == 7 && out[99] == 7);
+        TEST_CHECK(smallRing.empty() && smallRing.usedBytes() == 0);
+
+        // Zero-copy production, committing less than reserved
+        std::uint8_t* payload{ smallRing.prepare(64) };
+        TEST_CHECK(payload != nullptr);
+        payload[0] = 0x5A;
+        smallRing.commit(1);
+        const SmallRing::Message message{ smallRing.front() };
+        TEST_CHECK(message.size == 1 && message.data[0] == 0x5A);
+        smallRing.pop();
+
+        // A destination too small drops the message
+        TEST_CHECK(smallRing.push(block, sizeof(block)));
+        TEST_CHECK(smallRing.pop(out, 10) == 0 && smallRing.empty());
+    }
+
+    using LargeRing = Ipc::SpscRing<4096>;
+    LargeRing largeRing;
+
+    void testTwoThreads()
+    {
+        largeRing.reset();
+        constexpr std::uint32_t messages{ 50000 };
+        bool ordered{ true };
+
+        std::thread consumer([&] {
+            std::uint8_t buffer[LargeRing::maxMessageSize()];
+            for (std::uint32_t expected = 0; expected < messages; ++expected) {
+                largeRing.waitForData();
+                const std::size_t size{ largeRing.pop(buffer, sizeof(buffer)) };
+                std::uint32_t sequence{ 0 };
+                std::memcpy(&sequence, buffer, sizeof(sequence));
+                // Size and content are derived from the sequence number
+                if (sequence != expected || size != 4 + sequence % 1500 || (size > 4 && buffer[size - 1] != static_cast<std::uint8_t>(sequence))) {
+                    ordered = false;
+                }
+            }
+        });
+
+        std::uint8_t buffer[LargeRing::maxMessageSize()];
+        for (std::uint32_t sequence = 0; sequence < messages; ++sequence) {
+            const std::size_t size{ 4 + sequence % 1500 };
+            std::memset(buffer, static_cast<std::uint8_t>(sequence), size);
+            std::memcpy(buffer, &sequence, sizeof(sequence));
+            while (!largeRing.push(buffer, size)) { std::this_thread::yield(); }
+        }
+        consumer.join();
+        TEST_CHECK(ordered);
+        TEST_CHECK(largeRing.pushedCount() == messages && largeRing.poppedCount() == messages);
+        TEST_CHECK(largeRing.empty());
+    }
+    /**
+     * @brief Core model: PRIMASK, a pending flag, and a handler run at once when unmasked.
+     */
+    struct ModelInterrupts {
+        static inline bool masked{ false };
+        static inline bool pending{ false };
+        static inline std::uint32_t handled{ 0 };
+        static inline bool lostWakeup{ false };
+
+        /// The release interrupt of the producer.
+        static void raise()
+        {
+            if (masked) { pending = true; } else { ++handled; }
+        }
+
+        static std::uint32_t mask()
+        {
+            const bool previous{ masked };
+            masked = true;
+            return previous ? 1 : 0;
+        }
+
+        static void restore(const std::uint32_t primask)
+        {
+            masked = primask != 0;
+            if (!masked && pending) {
+                pending = false;
+                ++handled;
+            }
+        }
+
+        /// WFI with nothing pending: on the target the core would sleep with the message waiting.
+        static void waitForInterrupt() { lostWakeup = lostWakeup || !pending; }
+    };
+
+    /// Consumer side of HsemWakeup on the model, the producer posts right after the check.
+    template<bool Armed>
+    struct RacingWakeup {
+        static inline void (*post)() { nullptr };
+
+        static void signal() { ModelInterrupts::raise(); }
+
+        template<typename Condition>
+        static void wait(Condition&& ready)
+        {
+            auto racingReady = [&] {
+                const bool result{ ready() };
+                if (post != nullptr) { std::exchange(post, nullptr)(); }
+                return result;
+            };
+            if (Armed) {
+                Ipc::sleepUnless<ModelInterrupts>(racingReady);
+            } else if (!racingReady()) {
+                ModelInterrupts::waitForInterrupt();
+            }
+        }
+    };
+
+    template<bool Armed>
+    bool sleepsThroughPost()
+    {
+        using Ring = Ipc::SpscRing<256, RacingWakeup<Armed>>;
+        static Ring ring;
+        ring.reset();
+        ModelInterrupts::lostWakeup = false;
+        ModelInterrupts::handled = 0;
+        RacingWakeup<Armed>::post = [] {
+            const std::uint32_t value{ 42 };
+            ring.push(&value, sizeof(value));
+        };
+        ring.waitForData();
+        std::uint32_t value{ 0 };
+        return ring.pop(&value, sizeof(value)) != sizeof(value) || value != 42 || ModelInterrupts::handled != 1 || ModelInterrupts::lostWakeup;
+    }
+
+    void testWakeupRace()
+    {
+        // Checked with the interrupt masked: the release stays pending and ends the sleep
+        TEST_CHECK(!sleepsThroughPost<true>());
+        TEST_CHECK(!ModelInterrupts::masked && !ModelInterrupts::pending);
+        // Checked unmasked: the handler runs between the check and WFI, the wakeup is lost
+        TEST_CHECK(sleepsThroughPost<false>());
+    }
+};
+
+void runSpscRingTests()
+{
+    testSingleThread();
+    testWrapAndFull();
+    testTwoThreads();
+    testWakeupRace();
+}
@@ -0,0 +1,103 @@
+#include "UnitTest.hh"
+#include <StackMonitor.hh>
+#include <cstdint>
+
+using namespace StackMonitor;
+
+namespace
+{
+    alignas(8) std::uint32_t fakeStack[256];
+
+    Region fakeRegion()
+    {
+        return Region{ reinterpret_cast<std::uintptr_t>(fakeStack), reinterpret_cast<std::uintptr_t>(fakeStack + 256) };
+    }
+
+    // Simulate a stack growing down to depth bytes below the top
+    void touch(const std::size_t depth)
+    {
+        for (std::size_t index = 256 - depth / 4; index < 256; ++index) { fakeStack[index] = static_cast<std::uint32_t>(index); }
+    }
+
+    void testWatermark()
+    {
+        const Region region{ fakeRegion() };
+        paint(region, region.top);
+        TEST_CHECK(highWaterMark(region) == 0);
+        TEST_CHECK(!overflowed(region));
+
+        touch(100);
+        TEST_CHECK(highWaterMark(region) == 100);
+        // A word equal to the pattern inside the used part does not hide the deeper use
+        fakeStack[256 - 10] = paintPattern;
+        TEST_CHECK(highWaterMark(region) == 100);
+
+        touch(1024);
+        TEST_CHECK(highWaterMark(region) == 1024);
+        TEST_CHECK(overflowed(region));
+
+        TEST_CHECK(mainStack().size() == 0 && currentDepth() == 0);
+    }
+
+    void testIsrSampling()
+    {
+        const Region region{ fakeRegion() };
+        paint(region, region.top);
+        touch(400);                             // Thread code went 400 B deep earlier, is now at 256 B
+        const std::uintptr_t entry{ region.top - 256 };
+        {
+            IsrScope scope{ region, entry, 16 + 37 };
+            // The earlier thread mark was saved before the repaint
+            TEST_CHECK(erasedMark() == 400);
+            TEST_CHECK(highWaterMark(region) == 256);
+            touch(256 + 120);
+        }
+        const IsrStats& stats{ getIsrStats()[16 + 37] };
+        TEST_CHECK(stats.samples == 1);
+        TEST_CHECK(stats.maxEntryDepth == 256);
+        TEST_CHECK(stats.maxPeakDepth == 376);
+
+        // Out of range exception numbers are ignored
+        { IsrScope ignored{ region, entry, exceptionCount }; }
+        TEST_CHECK(getIsrStats()[16 + 37].samples == 1);
+    }
+
+    void testNestedSampling()
+    {
+        const Region region{ fakeRegion() };
+        paint(region, region.top);
+        const std::uintptr_t outerEntry{ region.top - 64 };
+        const std::uintptr_t innerEntry{ region.top - 200 };
+        {
+            IsrScope outer{ region, outerEntry, 16 + 40 };
+            touch(300);                         // The outer handler went deep, then came back up
+            {
+                IsrScope inner{ region, innerEntry, 16 + 41 };
+                // The nested scope does not repaint: the outer mark survives
+                TEST_CHECK(highWaterMark(region) == 300);
+                touch(240);
+                TEST_CHECK(nesting().depth == 2);
+            }
+            TEST_CHECK(nesting().depth == 1 && getIsrStats()[16 + 41].maxPeakDepth == 0);
+        }
+        TEST_CHECK(nesting().depth == 0);
+        TEST_CHECK(getIsrStats()[16 + 40].maxPeakDepth == 300);
+        TEST_CHECK(getIsrStats()[16 + 41].samples == 1 && getIsrStats()[16 + 41].maxEntryDepth == 200);
+        // The nested handler is given the peak of the outermost one, never less than its own
+        TEST_CHECK(getIsrStats()[16 + 41].maxPeakDepth == 300);
+
+        // The next outermost handler only repaints what was used, deeper words still hold the pattern
+        {
+            IsrScope again{ region, outerEntry, 16 + 40 };
+            TEST_CHECK(highWaterMark(region) == 64 && erasedMark() >= 300);
+        }
+        TEST_CHECK(getIsrStats()[16 + 40].samples == 2 && getIsrStats()[16 + 41].samples == 1);
+    }
+};
+
+void runStackMonitorTests()
+{
+    testWatermark();
+    testIsrSampling();
+    testNestedSampling();
+}
@@ -0,0 +1,205 @@
+#include "UnitTest.hh"
+#include <TlsfHeap.hh>
+#include <SystemHeap.hh>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using Memory::TlsfHeap;
+
+namespace
+{
+    alignas(64) std::uint8_t poolA[64 * 1024];
+    alignas(64) std::uint8_t poolB[16 * 1024];
+
+    bool isAligned(const void* pointer, const std::size_t align)
+    {
+        return reinterpret_cast<std::uintptr_t>(pointer) % align == 0;
+    }
+
+    void testAllocateRelease()
+    {
+        TlsfHeap heap;
+        TEST_CHECK(heap.allocate(16) == nullptr);
+        TEST_CHECK(heap.addRegion(poolA, sizeof(poolA)));
+        const std::size_t initialFree{ heap.getStatistics().freeBytes };
+
+        void* a{ heap.allocate(1) };
+        void* b{ heap.allocate(100) };
+        void* c{ heap.allocate(1000) };
+        TEST_CHECK(a != nullptr && b != nullptr && c != nullptr);
+        TEST_CHECK(isAligned(a, TlsfHeap::alignment) && isAligned(b, TlsfHeap::alignment) && isAligned(c, TlsfHeap::alignment));
+        TEST_CHECK(TlsfHeap::usableSize(b) >= 100 && TlsfHeap::usableSize(c) >= 1000);
+        TEST_CHECK(heap.owns(b) && !heap.owns(poolB));
+        std::memset(b, 0xAA, 100);
+        TEST_CHECK(heap.check());
+
+        // Release out of order: the middle block stays isolated until its neighbours are free
+        heap.deallocate(b);
+        TEST_CHECK(heap.getStatistics().freeBlocks == 2);
+        heap.deallocate(a);
+        heap.deallocate(c);
+        TEST_CHECK(heap.check());
+
+        const TlsfHeap::Statistics stats{ heap.getStatistics() };
+        TEST_CHECK(stats.freeBlocks == 1);
+        TEST_CHECK(stats.freeBytes == initialFree);
+        TEST_CHECK(stats.usedBytes == 0);
+        TEST_CHECK(stats.peakUsedBytes >= 1100);
+        TEST_CHECK(stats.allocations == 3);
+        TEST_CHECK(stats.fragmentationPercent() == 0);
+    }
+
+    void testExhaustionAndRegions()
+    {
+        TlsfHeap heap;
+        TEST_CHECK(heap.addRegion(poolB, sizeof(poolB)));
+        TEST_CHECK(heap.allocate(sizeof(poolB)) == nullptr);
+        TEST_CHECK(heap.getStatistics().failedAllocations == 1);
+
+        void* large{ heap.allocate(12 * 1024) };
+        TEST_CHECK(large != nullptr);
+        TEST_CHECK(heap.allocate(8 * 1024) == nullptr);
+
+        // A second region serves what the first one cannot
+        TEST_CHECK(heap.addRegion(poolA, sizeof(poolA)));
+        void* other{ heap.allocate(8 * 1024) };
+        TEST_CHECK(other != nullptr && other >= static_cast<void*>(poolA) && other < static_cast<void*>(poolA + sizeof(poolA)));
+        TEST_CHECK(heap.getStatistics().totalBytes > 78 * 1024);
+        TEST_CHECK(heap.check());
+        heap.deallocate(large);
+        heap.deallocate(other);
+        TEST_CHECK(heap.getStatistics().freeBlocks == 2);
+        TEST_CHECK(heap.check());
+
+        TEST_CHECK(!heap.addRegion(poolA, 8));
+    }
+
+    void testAligned()
+    {
+        TlsfHeap heap;
+        heap.addRegion(poolA + 8, sizeof(poolA) - 8);
+        std::vector<void*> blocks;
+        for (const std::size_t align : { 32U, 64U, 256U, 1024U, 4096U }) {
+            void* pointer{ heap.allocateAligned(100, align) };
+            TEST_CHECK(pointer != nullptr && isAligned(pointer, align));
+            blocks.push_back(pointer);
+            TEST_CHECK(heap.check());
+        }
+        TEST_CHECK(heap.allocateAligned(100, 48) == nullptr);
+        for (void* pointer : blocks) { heap.deallocate(pointer); }
+        TEST_CHECK(heap.getStatistics().freeBlocks == 1);
+        TEST_CHECK(heap.check());
+    }
+
+    void testReallocate()
+    {
+        TlsfHeap heap;
+        heap.addRegion(poolA, sizeof(poolA));
+        auto* bytes{ static_cast<std::uint8_t*>(heap.allocate(64)) };
+        for (std::size_t i = 0; i < 64; ++i) { bytes[i] = static_cast<std::uint8_t>(i); }
+
+        // The successor is free: grows in place
+        auto* grown{ static_cast<std::uint8_t*>(heap.reallocate(bytes, 512)) };
+        TEST_CHECK(grown == bytes);
+        TEST_CHECK(heap.check());
+
+        // Shrinking always stays in place
+        TEST_CHECK(heap.reallocate(grown, 32) == grown);
+        TEST_CHECK(heap.check());
+
+        // Blocked by a neighbour: moves and keeps the contents
+        void* blocker{ heap.allocate(64) };
+        auto* moved{ static_cast<std::uint8_t*>(heap.reallocate(grown, 1024)) };
+        TEST_CHECK(moved != nullptr && moved != grown);
+        bool intact{ true };
+        for (std::size_t i = 0; i < 32; ++i) { intact = intact && moved[i] == i; }
+        TEST_CHECK(intact);
+        TEST_CHECK(heap.check());
+
+        TEST_CHECK(heap.reallocate(moved, 0) == nullptr);
+        heap.deallocate(blocker);
+        TEST_CHECK(heap.getStatistics().usedBytes == 0);
+        TEST_CHECK(heap.check());
+    }
+
+    void testFragmentation()
+    {
+        TlsfHeap heap;
+        heap.addRegion(poolA, sizeof(poolA));
+        std::vector<void*> blocks;
+        for (int i = 0; i < 64; ++i) { blocks.push_back(heap.allocate(256)); }
+        for (std::size_t i = 0; i < blocks.size(); i += 2) { heap.deallocate(blocks[i]); }
+        const TlsfHeap::Statistics stats{ heap.getStatistics() };
+        TEST_CHECK(stats.freeBlocks == 33);
+        TEST_CHECK(stats.largestFreeBlock > 256);
+        TEST_CHECK(stats.fragmentationPercent() > 0 && stats.fragmentationPercent() < 100);
+        for (std::size_t i = 1; i < blocks.size(); i += 2) { heap.deallocate(blocks[i]); }
+        TEST_CHECK(heap.getStatistics().fragmentationPercent() == 0);
+    }
+
+    void testRandomTrace()
+    {
+        TlsfHeap heap;
+        heap.addRegion(poolA, sizeof(poolA));
+        heap.addRegion(poolB, sizeof(poolB));
+        std::mt19937 random{ 1234 };
+        std::vector<std::pair<std::uint8_t*, std::size_t>> live;
+        bool consistent{ true };
+        for (int step = 0; step < 20000; ++step) {
+            if (live.empty() || random() % 3 != 0) {
+                const std::size_t size{ 1 + random() % ((random() % 8 == 0) ? 4096 : 128) };
+                auto* pointer{ static_cast<std::uint8_t*>(heap.allocate(size)) };
+                if (pointer != nullptr) {
+                    std::memset(pointer, static_cast<int>(size & 0xFF), size);
+                    live.emplace_back(pointer, size);
+                }
+            } else {
+                const std::size_t index{ random() % live.size() };
+                auto [pointer, size] = live[index];
+                consistent = consistent && pointer[0] == static_cast<std::uint8_t>(size) && pointer[size - 1] == static_cast<std::uint8_t>(size);
+                heap.deallocate(pointer);
+                live[index] = live.back();
+                live.pop_back();
+            }
+            if (step % 1000 == 0) { consistent = consistent && heap.check(); }
+        }
+        TEST_CHECK(consistent);
+        for (auto [pointer, size] : live) { heap.deallocate(pointer); }
+        TEST_CHECK(heap.getStatistics().freeBlocks == 2);
+        TEST_CHECK(heap.check());
+    }
+
+    void testSystemHeapFallback()
+    {
+        using namespace Memory;
+        SystemHeap::addRegion(HeapRegion::fast, poolB, sizeof(poolB));
+        SystemHeap::addRegion(HeapRegion::bulk, poolA, sizeof(poolA));
+        void* small{ SystemHeap::allocate(128) };
+        void* large{ SystemHeap::allocate(32 * 1024) };
+        void* bulk{ SystemHeap::allocate(128, HeapRegion::bulk) };
+        TEST_CHECK(SystemHeap::fastHeap.owns(small));
+        TEST_CHECK(SystemHeap::bulkHeap.owns(large));
+        TEST_CHECK(SystemHeap::bulkHeap.owns(bulk));
+
+        // Growing beyond the fast heap moves the block to the bulk heap
+        void* moved{ SystemHeap::reallocate(small, 20 * 1024) };
+        TEST_CHECK(moved != nullptr && SystemHeap::bulkHeap.owns(moved));
+        SystemHeap::deallocate(moved);
+        SystemHeap::deallocate(large);
+        SystemHeap::deallocate(bulk);
+        TEST_CHECK(SystemHeap::getStatistics(HeapRegion::fast).usedBytes == 0);
+        TEST_CHECK(SystemHeap::getStatistics(HeapRegion::bulk).usedBytes == 0);
+    }
+};
+
+void runTlsfHeapTests()
+{
+    testAllocateRelease();
+    testExhaustionAndRegions();
+    testAligned();
+    testReallocate();
+    testFragmentation();
+    testRandomTrace();
+    testSystemHeapFallback();
+}
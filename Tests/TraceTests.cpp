@@ -0,0 +1,76 @@
+#include "UnitTest.hh"
+#include <Trace.hh>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+
+namespace
+{
+    using Area = Trace::Area<16>;
+    Area area;
+
+    constexpr std::uint32_t hostClockHz{ 1000000000 };
+
+    void testRecords()
+    {
+        area.cm7.reset(hostClockHz, Hsem::cm7CoreId);
+        TEST_CHECK(area.cm7.written() == 0 && area.cm7.size() == 0);
+
+        // The ring keeps the last 16 records
+        for (std::uint16_t event = 0; event < 20; ++event) { area.cm7.instant(event, event * 2U); }
+        TEST_CHECK(area.cm7.written() == 20 && area.cm7.size() == 16);
+        TEST_CHECK(area.cm7.at(0).event == 4 && area.cm7.at(15).event == 19 && area.cm7.at(15).arg0 == 38);
+        bool ordered{ true };
+        for (std::uint32_t index = 1; index < area.cm7.size(); ++index) {
+            ordered = ordered && static_cast<std::int32_t>(area.cm7.at(index).cycles - area.cm7.at(index - 1).cycles) >= 0;
+        }
+        TEST_CHECK(ordered);
+
+        {
+            Trace::Scope scope{ area.cm7, 42, 7 };
+            area.cm7.counter(43, 1234);
+        }
+        TEST_CHECK(area.cm7.at(13).kind == Trace::Kind::begin && area.cm7.at(13).arg0 == 7);
+        TEST_CHECK(area.cm7.at(14).kind == Trace::Kind::counter && area.cm7.at(14).arg0 == 1234);
+        TEST_CHECK(area.cm7.at(15).kind == Trace::Kind::end && area.cm7.at(15).event == 42);
+
+        // Dump layout read by Tools/trace_merge.py
+        const auto* base{ reinterpret_cast<const std::uint8_t*>(&area) };
+        TEST_CHECK(reinterpret_cast<const std::uint8_t*>(&area.cm4) - base == 64 + 16 * 16);
+        std::uint32_t magic;
+        std::memcpy(&magic, base, sizeof(magic));
+        TEST_CHECK(magic == Trace::magic && base[6] == Hsem::cm7CoreId && base[7] == sizeof(Trace::Record));
+    }
+
+    void testSynchronize()
+    {
+        area.cm7.reset(hostClockHz, Hsem::cm7CoreId);
+        area.cm4.reset(hostClockHz, Hsem::cm4CoreId);
+        // Leftovers of a previous run: the CM4 may spend its first answer on a stale ping,
+        // then the last CM7 round goes unanswered
+        area.cell.ping.store(7);
+        area.cell.pong.store(3);
+
+        std::thread cm4([&] { static_cast<void>(area.respondToSync(4)); });
+        const bool synchronized{ area.synchronize(4) };
+        cm4.join();
+        TEST_CHECK(synchronized);
+
+        // One clock on the host: the CM4 stamps fall inside the best round trip
+        const Trace::SyncPoint& point{ area.cm7.syncPoint() };
+        TEST_CHECK(point.sequence != 0 && point.sequence != 7);
+        TEST_CHECK(static_cast<std::int32_t>(point.peerReceive - point.masterSend) >= 0);
+        TEST_CHECK(static_cast<std::int32_t>(point.peerSend - point.peerReceive) >= 0);
+        TEST_CHECK(static_cast<std::int32_t>(point.masterReceive - point.peerSend) >= 0);
+        TEST_CHECK(area.cm7.written() >= 3 && area.cm7.at(area.cm7.size() - 1).kind == Trace::Kind::sync);
+
+        // No answer: the CM7 gives up
+        TEST_CHECK(!area.synchronize(1));
+    }
+};
+
+void runTraceTests()
+{
+    testRecords();
+    testSynchronize();
+}
@@ -0,0 +1,36 @@
+#ifndef __UNITTEST_H__
+#define __UNITTEST_H__
+
+/**
+ * @file UnitTest.hh
+ * @brief Minimal check macros for the host test executable.
+ *
+ * Each Tests/<Module>Tests.cpp file exposes a run<Module>Tests() function called from
+ * main(). A failed check prints its location and is counted, main() returns the count.
+ */
+
+//<------------------------------INCLUDES------------------------------>//
+#include <iostream>
+//<-------------------------------------------------------------------->//
+
+namespace UnitTest
+{
+    /// Number of failed checks since the start of the executable.
+    inline int& failures()
+    {
+        static int count{ 0 };
+        return count;
+    }
+
+    inline void check(const bool condition, const char* expression, const char* file, const int line)
+    {
+        if (!condition) {
+            ++failures();
+            std::cout << file << ":" << line << ": check failed: " << expression << std::endl;
+        }
+    }
+};
+
+#define TEST_CHECK(expression) UnitTest::check((expression), #expression, __FILE__, __LINE__)
+
+#endif // __UNITTEST_H__
@@ -0,0 +1,200 @@
+#ifndef __USARTMODEL_H__
+#define __USARTMODEL_H__
+
+/**
+ * @file UsartModel.hh
+ * @brief Behavioral model of a USART receiver for host tests, feeding a DmaModel stream.
+ *
+ * Models what the driver relies on: CR1, CR2, CR3, BRR and RTOR, the flags of ISR cleared
+ * through ICR, RXNE cleared by reading RDR or by the DMA taking the byte, and the overrun
+ * of a byte arriving while RDR is still full. receive() shifts bytes in while the receiver
+ * is enabled; with DMAR set, each byte is a request the DmaModel stream serves at once
+ * unless stall() holds it back. silence() keeps the line idle for a number of bit times:
+ * the idle flag after one character, the receiver timeout after RTOR bit times, each once
+ * per burst.
+ */
+
+//<------------------------------INCLUDES------------------------------>//
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <Usart.hh>
+#include "DmaModel.hh"
+#include "ModelSupport.hh"
+//<-------------------------------------------------------------------->//
+
+class UsartModel
+{
+    public:
+        /// Bit times of one character, 8N1.
+        static constexpr std::uint32_t characterBits{ 10 };
+
+        using ModelRegister = HostRegister<UsartModel, UsartRegisters>;
+        friend ModelRegister;
+
+        static constexpr std::size_t registerCount{ 8 };
+
+        /**
+         * @param dataAddress Bus address of RDR, mapped in dma.
+         * @param controller, stream The stream serving the receive requests.
+         */
+        UsartModel(DmaModel& dma, const std::uint32_t dataAddress, const std::uint8_t controller, const std::uint8_t stream)
+            : dma(dma), controller(controller), stream(stream)
+        {
+            for (std::size_t index = 0; index < registerCount; ++index) {
+                views.push_back(std::make_unique<ModelRegister>(*this, static_cast<UsartRegisters>(index)));
+            }
+            dma.map(dataAddress, &data, sizeof(data));
+        }
+
+        /**
+         * @brief Handler of the USART, running on the model.
+         */
+        UsartHandler& handler(const std::uint32_t kernelClock)
+        {
+            if (!instance) {
+                auto handle = [this](const std::size_t index) -> IRegister<volatile std::uint32_t*>* { return views[index].get(); };
+                instance = std::make_unique<UsartHandler>(kernelClock, registerHandles, handle(0), handle(1), handle(2), handle(3), handle(4), handle(5),
+                                                          handle(6), handle(7));
+            }
+            return *instance;
+        }
+
+        /**
+         * @brief Bytes arriving on the line back to back.
+         */
+        void receive(const std::uint8_t* bytes, const std::size_t count)
+        {
+            for (std::size_t index = 0; index < count; ++index) {
+                if (!isSet(control1, Usart::enablePos) || !isSet(control1, Usart::receiverEnablePos)) { continue; }
+                burst = true;
+                if ((flags & Usart::receiveNotEmptyFlag) != 0) {
+                    // RDR still full: the byte is lost
+                    flags |= Usart::overrunFlag;
+                    continue;
+                }
+                data = bytes[index];
+                flags |= Usart::receiveNotEmptyFlag;
+                request();
+            }
+        }
+
+        void receive(const std::vector<std::uint8_t>& bytes) { receive(bytes.data(), bytes.size()); }
+
+        /**
+         * @brief Keep the line idle for bits bit times after the last byte.
+         */
+        void silence(const std::uint32_t bits)
+        {
+            if (!burst) { return; }
+            idleBits += bits;
+            if (!idleRaised && idleBits >= characterBits) {
+                flags |= Usart::idleFlag;
+                idleRaised = true;
+            }
+            if (!timeoutRaised && isSet(control2, Usart::receiverTimeoutEnablePos) && idleBits >= timeout) {
+                flags |= Usart::receiverTimeoutFlag;
+                timeoutRaised = true;
+            }
+            if (idleRaised && (timeoutRaised || !isSet(control2, Usart::receiverTimeoutEnablePos))) { endBurst(); }
+        }
+
+        /// The next byte has a framing error.
+        void framingError() { flags |= Usart::framingErrorFlag; }
+
+        /**
+         * @brief Hold the DMA requests back, as a busy bus would; releasing serves the pending one.
+         */
+        void stall(const bool stalled)
+        {
+            dmaStalled = stalled;
+            if (!stalled && (flags & Usart::receiveNotEmptyFlag) != 0) { request(); }
+        }
+
+        /// Whether an enabled interrupt is pending, the NVIC line.
+        bool interruptPending() const
+        {
+            std::uint32_t enabledFlags{ 0 };
+            if (isSet(control1, Usart::idleInterruptPos)) { enabledFlags |= Usart::idleFlag; }
+            if (isSet(control1, Usart::receiverTimeoutInterruptPos)) { enabledFlags |= Usart::receiverTimeoutFlag; }
+            if (isSet(control3, Usart::errorInterruptPos)) { enabledFlags |= Usart::overrunFlag | Usart::framingErrorFlag | Usart::noiseFlag; }
+            return (flags & enabledFlags) != 0;
+        }
+
+        std::uint32_t baudRateRegister() const { return brr; }
+        std::uint32_t timeoutRegister() const { return timeout; }
+        bool isOversampling8() const { return isSet(control1, Usart::oversampling8Pos); }
+
+    private:
+        DmaModel& dma;
+        std::uint8_t controller;
+        std::uint8_t stream;
+        std::uint32_t control1{ 0 };
+        std::uint32_t control2{ 0 };
+        std::uint32_t control3{ 0 };
+        std::uint32_t brr{ 0 };
+        std::uint32_t timeout{ 0 };
+        std::uint32_t flags{ 0 };
+        std::uint32_t data{ 0 };
+        std::uint32_t idleBits{ 0 };
+        bool burst{ false };
+        bool idleRaised{ false };
+        bool timeoutRaised{ false };
+        bool dmaStalled{ false };
+        std::vector<std::unique_ptr<ModelRegister>> views;
+        std::unique_ptr<UsartHandler> instance;
+
+        static bool isSet(const std::uint32_t value, const std::uint32_t position) { return (value & (1U << position)) != 0; }
+
+        void endBurst()
+        {
+            burst = false;
+            idleBits = 0;
+            idleRaised = false;
+            timeoutRaised = false;
+        }
+
+        /// A byte in RDR: the DMA takes it if requests are on.
+        void request()
+        {
+            idleBits = 0;
+            idleRaised = false;
+            timeoutRaised = false;
+            if (!isSet(control3, Usart::dmaReceivePos) || dmaStalled) { return; }
+            if (dma.transfer(controller, stream, 1) == 1) { flags &= ~Usart::receiveNotEmptyFlag; }
+        }
+
+        std::uint32_t read(const UsartRegisters kind)
+        {
+            switch (kind) {
+                case UsartRegisters::control1: return control1;
+                case UsartRegisters::control2: return control2;
+                case UsartRegisters::control3: return control3;
+                case UsartRegisters::baudRate: return brr;
+                case UsartRegisters::receiverTimeout: return timeout;
+                case UsartRegisters::interruptStatus: return flags;
+                case UsartRegisters::receiveData:
+                    flags &= ~Usart::receiveNotEmptyFlag;
+                    return data;
+                default: return 0;
+            }
+        }
+
+        void write(const UsartRegisters kind, const std::uint32_t value)
+        {
+            const bool enabled{ isSet(control1, Usart::enablePos) };
+            switch (kind) {
+                case UsartRegisters::control1: control1 = value; break;
+                // The other configuration registers are locked while UE is set
+                case UsartRegisters::control2: if (!enabled) { control2 = value; } break;
+                case UsartRegisters::control3: if (!enabled) { control3 = value; } break;
+                case UsartRegisters::baudRate: if (!enabled) { brr = value & 0xFFFFU; } break;
+                case UsartRegisters::receiverTimeout: timeout = value & Usart::maxReceiverTimeout; break;
+                case UsartRegisters::interruptClear: flags &= ~(value & Usart::allFlags); break;
+                default: break;
+            }
+        }
+};
+
+#endif // __USARTMODEL_H__
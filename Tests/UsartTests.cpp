@@ -0,0 +1,229 @@
+#include "UnitTest.hh"
+#include "DmaModel.hh"
+#include "ModelSupport.hh"
+#include "UsartModel.hh"
+#include <Usart.hh>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+    // USART1 RDR, the receiver in AXI SRAM
+    constexpr std::uint32_t dataRegister{ 0x40011024 };
+    constexpr std::uint32_t receiverBase{ TestBus::axiSram };
+    constexpr std::uint32_t kernelClock{ 120000000 };
+
+    template<std::size_t Size>
+    struct Line {
+        DmaModel dma;
+        UsartModel model{ dma, dataRegister, 1, 0 };
+        UsartHandler& usart{ model.handler(kernelClock) };
+        DmaStreamHandler& stream{ dma.handler(1, 0) };
+        UartDmaReceiver<Size> receiver;
+        std::uint8_t next{ 0 };
+
+        Line() { dma.map(receiverBase, &receiver, sizeof(receiver)); }
+
+        DriverStatus start(const UsartConfig& config = UsartConfig{ .baudRate = 12000000 })
+        {
+            return receiver.start(usart, stream, Dma::Request::usart1Rx, dataRegister, config, DmaPriority::high, receiverBase);
+        }
+
+        /// Serve the USART and stream interrupts, as the NVIC would.
+        void serve()
+        {
+            if (model.interruptPending()) { usart.handleInterrupt(); }
+            if (dma.interruptPending(1, 0)) { stream.handleInterrupt(); }
+        }
+
+        /// Bytes counting up from where the last burst stopped, then the idle line.
+        void burst(const std::size_t bytes, const std::uint32_t idleBits = UsartModel::characterBits)
+        {
+            for (std::size_t index = 0; index < bytes; ++index) {
+                model.receive(&next, 1);
+                ++next;
+                serve();
+            }
+            model.silence(idleBits);
+            serve();
+        }
+
+        bool isInside(const std::uint8_t* pointer) const
+        {
+            const auto* base{ reinterpret_cast<const std::uint8_t*>(&receiver) };
+            return pointer >= base && pointer < base + sizeof(receiver);
+        }
+    };
+
+    /// Whether a span holds count bytes counting up from first.
+    bool counts(const UartDmaReceiver<64>::Span& span, const std::uint8_t first, const std::size_t count)
+    {
+        if (!span.isValid() || span.size != count) { return false; }
+        for (std::size_t index = 0; index < count; ++index) {
+            if (span.data[index] != static_cast<std::uint8_t>(first + index)) { return false; }
+        }
+        return true;
+    }
+
+    void testDivider()
+    {
+        // By 16 when the clock allows it, by 8 above fck / 16, out of reach below fck / 8
+        static_assert(Usart::divider(kernelClock, 115200).brr == 1042 && !Usart::divider(kernelClock, 115200).oversampling8);
+        static_assert(Usart::divider(kernelClock, 12000000).brr == 0x12 && Usart::divider(kernelClock, 12000000).oversampling8);
+        static_assert(Usart::baudRateOf(kernelClock, Usart::divider(kernelClock, 12000000)) == 12000000);
+        static_assert(Usart::baudRateOf(kernelClock, Usart::divider(kernelClock, 2000000)) == 2000000);
+        static_assert(!Usart::divider(64000000, 12000000).isValid() && !Usart::divider(kernelClock, 0).isValid());
+        static_assert(!Usart::divider(kernelClock, 1000).isValid());
+        TEST_CHECK(Usart::baudRateOf(kernelClock, Usart::divider(kernelClock, 115200)) == 115163);
+    }
+
+    void testConfigure()
+    {
+        DmaModel dma;
+        UsartModel model{ dma, dataRegister, 1, 0 };
+        UsartHandler& usart{ model.handler(kernelClock) };
+        TEST_CHECK(usart.enable().error() == DriverError::notInitialized);
+        TEST_CHECK(usart.configure(UsartConfig{ .baudRate = 64000000 }).error() == DriverError::invalidParameter);
+        TEST_CHECK(usart.configure(UsartConfig{ .receiverTimeout = 0x1000000 }).error() == DriverError::invalidParameter);
+
+        TEST_CHECK(usart.configure(UsartConfig{ .baudRate = 12000000, .receiverTimeout = 40 }).hasValue());
+        TEST_CHECK(model.baudRateRegister() == 0x12 && model.isOversampling8() && model.timeoutRegister() == 40);
+        TEST_CHECK(usart.enable().hasValue() && usart.isEnabled());
+        TEST_CHECK(usart.configure(UsartConfig{}).error() == DriverError::busy);
+
+        // Without DMA and callback: polled, the flags stay
+        TEST_CHECK(usart.disable().hasValue() && usart.configure(UsartConfig{ .dmaReceive = false }).hasValue() && usart.enable().hasValue());
+        const std::vector<std::uint8_t> bytes{ 0x41, 0x42 };
+        model.receive(bytes);
+        TEST_CHECK((usart.flags() & Usart::overrunFlag) != 0 && usart.handleInterrupt() == 0 && !model.interruptPending());
+        TEST_CHECK(usart.read() == 0x41 && (usart.flags() & Usart::receiveNotEmptyFlag) == 0);
+        usart.clearFlags(Usart::allFlags);
+        TEST_CHECK(usart.flags() == 0);
+    }
+
+    void testReceive()
+    {
+        Line<64> line;
+        TEST_CHECK(line.receiver.stop().error() == DriverError::notInitialized);
+        TEST_CHECK(!line.receiver.front().isValid());
+        TEST_CHECK(line.start().hasValue() && line.receiver.isRunning() && line.usart.isEnabled());
+        TEST_CHECK(line.dma.request(1, 0) == static_cast<std::uint8_t>(Dma::Request::usart1Rx));
+
+        // Nothing until the line goes idle
+        for (std::uint8_t index = 0; index < 10; ++index) {
+            line.model.receive(&line.next, 1);
+            ++line.next;
+        }
+        TEST_CHECK(!line.receiver.front().isValid());
+        line.model.silence(5);
+        line.serve();
+        TEST_CHECK(!line.receiver.front().isValid());
+        line.model.silence(5);
+        line.serve();
+
+        // The span is the DMA buffer itself
+        UartDmaReceiver<64>::Span span{ line.receiver.front() };
+        TEST_CHECK(counts(span, 0, 10) && line.isInside(span.data));
+        TEST_CHECK(line.receiver.pop(4) && counts(line.receiver.front(), 4, 6) && line.receiver.pop(6));
+        TEST_CHECK(!line.receiver.front().isValid() && line.receiver.pop(1));
+
+        // A burst across the end of the buffer: half and full transfer publish on the way, two spans
+        line.burst(60);
+        span = line.receiver.front();
+        TEST_CHECK(counts(span, 10, 54) && line.receiver.available() == 60 && line.receiver.pop(span.size));
+        span = line.receiver.front();
+        TEST_CHECK(counts(span, 64, 6) && span.data == line.receiver.front().data && line.receiver.pop(100));
+        TEST_CHECK(line.receiver.available() == 0);
+
+        const auto statistics{ line.receiver.statistics() };
+        TEST_CHECK(statistics.bytes == 70 && statistics.frames == 2 && statistics.overruns == 0 && statistics.usartOverruns == 0);
+
+        // Bytes of a burst cut by stop() are published
+        for (std::uint8_t index = 0; index < 3; ++index) {
+            line.model.receive(&line.next, 1);
+            ++line.next;
+        }
+        TEST_CHECK(line.receiver.stop().hasValue() && !line.receiver.isRunning() && counts(line.receiver.front(), 70, 3));
+    }
+
+    void testReceiverTimeout()
+    {
+        Line<64> line;
+        TEST_CHECK(line.start(UsartConfig{ .baudRate = 2000000, .receiverTimeout = 40, .idleInterrupt = false }).hasValue());
+        line.burst(8, 20);
+        TEST_CHECK(!line.receiver.front().isValid());
+        line.model.silence(20);
+        line.serve();
+        TEST_CHECK(counts(line.receiver.front(), 0, 8) && line.receiver.statistics().frames == 1);
+
+        // A longer burst delivers its first half before the timeout
+        line.receiver.pop(8);
+        line.burst(40, 0);
+        TEST_CHECK(counts(line.receiver.front(), 8, 24));
+        line.model.silence(40);
+        line.serve();
+        TEST_CHECK(line.receiver.pop(24) && counts(line.receiver.front(), 32, 16));
+    }
+
+    void testOverrun()
+    {
+        Line<64> line;
+        TEST_CHECK(line.start().hasValue());
+
+        // The consumer fell a whole buffer behind: the pending bytes are dropped
+        line.burst(100);
+        TEST_CHECK(!line.receiver.front().isValid());
+        UartDmaReceiver<64>::Statistics statistics{ line.receiver.statistics() };
+        TEST_CHECK(statistics.overruns == 1 && statistics.lostBytes == 100 && statistics.bytes == 100);
+        line.burst(5);
+        TEST_CHECK(counts(line.receiver.front(), 100, 5) && line.receiver.pop(5));
+
+        // Overwritten while read: pop() says so
+        line.burst(20);
+        const UartDmaReceiver<64>::Span span{ line.receiver.front() };
+        TEST_CHECK(counts(span, 105, 20));
+        line.burst(50);
+        TEST_CHECK(!line.receiver.pop(span.size) && line.receiver.statistics().overruns == 2);
+
+        // Exactly a buffer behind is still intact
+        line.receiver.pop(100);
+        line.burst(64);
+        TEST_CHECK(line.receiver.available() == 64 && counts(line.receiver.front(), 175, 17) && line.receiver.pop(17));
+        TEST_CHECK(counts(line.receiver.front(), 192, 47) && line.receiver.pop(47) && line.receiver.statistics().overruns == 2);
+    }
+
+    void testLineErrors()
+    {
+        Line<64> line;
+        TEST_CHECK(line.start().hasValue());
+
+        // The DMA held back: the bytes behind the first are lost in the USART
+        line.model.stall(true);
+        line.burst(3);
+        TEST_CHECK(line.receiver.statistics().usartOverruns == 2 && !line.receiver.front().isValid());
+        line.model.stall(false);
+        line.burst(1);
+        const UartDmaReceiver<64>::Span span{ line.receiver.front() };
+        TEST_CHECK(span.size == 2 && span.data[0] == 0 && span.data[1] == 3);
+
+        line.model.framingError();
+        line.serve();
+        TEST_CHECK(line.receiver.statistics().errors == 1);
+
+        // Receiver in DTCM: the stream cannot reach it
+        Line<64> tcm;
+        TEST_CHECK(tcm.receiver.start(tcm.usart, tcm.stream, Dma::Request::usart1Rx, dataRegister, UsartConfig{}, DmaPriority::high, TestBus::dtcm).error() ==
+                   DriverError::invalidParameter);
+        TEST_CHECK(!tcm.receiver.isRunning() && !tcm.usart.isEnabled());
+    }
+};
+
+void runUsartTests()
+{
+    testDivider();
+    testConfigure();
+    testReceive();
+    testReceiverTimeout();
+    testOverrun();
+    testLineErrors();
+}
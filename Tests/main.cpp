@@ -1,5 +1,6 @@
 #include <iostream>
 #include <InputPin.hh>
+#include "UnitTest.hh"
 
 using namespace std::string_literals;
 
@@ -8,11 +9,49 @@ volatile uint32_t ODR = 0b11110101101010101100110000001110;
 
 InputPin<0> pin0 {&MODER, &ODR};
 
+void runClockTreeTests();
+void runTlsfHeapTests();
+void runObjectPoolTests();
+void runStackMonitorTests();
+void runResultTests();
+void runSpscRingTests();
+void runHsemTests();
+void runDualCoreBootTests();
+void runRpcTests();
+void runOffloadTests();
+void runSharedBufferPoolTests();
+void runTraceTests();
+void runDmaTests();
+void runMdmaTests();
+void runAsyncMemoryTests();
+void runBdmaTests();
+void runDma2dTests();
+void runUsartTests();
+
 
 int main(void)
 {
     std::cout << pin0.read() << std::endl;
-    return 0;
+    runClockTreeTests();
+    runTlsfHeapTests();
+    runObjectPoolTests();
+    runStackMonitorTests();
+    runResultTests();
+    runSpscRingTests();
+    runHsemTests();
+    runDualCoreBootTests();
+    runRpcTests();
+    runOffloadTests();
+    runSharedBufferPoolTests();
+    runTraceTests();
+    runDmaTests();
+    runMdmaTests();
+    runAsyncMemoryTests();
+    runBdmaTests();
+    runDma2dTests();
+    runUsartTests();
+    std::cout << UnitTest::failures() << " failed check(s)" << std::endl;
+    return UnitTest::failures();
 }
 
 #ifdef compile
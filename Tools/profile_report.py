@@ -0,0 +1,121 @@
+#!/usr/bin/env python3
+"""
+Compare the build profiles of the Core/m4 and Core/m7 makefiles side by side.
+
+  profile_report.py [--build-dir Build] [--profiles debug size speed speed_lto] [--output FILE]
+
+For every profile it reads the firmware images Build[/<profile>]/m4 and m7 and reports
+the bytes they place in each memory region (FLASH, RAM, ...), as computed by
+size_analysis.py from the ELF and its linker map. It then runs the host benchmark of
+the profile, if built, and reports the mean and p99 of every benchmark line. Missing
+images or benchmarks show as "-", so the report also works for a subset of profiles.
+
+The top-level "make profile_report" builds every profile and calls this script.
+The table is Markdown so it can be pasted as is into a review.
+"""
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import size_analysis  # noqa: E402
+
+CORES = ("m4", "m7")
+RESULT_RE = re.compile(r"^\s+(?P<name>\S.*?)\s+mean\s+(?P<mean>[\d.]+) ns\s+p99\s+(?P<p99>\d+) ns")
+
+
+def profile_dir(build_dir, profile):
+    return build_dir if profile == "debug" else os.path.join(build_dir, profile)
+
+
+def image_sizes(build_dir, profile, core):
+    """{region: bytes} of one image, None if it was not built."""
+    elf = os.path.join(profile_dir(build_dir, profile), core, f"stm32h755xx_libs_{core}.elf")
+    if not os.path.exists(elf):
+        return None
+    map_path = elf[:-len(".elf")] + ".map"
+    rows, _ = size_analysis.collect(elf, map_path if os.path.exists(map_path) else None)
+    sizes = {}
+    for row in rows:
+        sizes[row["region"]] = sizes.get(row["region"], 0) + row["size"]
+    return sizes
+
+
+def benchmark_results(build_dir, profile):
+    """{"title / line": (mean ns, p99 ns)} of the host benchmark of a profile."""
+    binary = os.path.join(profile_dir(build_dir, profile), "Benchmarks", "stm32h755xx_libs_bench.elf")
+    if not os.path.exists(binary):
+        return {}
+    output = subprocess.run([binary], capture_output=True, text=True, check=False).stdout
+    results, title = {}, ""
+    for line in output.split("\n"):
+        match = RESULT_RE.match(line)
+        if match:
+            results[f"{title} / {match['name']}" if title else match["name"]] = (float(match["mean"]), int(match["p99"]))
+        elif line and not line[0].isspace() and not line.startswith("==="):
+            title = line.split(",")[0].strip()
+    return results
+
+
+def table(header, rows):
+    lines = ["| " + " | ".join(header) + " |", "|" + "|".join("---" if index == 0 else "---:" for index in range(len(header))) + "|"]
+    lines += ["| " + " | ".join(row) + " |" for row in rows]
+    return "\n".join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("--build-dir", default="Build")
+    parser.add_argument("--profiles", nargs="+", default=["debug", "size", "speed", "speed_lto"])
+    parser.add_argument("--output", help="Also write the report to this file")
+    args = parser.parse_args()
+
+    sections = []
+    for core in CORES:
+        sizes = {profile: image_sizes(args.build_dir, profile, core) for profile in args.profiles}
+        regions = sorted({region for value in sizes.values() if value for region in value})
+        if not regions:
+            continue
+        rows = []
+        for region in regions:
+            base = (sizes.get("debug") or {}).get(region)
+            cells = [region]
+            for profile in args.profiles:
+                value = (sizes[profile] or {}).get(region) if sizes[profile] is not None else None
+                if value is None:
+                    cells.append("-")
+                elif base and profile != "debug":
+                    cells.append(f"{value} ({100 * (value - base) / base:+.0f}%)")
+                else:
+                    cells.append(str(value))
+            rows.append(cells)
+        sections.append(f"### {core.upper()} image, bytes per region\n\n" + table(["region"] + args.profiles, rows))
+
+    benchmarks = {profile: benchmark_results(args.build_dir, profile) for profile in args.profiles}
+    names = list(dict.fromkeys(name for profile in args.profiles for name in benchmarks[profile]))
+    if names:
+        rows = []
+        for name in names:
+            cells = [name]
+            for profile in args.profiles:
+                result = benchmarks[profile].get(name)
+                cells.append(f"{result[0]:.1f} / {result[1]}" if result else "-")
+            rows.append(cells)
+        sections.append("### Host benchmarks, mean / p99 ns\n\n" + table(["benchmark"] + args.profiles, rows))
+
+    if not sections:
+        print(f"error: nothing built under {args.build_dir} for profiles {', '.join(args.profiles)}", file=sys.stderr)
+        return 1
+    report = "\n\n".join(sections) + "\n"
+    print(report, end="")
+    if args.output:
+        with open(args.output, "w", encoding="utf-8") as file:
+            file.write(report)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
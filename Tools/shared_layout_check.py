@@ -0,0 +1,86 @@
+#!/usr/bin/env python3
+"""
+Check that the objects both cores share in SRAM4 sit at the same address in both images.
+
+  shared_layout_check.py CM7.elf CM4.elf [--section .sram4_shared]
+
+The linker scripts only fix where .sram4_shared starts; the objects inside follow the
+order in which each image links them, so an object defined in both images may land at
+two addresses. The check reads the sized objects of the section from the symbol tables
+and fails when
+  - an object of both images has a different address or size in each, or
+  - an object of one image overlaps an object of the other it is not also defined in:
+    the two cores would use the same bytes for different things.
+Objects of one image alone that overlap nothing are reported as a note: the other core
+cannot name them, which is fine for data it never touches.
+
+The top-level "make build" and "make all" run it on the two images of the profile.
+It exits with status 1 on any error.
+"""
+
+import argparse
+import os
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import size_analysis  # noqa: E402
+
+
+def shared_objects(path, section_name):
+    """{name: (address, size)} of the objects of a section."""
+    elf = size_analysis.Elf(path)
+    objects = {}
+    for name, shndx, address, size in elf.symbols():
+        if elf.sections[shndx].name == section_name:
+            objects[name] = (address, size)
+    return objects
+
+
+def overlaps(first, second):
+    return first[0] < second[0] + second[1] and second[0] < first[0] + first[1]
+
+
+def check(first, second, names, labels):
+    """Error and note lines for the objects of two images."""
+    errors = []
+    notes = []
+    for name in sorted(first.keys() & second.keys()):
+        if first[name] != second[name]:
+            errors.append(f"{names[name]}: 0x{first[name][0]:08x} ({first[name][1]} bytes) in {labels[0]}, "
+                          f"0x{second[name][0]:08x} ({second[name][1]} bytes) in {labels[1]}")
+    for own, other, label, other_label in ((first, second, labels[0], labels[1]), (second, first, labels[1], labels[0])):
+        for name in sorted(own.keys() - other.keys()):
+            clashes = [other_name for other_name, placement in other.items() if other_name not in own and overlaps(own[name], placement)]
+            if clashes:
+                errors.append(f"{names[name]} of {label} overlaps {', '.join(names[clash] for clash in sorted(clashes))} of {other_label}")
+            else:
+                notes.append(f"{names[name]} is only defined in {label}")
+    return errors, notes
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("first", help="Image of one core, e.g. the CM7")
+    parser.add_argument("second", help="Image of the other core")
+    parser.add_argument("--section", default=".sram4_shared")
+    args = parser.parse_args()
+
+    first = shared_objects(args.first, args.section)
+    second = shared_objects(args.second, args.section)
+    names = size_analysis.demangle(sorted(first.keys() | second.keys()))
+    labels = (os.path.basename(args.first), os.path.basename(args.second))
+    errors, notes = check(first, second, names, labels)
+    for note in notes:
+        print(f"note: {note}")
+    for error in errors:
+        print(f"error: {error}", file=sys.stderr)
+    if errors:
+        print(f"error: {args.section} differs between the images, define the shared objects in the same order in both "
+              f"(see SRAM4_SHARED in Core/System/MemorySections.hh)", file=sys.stderr)
+        return 1
+    print(f"{args.section}: {len(first.keys() & second.keys())} shared object(s) at the same address in both images")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
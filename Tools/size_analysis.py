@@ -0,0 +1,382 @@
+#!/usr/bin/env python3
+"""
+Flash and RAM attribution of a firmware image by template family, section and memory region.
+
+  size_analysis.py report IMAGE.elf [--map IMAGE.map] [--group family|symbol|section|region|object]
+  size_analysis.py diff OLD.elf NEW.elf [--old-map OLD.map] [--new-map NEW.map] [--fail-above BYTES]
+
+Symbols are read straight from the ELF symbol table, demangled with c++filt and reduced to
+their template family: template arguments and parameter lists are dropped, so
+PeripheralHandlerBase<TypeList<...>, ...>::getParam<(IPinHandlerProperties)1>() and every
+other instantiation of that class count as "PeripheralHandlerBase<>". Bytes of a section not
+covered by any sized symbol (padding, literal pools, library code without symbol sizes) are
+reported as "(unattributed <section>)" so totals add up to the section sizes.
+
+The memory regions come from the "Memory Configuration" table of the linker map. Initialized
+data is counted twice, in the region it runs from (RAM) and in the region it is loaded
+from (FLASH), through the ELF program headers. --group object attributes input sections to
+their object file or archive member using the map.
+
+diff prints the size change of every group between two builds, largest first, and exits
+with status 1 when the total grows by more than --fail-above bytes.
+"""
+
+import argparse
+import os
+import re
+import shutil
+import struct
+import subprocess
+import sys
+from collections import defaultdict
+
+SHT_NOBITS = 8
+SHT_SYMTAB = 2
+SHF_ALLOC = 0x2
+SHF_WRITE = 0x1
+PT_LOAD = 1
+STT_OBJECT = 1
+STT_FUNC = 2
+
+
+class Section:
+    def __init__(self, name, kind, flags, address, size):
+        self.name = name
+        self.kind = kind
+        self.flags = flags
+        self.address = address
+        self.size = size
+        self.load_address = address
+
+
+class Elf:
+    """Minimal little-endian ELF32/ELF64 reader: sections, program headers, symbols."""
+
+    def __init__(self, path):
+        with open(path, "rb") as file:
+            self.data = file.read()
+        if self.data[:4] != b"\x7fELF" or self.data[5] != 1:
+            sys.exit(f"error: {path} is not a little-endian ELF file")
+        self.wide = self.data[4] == 2
+        header = "<HHIQQQIHHHHHH" if self.wide else "<HHIIIIIHHHHHH"
+        (_, _, _, _, self.phoff, self.shoff, _, _, self.phentsize, self.phnum,
+         self.shentsize, self.shnum, self.shstrndx) = struct.unpack_from(header, self.data, 16)
+        self.raw_sections = [self.section_header(index) for index in range(self.shnum)]
+        names = self.raw_sections[self.shstrndx]
+        self.sections = [Section(self.string(names["offset"], raw["name"]), raw["type"], raw["flags"], raw["address"], raw["size"])
+                         for raw in self.raw_sections]
+        self.apply_load_addresses()
+
+    def section_header(self, index):
+        offset = self.shoff + index * self.shentsize
+        if self.wide:
+            name, kind, flags, address, file_offset, size, link, _, _, entsize = struct.unpack_from("<IIQQQQIIQQ", self.data, offset)
+        else:
+            name, kind, flags, address, file_offset, size, link, _, _, entsize = struct.unpack_from("<IIIIIIIIII", self.data, offset)
+        return {"name": name, "type": kind, "flags": flags, "address": address, "offset": file_offset,
+                "size": size, "link": link, "entsize": entsize}
+
+    def string(self, table_offset, offset):
+        end = self.data.index(b"\0", table_offset + offset)
+        return self.data[table_offset + offset:end].decode("utf-8", errors="replace")
+
+    def apply_load_addresses(self):
+        for index in range(self.phnum):
+            offset = self.phoff + index * self.phentsize
+            if self.wide:
+                kind, _, _, vaddr, paddr, filesz, memsz, _ = struct.unpack_from("<IIQQQQQQ", self.data, offset)
+            else:
+                kind, _, vaddr, paddr, filesz, memsz, _, _ = struct.unpack_from("<IIIIIIII", self.data, offset)
+            if kind != PT_LOAD or filesz == 0 or vaddr == paddr:
+                continue
+            for section in self.sections:
+                if section.kind != SHT_NOBITS and vaddr <= section.address < vaddr + filesz:
+                    section.load_address = section.address - vaddr + paddr
+
+    def symbols(self):
+        """(name, section index, address, size) of every sized function and object."""
+        for raw in self.raw_sections:
+            if raw["type"] != SHT_SYMTAB:
+                continue
+            strings = self.raw_sections[raw["link"]]["offset"]
+            for offset in range(raw["offset"], raw["offset"] + raw["size"], raw["entsize"]):
+                if self.wide:
+                    name, info, _, shndx, value, size = struct.unpack_from("<IBBHQQ", self.data, offset)
+                else:
+                    name, value, size, info, _, shndx = struct.unpack_from("<IIIBBH", self.data, offset)
+                if size == 0 or (info & 0xF) not in (STT_FUNC, STT_OBJECT) or not 0 < shndx < len(self.sections):
+                    continue
+                yield self.string(strings, name), shndx, value & ~1 if (info & 0xF) == STT_FUNC else value, size
+
+
+def demangle(names):
+    tool = next((candidate for candidate in ("arm-none-eabi-c++filt", "c++filt") if shutil.which(candidate)), None)
+    if tool is None or not names:
+        return {name: name for name in names}
+    result = subprocess.run([tool], input="\n".join(names), capture_output=True, text=True, check=False)
+    demangled = result.stdout.split("\n")
+    return {name: demangled[index] if index < len(demangled) and demangled[index] else name for index, name in enumerate(names)}
+
+
+SPECIAL_PREFIXES = ("vtable for ", "typeinfo for ", "typeinfo name for ", "guard variable for ",
+                    "construction vtable for ", "VTT for ", "non-virtual thunk to ", "virtual thunk to ")
+
+
+def collapse(name):
+    """Drop template arguments, lambda bodies and parameter lists from a demangled name."""
+    for prefix in SPECIAL_PREFIXES:
+        if name.startswith(prefix):
+            name = name[len(prefix):]
+    name = name.replace("(anonymous namespace)", "{anonymous}")
+    output = []
+    angle = 0
+    brace = 0
+    index = 0
+    while index < len(name):
+        if name.startswith("operator", index) and angle == 0 and brace == 0:
+            match = re.match(r"operator\s*(<<=|>>=|<<|>>|<=>|<=|>=|->\*|->|\(\)|\[\]|[<>]|[^\w\s(]*)", name[index:])
+            output.append(match.group(0))
+            index += len(match.group(0))
+            continue
+        char = name[index]
+        if char == "<":
+            if angle == 0 and brace == 0:
+                output.append("<>")
+            angle += 1
+        elif char == ">":
+            angle = max(angle - 1, 0)
+        elif char == "{" and angle == 0:
+            if brace == 0:
+                output.append("{")
+            brace += 1
+        elif char == "}" and angle == 0:
+            brace -= 1
+            if brace == 0:
+                output.append("}")
+        elif angle == 0 and brace == 0:
+            output.append(char)
+        elif brace > 0 and angle == 0 and char.isalpha() and output[-1] == "{":
+            word = re.match(r"\w+", name[index:]).group(0)
+            output.append(word)
+            index += len(word)
+            continue
+        index += 1
+    collapsed = "".join(output)
+    # Parameter list: the last parenthesized group at the top level, with trailing qualifiers
+    collapsed = re.sub(r"\s*(const|volatile|&|&&|\s)*$", "", collapsed)
+    if collapsed.endswith(")"):
+        depth = 0
+        for position in range(len(collapsed) - 1, -1, -1):
+            depth += {")": 1, "(": -1}.get(collapsed[position], 0)
+            if depth == 0:
+                if not collapsed[:position].endswith("operator"):
+                    collapsed = collapsed[:position]
+                break
+    # Return type of function templates, e.g. "void foo<>": everything up to the last space
+    # that does not belong to an operator name ("operator< <>", "operator new")
+    start = 0
+    for space in re.finditer(" ", collapsed):
+        if not re.search(r"operator\S*$", collapsed[:space.start()]):
+            start = space.end()
+    return collapsed[start:].strip()
+
+
+def family_of(name):
+    """Scope up to the first template: Memory::ObjectPool<>::create<> -> Memory::ObjectPool<>."""
+    collapsed = collapse(name)
+    parts = collapsed.split("::")
+    for index, part in enumerate(parts):
+        if part.endswith("<>"):
+            return "::".join(parts[:index + 1])
+    return collapsed
+
+
+def read_map(path):
+    """Memory regions [(name, origin, length)] and input section owners {address: object}."""
+    regions, owners = [], {}
+    if not path:
+        return regions, owners
+    with open(path, encoding="utf-8", errors="replace") as file:
+        lines = file.read().split("\n")
+    in_memory = False
+    pending = None
+    for line in lines:
+        if line.startswith("Memory Configuration"):
+            in_memory = True
+            continue
+        if in_memory:
+            if line.startswith("Linker script and memory map"):
+                in_memory = False
+            match = re.match(r"^(\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)", line)
+            if match and match.group(1) != "*default*" and match.group(1) != "Name":
+                regions.append((match.group(1), int(match.group(2), 16), int(match.group(3), 16)))
+            continue
+        # " .text.name  0xADDR  0xSIZE object" on one line, or the name alone and the rest on the next
+        match = re.match(r"^ (\.\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$", line)
+        if match is None and pending:
+            match = re.match(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$", line)
+            if match:
+                owners[int(match.group(1), 16)] = (int(match.group(2), 16), match.group(3))
+            pending = None
+            continue
+        if match:
+            owners[int(match.group(2), 16)] = (int(match.group(3), 16), match.group(4))
+            continue
+        pending = re.match(r"^ \.\S+$", line) is not None
+    return regions, owners
+
+
+def region_of(regions, address):
+    for name, origin, length in regions:
+        if origin <= address < origin + length:
+            return name
+    return "?"
+
+
+def owner_of(owners, starts, address):
+    """Object file of the input section containing address, by bisection on the section starts."""
+    low, high = 0, len(starts)
+    while low < high:
+        middle = (low + high) // 2
+        if starts[middle] <= address:
+            low = middle + 1
+        else:
+            high = middle
+    if low == 0:
+        return "?"
+    start = starts[low - 1]
+    size, owner = owners[start]
+    return os.path.basename(owner) if address < start + max(size, 1) else "?"
+
+
+def collect(elf_path, map_path):
+    """Entries (group keys..., size, region) for every allocated byte of the image."""
+    elf = Elf(elf_path)
+    regions, owners = read_map(map_path)
+    starts = sorted(owners)
+    raw = list(elf.symbols())
+    names = demangle(sorted({name for name, _, _, _ in raw}))
+
+    entries = []
+    covered = defaultdict(int)
+    seen = set()
+    for name, shndx, address, size in raw:
+        section = elf.sections[shndx]
+        if not section.flags & SHF_ALLOC or (shndx, address) in seen:
+            continue
+        seen.add((shndx, address))
+        covered[shndx] += size
+        entries.append((names[name], section, address, size))
+    for index, section in enumerate(elf.sections):
+        if section.flags & SHF_ALLOC and section.size > covered[index]:
+            entries.append((f"(unattributed {section.name})", section, section.address, section.size - covered[index]))
+
+    rows = []
+    for name, section, address, size in entries:
+        run_region = region_of(regions, section.address)
+        base = {
+            "symbol": collapse(name) if not name.startswith("(") else name,
+            "family": family_of(name) if not name.startswith("(") else name,
+            "section": section.name,
+            "object": owner_of(owners, starts, address) if owners else "?",
+        }
+        rows.append(dict(base, region=run_region, size=size))
+        # Initialized data also occupies its load image in another region
+        if section.kind != SHT_NOBITS and section.load_address != section.address:
+            load_region = region_of(regions, section.load_address)
+            if load_region != run_region:
+                rows.append(dict(base, region=load_region, size=size))
+    return rows, regions
+
+
+def totals(rows, group):
+    result = defaultdict(lambda: defaultdict(int))
+    for row in rows:
+        result[row[group]][row["region"]] += row["size"]
+    return result
+
+
+def region_columns(regions, rows):
+    names = [name for name, _, _ in regions if any(row["region"] == name for row in rows)]
+    if any(row["region"] == "?" for row in rows):
+        names.append("?")
+    return names
+
+
+def report(args):
+    rows, regions = collect(args.image, args.map)
+    print("Region usage")
+    for name, origin, length in regions:
+        used = sum(row["size"] for row in rows if row["region"] == name)
+        if used:
+            print(f"  {name:<12} {used:>9} B of {length:>9} B ({100 * used / length:5.1f}%)")
+    columns = region_columns(regions, rows)
+    groups = totals(rows, args.group)
+    ordered = sorted(groups.items(), key=lambda item: -sum(item[1].values()))
+    print(f"\nTop {args.top} by {args.group}")
+    print("  " + "".join(f"{column:>10}" for column in columns) + "     total  " + args.group)
+    for key, sizes in ordered[:args.top]:
+        print("  " + "".join(f"{sizes.get(column, 0):>10}" for column in columns) + f"{sum(sizes.values()):>10}  {key}")
+    return 0
+
+
+def diff(args):
+    old_rows, old_regions = collect(args.old, args.old_map)
+    new_rows, new_regions = collect(args.new, args.new_map)
+    columns = list(dict.fromkeys(region_columns(old_regions, old_rows) + region_columns(new_regions, new_rows)))
+    old_groups, new_groups = totals(old_rows, args.group), totals(new_rows, args.group)
+    changes = []
+    for key in set(old_groups) | set(new_groups):
+        deltas = {column: new_groups[key].get(column, 0) - old_groups[key].get(column, 0) for column in columns}
+        if any(deltas.values()):
+            changes.append((key, deltas, sum(new_groups[key].values()) - sum(old_groups[key].values())))
+    changes.sort(key=lambda change: (-abs(change[2]), change[0]))
+
+    print("Region totals")
+    growth = 0
+    for column in columns:
+        old = sum(row["size"] for row in old_rows if row["region"] == column)
+        new = sum(row["size"] for row in new_rows if row["region"] == column)
+        growth += new - old
+        print(f"  {column:<12} {old:>9} -> {new:>9} B  ({new - old:+d})")
+    print(f"\nChanges by {args.group}")
+    print("  " + "".join(f"{column:>10}" for column in columns) + "     total  " + args.group)
+    for key, deltas, total in changes[:args.top]:
+        status = " (new)" if key not in old_groups else " (removed)" if key not in new_groups else ""
+        print("  " + "".join(f"{deltas[column]:>+10d}" for column in columns) + f"{total:>+10d}  {key}{status}")
+    if len(changes) > args.top:
+        print(f"  ... {len(changes) - args.top} more")
+    if args.fail_above is not None and growth > args.fail_above:
+        print(f"error: image grew by {growth} B, more than the allowed {args.fail_above} B")
+        return 1
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    commands = parser.add_subparsers(dest="command", required=True)
+    groups = ("family", "symbol", "section", "region", "object")
+
+    report_parser = commands.add_parser("report", help="Size of one image")
+    report_parser.add_argument("image")
+    report_parser.add_argument("--map", help="Linker map of the image, for regions and objects")
+    report_parser.add_argument("--group", choices=groups, default="family")
+    report_parser.add_argument("--top", type=int, default=30)
+    report_parser.set_defaults(handler=report)
+
+    diff_parser = commands.add_parser("diff", help="Size changes between two images")
+    diff_parser.add_argument("old")
+    diff_parser.add_argument("new")
+    diff_parser.add_argument("--old-map")
+    diff_parser.add_argument("--new-map")
+    diff_parser.add_argument("--group", choices=groups, default="family")
+    diff_parser.add_argument("--top", type=int, default=40)
+    diff_parser.add_argument("--fail-above", type=int, help="Exit with status 1 if the image grows by more bytes")
+    diff_parser.set_defaults(handler=diff)
+
+    args = parser.parse_args()
+    return args.handler(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
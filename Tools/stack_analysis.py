@@ -0,0 +1,283 @@
+#!/usr/bin/env python3
+"""
+Worst-case stack depth of a firmware image from the compiler's own data.
+
+Inputs, all produced by the build (see the stack_check target of Core/m4 and Core/m7):
+  - *.su files (-fstack-usage): frame size and qualifier (static, dynamic, dynamic,bounded)
+    of every function.
+  - *.ci files (-fcallgraph-info=su,da): the call graph of every translation unit.
+  - the startup file: the vector table, i.e. the names of every exception handler.
+  - the linker script: _Min_Stack_Size, the MSP stack reserve to check against.
+
+The thread depth is the deepest of main() and SystemInit(), which run one after the other
+on the same stack. Handlers preempt each other by priority: a handler only preempts handlers
+of a strictly lower urgency, so at most one handler per priority level is on the stack at
+a time. The worst case is therefore
+
+    thread + sum over priority levels of (deepest handler at that level + exception frame)
+
+Priorities default to the NVIC reset value 0 (no nesting between configurable handlers);
+NMI is -2 and HardFault -1. Give the real ones with --priority NAME=N or --priorities FILE.
+
+The result is a lower bound when the graph contains indirect calls (function pointers,
+virtual calls) or calls to functions without stack data (libraries, assembly): those are
+listed, and --assume NAME=BYTES adds known costs. Recursion and unbounded dynamic
+allocations (alloca, VLAs) make a depth unbounded and are reported as errors.
+
+Exit status: 0 if the worst case fits the stack, 1 otherwise or when it is unbounded.
+"""
+
+import argparse
+import os
+import re
+import sys
+
+NODE_RE = re.compile(r'node: \{ title: "(?P<title>[^"]*)" label: "(?P<label>[^"]*)"(?P<rest>[^}]*)\}')
+EDGE_RE = re.compile(r'edge: \{ sourcename: "(?P<source>[^"]*)" targetname: "(?P<target>[^"]*)"')
+SU_RE = re.compile(r'^(?P<location>.*?:\d+:\d+):(?P<name>.*)\t(?P<size>\d+)\t(?P<qualifier>\S+)$')
+VECTOR_RE = re.compile(r'^\s*\.word\s+(?P<name>\w+_(?:IRQ)?Handler)\b')
+HANDLER_RE = re.compile(r'^\w+_(?:IRQ)?Handler$')
+STACK_SIZE_RE = re.compile(r'^\s*_Min_Stack_Size\s*=\s*(?P<value>0x[0-9a-fA-F]+|\d+)\s*;', re.MULTILINE)
+
+INDIRECT = "__indirect_call"
+THREAD_ROOTS = ("main", "SystemInit")
+FIXED_PRIORITIES = {"NMI_Handler": -2, "HardFault_Handler": -1}
+UNBOUNDED = None
+
+
+class Function:
+    def __init__(self, title, name, location):
+        self.title = title
+        self.name = name
+        self.location = location
+        self.frame = None           # Bytes, None if the compiler gave no stack data
+        self.qualifier = "static"
+        self.callees = []
+
+
+def find_files(root, extension):
+    for directory, _, files in os.walk(root):
+        for file in sorted(files):
+            if file.endswith(extension):
+                yield os.path.join(directory, file)
+
+
+def load_su(build_dir):
+    """Frame sizes keyed by 'file:line:col:name', the name being the demangled one."""
+    frames = {}
+    for path in find_files(build_dir, ".su"):
+        with open(path, encoding="utf-8", errors="replace") as file:
+            for line in file:
+                match = SU_RE.match(line.rstrip("\n"))
+                if match:
+                    key = os.path.basename(match["location"]) + ":" + match["name"]
+                    frames[key] = (int(match["size"]), match["qualifier"])
+    return frames
+
+
+def load_callgraph(build_dir, frames):
+    """Merge every .ci file into one graph keyed by symbol, frames taken from the .su data."""
+    functions = {}
+    edges = []
+    for path in find_files(build_dir, ".ci"):
+        with open(path, encoding="utf-8", errors="replace") as file:
+            text = file.read()
+        for match in NODE_RE.finditer(text):
+            title = match["title"]
+            label = match["label"].split("\\n")
+            function = functions.get(title)
+            if function is None:
+                function = Function(title, label[0], label[1] if len(label) > 1 else "")
+                functions[title] = function
+            # Declaration only nodes (shape: ellipse) carry no stack data
+            if len(label) > 2 and "bytes" in label[2]:
+                key = os.path.basename(function.location) + ":" + function.name
+                size, qualifier = frames.get(key, (int(label[2].split()[0]), label[2].split("(")[-1].rstrip(")")))
+                function.frame = size
+                function.qualifier = qualifier
+                function.name = label[0]
+                function.location = label[1]
+        edges.extend((match["source"], match["target"]) for match in EDGE_RE.finditer(text))
+
+    # Static functions are titled "file:symbol", calls from other units use the symbol alone
+    by_symbol = {}
+    for title, function in functions.items():
+        if function.frame is not None:
+            by_symbol.setdefault(title.split(":")[-1], function)
+    for source, target in edges:
+        callee = functions.get(target)
+        if callee is not None and callee.frame is None:
+            callee = by_symbol.get(target, callee)
+        functions[source].callees.append(callee if callee is not None else target)
+    return functions
+
+
+def symbol_index(functions):
+    """Look functions up by symbol and by demangled name without parameters."""
+    index = {}
+    for title, function in functions.items():
+        index.setdefault(title.split(":")[-1], function)
+        plain = re.sub(r"\(.*$", "", function.name).split()[-1] if function.name else title
+        index.setdefault(plain, function)
+    return index
+
+
+class Analyzer:
+    def __init__(self, functions, assumed):
+        self.functions = functions
+        self.assumed = assumed
+        self.memo = {}
+        self.unknown = set()
+        self.indirect = set()
+        self.unbounded = {}
+
+    def cost(self, callee, caller):
+        if isinstance(callee, str) or callee.title == INDIRECT:
+            self.indirect.add(caller.name)
+            return 0, []
+        if callee.frame is None:
+            bare = callee.title.split(":")[-1]
+            if bare in self.assumed:
+                return self.assumed[bare], [f"{callee.name} (assumed)"]
+            self.unknown.add(callee.name)
+            return 0, [f"{callee.name} (unknown)"]
+        return self.depth(callee)
+
+    def depth(self, function, stack=()):
+        """Deepest stack use from function, with the call path realizing it."""
+        if function.title in self.memo:
+            return self.memo[function.title]
+        if function.title in stack:
+            self.unbounded[function.name] = "recursion"
+            return UNBOUNDED, []
+        if function.qualifier == "dynamic":
+            self.unbounded[function.name] = "unbounded dynamic stack allocation"
+            self.memo[function.title] = (UNBOUNDED, [])
+            return UNBOUNDED, [function.name]
+
+        deepest, path = 0, []
+        for callee in function.callees:
+            if not isinstance(callee, str) and callee.frame is not None and callee.title != INDIRECT:
+                size, sub_path = self.depth(callee, stack + (function.title,))
+            else:
+                size, sub_path = self.cost(callee, function)
+            if size is UNBOUNDED:
+                self.memo[function.title] = (UNBOUNDED, [])
+                return UNBOUNDED, [function.name] + sub_path
+            if size > deepest:
+                deepest, path = size, sub_path
+        result = (function.frame + deepest, [f"{function.name} [{function.frame}]"] + path)
+        self.memo[function.title] = result
+        return result
+
+
+def read_vector_table(path):
+    with open(path, encoding="utf-8", errors="replace") as file:
+        return [match["name"] for match in map(VECTOR_RE.match, file) if match and match["name"] != "Reset_Handler"]
+
+
+def read_stack_size(path):
+    with open(path, encoding="latin-1") as file:
+        match = STACK_SIZE_RE.search(file.read())
+    return int(match["value"], 0) if match else None
+
+
+def parse_assignments(values, what):
+    result = {}
+    for value in values:
+        name, _, number = value.partition("=")
+        if not number:
+            sys.exit(f"error: expected NAME=N for {what}, got '{value}'")
+        result[name.strip()] = int(number, 0)
+    return result
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("build_dir", help="Object directory holding the .su and .ci files")
+    parser.add_argument("--linker-script", help="Read _Min_Stack_Size from this script")
+    parser.add_argument("--stack-size", type=lambda value: int(value, 0), help="Stack size in bytes, overrides the linker script")
+    parser.add_argument("--startup", help="Startup file with the vector table")
+    parser.add_argument("--priority", action="append", default=[], help="NAME=N preemption priority of a handler, lower is more urgent")
+    parser.add_argument("--priorities", help="File with one 'NAME N' line per handler")
+    parser.add_argument("--assume", action="append", default=[], help="NAME=BYTES stack use of a function without stack data")
+    parser.add_argument("--exception-frame", type=int, default=108, help="Bytes pushed on exception entry (default 108: FPU extended frame + alignment)")
+    args = parser.parse_args()
+
+    functions = load_callgraph(args.build_dir, load_su(args.build_dir))
+    if not functions:
+        sys.exit(f"error: no .ci files under {args.build_dir}, build with -fstack-usage -fcallgraph-info=su,da")
+    index = symbol_index(functions)
+    analyzer = Analyzer(functions, parse_assignments(args.assume, "--assume"))
+
+    priorities = dict(FIXED_PRIORITIES)
+    if args.priorities:
+        with open(args.priorities, encoding="utf-8") as file:
+            for line in file:
+                fields = line.split("#")[0].split()
+                if len(fields) == 2:
+                    priorities[fields[0]] = int(fields[1], 0)
+    priorities.update(parse_assignments(args.priority, "--priority"))
+
+    # Thread mode
+    print("Thread mode")
+    thread = 0
+    for root in THREAD_ROOTS:
+        function = index.get(root)
+        if function is None or function.frame is None:
+            continue
+        size, path = analyzer.depth(function)
+        print(f"  {root:<30} {'unbounded' if size is UNBOUNDED else f'{size} B':>10}   {' -> '.join(path)}")
+        thread = UNBOUNDED if size is UNBOUNDED or thread is UNBOUNDED else max(thread, size)
+
+    # Handlers, grouped by priority
+    handlers = read_vector_table(args.startup) if args.startup else sorted(name for name in index if HANDLER_RE.match(name))
+    levels = {}
+    print("\nHandlers (priority, depth without exception frame)")
+    for name in dict.fromkeys(handlers):
+        function = index.get(name)
+        if function is None or function.frame is None:
+            continue
+        size, path = analyzer.depth(function)
+        priority = priorities.get(name, 0)
+        print(f"  {name:<30} {priority:>3} {'unbounded' if size is UNBOUNDED else f'{size} B':>10}   {' -> '.join(path)}")
+        if size is UNBOUNDED or levels.get(priority, 0) is UNBOUNDED:
+            levels[priority] = UNBOUNDED
+        else:
+            levels[priority] = max(levels.get(priority, 0), size)
+
+    # Nesting: one handler per priority level, each with its exception frame
+    print("\nWorst case nesting")
+    total = thread
+    print(f"  {'thread':<30} {'unbounded' if thread is UNBOUNDED else f'{thread} B':>10}")
+    for priority in sorted(levels, reverse=True):
+        size = levels[priority]
+        print(f"  {f'priority {priority}':<30} {'unbounded' if size is UNBOUNDED else f'{size} + {args.exception_frame} B':>10}")
+        total = UNBOUNDED if total is UNBOUNDED or size is UNBOUNDED else total + size + args.exception_frame
+
+    for name, reason in sorted(analyzer.unbounded.items()):
+        print(f"error: {name}: {reason}")
+    lower_bound = bool(analyzer.unknown or analyzer.indirect)
+    if analyzer.indirect:
+        print(f"warning: indirect calls not followed in: {', '.join(sorted(analyzer.indirect))}")
+    if analyzer.unknown:
+        print(f"warning: no stack data for: {', '.join(sorted(analyzer.unknown))} (use --assume NAME=BYTES)")
+
+    stack_size = args.stack_size if args.stack_size is not None else (read_stack_size(args.linker_script) if args.linker_script else None)
+    print()
+    if total is UNBOUNDED:
+        print("Worst case stack depth: unbounded")
+        return 1
+    qualifier = "at least " if lower_bound else ""
+    if stack_size is None:
+        print(f"Worst case stack depth: {qualifier}{total} B")
+        return 0
+    print(f"Worst case stack depth: {qualifier}{total} B of {stack_size} B ({100 * total // stack_size}%)")
+    if total > stack_size:
+        print(f"error: stack overflow by {total - stack_size} B, increase _Min_Stack_Size")
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,189 @@
+#!/usr/bin/env python3
+"""
+Merge the per-core trace logs of Core/System/Trace.hh into one timeline in the Chrome
+trace-event format (chrome://tracing, ui.perfetto.dev).
+
+  trace_merge.py DUMP.bin [DUMP.bin ...] [--names EVENTS.txt] [--output trace.json]
+
+The inputs are raw memory dumps holding the Trace::Area, e.g. from gdb:
+  dump binary memory sram4.bin 0x38000000 0x38010000
+Logs are found by their header magic, anywhere in the dumps, so a dump of all of SRAM4 or
+of each log on its own both work.
+
+Each log keeps the last records of one core, stamped with that core's cycle counter.
+The CM4 stamps are moved into the CM7 time base with the sync point of the CM7 log
+header: the counters run at an integer ratio (both clocks come from PLL1), so
+  cm7 = ratio * cm4 + offset (mod 2^32)
+with the offset taken from the ping-pong round kept by Trace::Area::synchronize(). The
+32-bit stamps are then unwrapped per core, assuming less than 2^31 CM7 cycles between
+two records of a core, and the cores are aligned on their newest records.
+
+--names reads "ID NAME" lines (decimal or 0x hexadecimal IDs, # starts a comment);
+events without a name are called "event ID".
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+MAGIC = 0x45435254
+VERSION = 1
+HEADER = struct.Struct("<IHBBIII5I")
+HEADER_SIZE = 64
+RECORD = struct.Struct("<IHBBII")
+WRAP = 1 << 32
+CORE_NAMES = {3: "CM7", 1: "CM4"}
+KINDS = ("instant", "begin", "end", "counter", "sync")
+
+
+class Log:
+    def __init__(self, core, clock_hz, capacity, head, sync, records):
+        self.core = core
+        self.clock_hz = clock_hz
+        self.capacity = capacity
+        self.head = head
+        self.sync = sync
+        self.records = records
+
+    @property
+    def overwritten(self):
+        return max(0, self.head - self.capacity)
+
+
+def signed32(value):
+    return (value + (1 << 31)) % WRAP - (1 << 31)
+
+
+def find_logs(data):
+    """Every valid log header in a dump, with the records still in its ring, oldest first."""
+    logs = []
+    offset = 0
+    while offset + HEADER_SIZE <= len(data):
+        magic, version, core, record_size, capacity, clock_hz, head, *sync = HEADER.unpack_from(data, offset)
+        size = HEADER_SIZE + capacity * RECORD.size
+        if (magic != MAGIC or version != VERSION or record_size != RECORD.size or capacity == 0
+                or capacity & (capacity - 1) or clock_hz == 0 or offset + size > len(data)):
+            offset += 4
+            continue
+        count = min(head, capacity)
+        records = []
+        for index in range(count):
+            slot = (head - count + index) % capacity
+            records.append(RECORD.unpack_from(data, offset + HEADER_SIZE + slot * RECORD.size))
+        logs.append(Log(core, clock_hz, capacity, head, tuple(sync), records))
+        offset += size
+    return logs
+
+
+def read_names(path):
+    names = {}
+    if path is None:
+        return names
+    with open(path, encoding="utf-8") as file:
+        for line in file:
+            line = line.split("#", 1)[0].strip()
+            if line:
+                identifier, name = line.split(None, 1)
+                names[int(identifier, 0)] = name.strip()
+    return names
+
+
+def peer_mapping(master, peer):
+    """(ratio, offset) such that master stamp = ratio * peer stamp + offset, modulo 2^32."""
+    if master.clock_hz % peer.clock_hz != 0:
+        raise SystemExit(f"error: {master.clock_hz} Hz / {peer.clock_hz} Hz is not an integer clock ratio")
+    ratio = master.clock_hz // peer.clock_hz
+    sequence, master_send, peer_receive, peer_send, master_receive = master.sync
+    if sequence == 0:
+        print(f"warning: {CORE_NAMES.get(master.core, master.core)} log never synchronized, "
+              f"{CORE_NAMES.get(peer.core, peer.core)} stamps are not aligned", file=sys.stderr)
+        return ratio, 0
+    forward = (master_send - ratio * peer_receive) % WRAP
+    backward = (master_receive - ratio * peer_send) % WRAP
+    return ratio, (forward + signed32(backward - forward) // 2) % WRAP
+
+
+def unwrap(stamps):
+    """Free-running 32-bit stamps to a monotonic count, small reorderings tolerated."""
+    result = []
+    for stamp in stamps:
+        result.append(stamp if not result else result[-1] + signed32(stamp - result[-1]))
+    return result
+
+
+def merge(logs, names):
+    master = next((log for log in logs if log.core == 3), logs[0])
+    timelines = []
+    for log in logs:
+        ratio, offset = (1, 0) if log is master else peer_mapping(master, log)
+        stamps = unwrap([(ratio * record[0] + offset) % WRAP for record in log.records])
+        timelines.append((log, stamps))
+
+    # Align every core on the master with their newest records
+    master_stamps = next(stamps for log, stamps in timelines if log is master)
+    aligned = []
+    for log, stamps in timelines:
+        if log is not master and stamps and master_stamps:
+            shift = round((master_stamps[-1] - stamps[-1]) / WRAP) * WRAP
+            stamps = [stamp + shift for stamp in stamps]
+        aligned.append((log, stamps))
+
+    origin = min((stamps[0] for _, stamps in aligned if stamps), default=0)
+    events = [{"name": "process_name", "ph": "M", "pid": 1, "args": {"name": "STM32H755"}}]
+    for log, stamps in aligned:
+        tid = log.core
+        events.append({"name": "thread_name", "ph": "M", "pid": 1, "tid": tid,
+                       "args": {"name": CORE_NAMES.get(log.core, f"core {log.core}")}})
+        for (_, event, kind, _, arg0, arg1), stamp in zip(log.records, stamps):
+            kind_name = KINDS[kind] if kind < len(KINDS) else "instant"
+            if kind_name == "sync":
+                continue
+            name = names.get(event, f"event {event}")
+            entry = {"name": name, "pid": 1, "tid": tid, "ts": (stamp - origin) * 1e6 / master.clock_hz}
+            if kind_name == "instant":
+                entry.update(ph="i", s="t", args={"arg0": arg0, "arg1": arg1})
+            elif kind_name == "begin":
+                entry.update(ph="B", args={"arg0": arg0})
+            elif kind_name == "end":
+                entry.update(ph="E", args={"arg0": arg0})
+            else:
+                entry.update(ph="C", args={name: arg0})
+            events.append(entry)
+    events.sort(key=lambda entry: entry.get("ts", -1.0))
+    return {"traceEvents": events, "displayTimeUnit": "ns"}, master
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("dumps", nargs="+", help="Raw memory dumps holding the trace logs")
+    parser.add_argument("--names", help="Event names, one \"ID NAME\" per line")
+    parser.add_argument("--output", "-o", help="Trace-event JSON file, standard output by default")
+    args = parser.parse_args()
+
+    logs = []
+    for path in args.dumps:
+        with open(path, "rb") as file:
+            logs.extend(find_logs(file.read()))
+    if not logs:
+        print("error: no trace log found in the dumps", file=sys.stderr)
+        return 1
+
+    trace, master = merge(logs, read_names(args.names))
+    for log in logs:
+        print(f"{CORE_NAMES.get(log.core, log.core)}: {len(log.records)} records, {log.overwritten} overwritten, "
+              f"{log.clock_hz / 1e6:g} MHz", file=sys.stderr)
+    if master.sync[0] != 0:
+        round_trip = (master.sync[4] - master.sync[1]) % WRAP
+        print(f"sync: round trip {round_trip} cycles, {round_trip * 1e9 / master.clock_hz:.0f} ns", file=sys.stderr)
+
+    if args.output:
+        with open(args.output, "w", encoding="utf-8") as file:
+            json.dump(trace, file)
+    else:
+        json.dump(trace, sys.stdout)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())